@@ -0,0 +1,109 @@
+// load time of a large asset through the FileUtils read paths
+// usage: SoftRenderAdv_bench_io [file path] [size in MB, default 1024]
+// the file is generated if it does not exist. note the first run after generating
+// reads from the OS page cache, drop caches between runs to measure cold disk reads.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "base/FileUtils.h"
+#include "base/Timer.h"
+
+static constexpr size_t MB = 1024 * 1024;
+
+static bool generateFile(const std::string& path, size_t size) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    std::vector<uint32_t> chunk(16 * MB / sizeof(uint32_t));
+    uint32_t seed = 1;
+    size_t written = 0;
+    while (written < size) {
+        for (auto& v : chunk) {
+            seed = seed * 1664525u + 1013904223u;
+            v = seed;
+        }
+        size_t n = std::min(size - written, chunk.size() * sizeof(uint32_t));
+        fwrite(chunk.data(), 1, n, file);
+        written += n;
+    }
+    fclose(file);
+    return true;
+}
+
+// touch every byte so mapped pages are actually faulted in
+static uint64_t checksum(const uint8_t* data, size_t size) {
+    uint64_t sum = 0;
+    const auto* words = (const uint64_t*)data;
+    size_t wordCnt = size / sizeof(uint64_t);
+    for (size_t i = 0; i < wordCnt; i++) {
+        sum += words[i];
+    }
+    for (size_t i = wordCnt * sizeof(uint64_t); i < size; i++) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+static void report(const char* name, double ms, size_t size, uint64_t sum) {
+    printf("%-28s %10.2f ms %8.2f GB/s  (checksum %016llx)\n", name, ms,
+           (double)size / (1024.0 * MB) / (ms / 1000.0), (unsigned long long)sum);
+}
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "bench_io.bin";
+    size_t size = (argc > 2 ? (size_t)atoll(argv[2]) : 1024) * MB;
+
+    if (!FileUtils::exists(path)) {
+        printf("generating %s (%zu MB)\n", path.c_str(), size / MB);
+        if (!generateFile(path, size)) {
+            LOGE("generate file failed: %s", path.c_str());
+            return -1;
+        }
+    }
+
+    // readBytes: ifstream copy into std::vector
+    {
+        Timer timer;
+        auto bytes = FileUtils::readBytes(path);
+        uint64_t sum = checksum(bytes.data(), bytes.size());
+        report("readBytes", timer.elapseMillis(), bytes.size(), sum);
+        size = bytes.size();
+    }
+
+    // mapFile with each access hint
+    const std::pair<const char*, MapAdvice> advices[] = {
+        { "mapFile (normal)", MapAdvice_NORMAL },
+        { "mapFile (sequential)", MapAdvice_SEQUENTIAL },
+        { "mapFile (willneed)", MapAdvice_WILLNEED },
+    };
+    for (auto& it : advices) {
+        Timer timer;
+        auto file = FileUtils::mapFile(path, it.second);
+        if (!file) {
+            return -1;
+        }
+        uint64_t sum = checksum(file->data(), file->size());
+        report(it.first, timer.elapseMillis(), file->size(), sum);
+    }
+
+    // chunked streaming with bounded memory
+    for (size_t chunkSize : { 1 * MB, 16 * MB, 64 * MB }) {
+        Timer timer;
+        uint64_t sum = 0;
+        size_t total = 0;
+        FileUtils::readChunks(path, chunkSize, [&](const uint8_t* data, size_t n) -> bool {
+            sum += checksum(data, n);
+            total += n;
+            return true;
+        });
+        char name[64];
+        snprintf(name, sizeof(name), "readChunks (%zu MB)", chunkSize / MB);
+        report(name, timer.elapseMillis(), total, sum);
+    }
+
+    return 0;
+}
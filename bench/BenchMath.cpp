@@ -0,0 +1,630 @@
+// microbenchmarks of the math library used by every vertex transform
+// usage: SoftRenderAdv_bench_math [--filter text] [--time ms] [--output results.json]
+//                                 [--compare baseline.json] [--threshold 0.1]
+// every kernel runs over arrays of BATCH elements, ns/op is the best of several samples.
+// with --compare the exit code is non-zero when a kernel is slower than the baseline by more than threshold,
+// so CI can run it after SoftRenderAdv_bench_math --output baseline.json on the parent commit.
+// correctness against the scalar reference is checked by SoftRenderAdv_test_math, see test/TestMath.cpp.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cfloat>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <json11.hpp>
+
+#include "base/MathInc.h"
+#include "math/fast.h"
+#include "math/simd.h"
+#include "math/transform.h"
+#include "math/frustum.h"
+#include "Scene.h"
+#include "BVH.h"
+#include "OcclusionCuller.h"
+#include "base/Timer.h"
+#include "base/FileUtils.h"
+#include "base/ParallelUtils.h"
+#include "MathReference.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#define BENCH_SSE
+#include <immintrin.h>
+#endif
+
+static constexpr size_t BATCH = 1024;
+
+// keep the compiler from removing the benchmarked work
+template<typename T>
+static inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile char sink;
+    sink = *(const volatile char*)&value;
+#endif
+}
+
+struct KernelResult {
+    std::string name;
+    std::string variant;
+    double nsPerOp = 0;
+};
+
+class MathBench {
+public:
+    MathBench(const std::string& filter, double sampleMillis) : filter_(filter), sampleMillis_(sampleMillis) {}
+
+    // func() processes opsPerCall elements
+    template<typename F>
+    void run(const char* name, const char* variant, F&& func, size_t opsPerCall = BATCH) {
+        std::string fullName = std::string(name) + "/" + variant;
+        if (!filter_.empty() && fullName.find(filter_) == std::string::npos) {
+            return;
+        }
+
+        // calibrate the call count of one sample
+        size_t calls = 1;
+        while (true) {
+            Timer timer;
+            for (size_t i = 0; i < calls; i++) {
+                func();
+            }
+            if (timer.elapseMillis() >= sampleMillis_ / 10.0 || calls >= (1u << 24)) {
+                break;
+            }
+            calls *= 2;
+        }
+
+        double best = 1e30;
+        for (int sample = 0; sample < 5; sample++) {
+            Timer timer;
+            for (size_t i = 0; i < calls; i++) {
+                func();
+            }
+            best = std::min(best, timer.elapseMillis());
+        }
+
+        KernelResult result;
+        result.name = name;
+        result.variant = variant;
+        result.nsPerOp = best * 1e6 / (double)(calls * opsPerCall);
+        printf("%-24s %-8s %10.3f ns/op\n", name, variant, result.nsPerOp);
+        results_.push_back(result);
+    }
+
+    inline const std::vector<KernelResult>& results() const {
+        return results_;
+    }
+
+private:
+    std::string filter_;
+    double sampleMillis_;
+    std::vector<KernelResult> results_;
+};
+
+static uint32_t seed_ = 1;
+
+static float randomFloat(float lo, float hi) {
+    seed_ = seed_ * 1664525u + 1013904223u;
+    return lo + (hi - lo) * (float)(seed_ >> 8) / (float)(1u << 24);
+}
+
+static math::mat4f randomMatrix() {
+    math::mat4f m;
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            m[c][r] = randomFloat(-1.f, 1.f) + (c == r ? 4.f : 0.f);
+        }
+    }
+    return m;
+}
+
+static math::quatf randomQuat() {
+    return normalize(math::quatf(randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f),
+                                 randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f)));
+}
+
+#ifdef BENCH_SSE
+// rsqrt estimate refined by one Newton-Raphson step
+static inline __m128 normalize4SSE(__m128 v) {
+    __m128 sq = _mm_mul_ps(v, v);
+    sq = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1)));
+    sq = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1, 0, 3, 2)));
+    __m128 r = _mm_rsqrt_ps(sq);
+    r = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), r),
+                   _mm_sub_ps(_mm_set1_ps(3.f), _mm_mul_ps(_mm_mul_ps(sq, r), r)));
+    return _mm_mul_ps(v, r);
+}
+#endif
+
+static bool compareBaseline(const std::vector<KernelResult>& results, const std::string& path, double threshold) {
+    std::string text = FileUtils::readText(path);
+    std::string err;
+    json11::Json baseline = json11::Json::parse(text, err);
+    if (!err.empty()) {
+        fprintf(stderr, "parse %s failed: %s\n", path.c_str(), err.c_str());
+        return false;
+    }
+
+    bool pass = true;
+    for (auto& item : baseline["kernels"].array_items()) {
+        for (auto& r : results) {
+            if (r.name != item["name"].string_value() || r.variant != item["variant"].string_value()) {
+                continue;
+            }
+            double base = item["ns_per_op"].number_value();
+            double ratio = base > 0 ? r.nsPerOp / base : 1.0;
+            if (ratio > 1.0 + threshold) {
+                printf("REGRESSION %s/%s: %.3f ns/op, baseline %.3f (+%.0f%%)\n", r.name.c_str(), r.variant.c_str(),
+                       r.nsPerOp, base, (ratio - 1.0) * 100.0);
+                pass = false;
+            }
+        }
+    }
+    return pass;
+}
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string output;
+    std::string comparePath;
+    double sampleMillis = 20.0;
+    double threshold = 0.1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) {
+            filter = argv[++i];
+        } else if (arg == "--time" && hasValue) {
+            sampleMillis = std::max(1.0, atof(argv[++i]));
+        } else if (arg == "--output" && hasValue) {
+            output = argv[++i];
+        } else if (arg == "--compare" && hasValue) {
+            comparePath = argv[++i];
+        } else if (arg == "--threshold" && hasValue) {
+            threshold = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "unknown option: %s\n", arg.c_str());
+            return -1;
+        }
+    }
+
+    // inputs
+    std::vector<math::mat4f> matrices(BATCH);
+    std::vector<math::float4> vectors(BATCH);
+    std::vector<math::float3> vectors3(BATCH);
+    std::vector<math::quatf> quats(BATCH * 2);
+    std::vector<float> floats(BATCH);
+    std::vector<math::half> halfs(BATCH);
+    for (size_t i = 0; i < BATCH; i++) {
+        matrices[i] = randomMatrix();
+        vectors[i] = {randomFloat(-10.f, 10.f), randomFloat(-10.f, 10.f), randomFloat(-10.f, 10.f), 1.f};
+        vectors3[i] = {randomFloat(-10.f, 10.f), randomFloat(-10.f, 10.f), randomFloat(-10.f, 10.f)};
+        quats[i * 2] = randomQuat();
+        quats[i * 2 + 1] = randomQuat();
+        floats[i] = randomFloat(-math::F_PI, math::F_PI);
+        halfs[i] = math::half(floats[i]);
+    }
+    const math::mat4f mvp = randomMatrix();
+
+    // outputs
+    std::vector<math::float4> outVectors(BATCH);
+    std::vector<math::float3> outVectors3(BATCH);
+    std::vector<math::mat4f> outMatrices(BATCH);
+    std::vector<math::quatf> outQuats(BATCH);
+    std::vector<float> outFloats(BATCH);
+    std::vector<math::half> outHalfs(BATCH);
+
+    // the same vectors in SoA batches
+    std::vector<math::simd::float4x8> soaVectors(BATCH / math::simd::WIDTH);
+    std::vector<math::simd::float3x8> soaVectors3(BATCH / math::simd::WIDTH);
+    std::vector<math::simd::float4x8> outSoaVectors(BATCH / math::simd::WIDTH);
+    std::vector<math::simd::float3x8> outSoaVectors3(BATCH / math::simd::WIDTH);
+    for (size_t i = 0; i < soaVectors.size(); i++) {
+        soaVectors[i] = math::simd::float4x8::load(&vectors[i * math::simd::WIDTH]);
+        soaVectors3[i] = math::simd::float3x8::load(&vectors3[i * math::simd::WIDTH]);
+    }
+
+    MathBench bench(filter, sampleMillis);
+    printf("%-24s %-8s %10s\n", "kernel", "variant", "time");
+
+    // "math" is the library call, specialized for float when SOFTGL_SIMD_OPT is defined,
+    // "scalar" the generic code it replaces
+    bench.run("mat4_mul_vec4", "scalar", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outVectors[i] = mulMat4Vec4Scalar(mvp, vectors[i]);
+        }
+        doNotOptimize(outVectors[0]);
+    });
+    bench.run("mat4_mul_vec4", "math", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outVectors[i] = mvp * vectors[i];
+        }
+        doNotOptimize(outVectors[0]);
+    });
+
+    bench.run("mat4_mul_vec4", "simd8", [&]() {
+        for (size_t i = 0; i < soaVectors.size(); i++) {
+            outSoaVectors[i] = math::simd::transform(mvp, soaVectors[i]);
+        }
+        doNotOptimize(outSoaVectors[0]);
+    });
+
+    bench.run("mat4_mul_mat4", "scalar", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outMatrices[i] = mulMat4Mat4Scalar(mvp, matrices[i]);
+        }
+        doNotOptimize(outMatrices[0]);
+    });
+    bench.run("mat4_mul_mat4", "math", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outMatrices[i] = mvp * matrices[i];
+        }
+        doNotOptimize(outMatrices[0]);
+    });
+
+    bench.run("mat4_transpose", "math", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outMatrices[i] = transpose(matrices[i]);
+        }
+        doNotOptimize(outMatrices[0]);
+    });
+
+    bench.run("mat4_inverse", "scalar", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outMatrices[i] = math::details::matrix::gaussJordanInverse(matrices[i]);
+        }
+        doNotOptimize(outMatrices[0]);
+    });
+    bench.run("mat4_inverse", "math", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outMatrices[i] = inverse(matrices[i]);
+        }
+        doNotOptimize(outMatrices[0]);
+    });
+
+    bench.run("vec4_dot", "scalar", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outFloats[i] = dot4Scalar(vectors[i], outVectors[i]);
+        }
+        doNotOptimize(outFloats[0]);
+    });
+    bench.run("vec4_dot", "math", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outFloats[i] = dot(vectors[i], outVectors[i]);
+        }
+        doNotOptimize(outFloats[0]);
+    });
+
+    std::vector<math::AABB> boxes(BATCH);
+    std::vector<math::AABB> outBoxes(BATCH);
+    for (size_t i = 0; i < BATCH; i++) {
+        boxes[i] = math::AABB(vectors3[i] - math::float3(1.f), vectors3[i] + math::float3(1.f));
+    }
+    bench.run("transform_points", "scalar", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outVectors[i] = mulMat4Vec4Scalar(mvp, math::float4(vectors3[i], 1.f));
+        }
+        doNotOptimize(outVectors[0]);
+    });
+    bench.run("transform_points", "math", [&]() {
+        math::transformPoints(mvp, vectors3.data(), outVectors.data(), BATCH);
+        doNotOptimize(outVectors[0]);
+    });
+    bench.run("transform_aabbs", "scalar", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            math::AABB box;
+            for (int corner = 0; corner < 8; corner++) {
+                math::float3 p((corner & 1) ? boxes[i].max.x : boxes[i].min.x, (corner & 2) ? boxes[i].max.y : boxes[i].min.y,
+                               (corner & 4) ? boxes[i].max.z : boxes[i].min.z);
+                box.merge(mulMat4Vec4Scalar(mvp, math::float4(p, 1.f)).xyz);
+            }
+            outBoxes[i] = box;
+        }
+        doNotOptimize(outBoxes[0]);
+    });
+    bench.run("transform_aabbs", "math", [&]() {
+        math::transformAABBs(mvp, boxes.data(), outBoxes.data(), BATCH);
+        doNotOptimize(outBoxes[0]);
+    });
+
+    // arrays larger than the caches, single thread and split across a pool
+    {
+        const size_t largeCnt = 1 << 22;
+        std::vector<math::float3> largeIn(largeCnt);
+        std::vector<math::float4> largeOut(largeCnt);
+        for (size_t i = 0; i < largeCnt; i++) {
+            largeIn[i] = vectors3[i % BATCH];
+        }
+        ThreadPool pool;
+        bench.run("transform_points_4m", "math", [&]() {
+            math::transformPoints(mvp, largeIn.data(), largeOut.data(), largeCnt);
+            doNotOptimize(largeOut[0]);
+        }, largeCnt);
+        bench.run("transform_points_4m", "pool", [&]() {
+            ParallelUtils::transformPoints(mvp, largeIn.data(), largeOut.data(), largeCnt, &pool);
+            doNotOptimize(largeOut[0]);
+        }, largeCnt);
+    }
+
+    // 64 roots with 64 children of 64 boxes each, all roots moved or only one subtree
+    {
+        Scene scene;
+        std::vector<NodeId> roots;
+        for (size_t i = 0; i < 64; i++) {
+            roots.push_back(scene.addNode(INVALID_NODE, matrices[i]));
+        }
+        for (size_t i = 0; i < 64 * 64; i++) {
+            scene.addNode(roots[i % 64], matrices[i % BATCH]);
+        }
+        for (size_t i = 0; i < 64 * 64 * 64; i++) {
+            NodeId node = scene.addNode(roots.size() + i % (64 * 64), matrices[(i * 7) % BATCH]);
+            scene.setLocalBounds(node, math::AABB(math::float3(-0.5f), math::float3(0.5f)));
+        }
+        size_t nodeCnt = scene.getNodeCount();
+        bench.run("scene_update_266k", "all", [&]() {
+            for (NodeId root : roots) {
+                scene.setLocalMatrix(root, scene.getLocalMatrix(root));
+            }
+            doNotOptimize(scene.updateTransforms());
+        }, nodeCnt);
+        bench.run("scene_update_266k", "subtree", [&]() {
+            scene.setLocalMatrix(roots[0], scene.getLocalMatrix(roots[0]));
+            doNotOptimize(scene.updateTransforms());
+        }, nodeCnt);
+    }
+
+    // unit boxes scattered in a 200^3 volume seen from the center, about 1/6 visible
+    {
+        const size_t boxCnt = 1 << 16;
+        math::mat4f view = inverse(math::mat4f::lookAt(math::float3(0.f), math::float3(0.f, 0.f, -1.f),
+                                                       math::float3(0.f, 1.f, 0.f)));
+        math::Frustum frustum(math::mat4f::perspective(60.f, 1.f, 0.1f, 100.f) * view);
+        std::vector<math::AABB> boxes(boxCnt);
+        math::AABBArray boxArray;
+        boxArray.resize(boxCnt);
+        for (size_t i = 0; i < boxCnt; i++) {
+            math::float3 c(randomFloat(-100.f, 100.f), randomFloat(-100.f, 100.f), randomFloat(-100.f, 100.f));
+            boxes[i] = math::AABB(c - 0.5f, c + 0.5f);
+            boxArray.set(i, boxes[i]);
+        }
+
+        std::vector<uint8_t> scalarVisible(boxCnt);
+        std::vector<uint8_t> masks(boxArray.paddedSize() / 8);
+        bench.run("frustum_cull_64k", "scalar", [&]() {
+            for (size_t i = 0; i < boxCnt; i++) {
+                scalarVisible[i] = frustum.intersects(boxes[i]) ? 1 : 0;
+            }
+            doNotOptimize(scalarVisible[0]);
+        }, boxCnt);
+        bench.run("frustum_cull_64k", "simd8", [&]() {
+            math::cullAABBs(frustum, boxArray, masks.data());
+            doNotOptimize(masks[0]);
+        }, boxCnt);
+        ThreadPool pool;
+        bench.run("frustum_cull_64k", "pool", [&]() {
+            ParallelUtils::cullAABBs(frustum, boxArray, masks.data(), &pool);
+            doNotOptimize(masks[0]);
+        }, boxCnt);
+
+        // built once up front so that refit, cull and pick also run when filtered alone
+        BVH bvh;
+        bvh.build(boxArray);
+        std::vector<uint32_t> bvhVisible;
+        bench.run("bvh_build_64k", "sah", [&]() {
+            bvh.build(boxArray);
+            doNotOptimize(bvh.getNodes()[0]);
+        }, boxCnt);
+        ThreadPool buildPool;
+        bench.run("bvh_build_64k", "pool", [&]() {
+            bvh.build(boxArray, &buildPool);
+            doNotOptimize(bvh.getNodes()[0]);
+        }, boxCnt);
+
+        // 1% of the boxes moved, ns per box of the tree
+        std::vector<uint8_t> changed(boxCnt, 0);
+        for (size_t i = 0; i < boxCnt; i += 100) {
+            changed[i] = 1;
+        }
+        bench.run("bvh_refit_64k", "1%", [&]() {
+            bvh.refit(boxArray, changed.data());
+            doNotOptimize(bvh.getNodes()[0]);
+        }, boxCnt);
+
+        bench.run("bvh_cull_64k", "bvh", [&]() {
+            bvhVisible.clear();
+            bvh.cull(frustum, boxArray, bvhVisible);
+            doNotOptimize(bvhVisible.size());
+        }, boxCnt);
+
+        // rays from the center
+        const size_t rayCnt = 64;
+        std::vector<math::float3> rayDirs(rayCnt);
+        for (size_t i = 0; i < rayCnt; i++) {
+            rayDirs[i] = normalize(math::float3(randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f), -1.f));
+        }
+        size_t ray = 0;
+        bench.run("bvh_pick_64k", "bvh", [&]() {
+            doNotOptimize(bvh.pick(math::float3(0.f), rayDirs[ray++ % rayCnt], boxArray, FLT_MAX));
+        }, 1);
+    }
+
+    // 4x4 wall panels with gaps at z = -20 in front of the boxes of the frustum test
+    {
+        const size_t boxCnt = 1 << 16;
+        math::mat4f view = inverse(math::mat4f::lookAt(math::float3(0.f), math::float3(0.f, 0.f, -1.f),
+                                                       math::float3(0.f, 1.f, 0.f)));
+        math::mat4f viewProjection = math::mat4f::perspective(60.f, 1.f, 0.1f, 100.f) * view;
+
+        OccluderMesh cube;
+        for (int i = 0; i < 8; i++) {
+            cube.positions.emplace_back((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f);
+        }
+        cube.indices = { 0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+                         2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5 };
+        std::vector<math::mat4f> wallMatrices;
+        for (int i = 0; i < 16; i++) {
+            math::float3 center(-15.f + 10.f * (float)(i % 4), -15.f + 10.f * (float)(i / 4), -20.f);
+            math::float3 size(8.f, 8.f, 1.f);
+            wallMatrices.push_back(math::mat4f::translation(center) * math::mat4f::scaling(size));
+        }
+
+        math::Frustum frustum(viewProjection);
+        math::AABBArray boxArray;
+        boxArray.resize(boxCnt);
+        std::vector<uint32_t> inFrustum;
+        for (uint32_t i = 0; i < boxCnt; i++) {
+            math::float3 c(randomFloat(-50.f, 50.f), randomFloat(-50.f, 50.f), randomFloat(-99.f, -1.f));
+            boxArray.set(i, math::AABB(c - 0.5f, c + 0.5f));
+            if (frustum.intersects(boxArray.get(i))) {
+                inFrustum.push_back(i);
+            }
+        }
+
+        OcclusionCuller culler;
+        auto rasterizeWalls = [&]() {
+            culler.begin(viewProjection);
+            for (auto& model : wallMatrices) {
+                culler.addOccluder(cube, model);
+            }
+            culler.rasterize();
+        };
+
+        std::vector<uint32_t> visible;
+        bench.run("occlusion_raster_16", "simd8", [&]() {
+            rasterizeWalls();
+            doNotOptimize(culler.getDepth()[0]);
+        }, 16);
+        ThreadPool pool;
+        bench.run("occlusion_raster_16", "pool", [&]() {
+            culler.begin(viewProjection);
+            for (auto& model : wallMatrices) {
+                culler.addOccluder(cube, model);
+            }
+            culler.rasterize(&pool);
+            doNotOptimize(culler.getDepth()[0]);
+        }, 16);
+        rasterizeWalls();
+        bench.run("occlusion_test_64k", "simd8", [&]() {
+            visible = inFrustum;
+            doNotOptimize(culler.cull(boxArray, visible));
+        }, inFrustum.size());
+        bench.run("occlusion_test_64k", "pool", [&]() {
+            visible = inFrustum;
+            doNotOptimize(culler.cull(boxArray, visible, &pool));
+        }, inFrustum.size());
+    }
+
+    bench.run("quat_slerp", "scalar", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outQuats[i] = slerp(quats[i * 2], quats[i * 2 + 1], 0.3f);
+        }
+        doNotOptimize(outQuats[0]);
+    });
+
+    bench.run("vec3_normalize", "scalar", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outVectors3[i] = normalize(vectors3[i]);
+        }
+        doNotOptimize(outVectors3[0]);
+    });
+
+    bench.run("vec3_normalize", "simd8", [&]() {
+        for (size_t i = 0; i < soaVectors3.size(); i++) {
+            outSoaVectors3[i] = normalize(soaVectors3[i]);
+        }
+        doNotOptimize(outSoaVectors3[0]);
+    });
+
+    bench.run("vec4_normalize", "math", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outVectors[i] = normalize(vectors[i]);
+        }
+        doNotOptimize(outVectors[0]);
+    });
+#ifdef BENCH_SSE
+    bench.run("vec4_normalize", "sse", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            _mm_storeu_ps(&outVectors[i][0], normalize4SSE(_mm_loadu_ps(&vectors[i][0])));
+        }
+        doNotOptimize(outVectors[0]);
+    });
+#endif
+
+    bench.run("float_to_half", "scalar", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outHalfs[i] = math::half(floats[i]);
+        }
+        doNotOptimize(outHalfs[0]);
+    });
+    bench.run("half_to_float", "scalar", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outFloats[i] = (float)halfs[i];
+        }
+        doNotOptimize(outFloats[0]);
+    });
+#ifdef __F16C__
+    bench.run("float_to_half", "f16c", [&]() {
+        for (size_t i = 0; i < BATCH; i += 8) {
+            __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(&floats[i]), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128((__m128i*)&outHalfs[i], h);
+        }
+        doNotOptimize(outHalfs[0]);
+    });
+    bench.run("half_to_float", "f16c", [&]() {
+        for (size_t i = 0; i < BATCH; i += 8) {
+            _mm256_storeu_ps(&outFloats[i], _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)&halfs[i])));
+        }
+        doNotOptimize(outFloats[0]);
+    });
+#endif
+
+    bench.run("cos", "std", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outFloats[i] = std::cos(floats[i]);
+        }
+        doNotOptimize(outFloats[0]);
+    });
+    bench.run("cos", "fast", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outFloats[i] = math::fast::cos(floats[i]);
+        }
+        doNotOptimize(outFloats[0]);
+    });
+    bench.run("sin", "std", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outFloats[i] = std::sin(floats[i]);
+        }
+        doNotOptimize(outFloats[0]);
+    });
+    bench.run("sin", "fast", [&]() {
+        for (size_t i = 0; i < BATCH; i++) {
+            outFloats[i] = math::fast::sin(floats[i]);
+        }
+        doNotOptimize(outFloats[0]);
+    });
+
+    json11::Json::array kernels;
+    for (auto& r : bench.results()) {
+        kernels.push_back(json11::Json::object{
+            {"name", r.name},
+            {"variant", r.variant},
+            {"ns_per_op", r.nsPerOp},
+        });
+    }
+    if (!output.empty() && !FileUtils::writeText(output, json11::Json(json11::Json::object{
+            {"batch", (int)BATCH},
+            {"kernels", kernels},
+        }).dump())) {
+        fprintf(stderr, "write %s failed\n", output.c_str());
+        return -1;
+    }
+
+    if (!comparePath.empty() && !compareBaseline(bench.results(), comparePath, threshold)) {
+        return 1;
+    }
+    return 0;
+}
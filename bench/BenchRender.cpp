@@ -0,0 +1,800 @@
+// rendering throughput of the software renderer on fixed synthetic scenes
+// usage: SoftRenderAdv_bench [--frames n] [--width n] [--height n] [--threads n]
+//                            [--scene name] [--output results.json] [--tag text]
+// every scene is deterministic (no random seeds depend on time), one warm-up frame is not measured.
+// results are printed as a table and written to a json file for regression tracking across commits.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <json11.hpp>
+
+#include "base/Timer.h"
+#include "base/FileUtils.h"
+#include "render/soft/RendererSoft.h"
+#include "render/soft/UniformSoft.h"
+#include "render/VertexUtils.h"
+#include "Meshlet.h"
+#include "MeshSimplifier.h"
+#include "OcclusionCuller.h"
+
+struct BenchUniforms {
+    math::mat4f mvp = math::mat4f(1.f);
+    math::float4 color = math::float4(1.f);
+    float lod = 0.f;
+};
+
+// uniform block "uniforms" at location 0, sampler "uTexture" at location 1
+class BenchShader : public ShaderSoft {
+public:
+    int getUniformLocation(const std::string& name) override {
+        if (name == "uniforms") {
+            return 0;
+        }
+        return name == "uTexture" ? 1 : -1;
+    }
+
+    void setUniformData(int location, const void* data, size_t size) override {
+        memcpy(&uniforms_, data, std::min(size, sizeof(BenchUniforms)));
+    }
+
+    void setSampler(int location, TextureSoft* tex) override {
+        texture_ = tex;
+    }
+
+protected:
+    BenchUniforms uniforms_;
+    TextureSoft* texture_ = nullptr;
+};
+
+// position, color
+class ColorShader : public BenchShader {
+public:
+    size_t getVaryingsCount() const override {
+        return 3;
+    }
+
+    void vertexShader(const float* const* attributes, float* varyings, ShaderBuiltin& builtin) const override {
+        builtin.position = uniforms_.mvp * math::float4(attributes[0][0], attributes[0][1], attributes[0][2], 1.f);
+        memcpy(varyings, attributes[1], 3 * sizeof(float));
+    }
+
+    void fragmentShader(const float* varyings, ShaderBuiltin& builtin) const override {
+        builtin.fragColor = math::float4(varyings[0], varyings[1], varyings[2], 1.f) * uniforms_.color;
+    }
+};
+
+// position, color, per instance xy offset and xy scale applied before mvp
+class InstancedColorShader : public ColorShader {
+public:
+    void vertexShader(const float* const* attributes, float* varyings, ShaderBuiltin& builtin) const override {
+        const float* p = attributes[0];
+        const float* instance = attributes[2];
+        builtin.position = uniforms_.mvp * math::float4(p[0] * instance[2] + instance[0], p[1] * instance[3] + instance[1],
+                                                        p[2], 1.f);
+        memcpy(varyings, attributes[1], 3 * sizeof(float));
+    }
+};
+
+// position, uv
+class TextureShader : public BenchShader {
+public:
+    size_t getVaryingsCount() const override {
+        return 2;
+    }
+
+    void vertexShader(const float* const* attributes, float* varyings, ShaderBuiltin& builtin) const override {
+        builtin.position = uniforms_.mvp * math::float4(attributes[0][0], attributes[0][1], attributes[0][2], 1.f);
+        varyings[0] = attributes[1][0];
+        varyings[1] = attributes[1][1];
+    }
+
+    void fragmentShader(const float* varyings, ShaderBuiltin& builtin) const override {
+        builtin.fragColor = texture_ ? texture_->sample2D({varyings[0], varyings[1]}, uniforms_.lod) : uniforms_.color;
+    }
+};
+
+// shadow map: depth only, no color attachment
+class DepthShader : public BenchShader {
+public:
+    size_t getVaryingsCount() const override {
+        return 0;
+    }
+
+    void vertexShader(const float* const* attributes, float* varyings, ShaderBuiltin& builtin) const override {
+        builtin.position = uniforms_.mvp * math::float4(attributes[0][0], attributes[0][1], attributes[0][2], 1.f);
+    }
+
+    void fragmentShader(const float* varyings, ShaderBuiltin& builtin) const override {
+    }
+};
+
+// interleaved position (3 floats) and one extra attribute of attrSize floats
+struct Mesh {
+    size_t attrSize = 3;
+    std::vector<float> vertices;
+    std::vector<int32_t> indices;
+
+    void addVertex(const math::float3& pos, const float* attr) {
+        vertices.insert(vertices.end(), {pos.x, pos.y, pos.z});
+        vertices.insert(vertices.end(), attr, attr + attrSize);
+    }
+
+    int32_t vertexCnt() const {
+        return (int32_t)(vertices.size() / (3 + attrSize));
+    }
+
+    VertexArray getVertexArray() {
+        size_t stride = (3 + attrSize) * sizeof(float);
+        VertexArray vertexArray;
+        vertexArray.vertexSize = stride;
+        vertexArray.vertexesDesc = {{3, stride, 0}, {attrSize, stride, 3 * sizeof(float)}};
+        vertexArray.vertexesBuffer = (uint8_t*)vertices.data();
+        vertexArray.vertexesBufferLength = vertices.size() * sizeof(float);
+        vertexArray.indexBuffer = indices.data();
+        vertexArray.indexBufferLength = indices.size() * sizeof(int32_t);
+        return vertexArray;
+    }
+
+    std::shared_ptr<VertexArrayObject> createVAO(Renderer& renderer) {
+        return renderer.createVertexArrayObject(getVertexArray());
+    }
+
+    // reorders the triangles meshlet by meshlet, call before creating vertex array objects
+    std::vector<Meshlet> buildMeshlets() {
+        std::vector<uint32_t> reordered(indices.begin(), indices.end());
+        std::vector<Meshlet> meshlets;
+        MeshletBuilder::build(getVertexArray(), reordered.data(), reordered.size(), meshlets);
+        indices.assign(reordered.begin(), reordered.end());
+        return meshlets;
+    }
+
+    // one mesh per level of detail sharing the vertexes, the first one is this mesh
+    std::vector<Mesh> buildLods(std::vector<MeshLod>& lods) {
+        std::vector<uint32_t> chain(indices.begin(), indices.end());
+        MeshSimplifier::buildLods(getVertexArray(), chain, lods);
+        std::vector<Mesh> levels(lods.size(), *this);
+        for (size_t i = 0; i < lods.size(); i++) {
+            levels[i].indices.assign(chain.begin() + lods[i].indexOffset,
+                                     chain.begin() + lods[i].indexOffset + lods[i].indexCount);
+        }
+        return levels;
+    }
+
+    // same vertexes encoded as posType / attrType with 4 byte aligned stride, 16 bit indices if they fit
+    std::shared_ptr<VertexArrayObject> createQuantizedVAO(Renderer& renderer, VertexAttributeType posType,
+                                                          VertexAttributeType attrType) {
+        size_t posBytes = VertexUtils::attributeBytes(posType, 3);
+        size_t stride = (posBytes + VertexUtils::attributeBytes(attrType, attrSize) + 3) & ~(size_t)3;
+        size_t cnt = (size_t)vertexCnt();
+        quantizedVertices.assign(cnt * stride, 0);
+        for (size_t i = 0; i < cnt; i++) {
+            const float* v = vertices.data() + i * (3 + attrSize);
+            VertexUtils::encodeAttribute(posType, v, 3, quantizedVertices.data() + i * stride);
+            VertexUtils::encodeAttribute(attrType, v + 3, attrSize, quantizedVertices.data() + i * stride + posBytes);
+        }
+
+        VertexArray vertexArray;
+        vertexArray.vertexSize = stride;
+        vertexArray.vertexesDesc = {{3, stride, 0, posType}, {attrSize, stride, posBytes, attrType}};
+        vertexArray.vertexesBuffer = quantizedVertices.data();
+        vertexArray.vertexesBufferLength = quantizedVertices.size();
+        if (cnt <= 65536) {
+            shortIndices.assign(indices.begin(), indices.end());
+            vertexArray.indexBuffer = shortIndices.data();
+            vertexArray.indexBufferLength = shortIndices.size() * sizeof(uint16_t);
+            vertexArray.indexType = Index_UINT16;
+        } else {
+            vertexArray.indexBuffer = indices.data();
+            vertexArray.indexBufferLength = indices.size() * sizeof(int32_t);
+        }
+        return renderer.createVertexArrayObject(vertexArray);
+    }
+
+    std::vector<uint8_t> quantizedVertices;
+    std::vector<uint16_t> shortIndices;
+};
+
+static uint32_t nextRandom(uint32_t& seed) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+static float randomFloat(uint32_t& seed) {
+    return (float)nextRandom(seed) / (float)(1u << 24);
+}
+
+// n x n quads on [x0, x1] x [y0, y1], z from height(u, v), attributes: color or uv
+static Mesh makeGrid(int n, float x0, float y0, float x1, float y1, bool uv,
+                     const std::function<float(float, float)>& height = nullptr) {
+    Mesh mesh;
+    mesh.attrSize = uv ? 2 : 3;
+    for (int y = 0; y <= n; y++) {
+        for (int x = 0; x <= n; x++) {
+            float u = (float)x / (float)n;
+            float v = (float)y / (float)n;
+            float attr[3] = {u, v, uv ? 0.f : 1.f - u * v};
+            float z = height ? height(u, v) : 0.f;
+            mesh.addVertex({math::mix(x0, x1, u), math::mix(y0, y1, v), z}, attr);
+        }
+    }
+    for (int y = 0; y < n; y++) {
+        for (int x = 0; x < n; x++) {
+            int32_t i0 = y * (n + 1) + x;
+            int32_t i1 = i0 + 1;
+            int32_t i2 = i0 + n + 1;
+            int32_t i3 = i2 + 1;
+            mesh.indices.insert(mesh.indices.end(), {i0, i1, i3, i0, i3, i2});
+        }
+    }
+    return mesh;
+}
+
+// n longitude x n / 2 latitude segments of the unit sphere, counter-clockwise seen from outside,
+// attribute: normal as color
+static Mesh makeSphere(int n) {
+    Mesh mesh;
+    int rings = n / 2;
+    for (int y = 0; y <= rings; y++) {
+        float theta = (float)y / (float)rings * (float)math::F_PI;
+        for (int x = 0; x <= n; x++) {
+            float phi = (float)x / (float)n * (float)math::F_TAU;
+            math::float3 p(std::sin(theta) * std::cos(phi), std::cos(theta), -std::sin(theta) * std::sin(phi));
+            float color[3] = {p.x * 0.5f + 0.5f, p.y * 0.5f + 0.5f, p.z * 0.5f + 0.5f};
+            mesh.addVertex(p, color);
+        }
+    }
+    for (int y = 0; y < rings; y++) {
+        for (int x = 0; x < n; x++) {
+            int32_t i0 = y * (n + 1) + x;
+            int32_t i1 = i0 + 1;
+            int32_t i2 = i0 + n + 1;
+            int32_t i3 = i2 + 1;
+            mesh.indices.insert(mesh.indices.end(), {i0, i2, i3, i0, i3, i1});
+        }
+    }
+    return mesh;
+}
+
+struct DrawItem {
+    std::shared_ptr<VertexArrayObject> vao;
+    std::shared_ptr<ShaderProgram> program;
+    std::shared_ptr<PipelineStates> states;
+    std::shared_ptr<ShaderResources> resources;
+
+    // culled every frame with mvp and the eye in mesh space when not empty, then drawn by ranges
+    std::vector<Meshlet> meshlets;
+    math::mat4f mvp;
+    math::float3 eye;
+
+    // drawn instanced when set
+    std::shared_ptr<InstanceBuffer> instances;
+
+    // world bounds tested against the scene occluders, never skipped when empty
+    math::AABB bounds;
+    bool occluded = false;
+};
+
+// gpu-style resources of one scene, drawn every frame in order
+struct Scene {
+    std::string name;
+    std::string description;
+    std::shared_ptr<FrameBuffer> fbo;
+    ClearStates clearStates;
+    std::vector<DrawItem> draws;
+
+    // rasterized with viewProjection every frame when not empty, draws they hide are skipped
+    std::vector<OccluderMesh> occluders;
+    math::mat4f viewProjection;
+};
+
+class SceneBuilder {
+public:
+    SceneBuilder(Renderer& renderer, int width, int height) : renderer_(renderer), width_(width), height_(height) {}
+
+    std::shared_ptr<FrameBuffer> createFramebuffer(int width, int height, bool color) {
+        auto fbo = renderer_.createFrameBuffer(true);
+        TextureDesc desc{};
+        desc.width = width;
+        desc.height = height;
+        if (color) {
+            desc.format = TextureFormat_RGBA8;
+            desc.usage = TextureUsage_AttachmentColor;
+            auto tex = renderer_.createTexture(desc);
+            tex->initImageData();
+            fbo->setColorAttachment(tex, 0);
+        }
+        desc.format = TextureFormat_FLOAT32;
+        desc.usage = TextureUsage_AttachmentDepth;
+        auto depth = renderer_.createTexture(desc);
+        depth->initImageData();
+        fbo->setDepthAttachment(depth);
+        return fbo;
+    }
+
+    std::shared_ptr<ShaderProgram> createProgram(const std::shared_ptr<ShaderSoft>& shader) {
+        auto program = renderer_.createShaderProgram();
+        dynamic_cast<ShaderProgramSoft*>(program.get())->setShader(shader);
+        return program;
+    }
+
+    std::shared_ptr<ShaderResources> createResources(const BenchUniforms& uniforms,
+                                                     const std::shared_ptr<Texture>& texture = nullptr) {
+        auto resources = std::make_shared<ShaderResources>();
+        auto block = renderer_.createUniformBlock("uniforms", sizeof(BenchUniforms));
+        block->setData((void*)&uniforms, sizeof(BenchUniforms));
+        resources->blocks[0] = block;
+        if (texture) {
+            TextureDesc desc{};
+            auto sampler = renderer_.createUniformSampler("uTexture", desc);
+            sampler->setTexture(texture);
+            resources->samplers[1] = sampler;
+        }
+        return resources;
+    }
+
+    std::shared_ptr<PipelineStates> createStates(bool depthTest, bool blend, bool cullFace) {
+        RenderStates states;
+        states.depthTest = depthTest;
+        states.blend = blend;
+        states.cullFace = cullFace;
+        states.blendParams.SetBlendFactor(BlendFactor_SRC_ALPHA, BlendFactor_ONE_MINUS_SRC_ALPHA);
+        return renderer_.createPipelineStates(states);
+    }
+
+    std::shared_ptr<Texture> createNoiseTexture(int size) {
+        uint32_t seed = 7;
+        auto image = Buffer<RGBA>::makeDefault(size, size);
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                uint32_t r = nextRandom(seed);
+                image->set(x, y, RGBA(r & 0xFF, (r >> 8) & 0xFF, (r >> 16) & 0xFF, 255));
+            }
+        }
+        TextureDesc desc{};
+        desc.width = size;
+        desc.height = size;
+        desc.useMipmaps = true;
+        auto texture = renderer_.createTexture(desc);
+        SamplerDesc sampler{};
+        sampler.filterMin = Filter_LINEAR_MIPMAP_LINEAR;
+        sampler.filterMag = Filter_LINEAR;
+        sampler.wrapS = Wrap_REPEAT;
+        sampler.wrapT = Wrap_REPEAT;
+        texture->setSamplerDesc(sampler);
+        texture->setImageData({image});
+        return texture;
+    }
+
+    Scene begin(const char* name, const char* description, bool color = true) {
+        Scene scene;
+        scene.name = name;
+        scene.description = description;
+        scene.fbo = createFramebuffer(width_, height_, color);
+        scene.clearStates.colorFlag = color;
+        scene.clearStates.depthFlag = true;
+        scene.clearStates.clearColor = math::float4(0.1f, 0.1f, 0.1f, 1.f);
+        return scene;
+    }
+
+    std::vector<Scene> buildAll() {
+        std::vector<Scene> scenes;
+        auto colorShader = std::make_shared<ColorShader>();
+        auto textureShader = std::make_shared<TextureShader>();
+        auto depthShader = std::make_shared<DepthShader>();
+        float aspect = (float)width_ / (float)height_;
+
+        {
+            Scene scene = begin("small_triangles", "256x256 grid, 131k triangles of a few pixels");
+            Mesh mesh = makeGrid(256, -1.f, -1.f, 1.f, 1.f, false);
+            scene.draws.push_back({mesh.createVAO(renderer_), createProgram(colorShader),
+                                   createStates(false, false, false), createResources({})});
+            scenes.push_back(std::move(scene));
+        }
+
+        {
+            Scene scene = begin("quantized_vertices",
+                                "255x255 grid, 130k triangles, half positions, unorm8 colors, 16 bit indices");
+            Mesh mesh = makeGrid(255, -1.f, -1.f, 1.f, 1.f, false);
+            scene.draws.push_back({mesh.createQuantizedVAO(renderer_, VertexAttr_HALF, VertexAttr_UNORM8),
+                                   createProgram(colorShader), createStates(false, false, false),
+                                   createResources({})});
+            scenes.push_back(std::move(scene));
+        }
+
+        {
+            Scene scene = begin("huge_triangles", "8 opaque triangles covering the screen");
+            Mesh mesh;
+            uint32_t seed = 1;
+            for (int i = 0; i < 8; i++) {
+                float color[3] = {randomFloat(seed), randomFloat(seed), randomFloat(seed)};
+                int32_t base = mesh.vertexCnt();
+                mesh.addVertex({-1.f, -1.f, 0.f}, color);
+                mesh.addVertex({3.f, -1.f, 0.f}, color);
+                mesh.addVertex({-1.f, 3.f, 0.f}, color);
+                mesh.indices.insert(mesh.indices.end(), {base, base + 1, base + 2});
+            }
+            scene.draws.push_back({mesh.createVAO(renderer_), createProgram(colorShader),
+                                   createStates(false, false, false), createResources({})});
+            scenes.push_back(std::move(scene));
+        }
+
+        {
+            Scene scene = begin("overdraw", "32 alpha blended quads of 50-100% screen size");
+            Mesh mesh;
+            uint32_t seed = 2;
+            for (int i = 0; i < 32; i++) {
+                float w = 1.f + randomFloat(seed);
+                float h = 1.f + randomFloat(seed);
+                float x = -1.f + randomFloat(seed) * (2.f - w);
+                float y = -1.f + randomFloat(seed) * (2.f - h);
+                float color[3] = {randomFloat(seed), randomFloat(seed), randomFloat(seed)};
+                int32_t base = mesh.vertexCnt();
+                mesh.addVertex({x, y, 0.f}, color);
+                mesh.addVertex({x + w, y, 0.f}, color);
+                mesh.addVertex({x + w, y + h, 0.f}, color);
+                mesh.addVertex({x, y + h, 0.f}, color);
+                mesh.indices.insert(mesh.indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+            }
+            BenchUniforms uniforms;
+            uniforms.color = math::float4(1.f, 1.f, 1.f, 0.25f);
+            scene.draws.push_back({mesh.createVAO(renderer_), createProgram(colorShader),
+                                   createStates(false, true, false), createResources(uniforms)});
+            scenes.push_back(std::move(scene));
+        }
+
+        {
+            Scene scene = begin("texture_bound", "4 screen quads, 1024^2 trilinear texture minified 4x");
+            auto texture = createNoiseTexture(1024);
+            Mesh mesh = makeGrid(1, -1.f, -1.f, 1.f, 1.f, true);
+            for (size_t i = 0; i < mesh.vertices.size(); i += 5) {
+                mesh.vertices[i + 3] *= 4.f * aspect;
+                mesh.vertices[i + 4] *= 4.f;
+            }
+            BenchUniforms uniforms;
+            uniforms.lod = std::max(0.f, std::log2(4.f * 1024.f / (float)height_));
+            auto vao = mesh.createVAO(renderer_);
+            auto program = createProgram(textureShader);
+            auto states = createStates(false, false, false);
+            auto resources = createResources(uniforms, texture);
+            for (int i = 0; i < 4; i++) {
+                scene.draws.push_back({vao, program, states, resources});
+            }
+            scenes.push_back(std::move(scene));
+        }
+
+        {
+            Scene scene = begin("many_draws", "4096 draws of one small quad, resources bound per draw");
+            Mesh mesh = makeGrid(1, -1.f, -1.f, 1.f, 1.f, false);
+            auto vao = mesh.createVAO(renderer_);
+            auto program = createProgram(colorShader);
+            auto states = createStates(true, false, true);
+            for (int y = 0; y < 64; y++) {
+                for (int x = 0; x < 64; x++) {
+                    BenchUniforms uniforms;
+                    float scale = 1.f / 64.f;
+                    uniforms.mvp = math::mat4f::translation(math::float3(-1.f + (2.f * (float)x + 1.f) * scale,
+                                                                         -1.f + (2.f * (float)y + 1.f) * scale,
+                                                                         0.f))
+                        * math::mat4f::scaling(math::float3(scale * 0.8f, scale * 0.8f, 1.f));
+                    scene.draws.push_back({vao, program, states, createResources(uniforms)});
+                }
+            }
+            scenes.push_back(std::move(scene));
+        }
+
+        {
+            Scene scene = begin("many_instances", "same 4096 quads as one instanced draw, offset and scale per instance");
+            Mesh mesh = makeGrid(1, -1.f, -1.f, 1.f, 1.f, false);
+            std::vector<math::float4> instanceData;
+            for (int y = 0; y < 64; y++) {
+                for (int x = 0; x < 64; x++) {
+                    float scale = 1.f / 64.f;
+                    instanceData.emplace_back(-1.f + (2.f * (float)x + 1.f) * scale, -1.f + (2.f * (float)y + 1.f) * scale,
+                                              scale * 0.8f, scale * 0.8f);
+                }
+            }
+            InstanceArray instanceArray;
+            instanceArray.instanceSize = sizeof(math::float4);
+            instanceArray.instancesDesc = {{4, sizeof(math::float4), 0}};
+            instanceArray.instancesBuffer = (uint8_t*)instanceData.data();
+            instanceArray.instancesBufferLength = instanceData.size() * sizeof(math::float4);
+
+            DrawItem item{mesh.createVAO(renderer_), createProgram(std::make_shared<InstancedColorShader>()),
+                          createStates(true, false, true), createResources(BenchUniforms())};
+            item.instances = renderer_.createInstanceBuffer(instanceArray);
+            scene.draws.push_back(std::move(item));
+            scenes.push_back(std::move(scene));
+        }
+
+        {
+            // the same sphere drawn whole and by meshlets: about half is back facing, a third off screen
+            math::float3 eye(0.9f, 0.3f, 1.7f);
+            auto view = math::mat4f::lookAt(eye, math::float3(0.9f, 0.3f, 0.f), math::float3(0.f, 1.f, 0.f));
+            BenchUniforms uniforms;
+            uniforms.mvp = math::mat4f::perspective(60.f, aspect, 0.1f, 10.f) * inverse(view);
+            Mesh mesh = makeSphere(512);
+            std::vector<Meshlet> meshlets = mesh.buildMeshlets();
+            auto vao = mesh.createVAO(renderer_);
+            auto program = createProgram(colorShader);
+            auto states = createStates(true, false, true);
+            auto resources = createResources(uniforms);
+
+            Scene full = begin("sphere_full", "262k triangle sphere, back faces and off screen parts culled per triangle");
+            full.draws.push_back({vao, program, states, resources});
+            scenes.push_back(std::move(full));
+
+            Scene culled = begin("sphere_meshlets", "same sphere, meshlets culled by frustum and normal cone first");
+            culled.draws.push_back({vao, program, states, resources, std::move(meshlets), uniforms.mvp, eye});
+            scenes.push_back(std::move(culled));
+        }
+
+        {
+            // receding row of spheres, the lod scene draws the coarsest level below one pixel of error
+            float fovy = 60.f;
+            auto view = math::mat4f::lookAt(math::float3(0.f, 0.5f, 2.f), math::float3(0.f, 0.f, -8.f),
+                                            math::float3(0.f, 1.f, 0.f));
+            math::mat4f viewProjection = math::mat4f::perspective(fovy, aspect, 0.1f, 40.f) * inverse(view);
+            Mesh mesh = makeSphere(256);
+            std::vector<MeshLod> lods;
+            std::vector<std::shared_ptr<VertexArrayObject>> vaos;
+            for (auto& level : mesh.buildLods(lods)) {
+                vaos.push_back(level.createVAO(renderer_));
+            }
+            auto program = createProgram(colorShader);
+            auto states = createStates(true, false, true);
+
+            Scene full = begin("spheres_full", "8 spheres of 65k triangles at distances from 2 to 30");
+            Scene lod = begin("spheres_lod", "same spheres, level of detail by screen space error");
+            float pixelScale = (float)height_ / (2.f * std::tan(fovy * 0.5f * math::f::DEG_TO_RAD));
+            for (int i = 0; i < 8; i++) {
+                float z = -4.f * (float)i;
+                BenchUniforms uniforms;
+                uniforms.mvp = viewProjection * math::mat4f::translation(math::float3(i % 2 ? 1.2f : -1.2f, 0.f, z));
+                auto resources = createResources(uniforms);
+                full.draws.push_back({vaos[0], program, states, resources});
+
+                float distance = std::max(std::sqrt(1.44f + 0.25f + (2.f - z) * (2.f - z)) - 1.f, 0.1f);
+                size_t level = 0;
+                while (level + 1 < lods.size() && lods[level + 1].error * pixelScale / distance <= 1.f) {
+                    level++;
+                }
+                lod.draws.push_back({vaos[level], program, states, resources});
+            }
+            scenes.push_back(std::move(full));
+            scenes.push_back(std::move(lod));
+        }
+
+        {
+            // grid of spheres behind a wall, the occluded scene tests their bounds before drawing
+            auto view = math::mat4f::lookAt(math::float3(0.f, 0.f, 5.f), math::float3(0.f), math::float3(0.f, 1.f, 0.f));
+            math::mat4f viewProjection = math::mat4f::perspective(60.f, aspect, 0.1f, 20.f) * inverse(view);
+            Mesh wall = makeGrid(1, -3.f, -2.f, 3.f, 2.f, false);
+            Mesh sphere = makeSphere(64);
+            auto sphereVao = sphere.createVAO(renderer_);
+            auto program = createProgram(colorShader);
+            auto states = createStates(true, false, true);
+            BenchUniforms wallUniforms;
+            wallUniforms.mvp = viewProjection;
+            DrawItem wallItem{wall.createVAO(renderer_), program, states, createResources(wallUniforms)};
+
+            Scene full = begin("wall_full", "wall in front of 64 spheres of 4k triangles, all drawn");
+            Scene occluded = begin("wall_occluded", "same scene, spheres hidden by the wall skipped by occlusion culling");
+            full.draws.push_back(wallItem);
+            occluded.draws.push_back(wallItem);
+            for (int y = 0; y < 8; y++) {
+                for (int x = 0; x < 8; x++) {
+                    math::float3 center(-2.5f + (float)x * 5.f / 7.f, -1.5f + (float)y * 3.f / 7.f, -3.f);
+                    BenchUniforms uniforms;
+                    uniforms.mvp = viewProjection * math::mat4f::translation(center) * math::mat4f::scaling(0.25f);
+                    DrawItem item{sphereVao, program, states, createResources(uniforms)};
+                    item.bounds = math::AABB(center - math::float3(0.25f), center + math::float3(0.25f));
+                    full.draws.push_back(item);
+                    occluded.draws.push_back(std::move(item));
+                }
+            }
+
+            OccluderMesh occluder;
+            for (size_t i = 0; i < wall.vertices.size(); i += 3 + wall.attrSize) {
+                occluder.positions.emplace_back(wall.vertices[i], wall.vertices[i + 1], wall.vertices[i + 2]);
+            }
+            occluder.indices.assign(wall.indices.begin(), wall.indices.end());
+            occluded.occluders.push_back(std::move(occluder));
+            occluded.viewProjection = viewProjection;
+            scenes.push_back(std::move(full));
+            scenes.push_back(std::move(occluded));
+        }
+
+        {
+            Scene scene = begin("shadow_pass", "depth only 2048^2 target, 131k triangle height field", false);
+            scene.fbo = createFramebuffer(2048, 2048, false);
+            Mesh mesh = makeGrid(256, -10.f, -10.f, 10.f, 10.f, false, [](float u, float v) {
+                return 0.5f * std::sin(u * 25.f) * std::cos(v * 19.f);
+            });
+            BenchUniforms uniforms;
+            // light looking down at the xy plane (z up)
+            auto view = math::mat4f::lookAt(math::float3(0.f, -6.f, 12.f), math::float3(0.f), math::float3(0.f, 0.f, 1.f));
+            uniforms.mvp = math::mat4f::ortho(-12.f, 12.f, -12.f, 12.f, 1.f, 40.f) * inverse(view);
+            scene.draws.push_back({mesh.createVAO(renderer_), createProgram(depthShader),
+                                   createStates(true, false, false), createResources(uniforms)});
+            scenes.push_back(std::move(scene));
+        }
+
+        return scenes;
+    }
+
+private:
+    Renderer& renderer_;
+    int width_;
+    int height_;
+};
+
+struct SceneResult {
+    std::string name;
+    double msAvg = 0;
+    double msMin = 0;
+    double msP50 = 0;
+    double mtriPerSec = 0;
+    double mpixPerSec = 0;
+    RenderStats stats;
+};
+
+static RenderStats drawScene(RendererSoft& renderer, Scene& scene) {
+    static std::vector<IndexRange> ranges;
+    static OcclusionCuller occlusionCuller;
+    renderer.beginFrame();
+    if (!scene.occluders.empty()) {
+        Timer timer;
+        occlusionCuller.begin(scene.viewProjection);
+        for (auto& occluder : scene.occluders) {
+            occlusionCuller.addOccluder(occluder, math::mat4f(1.f));
+        }
+        occlusionCuller.rasterize();
+        size_t occluded = 0;
+        for (auto& item : scene.draws) {
+            item.occluded = !item.bounds.isEmpty() && !occlusionCuller.isVisible(item.bounds);
+            occluded += item.occluded ? 1 : 0;
+        }
+        renderer.addOcclusionStats(occluded, timer.elapseMillis());
+    }
+    renderer.beginRenderPass(scene.fbo, scene.clearStates);
+    for (auto& item : scene.draws) {
+        if (item.occluded) {
+            continue;
+        }
+        renderer.setVertexArrayObject(item.vao);
+        renderer.setShaderProgram(item.program);
+        renderer.setShaderResources(item.resources);
+        renderer.setPipelineStates(item.states);
+        if (item.instances) {
+            renderer.drawInstanced(item.instances);
+            continue;
+        }
+        if (item.meshlets.empty()) {
+            renderer.draw();
+            continue;
+        }
+        MeshletCullStats cullStats;
+        ranges.clear();
+        MeshletCuller::cull(item.meshlets.data(), item.meshlets.size(), item.mvp, item.eye, true, ranges, cullStats);
+        renderer.addMeshletStats(cullStats.tested, cullStats.frustumCulled, cullStats.coneCulled);
+        renderer.drawRanges(ranges);
+    }
+    renderer.endRenderPass();
+    renderer.endFrame();
+    return renderer.getStats();
+}
+
+static SceneResult runScene(RendererSoft& renderer, Scene& scene, int frames) {
+    drawScene(renderer, scene);  // warm-up, allocates per-draw buffers
+
+    RenderStatsHistory history((size_t)frames);
+    for (int i = 0; i < frames; i++) {
+        Timer timer;
+        RenderStats stats = drawScene(renderer, scene);
+        stats.frameMillis = timer.elapseMillis();
+        history.push(stats);
+    }
+
+    auto frameMillis = [](const RenderStats& s) { return s.frameMillis; };
+    SceneResult result;
+    result.name = scene.name;
+    result.stats = history.last();
+    result.msAvg = history.average(frameMillis);
+    result.msP50 = history.percentile(frameMillis, 0.5);
+    result.msMin = history.percentile(frameMillis, 0.0);
+    result.mtriPerSec = (double)result.stats.trianglesIn / (result.msAvg * 1000.0);
+    result.mpixPerSec = (double)result.stats.fragmentsShaded / (result.msAvg * 1000.0);
+    return result;
+}
+
+int main(int argc, char** argv) {
+    int frames = 20;
+    int width = 1280;
+    int height = 720;
+    int threads = 0;
+    std::string sceneFilter;
+    std::string output = "bench_results.json";
+    std::string tag;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue) {
+            frames = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--width" && hasValue) {
+            width = atoi(argv[++i]);
+        } else if (arg == "--height" && hasValue) {
+            height = atoi(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if (arg == "--scene" && hasValue) {
+            sceneFilter = argv[++i];
+        } else if (arg == "--output" && hasValue) {
+            output = argv[++i];
+        } else if (arg == "--tag" && hasValue) {
+            tag = argv[++i];
+        } else {
+            fprintf(stderr, "unknown option: %s\n", arg.c_str());
+            return -1;
+        }
+    }
+    if (width <= 0 || height <= 0) {
+        fprintf(stderr, "invalid frame size\n");
+        return -1;
+    }
+
+    RendererSoft renderer((size_t)std::max(0, threads));
+    SceneBuilder builder(renderer, width, height);
+    std::vector<Scene> scenes = builder.buildAll();
+
+    printf("SoftRenderAdv_bench %dx%d, %d frames\n", width, height, frames);
+    printf("%-16s %10s %10s %10s %10s %10s\n", "scene", "ms/frame", "p50 ms", "min ms", "Mtri/s", "Mpix/s");
+
+    json11::Json::array results;
+    for (auto& scene : scenes) {
+        if (!sceneFilter.empty() && scene.name != sceneFilter) {
+            continue;
+        }
+        SceneResult r = runScene(renderer, scene, frames);
+        printf("%-16s %10.2f %10.2f %10.2f %10.2f %10.2f\n", r.name.c_str(), r.msAvg, r.msP50, r.msMin,
+               r.mtriPerSec, r.mpixPerSec);
+        results.push_back(json11::Json::object{
+            {"name", r.name},
+            {"description", scene.description},
+            {"ms_per_frame", r.msAvg},
+            {"ms_p50", r.msP50},
+            {"ms_min", r.msMin},
+            {"mtri_per_sec", r.mtriPerSec},
+            {"mpix_per_sec", r.mpixPerSec},
+            {"draw_calls", (double)r.stats.drawCalls},
+            {"instances_drawn", (double)r.stats.instancesDrawn},
+            {"triangles", (double)r.stats.trianglesIn},
+            {"triangles_culled", (double)r.stats.trianglesCulled},
+            {"vertices_shaded", (double)r.stats.verticesShaded},
+            {"meshlets_tested", (double)r.stats.meshletsTested},
+            {"meshlets_culled", (double)(r.stats.meshletsFrustumCulled + r.stats.meshletsConeCulled)},
+            {"objects_occluded", (double)r.stats.objectsOccluded},
+            {"fragments_shaded", (double)r.stats.fragmentsShaded},
+            {"fragments_depth_killed", (double)r.stats.fragmentsDepthKilled},
+        });
+    }
+
+    json11::Json report = json11::Json::object{
+        {"tag", tag},
+        {"width", width},
+        {"height", height},
+        {"frames", frames},
+        {"threads", threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency())},
+        {"scenes", results},
+    };
+    if (!output.empty() && !FileUtils::writeText(output, report.dump())) {
+        fprintf(stderr, "write %s failed\n", output.c_str());
+        return -1;
+    }
+    return 0;
+}
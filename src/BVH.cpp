@@ -0,0 +1,468 @@
+#include "BVH.h"
+#include "base/Profiler.h"
+#include "base/Timer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <future>
+
+// half the surface area, only used in ratios
+static inline float halfArea(const math::AABB& box)
+{
+    math::float3 e = box.max - box.min;
+    return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+// distance where the ray enters the box, false if it misses the box within [0, maxDistance)
+static inline bool intersectRay(const math::float3& origin, const math::float3& invDir, const math::float3& lo,
+    const math::float3& hi, float maxDistance, float& enter)
+{
+    math::float3 t1 = (lo - origin) * invDir;
+    math::float3 t2 = (hi - origin) * invDir;
+    math::float3 tNear = min(t1, t2);
+    math::float3 tFar = max(t1, t2);
+    enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.f));
+    float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+    return enter <= exit && enter < maxDistance;
+}
+
+void BVH::build(const math::AABBArray& boxes, ThreadPool* pool)
+{
+    PROFILE_ZONE("BVH::build");
+    Timer timer;
+    clear();
+
+    objectLeaf_.assign(boxes.size(), UINT32_MAX);
+    buildEntries_.clear();
+    for (uint32_t i = 0; i < boxes.size(); i++)
+    {
+        math::AABB box = boxes.get(i);
+        if (!box.isEmpty())
+        {
+            buildEntries_.push_back({ box, i });
+        }
+    }
+
+    uint32_t count = (uint32_t)buildEntries_.size();
+    if (count > 0)
+    {
+        nodes_.resize(2 * count);
+        parents_.resize(2 * count);
+        parents_[0] = UINT32_MAX;
+        nodeCount_ = 1;
+
+        BuildTask root{ 0, 0, count };
+        computeBounds(root);
+        if (!pool || count < BVH_PARALLEL_MIN)
+        {
+            buildSubtree(root);
+        }
+        else
+        {
+            // split the top levels here, the subtrees below BVH_PARALLEL_MIN are independent tasks
+            std::vector<BuildTask> stack = { root };
+            std::vector<std::future<void>> futures;
+            while (!stack.empty())
+            {
+                BuildTask task = stack.back();
+                stack.pop_back();
+                if (task.end - task.begin < BVH_PARALLEL_MIN)
+                {
+                    futures.push_back(pool->pushTask([this, task]() { buildSubtree(task); }));
+                    continue;
+                }
+                BuildTask left, right;
+                if (split(task, left, right))
+                {
+                    stack.push_back(left);
+                    stack.push_back(right);
+                }
+            }
+            for (auto& f : futures)
+            {
+                f.wait();
+            }
+        }
+
+        nodes_.resize(nodeCount_);
+        parents_.resize(nodeCount_);
+        objects_.resize(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            objects_[i] = buildEntries_[i].object;
+        }
+        for (uint32_t i = 0; i < nodes_.size(); i++)
+        {
+            const BVHNode& node = nodes_[i];
+            for (uint32_t k = 0; k < node.count; k++)
+            {
+                objectLeaf_[objects_[node.leftFirst + k]] = i;
+            }
+        }
+    }
+    refitFlags_.assign(nodes_.size(), 0);
+
+    // the capacity of the scratch array is kept for the next build
+    buildEntries_.clear();
+
+    stats_.nodeCount = nodes_.size();
+    stats_.buildMillis = timer.elapseMillis();
+}
+
+void BVH::clear()
+{
+    nodes_.clear();
+    parents_.clear();
+    objects_.clear();
+    objectLeaf_.clear();
+    refitFlags_.clear();
+    nodeCount_ = 0;
+    stats_.nodeCount = 0;
+}
+
+uint32_t BVH::allocNodes()
+{
+    return nodeCount_.fetch_add(2);
+}
+
+void BVH::computeBounds(BuildTask& task) const
+{
+    // merged into locals, task may alias the entries as far as the compiler knows
+    math::AABB bounds;
+    math::AABB centerBounds;
+    for (uint32_t i = task.begin; i < task.end; i++)
+    {
+        bounds.merge(buildEntries_[i].box);
+        centerBounds.merge(buildEntries_[i].center());
+    }
+    task.bounds = bounds;
+    task.centerBounds = centerBounds;
+}
+
+bool BVH::split(const BuildTask& task, BuildTask& left, BuildTask& right)
+{
+    BVHNode& node = nodes_[task.node];
+    node.min = task.bounds.min;
+    node.max = task.bounds.max;
+    node.leftFirst = task.begin;
+    node.count = task.end - task.begin;
+    if (node.count <= BVH_MAX_LEAF_SIZE)
+    {
+        return false;
+    }
+
+    // binned SAH over the centers along the axis of largest spread, about as good as
+    // binning all three axes for a third of the memory traffic
+    math::float3 spread = task.centerBounds.max - task.centerBounds.min;
+    int axis = spread.x >= spread.y && spread.x >= spread.z ? 0 : (spread.y >= spread.z ? 1 : 2);
+    float lo = task.centerBounds.min[axis];
+    float scale = spread[axis] > 0.f ? (float)BVH_SAH_BINS / spread[axis] : 0.f;
+    auto binOf = [&](const BuildEntry& entry)
+    {
+        return std::min(BVH_SAH_BINS - 1, (uint32_t)((entry.center()[axis] - lo) * scale));
+    };
+
+    float bestCost = FLT_MAX;
+    uint32_t bestBin = 0;
+    math::AABB binBoxes[BVH_SAH_BINS];
+    math::AABB binCenters[BVH_SAH_BINS];
+    uint32_t binCounts[BVH_SAH_BINS] = {};
+    if (scale > 0.f)
+    {
+        // plain float arrays, merging into AABB arrays kept every bin in memory
+        float boxMin[3][BVH_SAH_BINS], boxMax[3][BVH_SAH_BINS];
+        float centerMin[3][BVH_SAH_BINS], centerMax[3][BVH_SAH_BINS];
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            std::fill_n(boxMin[c], BVH_SAH_BINS, FLT_MAX);
+            std::fill_n(boxMax[c], BVH_SAH_BINS, -FLT_MAX);
+            std::fill_n(centerMin[c], BVH_SAH_BINS, FLT_MAX);
+            std::fill_n(centerMax[c], BVH_SAH_BINS, -FLT_MAX);
+        }
+        for (uint32_t i = task.begin; i < task.end; i++)
+        {
+            const BuildEntry& entry = buildEntries_[i];
+            math::float3 center = entry.center();
+            uint32_t bin = std::min(BVH_SAH_BINS - 1, (uint32_t)((center[axis] - lo) * scale));
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                boxMin[c][bin] = std::min(boxMin[c][bin], entry.box.min[c]);
+                boxMax[c][bin] = std::max(boxMax[c][bin], entry.box.max[c]);
+                centerMin[c][bin] = std::min(centerMin[c][bin], center[c]);
+                centerMax[c][bin] = std::max(centerMax[c][bin], center[c]);
+            }
+            binCounts[bin]++;
+        }
+        for (uint32_t i = 0; i < BVH_SAH_BINS; i++)
+        {
+            if (binCounts[i] > 0)
+            {
+                binBoxes[i].merge(math::float3(boxMin[0][i], boxMin[1][i], boxMin[2][i]),
+                    math::float3(boxMax[0][i], boxMax[1][i], boxMax[2][i]));
+                binCenters[i].merge(math::float3(centerMin[0][i], centerMin[1][i], centerMin[2][i]),
+                    math::float3(centerMax[0][i], centerMax[1][i], centerMax[2][i]));
+            }
+        }
+
+        // cost of splitting before bin i, from a left sweep and a right sweep
+        float leftCost[BVH_SAH_BINS];
+        math::AABB box;
+        uint32_t cnt = 0;
+        for (uint32_t i = 0; i + 1 < BVH_SAH_BINS; i++)
+        {
+            box.merge(binBoxes[i]);
+            cnt += binCounts[i];
+            leftCost[i] = cnt > 0 ? halfArea(box) * (float)cnt : 0.f;
+        }
+        box = math::AABB();
+        cnt = 0;
+        for (uint32_t i = BVH_SAH_BINS - 1; i > 0; i--)
+        {
+            box.merge(binBoxes[i]);
+            cnt += binCounts[i];
+            float cost = leftCost[i - 1] + (cnt > 0 ? halfArea(box) * (float)cnt : 0.f);
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestBin = i;
+            }
+        }
+
+        // splitting is not worth it for small nodes when one leaf costs less
+        if (bestCost >= halfArea(task.bounds) * (float)node.count && node.count <= 4 * BVH_MAX_LEAF_SIZE)
+        {
+            return false;
+        }
+    }
+
+    uint32_t child = allocNodes();
+    node.leftFirst = child;
+    node.count = 0;
+    parents_[child] = task.node;
+    parents_[child + 1] = task.node;
+    left = { child, task.begin, task.begin };
+    right = { child + 1, task.begin, task.end };
+
+    if (bestBin > 0)
+    {
+        auto begin = buildEntries_.begin();
+        auto it = std::partition(begin + task.begin, begin + task.end,
+            [&](const BuildEntry& entry) { return binOf(entry) < bestBin; });
+        left.end = right.begin = (uint32_t)(it - begin);
+        for (uint32_t i = 0; i < BVH_SAH_BINS; i++)
+        {
+            BuildTask& side = i < bestBin ? left : right;
+            side.bounds.merge(binBoxes[i]);
+            side.centerBounds.merge(binCenters[i]);
+        }
+    }
+    else
+    {
+        // coincident centers, split in the middle
+        left.end = right.begin = task.begin + (task.end - task.begin) / 2;
+        computeBounds(left);
+        computeBounds(right);
+    }
+    return true;
+}
+
+void BVH::buildSubtree(const BuildTask& task)
+{
+    std::vector<BuildTask> stack = { task };
+    while (!stack.empty())
+    {
+        BuildTask current = stack.back();
+        stack.pop_back();
+        BuildTask left, right;
+        if (split(current, left, right))
+        {
+            stack.push_back(left);
+            stack.push_back(right);
+        }
+    }
+}
+
+void BVH::refit(const math::AABBArray& boxes, const uint8_t* changed)
+{
+    if (nodes_.empty())
+    {
+        return;
+    }
+    PROFILE_ZONE("BVH::refit");
+    Timer timer;
+
+    for (size_t i = 0; i < objectLeaf_.size(); i++)
+    {
+        if (changed[i] && objectLeaf_[i] != UINT32_MAX)
+        {
+            refitFlags_[objectLeaf_[i]] = 1;
+        }
+    }
+
+    // children are after their parent, a backward pass visits them first
+    size_t refitted = 0;
+    for (size_t i = nodes_.size(); i-- > 0;)
+    {
+        if (!refitFlags_[i])
+        {
+            continue;
+        }
+        refitFlags_[i] = 0;
+        refitted++;
+
+        BVHNode& node = nodes_[i];
+        math::AABB bounds;
+        if (node.count > 0)
+        {
+            for (uint32_t k = 0; k < node.count; k++)
+            {
+                bounds.merge(boxes.get(objects_[node.leftFirst + k]));
+            }
+        }
+        else
+        {
+            const BVHNode& l = nodes_[node.leftFirst];
+            const BVHNode& r = nodes_[node.leftFirst + 1];
+            bounds.merge(l.min, l.max);
+            bounds.merge(r.min, r.max);
+        }
+        node.min = bounds.min;
+        node.max = bounds.max;
+
+        if (parents_[i] != UINT32_MAX)
+        {
+            refitFlags_[parents_[i]] = 1;
+        }
+    }
+
+    stats_.refitNodes = refitted;
+    stats_.refitMillis = timer.elapseMillis();
+}
+
+void BVH::cull(const math::Frustum& frustum, const math::AABBArray& boxes, std::vector<uint32_t>& visible)
+{
+    if (nodes_.empty())
+    {
+        return;
+    }
+    PROFILE_ZONE("BVH::cull");
+    Timer timer;
+
+    // node index and whether it is entirely inside the frustum
+    std::vector<std::pair<uint32_t, bool>> stack;
+    stack.reserve(64);
+    stack.emplace_back(0, false);
+    while (!stack.empty())
+    {
+        uint32_t index = stack.back().first;
+        bool inside = stack.back().second;
+        stack.pop_back();
+
+        const BVHNode& node = nodes_[index];
+        if (!inside)
+        {
+            auto containment = frustum.classify((node.min + node.max) * 0.5f, (node.max - node.min) * 0.5f);
+            if (containment == math::Frustum::OUTSIDE)
+            {
+                continue;
+            }
+            inside = containment == math::Frustum::INSIDE;
+        }
+
+        if (node.count == 0)
+        {
+            stack.emplace_back(node.leftFirst + 1, inside);
+            stack.emplace_back(node.leftFirst, inside);
+            continue;
+        }
+        for (uint32_t k = 0; k < node.count; k++)
+        {
+            uint32_t obj = objects_[node.leftFirst + k];
+            if (inside || frustum.intersects(
+                math::float3(boxes.centerX[obj], boxes.centerY[obj], boxes.centerZ[obj]),
+                math::float3(boxes.extentX[obj], boxes.extentY[obj], boxes.extentZ[obj])))
+            {
+                visible.push_back(obj);
+            }
+        }
+    }
+
+    stats_.cullMillis = timer.elapseMillis();
+}
+
+int64_t BVH::pick(const math::float3& origin, const math::float3& direction, const math::AABBArray& boxes,
+    float maxDistance, float* distance)
+{
+    if (nodes_.empty())
+    {
+        return -1;
+    }
+    PROFILE_ZONE("BVH::pick");
+    Timer timer;
+
+    math::float3 invDir = math::float3(1.f) / direction;
+    int64_t nearest = -1;
+    float nearestDistance = maxDistance;
+
+    // nodes with their entry distance, the nearer child is visited first
+    std::vector<std::pair<uint32_t, float>> stack;
+    stack.reserve(64);
+    float enter;
+    if (intersectRay(origin, invDir, nodes_[0].min, nodes_[0].max, nearestDistance, enter))
+    {
+        stack.emplace_back(0, enter);
+    }
+    while (!stack.empty())
+    {
+        uint32_t index = stack.back().first;
+        float nodeEnter = stack.back().second;
+        stack.pop_back();
+        if (nodeEnter >= nearestDistance)
+        {
+            continue;
+        }
+
+        const BVHNode& node = nodes_[index];
+        if (node.count > 0)
+        {
+            for (uint32_t k = 0; k < node.count; k++)
+            {
+                uint32_t obj = objects_[node.leftFirst + k];
+                math::AABB box = boxes.get(obj);
+                if (intersectRay(origin, invDir, box.min, box.max, nearestDistance, enter))
+                {
+                    nearest = obj;
+                    nearestDistance = enter;
+                }
+            }
+            continue;
+        }
+
+        const BVHNode& l = nodes_[node.leftFirst];
+        const BVHNode& r = nodes_[node.leftFirst + 1];
+        float enterL, enterR;
+        bool hitL = intersectRay(origin, invDir, l.min, l.max, nearestDistance, enterL);
+        bool hitR = intersectRay(origin, invDir, r.min, r.max, nearestDistance, enterR);
+        if (hitL && hitR)
+        {
+            bool leftFirst = enterL <= enterR;
+            stack.emplace_back(leftFirst ? node.leftFirst + 1 : node.leftFirst, leftFirst ? enterR : enterL);
+            stack.emplace_back(leftFirst ? node.leftFirst : node.leftFirst + 1, leftFirst ? enterL : enterR);
+        }
+        else if (hitL)
+        {
+            stack.emplace_back(node.leftFirst, enterL);
+        }
+        else if (hitR)
+        {
+            stack.emplace_back(node.leftFirst + 1, enterR);
+        }
+    }
+
+    if (distance && nearest >= 0)
+    {
+        *distance = nearestDistance;
+    }
+    stats_.pickMillis = timer.elapseMillis();
+    return nearest;
+}
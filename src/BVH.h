@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+#include "base/MathInc.h"
+#include "base/ThreadPool.h"
+#include "math/aabb.h"
+#include "math/frustum.h"
+
+// subtrees with fewer objects are built by one task
+constexpr size_t BVH_PARALLEL_MIN = 16 * 1024;
+constexpr uint32_t BVH_MAX_LEAF_SIZE = 4;
+constexpr uint32_t BVH_SAH_BINS = 16;
+
+struct BVHNode
+{
+    math::float3 min;
+    uint32_t leftFirst;     // interior: left child, right is leftFirst + 1. leaf: first entry of objects
+    math::float3 max;
+    uint32_t count;         // objects of a leaf, 0 for interior nodes
+};
+
+struct BVHStats
+{
+    size_t nodeCount = 0;
+    size_t refitNodes = 0;      // nodes refitted by the latest refit
+
+    // latest calls
+    double buildMillis = 0;
+    double refitMillis = 0;
+    double cullMillis = 0;
+    double pickMillis = 0;
+};
+
+// Bounding volume hierarchy over the boxes of an AABBArray, built with binned SAH. Nodes are
+// allocated parent-before-child, so a refit is one backward pass over the nodes marked by the
+// changed objects. The tree keeps the indices of the array, rebuild it when they change.
+class BVH
+{
+public:
+    // empty boxes are skipped, large inputs are split into subtrees built on the pool
+    void build(const math::AABBArray& boxes, ThreadPool* pool = nullptr);
+    void clear();
+
+    // update the nodes above the objects with changed[i] != 0, changed has boxes.size() entries
+    void refit(const math::AABBArray& boxes, const uint8_t* changed);
+
+    // indices of the objects intersecting the frustum, appended in tree order
+    void cull(const math::Frustum& frustum, const math::AABBArray& boxes, std::vector<uint32_t>& visible);
+
+    // nearest object whose box is hit by the ray within [0, maxDistance), -1 if none
+    int64_t pick(const math::float3& origin, const math::float3& direction, const math::AABBArray& boxes,
+        float maxDistance, float* distance = nullptr);
+
+    inline bool isEmpty() const
+    {
+        return nodes_.empty();
+    }
+
+    inline const std::vector<BVHNode>& getNodes() const
+    {
+        return nodes_;
+    }
+
+    inline const BVHStats& getStats() const
+    {
+        return stats_;
+    }
+
+private:
+    // bounds of the boxes and of their centers, known from the bins of the parent split
+    struct BuildTask
+    {
+        uint32_t node;
+        uint32_t begin;
+        uint32_t end;
+        math::AABB bounds;
+        math::AABB centerBounds;
+    };
+
+    // partitioned in place, so the build streams through memory instead of reading boxes[objects_[i]]
+    struct BuildEntry
+    {
+        math::AABB box;
+        uint32_t object;
+
+        inline math::float3 center() const
+        {
+            return (box.min + box.max) * 0.5f;
+        }
+    };
+
+    uint32_t allocNodes();
+    bool split(const BuildTask& task, BuildTask& left, BuildTask& right);
+    void computeBounds(BuildTask& task) const;
+    void buildSubtree(const BuildTask& task);
+
+private:
+    std::vector<BVHNode> nodes_;
+    std::vector<uint32_t> parents_;
+    std::vector<uint32_t> objects_;     // object indices referenced by the leaves
+    std::vector<uint32_t> objectLeaf_;  // leaf of each object, UINT32_MAX for empty boxes
+    std::vector<uint8_t> refitFlags_;
+
+    // build scratch
+    std::vector<BuildEntry> buildEntries_;
+    std::atomic<uint32_t> nodeCount_{ 0 };
+
+    BVHStats stats_;
+};
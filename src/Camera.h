@@ -0,0 +1,49 @@
+#pragma once
+
+#include "base/MathInc.h"
+
+class Camera
+{
+public:
+    void setPerspective(float fovy, float aspect, float near, float far)
+    {
+        fovy_ = fovy;
+        aspect_ = aspect;
+        near_ = near;
+        far_ = far;
+        projection_ = math::mat4f::perspective(fovy, aspect, near, far);
+    }
+
+    void lookAt(const math::float3& eye, const math::float3& center, const math::float3& up)
+    {
+        eye_ = eye;
+        center_ = center;
+        up_ = up;
+        view_ = inverse(math::mat4f::lookAt(eye, center, up));
+    }
+
+    inline const math::mat4f& viewMatrix() const { return view_; }
+    inline const math::mat4f& projectionMatrix() const { return projection_; }
+
+    inline const math::float3& eye() const { return eye_; }
+    inline const math::float3& center() const { return center_; }
+    inline const math::float3& up() const { return up_; }
+
+    inline float fovy() const { return fovy_; }
+    inline float aspect() const { return aspect_; }
+    inline float near() const { return near_; }
+    inline float far() const { return far_; }
+
+private:
+    float fovy_ = 60.f;
+    float aspect_ = 1.f;
+    float near_ = 0.01f;
+    float far_ = 100.f;
+
+    math::float3 eye_ = { 0.f, 0.f, 3.f };
+    math::float3 center_ = { 0.f, 0.f, 0.f };
+    math::float3 up_ = { 0.f, 1.f, 0.f };
+
+    math::mat4f view_ = math::mat4f(1.f);
+    math::mat4f projection_ = math::mat4f(1.f);
+};
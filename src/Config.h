@@ -8,6 +8,7 @@
 
 const std::string ASSETS_DIR = "../assets/";
 const std::string SHADER_GLSL_DIR = "../shaders/GLSL/";
+const std::string CACHE_DIR = "../cache/";
 
 enum AAType
 {
@@ -16,6 +17,13 @@ enum AAType
     AAType_FXAA,
 };
 
+enum CaptureFormat
+{
+    CaptureFormat_PNG,
+    CaptureFormat_RGBA,
+    CaptureFormat_Y4M,
+};
+
 class Config
 {
 public:
@@ -32,6 +40,12 @@ public:
     bool showFloor = true;
 
     bool shadowMap = true;
+    // test the objects in the view frustum against a coarse depth buffer of the scene occluders
+    bool occlusionCulling = true;
+    // nodes whose bounds span occluderMinSize of the model bounds along two axes are occluders,
+    // unless their opaque meshes have more than occluderMaxTriangles at full detail
+    float occluderMinSize = 0.25f;
+    size_t occluderMaxTriangles = 4096;
     bool pbrIbl = false;
     bool mipmaps = false;
 
@@ -48,6 +62,31 @@ public:
 
     int aaType = AAType_NONE;
     int rendererType = Renderer_OPENGL;
+
+    // max bytes of decoded texture data uploaded per frame by TextureLoader
+    size_t textureUploadBudget = 16 * 1024 * 1024;
+    // store decoded textures with mipmaps in CACHE_DIR
+    bool textureCache = true;
+    // store loaded models in the binary mesh format in CACHE_DIR
+    bool meshCache = true;
+    // cached meshes with half texcoords, octahedral normals, snorm16 tangents and 16 bit indices
+    bool meshQuantize = true;
+    // split meshes into meshlets at load time for cluster culling, cached meshes always have them
+    bool meshlets = true;
+    // build a LOD chain for meshes at load time and draw the coarsest level whose error projects
+    // below lodErrorPixels, cached meshes always have the chain
+    bool meshLods = true;
+    float lodErrorPixels = 1.f;
+    // a coarser level is only taken once its error is below lodErrorPixels * (1 - lodHysteresis)
+    float lodHysteresis = 0.25f;
+    // copies of a mesh drawn whole at the same level of detail share one instanced draw
+    bool instancing = true;
+
+    // write every rendered frame to captureOutput, see FrameWriter::open
+    bool captureFrames = false;
+    std::string captureOutput = "./capture/";
+    int captureFormat = CaptureFormat_PNG;
+    int captureFps = 30;
 };
 
 
@@ -0,0 +1,210 @@
+#include "FrameWriter.h"
+#include "base/ImageUtils.h"
+#include "base/Logger.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+FrameWriter::FrameWriter(size_t threadCnt, size_t maxPending)
+    : maxPending_(std::max((size_t)1, maxPending))
+{
+    if (threadCnt == 0)
+    {
+        // leave one core for the render thread
+        threadCnt = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+    threadPool_ = std::make_shared<ThreadPool>(threadCnt);
+}
+
+FrameWriter::~FrameWriter()
+{
+    close();
+}
+
+bool FrameWriter::open(const std::string& output, CaptureFormat format, int fps)
+{
+    close();
+
+    format_ = format;
+    fps_ = std::max(1, fps);
+    frameIndex_ = 0;
+    nextWrite_ = 0;
+
+    if (output == "-")
+    {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        stream_ = stdout;
+        ownStream_ = false;
+        return true;
+    }
+
+    if (format_ == CaptureFormat_PNG)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(output, ec);
+        if (!std::filesystem::is_directory(output))
+        {
+            LOGE("FrameWriter::open failed: can not create directory %s", output.c_str());
+            return false;
+        }
+        dir_ = output;
+        return true;
+    }
+
+    stream_ = fopen(output.c_str(), "wb");
+    if (!stream_)
+    {
+        LOGE("FrameWriter::open failed: can not open file %s", output.c_str());
+        return false;
+    }
+    ownStream_ = true;
+    return true;
+}
+
+void FrameWriter::close()
+{
+    flush();
+    if (stream_ && ownStream_)
+    {
+        fclose(stream_);
+    }
+    stream_ = nullptr;
+    ownStream_ = false;
+    dir_.clear();
+}
+
+void FrameWriter::write(std::shared_ptr<Buffer<RGBA>> frame, bool flipY)
+{
+    if (!stream_ && dir_.empty())
+    {
+        LOGE("FrameWriter::write failed: output not opened");
+        return;
+    }
+
+    waitPending(maxPending_ - 1);
+
+    size_t seq = frameIndex_++;
+    pendingCnt_++;
+    threadPool_->pushTask([this, seq, frame = std::move(frame), flipY]() {
+        if (!stream_)
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "frame_%06d.png", (int)seq);
+            std::string path = dir_ + "/" + name;
+            int width = (int)frame->getWidth();
+            int height = (int)frame->getHeight();
+            ImageUtils::writeImage(path.c_str(), width, height, 4, frame->getRawDataPtr(), width * 4, flipY);
+        }
+        else
+        {
+            // encode in parallel, write in submission order
+            writeStream(seq, encode(*frame, flipY, seq == 0));
+        }
+        onFrameWritten();
+    });
+}
+
+void FrameWriter::flush()
+{
+    threadPool_->waitTasksFinish();
+    if (stream_)
+    {
+        fflush(stream_);
+    }
+}
+
+std::vector<uint8_t> FrameWriter::encode(const Buffer<RGBA>& frame, bool flipY, bool header)
+{
+    int width = (int)frame.getWidth();
+    int height = (int)frame.getHeight();
+    const RGBA* pixels = frame.getRawDataPtr();
+    auto row = [&](int y) { return pixels + (size_t)(flipY ? height - 1 - y : y) * width; };
+
+    std::vector<uint8_t> bytes;
+    switch (format_)
+    {
+    case CaptureFormat_PNG:
+        bytes = ImageUtils::encodePNG(width, height, 4, pixels, width * 4, flipY);
+        break;
+    case CaptureFormat_RGBA:
+    {
+        bytes.resize((size_t)width * height * sizeof(RGBA));
+        for (int y = 0; y < height; y++)
+        {
+            memcpy(bytes.data() + (size_t)y * width * sizeof(RGBA), row(y), width * sizeof(RGBA));
+        }
+        break;
+    }
+    case CaptureFormat_Y4M:
+    {
+        char text[128];
+        int len = 0;
+        if (header)
+        {
+            len = snprintf(text, sizeof(text), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps_);
+        }
+        len += snprintf(text + len, sizeof(text) - len, "FRAME\n");
+
+        // BT.601 limited range, planar Y, U, V
+        size_t planeSize = (size_t)width * height;
+        bytes.resize(len + planeSize * 3);
+        memcpy(bytes.data(), text, len);
+        uint8_t* yPlane = bytes.data() + len;
+        uint8_t* uPlane = yPlane + planeSize;
+        uint8_t* vPlane = uPlane + planeSize;
+        for (int y = 0; y < height; y++)
+        {
+            const RGBA* src = row(y);
+            size_t offset = (size_t)y * width;
+            for (int x = 0; x < width; x++)
+            {
+                int r = src[x].r;
+                int g = src[x].g;
+                int b = src[x].b;
+                yPlane[offset + x] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                uPlane[offset + x] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                vPlane[offset + x] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+        }
+        break;
+    }
+    }
+    return bytes;
+}
+
+void FrameWriter::writeStream(size_t seq, const std::vector<uint8_t>& bytes)
+{
+    // tasks are started in submission order, so the frame before seq is already running or done
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&]() { return nextWrite_ == seq; });
+    if (fwrite(bytes.data(), 1, bytes.size(), stream_) != bytes.size())
+    {
+        LOGE("FrameWriter: write frame %d failed", (int)seq);
+    }
+    nextWrite_++;
+    lock.unlock();
+    cond_.notify_all();
+}
+
+void FrameWriter::waitPending(size_t maxPending)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&]() { return pendingCnt_ <= maxPending; });
+}
+
+void FrameWriter::onFrameWritten()
+{
+    writtenCnt_++;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pendingCnt_--;
+    }
+    cond_.notify_all();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <cstdio>
+#include <condition_variable>
+
+#include "base/Buffer.h"
+#include "base/MathInc.h"
+#include "base/ThreadPool.h"
+#include "Config.h"
+
+// encode and write captured frames on worker threads
+class FrameWriter
+{
+public:
+    explicit FrameWriter(size_t threadCnt = 0, size_t maxPending = 16);
+    ~FrameWriter();
+
+    // output "-" writes a stream to stdout (PNG frames are concatenated, e.g. for ffmpeg image2pipe).
+    // otherwise PNG output is a directory receiving frame_xxxxxx.png, RGBA and Y4M output is a single file.
+    // Y4M is a YUV4MPEG2 4:4:4 stream with fps in its header.
+    bool open(const std::string& output, CaptureFormat format, int fps = 30);
+
+    // flush pending frames and close the output file
+    void close();
+
+    // encode frame on a worker thread, blocks only when more than maxPending frames are queued.
+    // stream outputs are written in the order of write() calls
+    void write(std::shared_ptr<Buffer<RGBA>> frame, bool flipY);
+
+    // wait for all queued frames written
+    void flush();
+
+    inline size_t getPendingCount() const
+    {
+        return pendingCnt_;
+    }
+
+    inline size_t getWrittenCount() const
+    {
+        return writtenCnt_;
+    }
+
+private:
+    std::vector<uint8_t> encode(const Buffer<RGBA>& frame, bool flipY, bool header);
+    void writeStream(size_t seq, const std::vector<uint8_t>& bytes);
+
+    void waitPending(size_t maxPending);
+    void onFrameWritten();
+
+private:
+    std::shared_ptr<ThreadPool> threadPool_;
+    size_t maxPending_;
+    std::atomic<size_t> pendingCnt_{ 0 };
+    std::atomic<size_t> writtenCnt_{ 0 };
+    std::mutex mutex_;
+    std::condition_variable cond_;
+
+    CaptureFormat format_ = CaptureFormat_PNG;
+    int fps_ = 30;
+    std::string dir_;
+    FILE* stream_ = nullptr;
+    bool ownStream_ = false;
+
+    // sequence of submitted frames and the next one allowed to write to the stream
+    size_t frameIndex_ = 0;
+    size_t nextWrite_ = 0;
+};
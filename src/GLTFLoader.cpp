@@ -0,0 +1,976 @@
+#include "GLTFLoader.h"
+#include "base/Logger.h"
+#include "base/Profiler.h"
+#include "base/Timer.h"
+#include "math/transform.h"
+#include "render/VertexUtils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <json11.hpp>
+
+// glb container, little endian
+constexpr uint32_t GLB_MAGIC = 0x46546C67;          // "glTF"
+constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;     // "JSON"
+constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;      // "BIN\0"
+
+enum GLTFComponentType
+{
+    GLTF_BYTE = 5120,
+    GLTF_UNSIGNED_BYTE = 5121,
+    GLTF_SHORT = 5122,
+    GLTF_UNSIGNED_SHORT = 5123,
+    GLTF_UNSIGNED_INT = 5125,
+    GLTF_FLOAT = 5126,
+};
+
+constexpr int GLTF_MODE_TRIANGLES = 4;
+
+// glTF name of each ModelAttribute
+static const char* ATTRIBUTE_NAMES[ModelAttribute_COUNT] = { "POSITION", "TEXCOORD_0", "NORMAL", "TANGENT" };
+
+namespace
+{
+
+struct BufferRange
+{
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+struct BufferView
+{
+    int buffer = -1;
+    size_t byteOffset = 0;
+    size_t byteLength = 0;
+    size_t byteStride = 0;  // 0: tightly packed
+};
+
+struct Accessor
+{
+    int bufferView = -1;    // -1: all zeros, only sparse values
+    size_t byteOffset = 0;
+    int componentType = 0;
+    bool normalized = false;
+    size_t count = 0;
+    uint32_t components = 0;
+
+    bool hasBounds = false;
+    math::float3 min;
+    math::float3 max;
+
+    size_t sparseCount = 0;
+    int sparseIndicesView = -1;
+    size_t sparseIndicesOffset = 0;
+    int sparseIndicesType = 0;
+    int sparseValuesView = -1;
+    size_t sparseValuesOffset = 0;
+};
+
+struct LoadContext
+{
+    std::string dir;
+    std::vector<BufferRange> buffers;
+    std::vector<BufferView> views;
+    std::vector<Accessor> accessors;
+};
+
+}
+
+static size_t componentSize(int componentType)
+{
+    switch (componentType)
+    {
+        case GLTF_BYTE:
+        case GLTF_UNSIGNED_BYTE:
+            return 1;
+        case GLTF_SHORT:
+        case GLTF_UNSIGNED_SHORT:
+            return 2;
+        case GLTF_UNSIGNED_INT:
+        case GLTF_FLOAT:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static uint32_t typeComponents(const std::string& type)
+{
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    if (type == "MAT2") return 4;
+    if (type == "MAT3") return 9;
+    if (type == "MAT4") return 16;
+    return 0;
+}
+
+static bool decodeBase64(const std::string& text, size_t begin, std::vector<uint8_t>& out)
+{
+    static int8_t table[256];
+    static bool tableReady = []()
+    {
+        const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        memset(table, -1, sizeof(table));
+        for (int i = 0; i < 64; i++)
+        {
+            table[(uint8_t)alphabet[i]] = (int8_t)i;
+        }
+        return true;
+    }();
+    (void)tableReady;
+
+    out.clear();
+    out.reserve((text.size() - begin) / 4 * 3);
+    uint32_t bits = 0;
+    int bitCount = 0;
+    for (size_t i = begin; i < text.size() && text[i] != '='; i++)
+    {
+        int8_t value = table[(uint8_t)text[i]];
+        if (value < 0)
+        {
+            return false;
+        }
+        bits = (bits << 6) | (uint32_t)value;
+        bitCount += 6;
+        if (bitCount >= 8)
+        {
+            bitCount -= 8;
+            out.push_back((uint8_t)(bits >> bitCount));
+        }
+    }
+    return true;
+}
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// relative uris may be percent encoded, false on a malformed escape
+static bool decodeUri(const std::string& uri, std::string& out)
+{
+    out.clear();
+    for (size_t i = 0; i < uri.size(); i++)
+    {
+        if (uri[i] != '%')
+        {
+            out.push_back(uri[i]);
+            continue;
+        }
+        int high = i + 2 < uri.size() ? hexValue(uri[i + 1]) : -1;
+        int low = i + 2 < uri.size() ? hexValue(uri[i + 2]) : -1;
+        if (high < 0 || low < 0)
+        {
+            return false;
+        }
+        out.push_back((char)(high * 16 + low));
+        i += 2;
+    }
+    return true;
+}
+
+static bool readGLB(const MappedFile& file, std::string& json, BufferRange& bin)
+{
+    const uint8_t* data = file.data();
+    size_t size = file.size();
+    uint32_t header[3];
+    if (size < sizeof(header) + 8)
+    {
+        return false;
+    }
+    memcpy(header, data, sizeof(header));
+    if (header[0] != GLB_MAGIC || header[1] != 2 || header[2] > size)
+    {
+        LOGE("GLTFLoader: invalid glb header");
+        return false;
+    }
+
+    size_t offset = sizeof(header);
+    size = header[2];
+    while (offset + 8 <= size)
+    {
+        uint32_t chunk[2];
+        memcpy(chunk, data + offset, sizeof(chunk));
+        offset += sizeof(chunk);
+        if (offset + chunk[0] > size)
+        {
+            LOGE("GLTFLoader: glb chunk out of range");
+            return false;
+        }
+        if (chunk[1] == GLB_CHUNK_JSON)
+        {
+            json.assign((const char*)data + offset, chunk[0]);
+        }
+        else if (chunk[1] == GLB_CHUNK_BIN && !bin.data)
+        {
+            bin.data = data + offset;
+            bin.size = chunk[0];
+        }
+        // chunks are padded to 4 bytes
+        offset += (chunk[0] + 3) & ~3u;
+    }
+    return !json.empty();
+}
+
+static bool parseAccessor(const json11::Json& json, const LoadContext& ctx, Accessor& acc)
+{
+    acc.bufferView = json["bufferView"].is_number() ? json["bufferView"].int_value() : -1;
+    acc.byteOffset = (size_t)json["byteOffset"].int_value();
+    acc.componentType = json["componentType"].int_value();
+    acc.normalized = json["normalized"].bool_value();
+    acc.count = (size_t)json["count"].int_value();
+    acc.components = typeComponents(json["type"].string_value());
+    size_t elementSize = componentSize(acc.componentType) * acc.components;
+    if (elementSize == 0 || acc.count == 0)
+    {
+        return false;
+    }
+
+    auto& min = json["min"].array_items();
+    auto& max = json["max"].array_items();
+    if (acc.components == 3 && min.size() == 3 && max.size() == 3)
+    {
+        acc.hasBounds = true;
+        acc.min = math::float3(min[0].number_value(), min[1].number_value(), min[2].number_value());
+        acc.max = math::float3(max[0].number_value(), max[1].number_value(), max[2].number_value());
+    }
+
+    // every element must lie inside its view, checked once here
+    auto inView = [&](int view, size_t offset, size_t count, size_t elemSize, size_t stride)
+    {
+        if (view < 0 || view >= (int)ctx.views.size())
+        {
+            return false;
+        }
+        return offset + (count - 1) * stride + elemSize <= ctx.views[view].byteLength;
+    };
+    if (acc.bufferView >= 0)
+    {
+        size_t stride = acc.bufferView < (int)ctx.views.size() && ctx.views[acc.bufferView].byteStride
+            ? ctx.views[acc.bufferView].byteStride : elementSize;
+        if (!inView(acc.bufferView, acc.byteOffset, acc.count, elementSize, stride))
+        {
+            return false;
+        }
+    }
+
+    auto& sparse = json["sparse"];
+    if (sparse.is_object())
+    {
+        acc.sparseCount = (size_t)sparse["count"].int_value();
+        acc.sparseIndicesView = sparse["indices"]["bufferView"].int_value();
+        acc.sparseIndicesOffset = (size_t)sparse["indices"]["byteOffset"].int_value();
+        acc.sparseIndicesType = sparse["indices"]["componentType"].int_value();
+        acc.sparseValuesView = sparse["values"]["bufferView"].int_value();
+        acc.sparseValuesOffset = (size_t)sparse["values"]["byteOffset"].int_value();
+        size_t indexSize = componentSize(acc.sparseIndicesType);
+        if (acc.sparseCount == 0 || indexSize == 0
+            || !inView(acc.sparseIndicesView, acc.sparseIndicesOffset, acc.sparseCount, indexSize, indexSize)
+            || !inView(acc.sparseValuesView, acc.sparseValuesOffset, acc.sparseCount, elementSize, elementSize))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline const uint8_t* viewData(const LoadContext& ctx, int view, size_t offset)
+{
+    const BufferView& v = ctx.views[view];
+    return ctx.buffers[v.buffer].data + v.byteOffset + offset;
+}
+
+// component c of an element, normalized integers are mapped to [0, 1] or [-1, 1]
+static inline float readComponent(const uint8_t* p, int componentType, bool normalized)
+{
+    switch (componentType)
+    {
+        case GLTF_FLOAT:
+        {
+            float v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+        case GLTF_UNSIGNED_BYTE:
+            return normalized ? (float)*p / 255.f : (float)*p;
+        case GLTF_BYTE:
+            return normalized ? std::max((float)(int8_t)*p / 127.f, -1.f) : (float)(int8_t)*p;
+        case GLTF_UNSIGNED_SHORT:
+        {
+            uint16_t v;
+            memcpy(&v, p, sizeof(v));
+            return normalized ? (float)v / 65535.f : (float)v;
+        }
+        case GLTF_SHORT:
+        {
+            int16_t v;
+            memcpy(&v, p, sizeof(v));
+            return normalized ? std::max((float)v / 32767.f, -1.f) : (float)v;
+        }
+        case GLTF_UNSIGNED_INT:
+        {
+            uint32_t v;
+            memcpy(&v, p, sizeof(v));
+            return (float)v;
+        }
+        default:
+            return 0.f;
+    }
+}
+
+static inline uint32_t readIndex(const uint8_t* p, int componentType)
+{
+    switch (componentType)
+    {
+        case GLTF_UNSIGNED_BYTE:
+            return *p;
+        case GLTF_UNSIGNED_SHORT:
+        {
+            uint16_t v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+        case GLTF_UNSIGNED_INT:
+        {
+            uint32_t v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+        default:
+            return UINT32_MAX;
+    }
+}
+
+// write the elements as floats, element i at out + i * outStride floats
+static void readFloats(const LoadContext& ctx, const Accessor& acc, float* out, size_t outStride)
+{
+    size_t compSize = componentSize(acc.componentType);
+    size_t elementSize = compSize * acc.components;
+    if (acc.bufferView < 0)
+    {
+        for (size_t i = 0; i < acc.count; i++)
+        {
+            std::fill_n(out + i * outStride, acc.components, 0.f);
+        }
+    }
+    else
+    {
+        size_t stride = ctx.views[acc.bufferView].byteStride ? ctx.views[acc.bufferView].byteStride : elementSize;
+        const uint8_t* src = viewData(ctx, acc.bufferView, acc.byteOffset);
+        if (acc.componentType == GLTF_FLOAT)
+        {
+            for (size_t i = 0; i < acc.count; i++)
+            {
+                memcpy(out + i * outStride, src + i * stride, elementSize);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < acc.count; i++)
+            {
+                for (uint32_t c = 0; c < acc.components; c++)
+                {
+                    out[i * outStride + c] = readComponent(src + i * stride + c * compSize, acc.componentType,
+                        acc.normalized);
+                }
+            }
+        }
+    }
+
+    // sparse values replace the base elements
+    const uint8_t* indices = acc.sparseCount ? viewData(ctx, acc.sparseIndicesView, acc.sparseIndicesOffset) : nullptr;
+    const uint8_t* values = acc.sparseCount ? viewData(ctx, acc.sparseValuesView, acc.sparseValuesOffset) : nullptr;
+    size_t indexSize = componentSize(acc.sparseIndicesType);
+    for (size_t i = 0; i < acc.sparseCount; i++)
+    {
+        uint32_t index = readIndex(indices + i * indexSize, acc.sparseIndicesType);
+        if (index >= acc.count)
+        {
+            continue;
+        }
+        for (uint32_t c = 0; c < acc.components; c++)
+        {
+            out[index * outStride + c] = readComponent(values + i * elementSize + c * compSize, acc.componentType,
+                acc.normalized);
+        }
+    }
+}
+
+// float and normalized integer accessors map to vertex attribute types
+static bool vertexAttributeType(const Accessor& acc, VertexAttributeType& type)
+{
+    if (acc.componentType == GLTF_FLOAT)
+    {
+        type = VertexAttr_FLOAT;
+        return true;
+    }
+    if (!acc.normalized)
+    {
+        return false;
+    }
+    switch (acc.componentType)
+    {
+        case GLTF_BYTE:             type = VertexAttr_SNORM8;   return true;
+        case GLTF_UNSIGNED_BYTE:    type = VertexAttr_UNORM8;   return true;
+        case GLTF_SHORT:            type = VertexAttr_SNORM16;  return true;
+        case GLTF_UNSIGNED_SHORT:   type = VertexAttr_UNORM16;  return true;
+        default:
+            return false;
+    }
+}
+
+static math::mat4f parseNodeMatrix(const json11::Json& node)
+{
+    auto& matrix = node["matrix"].array_items();
+    if (matrix.size() == 16)
+    {
+        // column major like mat4f
+        math::mat4f m;
+        for (int c = 0; c < 4; c++)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                m[c][r] = (float)matrix[c * 4 + r].number_value();
+            }
+        }
+        return m;
+    }
+
+    math::float3 t(0.f);
+    math::quatf r(1.f, 0.f, 0.f, 0.f);
+    math::float3 s(1.f);
+    auto& translation = node["translation"].array_items();
+    auto& rotation = node["rotation"].array_items();
+    auto& scale = node["scale"].array_items();
+    if (translation.size() == 3)
+    {
+        t = math::float3(translation[0].number_value(), translation[1].number_value(), translation[2].number_value());
+    }
+    if (rotation.size() == 4)
+    {
+        // glTF stores x, y, z, w
+        r = math::quatf(rotation[3].number_value(), rotation[0].number_value(), rotation[1].number_value(),
+            rotation[2].number_value());
+    }
+    if (scale.size() == 3)
+    {
+        s = math::float3(scale[0].number_value(), scale[1].number_value(), scale[2].number_value());
+    }
+    return math::mat4f::translation(t) * math::mat4f(r) * math::mat4f::scaling(s);
+}
+
+std::shared_ptr<Model> GLTFLoader::load(const std::string& path)
+{
+    PROFILE_ZONE("GLTFLoader::load");
+    Timer totalTimer;
+    Timer timer;
+
+    auto model = std::make_shared<Model>();
+    model->path = path;
+    ModelLoadStats& stats = model->stats;
+
+    LoadContext ctx;
+    size_t slash = path.find_last_of("/\\");
+    ctx.dir = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+
+    // json and the glb binary chunk
+    auto file = FileUtils::mapFile(path, MapAdvice_SEQUENTIAL);
+    if (!file)
+    {
+        return nullptr;
+    }
+    model->files_.push_back(file);
+
+    std::string jsonText;
+    BufferRange glbBin;
+    bool isGLB = file->size() >= 4 && memcmp(file->data(), &GLB_MAGIC, 4) == 0;
+    if (isGLB)
+    {
+        if (!readGLB(*file, jsonText, glbBin))
+        {
+            LOGE("GLTFLoader: read glb failed: %s", path.c_str());
+            return nullptr;
+        }
+    }
+    else
+    {
+        jsonText.assign(file->view());
+    }
+
+    std::string err;
+    json11::Json json = json11::Json::parse(jsonText, err);
+    if (!err.empty())
+    {
+        LOGE("GLTFLoader: parse json failed: %s, %s", path.c_str(), err.c_str());
+        return nullptr;
+    }
+    if (json["asset"]["version"].string_value().compare(0, 1, "2") != 0)
+    {
+        LOGE("GLTFLoader: unsupported glTF version: %s", json["asset"]["version"].string_value().c_str());
+        return nullptr;
+    }
+
+    // buffers: glb chunk, base64 data uri or a mapped external file
+    for (auto& buffer : json["buffers"].array_items())
+    {
+        const std::string& uri = buffer["uri"].string_value();
+        BufferRange range;
+        if (uri.empty())
+        {
+            range = glbBin;
+        }
+        else if (uri.compare(0, 5, "data:") == 0)
+        {
+            size_t comma = uri.find(',');
+            std::vector<uint8_t> bytes;
+            if (comma == std::string::npos || !decodeBase64(uri, comma + 1, bytes))
+            {
+                LOGE("GLTFLoader: invalid data uri buffer");
+                return nullptr;
+            }
+            model->buffers_.push_back(std::move(bytes));
+            range = { model->buffers_.back().data(), model->buffers_.back().size() };
+        }
+        else
+        {
+            std::string bufferPath;
+            if (!decodeUri(uri, bufferPath))
+            {
+                LOGE("GLTFLoader: invalid buffer uri: %s", uri.c_str());
+                return nullptr;
+            }
+            auto bufferFile = FileUtils::mapFile(ctx.dir + bufferPath, MapAdvice_WILLNEED);
+            if (!bufferFile)
+            {
+                return nullptr;
+            }
+            range = { bufferFile->data(), bufferFile->size() };
+            model->files_.push_back(std::move(bufferFile));
+        }
+        if ((size_t)buffer["byteLength"].int_value() > range.size)
+        {
+            LOGE("GLTFLoader: buffer shorter than its byteLength");
+            return nullptr;
+        }
+        ctx.buffers.push_back(range);
+    }
+
+    for (auto& view : json["bufferViews"].array_items())
+    {
+        BufferView v;
+        v.buffer = view["buffer"].int_value();
+        v.byteOffset = (size_t)view["byteOffset"].int_value();
+        v.byteLength = (size_t)view["byteLength"].int_value();
+        v.byteStride = (size_t)view["byteStride"].int_value();
+        if (v.buffer < 0 || v.buffer >= (int)ctx.buffers.size() || v.byteOffset + v.byteLength > ctx.buffers[v.buffer].size)
+        {
+            LOGE("GLTFLoader: bufferView out of range");
+            return nullptr;
+        }
+        ctx.views.push_back(v);
+    }
+
+    for (auto& accessor : json["accessors"].array_items())
+    {
+        Accessor acc;
+        if (!parseAccessor(accessor, ctx, acc))
+        {
+            LOGE("GLTFLoader: invalid accessor %d", (int)ctx.accessors.size());
+            return nullptr;
+        }
+        ctx.accessors.push_back(acc);
+    }
+    stats.parseMillis = timer.elapseMillis();
+
+    // images are not decoded, nothing samples them yet. external files keep their path for the
+    // texture loader, embedded ones (buffer views and data uris) only their name
+    auto& images = json["images"].array_items();
+    model->images.resize(images.size());
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        const std::string& uri = images[i]["uri"].string_value();
+        bool embedded = uri.empty() || uri.compare(0, 5, "data:") == 0;
+        model->images[i].name = images[i]["name"].is_string() ? images[i]["name"].string_value()
+            : (embedded ? "image " + std::to_string(i) : uri);
+        if (!embedded)
+        {
+            std::string imagePath;
+            if (!decodeUri(uri, imagePath))
+            {
+                LOGE("GLTFLoader: invalid image uri: %s", uri.c_str());
+                return nullptr;
+            }
+            model->images[i].path = ctx.dir + imagePath;
+        }
+    }
+
+    // materials reference images through textures
+    std::vector<int> textureImages;
+    for (auto& texture : json["textures"].array_items())
+    {
+        int source = texture["source"].is_number() ? texture["source"].int_value() : -1;
+        textureImages.push_back(source >= 0 && source < (int)images.size() ? source : -1);
+    }
+    auto imageOf = [&](const json11::Json& textureInfo)
+    {
+        int texture = textureInfo["index"].is_number() ? textureInfo["index"].int_value() : -1;
+        return texture >= 0 && texture < (int)textureImages.size() ? textureImages[texture] : -1;
+    };
+    for (auto& material : json["materials"].array_items())
+    {
+        ModelMaterial m;
+        auto& pbr = material["pbrMetallicRoughness"];
+        auto& baseColor = pbr["baseColorFactor"].array_items();
+        if (baseColor.size() == 4)
+        {
+            m.baseColorFactor = math::float4(baseColor[0].number_value(), baseColor[1].number_value(),
+                baseColor[2].number_value(), baseColor[3].number_value());
+        }
+        auto& emissive = material["emissiveFactor"].array_items();
+        if (emissive.size() == 3)
+        {
+            m.emissiveFactor = math::float3(emissive[0].number_value(), emissive[1].number_value(),
+                emissive[2].number_value());
+        }
+        if (pbr["metallicFactor"].is_number())
+        {
+            m.metallicFactor = (float)pbr["metallicFactor"].number_value();
+        }
+        if (pbr["roughnessFactor"].is_number())
+        {
+            m.roughnessFactor = (float)pbr["roughnessFactor"].number_value();
+        }
+        const std::string& alphaMode = material["alphaMode"].string_value();
+        m.alphaMode = alphaMode == "MASK" ? AlphaMode_MASK : (alphaMode == "BLEND" ? AlphaMode_BLEND : AlphaMode_OPAQUE);
+        if (material["alphaCutoff"].is_number())
+        {
+            m.alphaCutoff = (float)material["alphaCutoff"].number_value();
+        }
+        m.doubleSided = material["doubleSided"].bool_value();
+        m.baseColorImage = imageOf(pbr["baseColorTexture"]);
+        m.metallicRoughnessImage = imageOf(pbr["metallicRoughnessTexture"]);
+        m.normalImage = imageOf(material["normalTexture"]);
+        m.occlusionImage = imageOf(material["occlusionTexture"]);
+        m.emissiveImage = imageOf(material["emissiveTexture"]);
+        model->materials.push_back(m);
+    }
+
+    // one ModelMesh per triangle primitive, meshPrimitives[gltf mesh] lists them
+    timer.start();
+    auto& meshes = json["meshes"].array_items();
+    std::vector<std::vector<uint32_t>> meshPrimitives(meshes.size());
+    for (size_t meshIdx = 0; meshIdx < meshes.size(); meshIdx++)
+    {
+        for (auto& primitive : meshes[meshIdx]["primitives"].array_items())
+        {
+            int mode = primitive["mode"].is_number() ? primitive["mode"].int_value() : GLTF_MODE_TRIANGLES;
+            if (mode != GLTF_MODE_TRIANGLES)
+            {
+                LOGW("GLTFLoader: skip primitive of mesh %d, mode %d is not a triangle list", (int)meshIdx, mode);
+                continue;
+            }
+
+            const Accessor* attributes[ModelAttribute_COUNT] = {};
+            for (int k = 0; k < ModelAttribute_COUNT; k++)
+            {
+                auto& index = primitive["attributes"][ATTRIBUTE_NAMES[k]];
+                if (!index.is_number() || index.int_value() < 0 || index.int_value() >= (int)ctx.accessors.size())
+                {
+                    continue;
+                }
+                const Accessor& acc = ctx.accessors[index.int_value()];
+                if (acc.components == MODEL_ATTRIBUTE_SIZES[k])
+                {
+                    attributes[k] = &acc;
+                }
+            }
+            const Accessor* position = attributes[ModelAttribute_POSITION];
+            if (!position)
+            {
+                LOGW("GLTFLoader: skip primitive of mesh %d without positions", (int)meshIdx);
+                continue;
+            }
+
+            ModelMesh mesh;
+            mesh.vertexCount = position->count;
+            mesh.material = primitive["material"].is_number() ? primitive["material"].int_value() : -1;
+            if (mesh.material >= (int)model->materials.size())
+            {
+                mesh.material = -1;
+            }
+            for (int k = 0; k < ModelAttribute_COUNT; k++)
+            {
+                if (attributes[k] && attributes[k]->count != mesh.vertexCount)
+                {
+                    LOGW("GLTFLoader: ignore %s of mesh %d, count mismatch", ATTRIBUTE_NAMES[k], (int)meshIdx);
+                    attributes[k] = nullptr;
+                }
+                if (attributes[k])
+                {
+                    mesh.attributeMask |= 1u << k;
+                }
+            }
+
+            // zero-copy when float or normalized attributes interleave with one stride, or are packed
+            // back to back, in a range [base, base + count * vertexSize) of one buffer
+            auto& desc = mesh.vertexes.vertexesDesc;
+            int buffer = -1;
+            size_t base = SIZE_MAX;
+            size_t end = 0;
+            size_t packedSize = 0;
+            size_t commonStride = 0;
+            bool zeroCopy = true;
+            for (int k = 0; k < ModelAttribute_COUNT && zeroCopy; k++)
+            {
+                const Accessor* acc = attributes[k];
+                if (!acc)
+                {
+                    continue;
+                }
+                VertexAttributeType type;
+                if (!vertexAttributeType(*acc, type) || acc->sparseCount > 0 || acc->bufferView < 0)
+                {
+                    zeroCopy = false;
+                    break;
+                }
+                const BufferView& view = ctx.views[acc->bufferView];
+                size_t elementSize = componentSize(acc->componentType) * acc->components;
+                size_t stride = view.byteStride ? view.byteStride : elementSize;
+                size_t start = view.byteOffset + acc->byteOffset;
+                zeroCopy = (buffer < 0 || buffer == view.buffer) && start % sizeof(float) == 0
+                    && stride % sizeof(float) == 0;
+                commonStride = commonStride == 0 || commonStride == stride ? stride : SIZE_MAX;
+                buffer = view.buffer;
+                base = std::min(base, start);
+                end = std::max(end, start + (acc->count - 1) * stride + elementSize);
+                packedSize += elementSize;
+                desc.push_back({ MODEL_ATTRIBUTE_SIZES[k], stride, start, type });
+            }
+            size_t vertexSize = packedSize;
+            if (zeroCopy)
+            {
+                bool interleaved = commonStride != SIZE_MAX;
+                for (auto& attr : desc)
+                {
+                    interleaved = interleaved && attr.offset - base < commonStride;
+                }
+                if (interleaved)
+                {
+                    vertexSize = commonStride;
+                    zeroCopy = base + mesh.vertexCount * vertexSize <= ctx.buffers[buffer].size;
+                }
+                else
+                {
+                    zeroCopy = end - base == mesh.vertexCount * vertexSize;
+                }
+            }
+            const uint8_t* vertexBase = zeroCopy ? ctx.buffers[buffer].data + base : nullptr;
+            zeroCopy = zeroCopy && (uintptr_t)vertexBase % sizeof(float) == 0;
+
+            if (zeroCopy)
+            {
+                for (auto& attr : desc)
+                {
+                    attr.offset -= base;
+                }
+                // read only, the renderers copy or upload the data
+                mesh.vertexes.vertexesBuffer = const_cast<uint8_t*>(vertexBase);
+                mesh.zeroCopyVertexes = true;
+                stats.zeroCopyBytes += mesh.vertexCount * vertexSize;
+            }
+            else
+            {
+                // interleaved floats in ModelAttribute order
+                desc.clear();
+                vertexSize = 0;
+                for (int k = 0; k < ModelAttribute_COUNT; k++)
+                {
+                    vertexSize += attributes[k] ? MODEL_ATTRIBUTE_SIZES[k] * sizeof(float) : 0;
+                }
+                mesh.vertexData.resize(mesh.vertexCount * vertexSize);
+                size_t offset = 0;
+                for (int k = 0; k < ModelAttribute_COUNT; k++)
+                {
+                    if (!attributes[k])
+                    {
+                        continue;
+                    }
+                    desc.push_back({ MODEL_ATTRIBUTE_SIZES[k], vertexSize, offset });
+                    readFloats(ctx, *attributes[k], (float*)(mesh.vertexData.data() + offset), vertexSize / sizeof(float));
+                    offset += MODEL_ATTRIBUTE_SIZES[k] * sizeof(float);
+                }
+                mesh.vertexes.vertexesBuffer = mesh.vertexData.data();
+                stats.convertedBytes += mesh.vertexData.size();
+            }
+            mesh.vertexes.vertexSize = vertexSize;
+            mesh.vertexes.vertexesBufferLength = mesh.vertexCount * vertexSize;
+
+            // indices, 16 and 32 bit ones are used in place
+            auto& indicesIndex = primitive["indices"];
+            if (indicesIndex.is_number() && indicesIndex.int_value() >= 0
+                && indicesIndex.int_value() < (int)ctx.accessors.size())
+            {
+                const Accessor& acc = ctx.accessors[indicesIndex.int_value()];
+                mesh.indexCount = acc.count;
+                const uint8_t* data = acc.bufferView >= 0 ? viewData(ctx, acc.bufferView, acc.byteOffset) : nullptr;
+                size_t compSize = componentSize(acc.componentType);
+                size_t stride = acc.bufferView >= 0 && ctx.views[acc.bufferView].byteStride
+                    ? ctx.views[acc.bufferView].byteStride : compSize;
+                if (acc.components != 1 || !data || readIndex(data, acc.componentType) == UINT32_MAX)
+                {
+                    LOGW("GLTFLoader: skip primitive of mesh %d, invalid indices", (int)meshIdx);
+                    continue;
+                }
+                if ((acc.componentType == GLTF_UNSIGNED_INT || acc.componentType == GLTF_UNSIGNED_SHORT)
+                    && stride == compSize && acc.sparseCount == 0 && (uintptr_t)data % compSize == 0)
+                {
+                    mesh.vertexes.indexBuffer = const_cast<uint8_t*>(data);
+                    mesh.vertexes.indexType = acc.componentType == GLTF_UNSIGNED_SHORT ? Index_UINT16 : Index_UINT32;
+                    mesh.zeroCopyIndices = true;
+                    stats.zeroCopyBytes += acc.count * compSize;
+                }
+                else
+                {
+                    mesh.indexData.resize(acc.count);
+                    for (size_t i = 0; i < acc.count; i++)
+                    {
+                        mesh.indexData[i] = (int32_t)readIndex(data + i * stride, acc.componentType);
+                    }
+                    mesh.vertexes.indexBuffer = mesh.indexData.data();
+                    stats.convertedBytes += mesh.indexData.size() * sizeof(int32_t);
+                }
+            }
+            else
+            {
+                mesh.indexCount = mesh.vertexCount;
+                mesh.indexData.resize(mesh.vertexCount);
+                for (size_t i = 0; i < mesh.vertexCount; i++)
+                {
+                    mesh.indexData[i] = (int32_t)i;
+                }
+                mesh.vertexes.indexBuffer = mesh.indexData.data();
+                stats.convertedBytes += mesh.indexData.size() * sizeof(int32_t);
+            }
+            mesh.vertexes.indexBufferLength = mesh.indexCount * VertexUtils::indexBytes(mesh.vertexes.indexType);
+
+            // the renderers index the vertex arrays without checks
+            bool validIndices = mesh.indexCount % 3 == 0;
+            for (size_t i = 0; i < mesh.indexCount && validIndices; i++)
+            {
+                validIndices = VertexUtils::getIndex(mesh.vertexes, i) < mesh.vertexCount;
+            }
+            if (!validIndices)
+            {
+                LOGW("GLTFLoader: skip primitive of mesh %d, index out of range", (int)meshIdx);
+                continue;
+            }
+
+            // positions are the first attribute in both layouts
+            if (position->hasBounds && position->sparseCount == 0)
+            {
+                mesh.bounds = math::AABB(position->min, position->max);
+            }
+            else
+            {
+                const auto& attr = desc[ModelAttribute_POSITION];
+                for (size_t i = 0; i < mesh.vertexCount; i++)
+                {
+                    float p[3];
+                    VertexUtils::decodeAttribute(attr, mesh.vertexes.vertexesBuffer + i * attr.stride + attr.offset, p);
+                    mesh.bounds.merge(math::float3(p[0], p[1], p[2]));
+                }
+            }
+
+            stats.vertexCount += mesh.vertexCount;
+            stats.triangleCount += mesh.indexCount / 3;
+            meshPrimitives[meshIdx].push_back((uint32_t)model->meshes.size());
+            model->meshes.push_back(std::move(mesh));
+        }
+    }
+    stats.meshCount = model->meshes.size();
+
+    // nodes, reordered parents first
+    auto& nodes = json["nodes"].array_items();
+    std::vector<int> parents(nodes.size(), -1);
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        for (auto& child : nodes[i]["children"].array_items())
+        {
+            int c = child.int_value();
+            if (c >= 0 && c < (int)nodes.size() && parents[c] < 0 && c != (int)i)
+            {
+                parents[c] = (int)i;
+            }
+        }
+    }
+    std::vector<int> order;
+    std::vector<int> newIndex(nodes.size(), -1);
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        if (parents[i] >= 0)
+        {
+            continue;
+        }
+        // children are appended after their parent, nodes in a cycle are never reached
+        size_t first = order.size();
+        order.push_back((int)i);
+        for (size_t k = first; k < order.size(); k++)
+        {
+            newIndex[order[k]] = (int)k;
+            for (auto& child : nodes[order[k]]["children"].array_items())
+            {
+                int c = child.int_value();
+                if (c >= 0 && c < (int)nodes.size() && parents[c] == order[k] && newIndex[c] < 0)
+                {
+                    order.push_back(c);
+                }
+            }
+        }
+    }
+    std::vector<math::mat4f> worldMatrices(order.size());
+    for (size_t k = 0; k < order.size(); k++)
+    {
+        const json11::Json& node = nodes[order[k]];
+        ModelNode n;
+        n.name = node["name"].string_value();
+        n.parent = parents[order[k]] >= 0 ? newIndex[parents[order[k]]] : -1;
+        n.localMatrix = parseNodeMatrix(node);
+        int mesh = node["mesh"].is_number() ? node["mesh"].int_value() : -1;
+        if (mesh >= 0 && mesh < (int)meshPrimitives.size())
+        {
+            n.meshes = meshPrimitives[mesh];
+        }
+
+        worldMatrices[k] = n.parent >= 0 ? worldMatrices[n.parent] * n.localMatrix : n.localMatrix;
+        for (uint32_t m : n.meshes)
+        {
+            model->bounds.merge(math::transformAABB(worldMatrices[k], model->meshes[m].bounds));
+        }
+        model->nodes.push_back(std::move(n));
+    }
+    stats.meshMillis = timer.elapseMillis();
+    stats.imageCount = model->images.size();
+    stats.totalMillis = totalTimer.elapseMillis();
+
+    LOGI("GLTFLoader: %s loaded in %.2f ms (parse %.2f, meshes %.2f), %d meshes, %d vertices, "
+         "%d triangles, %d images, zero-copy %.2f MB, converted %.2f MB",
+         path.c_str(), stats.totalMillis, stats.parseMillis, stats.meshMillis,
+         (int)stats.meshCount, (int)stats.vertexCount, (int)stats.triangleCount, (int)stats.imageCount,
+         (double)stats.zeroCopyBytes / (1024.0 * 1024.0), (double)stats.convertedBytes / (1024.0 * 1024.0));
+    return model;
+}
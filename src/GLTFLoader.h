@@ -0,0 +1,19 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Model.h"
+
+// glTF 2.0 loader for .gltf (with external or data uri buffers) and .glb files. Buffers are memory
+// mapped and vertex arrays point straight into them when the float or normalized integer attributes
+// of a mesh tile one range of a buffer (interleaved or one block per attribute) and the indices are
+// 16 or 32 bit. Other layouts, non normalized integer attributes and sparse accessors are converted
+// into interleaved float arrays. Images are listed but not decoded. Only triangle lists are loaded,
+// KHR extensions are ignored.
+class GLTFLoader
+{
+public:
+    // nullptr on failure
+    std::shared_ptr<Model> load(const std::string& path);
+};
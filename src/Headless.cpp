@@ -0,0 +1,198 @@
+#include "Headless.h"
+#include "ViewerManager.h"
+#include "base/Logger.h"
+#include "base/Timer.h"
+#include "base/Profiler.h"
+
+#include <cmath>
+#include <cstdlib>
+
+static const char* USAGE =
+    "headless options:\n"
+    "  --width <n>        frame width, default 1000\n"
+    "  --height <n>       frame height, default 800\n"
+    "  --frames <n>       frame count, default 120\n"
+    "  --fps <n>          frame rate written to y4m header, default 30\n"
+    "  --format <fmt>     png | rgba | y4m, default png\n"
+    "  --output <path>    png: directory, rgba/y4m: file, '-' for stdout. default ./capture/\n"
+    "  --orbit <r> <h>    camera orbit radius and height, default 3 1\n"
+    "  --profile <path>   write a Chrome trace json of all frames\n"
+    "  --model <path>     load a .gltf / .glb model into the scene\n";
+
+static void logToStderr(void* context, int level, const char* msg)
+{
+    static const char* tags[] = { "INFO", "DEBUG", "WARNING", "ERROR" };
+    fprintf(stderr, "[%s] : %s\n", tags[level], msg);
+}
+
+bool parseHeadlessOptions(int argc, char** argv, HeadlessOptions& options)
+{
+    for (int i = 0; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--width" && hasValue)
+        {
+            options.width = atoi(argv[++i]);
+        }
+        else if (arg == "--height" && hasValue)
+        {
+            options.height = atoi(argv[++i]);
+        }
+        else if (arg == "--frames" && hasValue)
+        {
+            options.frames = atoi(argv[++i]);
+        }
+        else if (arg == "--fps" && hasValue)
+        {
+            options.fps = atoi(argv[++i]);
+        }
+        else if (arg == "--output" && hasValue)
+        {
+            options.output = argv[++i];
+        }
+        else if (arg == "--format" && hasValue)
+        {
+            std::string format = argv[++i];
+            if (format == "png")
+            {
+                options.format = CaptureFormat_PNG;
+            }
+            else if (format == "rgba")
+            {
+                options.format = CaptureFormat_RGBA;
+            }
+            else if (format == "y4m")
+            {
+                options.format = CaptureFormat_Y4M;
+            }
+            else
+            {
+                fprintf(stderr, "unknown format: %s\n", format.c_str());
+                return false;
+            }
+        }
+        else if (arg == "--model" && hasValue)
+        {
+            options.model = argv[++i];
+        }
+        else if (arg == "--profile" && hasValue)
+        {
+            options.profileOutput = argv[++i];
+        }
+        else if (arg == "--orbit" && i + 2 < argc)
+        {
+            options.orbitRadius = (float)atof(argv[++i]);
+            options.orbitHeight = (float)atof(argv[++i]);
+        }
+        else if (arg == "--headless")
+        {
+            continue;
+        }
+        else
+        {
+            fprintf(stderr, "unknown option: %s\n%s", arg.c_str(), USAGE);
+            return false;
+        }
+    }
+
+    if (options.width <= 0 || options.height <= 0 || options.frames <= 0)
+    {
+        fprintf(stderr, "invalid frame size or count\n%s", USAGE);
+        return false;
+    }
+    return true;
+}
+
+int runHeadless(const HeadlessOptions& options)
+{
+    // stdout carries frame data
+    if (options.output == "-")
+    {
+        Logger::setLogFunc(nullptr, logToStderr);
+    }
+
+    auto viewer = std::make_shared<ViewerManager>();
+    if (!viewer->createHeadless(options.width, options.height))
+    {
+        LOGE("Failed to create Viewer");
+        return -1;
+    }
+
+    Config& config = viewer->getConfig();
+    config.captureFrames = true;
+    config.captureOutput = options.output;
+    config.captureFormat = options.format;
+    config.captureFps = options.fps;
+
+    if (!options.model.empty() && !viewer->loadModel(options.model))
+    {
+        return -1;
+    }
+
+    if (!options.profileOutput.empty())
+    {
+        Profiler::setThreadName("Main");
+        Profiler::setEnabled(true);
+    }
+
+    Timer timer;
+    Camera& camera = viewer->getCamera();
+    for (int i = 0; i < options.frames && config.captureFrames; i++)
+    {
+        float angle = (float)math::F_TAU * (float)i / (float)options.frames;
+        math::float3 eye(options.orbitRadius * std::sin(angle), options.orbitHeight, options.orbitRadius * std::cos(angle));
+        camera.lookAt(eye, math::float3(0.f), math::float3(0.f, 1.f, 0.f));
+
+        viewer->drawFrame();
+    }
+    [[maybe_unused]] double renderMillis = timer.elapseMillis();
+    bool captureSuccess = config.captureFrames;
+
+    [[maybe_unused]] auto& history = viewer->getStatsHistory();
+    [[maybe_unused]] auto frameMillis = [](const RenderStats& s) { return s.frameMillis; };
+    LOGI("Headless: frame avg %.2f ms, p50 %.2f ms, p95 %.2f ms, draw calls %.0f (%.0f instances), "
+         "triangles %.0f (%.0f saved by lod), fragments %.0f, "
+         "objects visible %.0f of %.0f, occluded %.0f in %.3f ms (latest %d frames)",
+         history.average(frameMillis), history.percentile(frameMillis, 0.5), history.percentile(frameMillis, 0.95),
+         history.average([](const RenderStats& s) { return (double)s.drawCalls; }),
+         history.average([](const RenderStats& s) { return (double)s.instancesDrawn; }),
+         history.average([](const RenderStats& s) { return (double)s.trianglesIn; }),
+         history.average([](const RenderStats& s) { return (double)s.trianglesLodSaved; }),
+         history.average([](const RenderStats& s) { return (double)s.fragmentsShaded; }),
+         history.average([](const RenderStats& s) { return (double)s.objectsVisible; }),
+         history.average([](const RenderStats& s) { return (double)s.objectsTested; }),
+         history.average([](const RenderStats& s) { return (double)s.objectsOccluded; }),
+         history.average([](const RenderStats& s) { return s.occlusionMillis; }),
+         (int)history.size());
+
+    // flushes frames still encoding
+    viewer->destroy();
+    viewer = nullptr;
+
+    if (Profiler::isEnabled())
+    {
+        Profiler::setEnabled(false);
+        Profiler::exportChromeTrace(options.profileOutput);
+    }
+
+    if (!captureSuccess)
+    {
+        return -1;
+    }
+
+    [[maybe_unused]] double totalMillis = timer.elapseMillis();
+    LOGI("Headless: %d frames %dx%d, render %.2f ms (%.2f ms/frame), total %.2f ms",
+         options.frames, options.width, options.height, renderMillis, renderMillis / options.frames, totalMillis);
+    return 0;
+}
+
+int runHeadless(int argc, char** argv)
+{
+    HeadlessOptions options;
+    if (!parseHeadlessOptions(argc, argv, options))
+    {
+        return -1;
+    }
+    return runHeadless(options);
+}
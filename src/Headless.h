@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include "Config.h"
+
+struct HeadlessOptions
+{
+    int width = 1000;
+    int height = 800;
+    int frames = 120;
+    int fps = 30;
+    CaptureFormat format = CaptureFormat_PNG;
+    std::string output = "./capture/";
+
+    // glTF / glb model added to the scene, empty for none
+    std::string model;
+
+    // Chrome trace json of all frames, empty to disable profiling
+    std::string profileOutput;
+
+    // scripted camera: one orbit around the origin over all frames
+    float orbitRadius = 3.f;
+    float orbitHeight = 1.f;
+};
+
+// parse "--width 640 --frames 60 --format y4m --output -", returns false on bad arguments
+bool parseHeadlessOptions(int argc, char** argv, HeadlessOptions& options);
+
+// render frames with the software renderer and write them through FrameWriter, no window required
+int runHeadless(const HeadlessOptions& options);
+
+// entry of the headless mode, argv excludes the program name
+int runHeadless(int argc, char** argv);
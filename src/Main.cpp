@@ -1,13 +1,20 @@
 
 #include <iostream>
 #include <sstream>
+#include <cstring>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "imgui/imgui.h"
+#include "imgui/imgui_impl_glfw.h"
+#include "imgui/imgui_impl_opengl3.h"
+
 #include "base/Logger.h"
+#include "base/Profiler.h"
 #include "render/opengl/GLSLUtils.h"
 #include "ViewerManager.h"
+#include "Headless.h"
 
 std::shared_ptr<ViewerManager> viewer = nullptr;
 
@@ -20,6 +27,7 @@ bool firstMouse = true;
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 void mouseCallback(GLFWwindow* window, double xPos, double yPos);
+void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void scrollCallback(GLFWwindow* window, double xOffset, double yOffset);
 void processInput(GLFWwindow* window);
 
@@ -52,7 +60,20 @@ static void glfwErrorCallback(int error, const char* description) {
     fprintf(stderr, "Glfw Error %d: %s\n", error, description);
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // render frames offline without a window
+    if (argc > 1 && strcmp(argv[1], "--headless") == 0) {
+        return runHeadless(argc - 2, argv + 2);
+    }
+
+    // record all frames and save a Chrome trace json on exit
+    const char* profileOutput = nullptr;
+    if (argc > 2 && strcmp(argv[1], "--profile") == 0) {
+        profileOutput = argv[2];
+        Profiler::setThreadName("Main");
+        Profiler::setEnabled(true);
+    }
+
     /* Initialize the library */
     glfwSetErrorCallback(glfwErrorCallback);
     if (!glfwInit()) {
@@ -79,6 +100,7 @@ int main() {
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
     glfwSetCursorPosCallback(window, mouseCallback);
+    glfwSetMouseButtonCallback(window, mouseButtonCallback);
     glfwSetScrollCallback(window, scrollCallback);
 
     /* Load all OpenGL function pointers */
@@ -88,6 +110,14 @@ int main() {
         return -1;
     }
 
+    // setup ImGui
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGui::GetIO().IniFilename = nullptr;
+    ImGui::StyleColorsDark();
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 330 core");
+
     ProgramGLSL program;
     if (!program.loadSource(VS, FS)) {
         LOGE("Failed to initialize Shader");
@@ -182,7 +212,13 @@ int main() {
             glBindVertexArray(VAO);
             glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
 
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
             viewer->drawPanel();
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
             glfwSwapBuffers(window);
             glfwPollEvents();
         }
@@ -198,9 +234,17 @@ int main() {
     glDeleteBuffers(1, &EBO);
     glDeleteTextures(1, &texture);
 
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+
     glfwDestroyWindow(window);
     glfwTerminate();
 
+    if (profileOutput) {
+        Profiler::exportChromeTrace(profileOutput);
+    }
+
     return 0;
 }
 
@@ -214,6 +258,22 @@ void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 
 void mouseCallback(GLFWwindow* window, double xPos, double yPos)
 {
+    lastX = xPos;
+    lastY = yPos;
+    firstMouse = false;
+}
+
+void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+    // clicks on the panels belong to ImGui
+    if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS || ImGui::GetIO().WantCaptureMouse)
+    {
+        return;
+    }
+    if (viewer)
+    {
+        viewer->pick(lastX, lastY);
+    }
 }
 
 void scrollCallback(GLFWwindow* window, double xOffset, double yOffset)
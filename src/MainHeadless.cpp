@@ -0,0 +1,6 @@
+#include "Headless.h"
+
+// offline rendering on the software backend, see Headless.cpp for options
+int main(int argc, char** argv) {
+    return runHeadless(argc - 1, argv + 1);
+}
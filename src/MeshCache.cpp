@@ -0,0 +1,554 @@
+#include "MeshCache.h"
+#include "GLTFLoader.h"
+#include "base/FileUtils.h"
+#include "base/HashUtils.h"
+#include "base/Logger.h"
+#include "base/MemoryUtils.h"
+#include "base/Profiler.h"
+#include "base/Timer.h"
+#include "render/VertexUtils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <sstream>
+#include <filesystem>
+
+MeshCache::MeshCache(const std::string& cacheDir, bool quantize)
+    : cacheDir_(cacheDir), quantize_(quantize)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir_, ec);
+    if (ec)
+    {
+        LOGE("MeshCache: create cache dir failed: %s", cacheDir_.c_str());
+    }
+}
+
+std::shared_ptr<Model> MeshCache::load(const std::string& path, bool& cacheHit)
+{
+    cacheHit = false;
+    std::string cachePath = getCachePath(path);
+    if (!cachePath.empty() && FileUtils::exists(cachePath))
+    {
+        auto model = read(cachePath);
+        if (model)
+        {
+            cacheHit = true;
+            model->path = path;
+            return model;
+        }
+    }
+
+    // cold path: parse the source and store
+    GLTFLoader loader;
+    auto model = loader.load(path);
+    if (model && !cachePath.empty())
+    {
+        write(*model, cachePath, quantize_);
+    }
+    return model;
+}
+
+std::string MeshCache::getCachePath(const std::string& path)
+{
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec)
+    {
+        return "";
+    }
+    auto time = std::filesystem::last_write_time(path, ec);
+    if (ec)
+    {
+        return "";
+    }
+    std::string key = std::filesystem::absolute(path, ec).string() + "|" + std::to_string(size) + "|"
+        + std::to_string(time.time_since_epoch().count()) + (quantize_ ? "|quantized" : "");
+    return cacheDir_ + "/" + HashUtils::getHashMD5(key) + MESH_CACHE_EXT;
+}
+
+static inline void storeAABB(const math::AABB& box, float* min, float* max)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        min[i] = box.min[i];
+        max[i] = box.max[i];
+    }
+}
+
+static inline math::AABB loadAABB(const float* min, const float* max)
+{
+    return math::AABB(math::float3(min[0], min[1], min[2]), math::float3(max[0], max[1], max[2]));
+}
+
+std::shared_ptr<Model> MeshCache::read(const std::string& path)
+{
+    PROFILE_ZONE("MeshCache::read");
+    Timer timer;
+
+    auto file = FileUtils::mapFile(path, MapAdvice_WILLNEED);
+    if (!file || file->size() < sizeof(MeshCacheHeader))
+    {
+        return nullptr;
+    }
+
+    auto* header = reinterpret_cast<const MeshCacheHeader*>(file->data());
+    if (memcmp(header->magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0
+        || header->version != MESH_CACHE_VERSION)
+    {
+        LOGW("MeshCache: invalid cache file: %s", path.c_str());
+        return nullptr;
+    }
+
+    // tables, data blocks are checked per entry below
+    uint64_t tablesSize = sizeof(MeshCacheHeader)
+        + (uint64_t)header->meshCount * sizeof(MeshCacheMesh)
+        + (uint64_t)header->materialCount * sizeof(MeshCacheMaterial)
+        + (uint64_t)header->nodeCount * sizeof(MeshCacheNode)
+        + (uint64_t)header->imageCount * sizeof(MeshCacheImage)
+        + (uint64_t)header->nodeMeshCount * sizeof(uint32_t)
+        + header->stringsSize;
+    if (tablesSize > file->size())
+    {
+        LOGW("MeshCache: truncated cache file: %s", path.c_str());
+        return nullptr;
+    }
+    const uint8_t* ptr = file->data() + sizeof(MeshCacheHeader);
+    auto* meshes = reinterpret_cast<const MeshCacheMesh*>(ptr);
+    ptr += header->meshCount * sizeof(MeshCacheMesh);
+    auto* materials = reinterpret_cast<const MeshCacheMaterial*>(ptr);
+    ptr += header->materialCount * sizeof(MeshCacheMaterial);
+    auto* nodes = reinterpret_cast<const MeshCacheNode*>(ptr);
+    ptr += header->nodeCount * sizeof(MeshCacheNode);
+    auto* images = reinterpret_cast<const MeshCacheImage*>(ptr);
+    ptr += header->imageCount * sizeof(MeshCacheImage);
+    auto* nodeMeshes = reinterpret_cast<const uint32_t*>(ptr);
+    ptr += header->nodeMeshCount * sizeof(uint32_t);
+    auto* strings = reinterpret_cast<const char*>(ptr);
+
+    auto inFile = [&](uint64_t offset, uint64_t size)
+    {
+        return offset % sizeof(float) == 0 && offset <= file->size() && size <= file->size() - offset;
+    };
+    auto getString = [&](uint32_t offset, uint32_t length)
+    {
+        return (uint64_t)offset + length <= header->stringsSize ? std::string(strings + offset, length) : std::string();
+    };
+    auto imageIndex = [&](int32_t image)
+    {
+        return image >= 0 && (uint32_t)image < header->imageCount ? image : -1;
+    };
+
+    auto model = std::make_shared<Model>();
+    model->path = path;
+    model->bounds = loadAABB(header->boundsMin, header->boundsMax);
+
+    // vertex arrays point into the mapping, block ranges and index values are checked before use
+    for (uint32_t i = 0; i < header->meshCount; i++)
+    {
+        const MeshCacheMesh& entry = meshes[i];
+        ModelMesh mesh;
+        mesh.vertexCount = entry.vertexCount;
+        mesh.indexCount = entry.indexCount;
+        mesh.attributeMask = entry.attributeMask;
+        mesh.material = entry.material >= 0 && (uint32_t)entry.material < header->materialCount ? entry.material : -1;
+        mesh.bounds = loadAABB(entry.boundsMin, entry.boundsMax);
+
+        IndexType indexType = entry.indexType == Index_UINT16 ? Index_UINT16 : Index_UINT32;
+        uint64_t vertexBytes = (uint64_t)entry.vertexCount * entry.vertexSize;
+        uint64_t indexBytes = (uint64_t)entry.indexCount * VertexUtils::indexBytes(indexType);
+        uint64_t meshletBytes = (uint64_t)entry.meshletCount * sizeof(Meshlet);
+        if (!inFile(entry.vertexOffset, vertexBytes) || !inFile(entry.indexOffset, indexBytes)
+            || !inFile(entry.meshletOffset, meshletBytes))
+        {
+            LOGW("MeshCache: mesh data out of range: %s", path.c_str());
+            return nullptr;
+        }
+        auto* meshlets = reinterpret_cast<const Meshlet*>(file->data() + entry.meshletOffset);
+        for (uint32_t k = 0; k < entry.meshletCount; k++)
+        {
+            if ((uint64_t)meshlets[k].indexOffset + meshlets[k].indexCount > entry.indexCount)
+            {
+                LOGW("MeshCache: meshlet out of range: %s", path.c_str());
+                return nullptr;
+            }
+        }
+        if (entry.lodCount == 1 || entry.lodCount > MESH_MAX_LODS)
+        {
+            LOGW("MeshCache: invalid lod count: %s", path.c_str());
+            return nullptr;
+        }
+        for (uint32_t k = 0; k < entry.lodCount; k++)
+        {
+            const MeshLod& lod = entry.lods[k];
+            if ((uint64_t)lod.indexOffset + lod.indexCount > entry.indexCount || lod.indexCount % 3 != 0)
+            {
+                LOGW("MeshCache: lod out of range: %s", path.c_str());
+                return nullptr;
+            }
+            mesh.lods.push_back(lod);
+        }
+
+        auto& desc = mesh.vertexes.vertexesDesc;
+        size_t offset = 0;
+        bool valid = true;
+        for (int k = 0; k < ModelAttribute_COUNT; k++)
+        {
+            if (mesh.hasAttribute((ModelAttribute)k))
+            {
+                auto type = (VertexAttributeType)entry.attributeTypes[k];
+                desc.push_back({ MODEL_ATTRIBUTE_SIZES[k], entry.vertexSize, offset, type });
+                offset += VertexUtils::attributeBytes(type, MODEL_ATTRIBUTE_SIZES[k]);
+                valid = valid && type <= VertexAttr_OCT16 && (type != VertexAttr_OCT16 || MODEL_ATTRIBUTE_SIZES[k] == 3);
+            }
+        }
+        if (!valid || offset != entry.vertexSize || !mesh.hasAttribute(ModelAttribute_POSITION))
+        {
+            LOGW("MeshCache: invalid vertex layout: %s", path.c_str());
+            return nullptr;
+        }
+        mesh.vertexes.vertexSize = entry.vertexSize;
+        mesh.vertexes.vertexesBuffer = const_cast<uint8_t*>(file->data() + entry.vertexOffset);
+        mesh.vertexes.vertexesBufferLength = vertexBytes;
+        mesh.vertexes.indexBuffer = const_cast<uint8_t*>(file->data() + entry.indexOffset);
+        mesh.vertexes.indexBufferLength = indexBytes;
+        mesh.vertexes.indexType = indexType;
+
+        // the renderers index the vertex arrays without checks
+        bool validIndices = entry.indexCount % 3 == 0;
+        for (size_t k = 0; k < entry.indexCount && validIndices; k++)
+        {
+            validIndices = VertexUtils::getIndex(mesh.vertexes, k) < entry.vertexCount;
+        }
+        if (!validIndices)
+        {
+            LOGW("MeshCache: index out of range: %s", path.c_str());
+            return nullptr;
+        }
+        mesh.zeroCopyVertexes = true;
+        mesh.zeroCopyIndices = true;
+        mesh.meshlets = entry.meshletCount > 0 ? meshlets : nullptr;
+        mesh.meshletCount = entry.meshletCount;
+
+        model->stats.vertexCount += mesh.vertexCount;
+        model->stats.meshletCount += mesh.meshletCount;
+        model->stats.lodCount += mesh.getLodCount() - 1;
+        model->stats.triangleCount += mesh.getLodRange(0).count / 3;
+        model->stats.zeroCopyBytes += vertexBytes + indexBytes + meshletBytes;
+        model->meshes.push_back(std::move(mesh));
+    }
+
+    for (uint32_t i = 0; i < header->materialCount; i++)
+    {
+        const MeshCacheMaterial& entry = materials[i];
+        ModelMaterial m;
+        m.baseColorFactor = math::float4(entry.baseColorFactor[0], entry.baseColorFactor[1],
+            entry.baseColorFactor[2], entry.baseColorFactor[3]);
+        m.emissiveFactor = math::float3(entry.emissiveFactor[0], entry.emissiveFactor[1], entry.emissiveFactor[2]);
+        m.metallicFactor = entry.metallicFactor;
+        m.roughnessFactor = entry.roughnessFactor;
+        m.alphaCutoff = entry.alphaCutoff;
+        m.alphaMode = entry.alphaMode;
+        m.doubleSided = entry.doubleSided != 0;
+        m.baseColorImage = imageIndex(entry.baseColorImage);
+        m.metallicRoughnessImage = imageIndex(entry.metallicRoughnessImage);
+        m.normalImage = imageIndex(entry.normalImage);
+        m.occlusionImage = imageIndex(entry.occlusionImage);
+        m.emissiveImage = imageIndex(entry.emissiveImage);
+        model->materials.push_back(m);
+    }
+
+    for (uint32_t i = 0; i < header->nodeCount; i++)
+    {
+        const MeshCacheNode& entry = nodes[i];
+        if ((uint64_t)entry.meshBegin + entry.meshCount > header->nodeMeshCount
+            || entry.parent >= (int32_t)i)
+        {
+            LOGW("MeshCache: invalid node: %s", path.c_str());
+            return nullptr;
+        }
+        ModelNode node;
+        node.name = getString(entry.nameOffset, entry.nameLength);
+        node.parent = std::max(entry.parent, -1);
+        memcpy(&node.localMatrix[0][0], entry.localMatrix, sizeof(entry.localMatrix));
+        for (uint32_t k = 0; k < entry.meshCount; k++)
+        {
+            uint32_t mesh = nodeMeshes[entry.meshBegin + k];
+            if (mesh < header->meshCount)
+            {
+                node.meshes.push_back(mesh);
+            }
+        }
+        model->nodes.push_back(std::move(node));
+    }
+
+    for (uint32_t i = 0; i < header->imageCount; i++)
+    {
+        const MeshCacheImage& entry = images[i];
+        ModelImage image;
+        image.name = getString(entry.nameOffset, entry.nameLength);
+        image.path = getString(entry.pathOffset, entry.pathLength);
+        model->images.push_back(std::move(image));
+    }
+    model->files_.push_back(std::move(file));
+
+    ModelLoadStats& stats = model->stats;
+    stats.meshCount = model->meshes.size();
+    stats.imageCount = model->images.size();
+    stats.parseMillis = timer.elapseMillis();
+    stats.totalMillis = stats.parseMillis;
+    LOGI("MeshCache: %s loaded in %.2f ms, %d meshes, %d vertices, %d triangles, %d images",
+         path.c_str(), stats.totalMillis, (int)stats.meshCount, (int)stats.vertexCount, (int)stats.triangleCount,
+         (int)stats.imageCount);
+    return model;
+}
+
+// vertex types of the attributes written by MeshCache::write, by ModelAttribute
+static const VertexAttributeType FLOAT_TYPES[ModelAttribute_COUNT] = {
+    VertexAttr_FLOAT, VertexAttr_FLOAT, VertexAttr_FLOAT, VertexAttr_FLOAT };
+static const VertexAttributeType QUANTIZED_TYPES[ModelAttribute_COUNT] = {
+    VertexAttr_FLOAT, VertexAttr_HALF, VertexAttr_OCT16, VertexAttr_SNORM16 };
+
+// interleave the vertexes in the order of their first use by sourceIndices, unused vertexes are dropped.
+// attributes are decoded and encoded again in the types of the cache, the index order is kept
+static void optimizeMesh(const ModelMesh& mesh, const std::vector<uint32_t>& sourceIndices,
+    const VertexAttributeType* types, std::vector<uint8_t>& vertexes, std::vector<uint8_t>& indices,
+    MeshCacheMesh& entry)
+{
+    const VertexArray& va = mesh.vertexes;
+    VertexAttributeType attrTypes[ModelAttribute_COUNT];
+    size_t attrCnt = 0;
+    size_t vertexSize = 0;
+    for (int k = 0; k < ModelAttribute_COUNT; k++)
+    {
+        if (mesh.hasAttribute((ModelAttribute)k))
+        {
+            attrTypes[attrCnt++] = types[k];
+            vertexSize += VertexUtils::attributeBytes(types[k], MODEL_ATTRIBUTE_SIZES[k]);
+        }
+        entry.attributeTypes[k] = (uint8_t)types[k];
+    }
+
+    size_t indexCount = sourceIndices.size();
+    std::vector<int32_t> remap(mesh.vertexCount, -1);
+    std::vector<uint32_t> remapped(indexCount);
+    uint32_t next = 0;
+    vertexes.clear();
+    vertexes.reserve(mesh.vertexCount * vertexSize);
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t v = sourceIndices[i];
+        if (remap[v] < 0)
+        {
+            remap[v] = (int32_t)next++;
+            size_t pos = vertexes.size();
+            vertexes.resize(pos + vertexSize);
+            for (size_t k = 0; k < attrCnt; k++)
+            {
+                const VertexAttributeDesc& attr = va.vertexesDesc[k];
+                float value[4];
+                VertexUtils::decodeAttribute(attr, va.vertexesBuffer + v * attr.stride + attr.offset, value);
+                VertexUtils::encodeAttribute(attrTypes[k], value, attr.size, vertexes.data() + pos);
+                pos += VertexUtils::attributeBytes(attrTypes[k], attr.size);
+            }
+        }
+        remapped[i] = (uint32_t)remap[v];
+    }
+
+    IndexType indexType = next <= 65536 ? Index_UINT16 : Index_UINT32;
+    indices.resize(indexCount * VertexUtils::indexBytes(indexType));
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        if (indexType == Index_UINT16)
+        {
+            ((uint16_t*)indices.data())[i] = (uint16_t)remapped[i];
+        }
+        else
+        {
+            ((int32_t*)indices.data())[i] = (int32_t)remapped[i];
+        }
+    }
+
+    entry.vertexCount = next;
+    entry.indexCount = (uint32_t)indexCount;
+    entry.vertexSize = (uint32_t)vertexSize;
+    entry.indexType = indexType;
+}
+
+bool MeshCache::write(const Model& model, const std::string& path, bool quantize)
+{
+    PROFILE_ZONE("MeshCache::write");
+
+    MeshCacheHeader header{};
+    memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+    header.version = MESH_CACHE_VERSION;
+    header.meshCount = (uint32_t)model.meshes.size();
+    header.materialCount = (uint32_t)model.materials.size();
+    header.nodeCount = (uint32_t)model.nodes.size();
+    header.imageCount = (uint32_t)model.images.size();
+    storeAABB(model.bounds, header.boundsMin, header.boundsMax);
+
+    std::string strings;
+    auto addString = [&](const std::string& str, uint32_t& offset, uint32_t& length)
+    {
+        offset = (uint32_t)strings.size();
+        length = (uint32_t)str.size();
+        strings += str;
+    };
+
+    std::vector<MeshCacheNode> nodes;
+    std::vector<uint32_t> nodeMeshes;
+    for (auto& node : model.nodes)
+    {
+        MeshCacheNode entry{};
+        memcpy(entry.localMatrix, &node.localMatrix[0][0], sizeof(entry.localMatrix));
+        entry.parent = node.parent;
+        entry.meshBegin = (uint32_t)nodeMeshes.size();
+        entry.meshCount = (uint32_t)node.meshes.size();
+        nodeMeshes.insert(nodeMeshes.end(), node.meshes.begin(), node.meshes.end());
+        addString(node.name, entry.nameOffset, entry.nameLength);
+        nodes.push_back(entry);
+    }
+    header.nodeMeshCount = (uint32_t)nodeMeshes.size();
+
+    std::vector<MeshCacheMaterial> materials;
+    for (auto& m : model.materials)
+    {
+        MeshCacheMaterial entry{};
+        for (int i = 0; i < 4; i++)
+        {
+            entry.baseColorFactor[i] = m.baseColorFactor[i];
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            entry.emissiveFactor[i] = m.emissiveFactor[i];
+        }
+        entry.metallicFactor = m.metallicFactor;
+        entry.roughnessFactor = m.roughnessFactor;
+        entry.alphaCutoff = m.alphaCutoff;
+        entry.alphaMode = m.alphaMode;
+        entry.doubleSided = m.doubleSided ? 1 : 0;
+        entry.baseColorImage = m.baseColorImage;
+        entry.metallicRoughnessImage = m.metallicRoughnessImage;
+        entry.normalImage = m.normalImage;
+        entry.occlusionImage = m.occlusionImage;
+        entry.emissiveImage = m.emissiveImage;
+        materials.push_back(entry);
+    }
+
+    std::vector<MeshCacheImage> images;
+    for (auto& image : model.images)
+    {
+        MeshCacheImage entry{};
+        addString(image.name, entry.nameOffset, entry.nameLength);
+        addString(image.path, entry.pathOffset, entry.pathLength);
+        images.push_back(entry);
+    }
+    header.stringsSize = (uint32_t)strings.size();
+
+    // data blocks in file order: per mesh vertexes, indices and meshlets
+    std::vector<std::vector<uint8_t>> vertexes(model.meshes.size());
+    std::vector<std::vector<uint8_t>> indices(model.meshes.size());
+    std::vector<std::vector<Meshlet>> meshlets(model.meshes.size());
+    std::vector<MeshCacheMesh> meshes;
+    size_t offset = MemoryUtils::alignedSize(sizeof(MeshCacheHeader)
+        + model.meshes.size() * sizeof(MeshCacheMesh)
+        + materials.size() * sizeof(MeshCacheMaterial)
+        + nodes.size() * sizeof(MeshCacheNode)
+        + images.size() * sizeof(MeshCacheImage)
+        + nodeMeshes.size() * sizeof(uint32_t)
+        + strings.size());
+    for (size_t i = 0; i < model.meshes.size(); i++)
+    {
+        const ModelMesh& mesh = model.meshes[i];
+        MeshCacheMesh entry{};
+
+        // LOD chains and meshlets of the model are kept, their indices are already in order
+        std::vector<uint32_t> meshIndices = mesh.getIndices();
+        std::vector<MeshLod> lods = mesh.lods;
+        if (lods.empty())
+        {
+            MeshSimplifier::buildLods(mesh.vertexes, meshIndices, lods);
+        }
+        if (mesh.meshletCount > 0)
+        {
+            meshlets[i].assign(mesh.meshlets, mesh.meshlets + mesh.meshletCount);
+        }
+        else
+        {
+            MeshletBuilder::build(mesh.vertexes, meshIndices.data(), lods[0].indexCount, meshlets[i]);
+        }
+        optimizeMesh(mesh, meshIndices, quantize ? QUANTIZED_TYPES : FLOAT_TYPES, vertexes[i], indices[i], entry);
+        entry.meshletCount = (uint32_t)meshlets[i].size();
+        if (lods.size() > 1)
+        {
+            entry.lodCount = (uint32_t)lods.size();
+            std::copy(lods.begin(), lods.end(), entry.lods);
+        }
+        entry.attributeMask = mesh.attributeMask;
+        entry.material = mesh.material;
+        storeAABB(mesh.bounds, entry.boundsMin, entry.boundsMax);
+        entry.vertexOffset = offset;
+        offset += MemoryUtils::alignedSize(vertexes[i].size());
+        entry.indexOffset = offset;
+        offset += MemoryUtils::alignedSize(indices[i].size());
+        entry.meshletOffset = offset;
+        offset += MemoryUtils::alignedSize(meshlets[i].size() * sizeof(Meshlet));
+        meshes.push_back(entry);
+    }
+
+    // write to a temp file first, another process may be reading the same key
+    std::stringstream tmpPath;
+    tmpPath << path << "." << std::this_thread::get_id() << ".tmp";
+    {
+        std::ofstream file(tmpPath.str(), std::ios::out | std::ios::binary);
+        if (!file.is_open())
+        {
+            LOGE("MeshCache: write cache failed: %s", path.c_str());
+            return false;
+        }
+
+        file.write((const char*)&header, sizeof(header));
+        file.write((const char*)meshes.data(), (std::streamsize)(meshes.size() * sizeof(MeshCacheMesh)));
+        file.write((const char*)materials.data(), (std::streamsize)(materials.size() * sizeof(MeshCacheMaterial)));
+        file.write((const char*)nodes.data(), (std::streamsize)(nodes.size() * sizeof(MeshCacheNode)));
+        file.write((const char*)images.data(), (std::streamsize)(images.size() * sizeof(MeshCacheImage)));
+        file.write((const char*)nodeMeshes.data(), (std::streamsize)(nodeMeshes.size() * sizeof(uint32_t)));
+        file.write(strings.data(), (std::streamsize)strings.size());
+        size_t pos = (size_t)file.tellp();
+
+        static const char padding[SOFTGL_ALIGNMENT] = {};
+        auto writeBlock = [&](uint64_t blockOffset, const void* data, size_t size)
+        {
+            file.write(padding, (std::streamsize)(blockOffset - pos));
+            file.write((const char*)data, (std::streamsize)size);
+            pos = blockOffset + size;
+        };
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            writeBlock(meshes[i].vertexOffset, vertexes[i].data(), vertexes[i].size());
+            writeBlock(meshes[i].indexOffset, indices[i].data(), indices[i].size());
+            writeBlock(meshes[i].meshletOffset, meshlets[i].data(), meshlets[i].size() * sizeof(Meshlet));
+        }
+        if (!file.good())
+        {
+            file.close();
+            std::remove(tmpPath.str().c_str());
+            LOGE("MeshCache: write cache failed: %s", path.c_str());
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    // rename does not replace existing files on windows
+    std::remove(path.c_str());
+#endif
+    if (std::rename(tmpPath.str().c_str(), path.c_str()) != 0)
+    {
+        std::remove(tmpPath.str().c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <string>
+#include <memory>
+
+#include "Model.h"
+
+// cache file layout:
+//   MeshCacheHeader
+//   MeshCacheMesh[meshCount]
+//   MeshCacheMaterial[materialCount]
+//   MeshCacheNode[nodeCount]
+//   MeshCacheImage[imageCount]
+//   uint32_t nodeMeshes[nodeMeshCount], MeshCacheNode::meshBegin indexes it
+//   char strings[stringsSize], names and paths are not null terminated
+//   vertex, index and Meshlet data, each block aligned to SOFTGL_ALIGNMENT
+// vertexes are interleaved in ModelAttribute order with the types in MeshCacheMesh::attributeTypes,
+// indices are uint16 for meshes of up to 65536 vertexes, int32 otherwise. the full mesh indices are ordered
+// meshlet by meshlet, the coarser levels of detail follow them
+constexpr char MESH_CACHE_MAGIC[4] = { 'S', 'M', 'S', 'H' };
+constexpr uint32_t MESH_CACHE_VERSION = 6;
+// extension of files written by the converter tool
+const std::string MESH_CACHE_EXT = ".smc";
+
+struct MeshCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t meshCount;
+    uint32_t materialCount;
+    uint32_t nodeCount;
+    uint32_t imageCount;
+    uint32_t nodeMeshCount;
+    uint32_t stringsSize;
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+struct MeshCacheMesh
+{
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t meshletOffset;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t vertexSize;
+    uint32_t attributeMask;
+    int32_t material;
+    uint32_t indexType;                             // IndexType
+    uint8_t attributeTypes[ModelAttribute_COUNT];   // VertexAttributeType, by ModelAttribute
+    uint32_t meshletCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint32_t lodCount;                              // 0 or at least 2, lods[0] is the full mesh
+    MeshLod lods[MESH_MAX_LODS];
+    uint32_t reserved;
+};
+
+struct MeshCacheMaterial
+{
+    float baseColorFactor[4];
+    float emissiveFactor[3];
+    float metallicFactor;
+    float roughnessFactor;
+    float alphaCutoff;
+    int32_t alphaMode;
+    int32_t doubleSided;
+    int32_t baseColorImage;
+    int32_t metallicRoughnessImage;
+    int32_t normalImage;
+    int32_t occlusionImage;
+    int32_t emissiveImage;
+    uint32_t reserved;
+};
+
+struct MeshCacheNode
+{
+    float localMatrix[16];  // column major
+    int32_t parent;
+    uint32_t meshBegin;
+    uint32_t meshCount;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t reserved;
+};
+
+// ModelImage, pathLength 0 for embedded images
+struct MeshCacheImage
+{
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t pathOffset;
+    uint32_t pathLength;
+};
+
+// Binary models ready for rendering: a cached model is a single file mapping, the vertex arrays and
+// images of the loaded Model point into it and nothing is parsed or decoded. Meshes get a LOD chain
+// and are split into meshlets when written, then interleaved with their vertexes reordered by first use in the index
+// buffer, quantized meshes store half texcoords, octahedral normals and snorm16 tangents (28 instead
+// of 48 bytes a vertex).
+class MeshCache
+{
+public:
+    // quantize: the vertex format of the meshes written on cache misses
+    explicit MeshCache(const std::string& cacheDir, bool quantize = false);
+
+    // load a glTF / glb model from the cache if present, otherwise load the source and write the cache.
+    // the cache key is the source path, size and modification time, the content is not hashed
+    std::shared_ptr<Model> load(const std::string& path, bool& cacheHit);
+
+    // nullptr if the file is missing, invalid or of another version
+    static std::shared_ptr<Model> read(const std::string& path);
+    static bool write(const Model& model, const std::string& path, bool quantize = false);
+
+private:
+    std::string getCachePath(const std::string& path);
+
+private:
+    std::string cacheDir_;
+    bool quantize_ = false;
+};
@@ -0,0 +1,485 @@
+#include "MeshSimplifier.h"
+#include "Model.h"
+#include "base/Profiler.h"
+#include "render/VertexUtils.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// a coarser level is dropped when it keeps more than this ratio of the triangles of the previous one
+static constexpr float MESH_LOD_MAX_KEPT = 0.8f;
+// no coarser level for meshes of fewer triangles
+static constexpr size_t MESH_LOD_MIN_TRIANGLES = 64;
+// error budget of the whole chain, relative to the diagonal of the mesh bounds
+static constexpr float MESH_LOD_MAX_ERROR = 0.05f;
+static constexpr int SIMPLIFY_MAX_PASSES = 64;
+
+// sum of squared distances to planes weighted by triangle area, symmetric 4x4 matrix
+struct Quadric
+{
+    double a2 = 0, b2 = 0, c2 = 0, ab = 0, ac = 0, bc = 0, ad = 0, bd = 0, cd = 0, d2 = 0;
+    double weight = 0;
+
+    void addPlane(const math::float3& n, double d, double w)
+    {
+        a2 += w * n.x * n.x;
+        b2 += w * n.y * n.y;
+        c2 += w * n.z * n.z;
+        ab += w * n.x * n.y;
+        ac += w * n.x * n.z;
+        bc += w * n.y * n.z;
+        ad += w * n.x * d;
+        bd += w * n.y * d;
+        cd += w * n.z * d;
+        d2 += w * d * d;
+        weight += w;
+    }
+
+    void add(const Quadric& q)
+    {
+        a2 += q.a2;
+        b2 += q.b2;
+        c2 += q.c2;
+        ab += q.ab;
+        ac += q.ac;
+        bc += q.bc;
+        ad += q.ad;
+        bd += q.bd;
+        cd += q.cd;
+        d2 += q.d2;
+        weight += q.weight;
+    }
+
+    // area weighted mean of the squared distances from p to the planes
+    double error(const math::float3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double e = x * x * a2 + y * y * b2 + z * z * c2 + 2.0 * (x * y * ab + x * z * ac + y * z * bc)
+            + 2.0 * (x * ad + y * bd + z * cd) + d2;
+        return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+    }
+};
+
+struct Collapse
+{
+    uint32_t from;
+    uint32_t to;
+    double cost;
+};
+
+static float pointTriangleDistance(const math::float3& p, const math::float3& a, const math::float3& b,
+    const math::float3& c)
+{
+    // closest point by the voronoi region of p, Ericson, Real-Time Collision Detection 5.1.5
+    math::float3 ab = b - a;
+    math::float3 ac = c - a;
+    math::float3 ap = p - a;
+    float d1 = dot(ab, ap);
+    float d2 = dot(ac, ap);
+    if (d1 <= 0.f && d2 <= 0.f)
+    {
+        return length(ap);
+    }
+    math::float3 bp = p - b;
+    float d3 = dot(ab, bp);
+    float d4 = dot(ac, bp);
+    if (d3 >= 0.f && d4 <= d3)
+    {
+        return length(bp);
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+    {
+        return length(ap - ab * (d1 / (d1 - d3)));
+    }
+    math::float3 cp = p - c;
+    float d5 = dot(ab, cp);
+    float d6 = dot(ac, cp);
+    if (d6 >= 0.f && d5 <= d6)
+    {
+        return length(cp);
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+    {
+        return length(ap - ac * (d2 / (d2 - d6)));
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f)
+    {
+        return length(bp - (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))));
+    }
+    float denom = 1.f / (va + vb + vc);
+    return length(ap - ab * (vb * denom) - ac * (vc * denom));
+}
+
+// largest distance from the vertexes of source to the triangles of result within two rings of the vertex
+// they were collapsed onto. the surface nearest to a vertex may lie on other triangles, so this is an
+// upper bound of the vertex to surface distance
+static float measureError(const std::vector<math::float3>& positions, const uint32_t* source, size_t sourceCount,
+    const std::vector<uint32_t>& vertexRemap, const std::vector<uint32_t>& result)
+{
+    size_t vertexCount = positions.size();
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t v : result)
+    {
+        offsets[v + 1]++;
+    }
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    std::vector<uint32_t> triangles(result.size());
+    for (size_t i = 0; i < result.size(); i++)
+    {
+        triangles[fill[result[i]]++] = (uint32_t)(i / 3);
+    }
+
+    float error = 0.f;
+    std::vector<uint8_t> visited(vertexCount, 0);
+    std::vector<uint32_t> testedBy(result.size() / 3, UINT32_MAX);
+    for (size_t i = 0; i < sourceCount; i++)
+    {
+        uint32_t v = source[i];
+        uint32_t to = vertexRemap[v];
+        if (visited[v] || v == to)
+        {
+            visited[v] = 1;
+            continue;
+        }
+        visited[v] = 1;
+        const math::float3& p = positions[v];
+        float distance = offsets[to] == offsets[to + 1] ? length(p - positions[to]) : FLT_MAX;
+        for (uint32_t k = offsets[to]; k < offsets[to + 1]; k++)
+        {
+            const uint32_t* triangle = &result[triangles[k] * 3];
+            for (int j = 0; j < 3; j++)
+            {
+                uint32_t w = triangle[j];
+                for (uint32_t m = offsets[w]; m < offsets[w + 1]; m++)
+                {
+                    if (testedBy[triangles[m]] == v)
+                    {
+                        continue;
+                    }
+                    testedBy[triangles[m]] = v;
+                    const uint32_t* t = &result[triangles[m] * 3];
+                    distance = std::min(distance, pointTriangleDistance(p, positions[t[0]], positions[t[1]],
+                        positions[t[2]]));
+                }
+            }
+        }
+        error = std::max(error, distance);
+    }
+    return error;
+}
+
+// the collapses of MeshSimplifier::simplify, collapsedTo receives the vertex each vertex ended on
+static void collapseEdges(const std::vector<math::float3>& positions, const uint32_t* indices, size_t indexCount,
+    size_t targetIndexCount, float maxError, std::vector<uint32_t>& result, std::vector<uint32_t>& collapsedTo)
+{
+    result.assign(indices, indices + indexCount / 3 * 3);
+    size_t vertexCount = positions.size();
+    collapsedTo.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        collapsedTo[i] = (uint32_t)i;
+    }
+    if (result.size() <= targetIndexCount || vertexCount == 0)
+    {
+        return;
+    }
+
+    std::vector<uint32_t> welded;
+    VertexUtils::weldPositions(positions, welded);
+
+    // locked positions: shared by several vertexes, or on an edge without exactly two triangles
+    std::vector<uint8_t> locked(vertexCount, 0);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        if (welded[i] != i)
+        {
+            locked[welded[i]] = 1;
+        }
+    }
+    std::vector<uint64_t> edges;
+    edges.reserve(result.size());
+    for (size_t i = 0; i < result.size(); i++)
+    {
+        uint32_t a = welded[result[i]];
+        uint32_t b = welded[result[i - i % 3 + (i % 3 + 1) % 3]];
+        if (a != b)
+        {
+            edges.push_back((uint64_t)std::min(a, b) << 32 | std::max(a, b));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size();)
+    {
+        size_t run = 1;
+        while (i + run < edges.size() && edges[i + run] == edges[i])
+        {
+            run++;
+        }
+        if (run != 2)
+        {
+            locked[edges[i] >> 32] = 1;
+            locked[edges[i] & UINT32_MAX] = 1;
+        }
+        i += run;
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t t = 0; t < result.size() / 3; t++)
+    {
+        const math::float3& p0 = positions[result[t * 3]];
+        math::float3 n = cross(positions[result[t * 3 + 1]] - p0, positions[result[t * 3 + 2]] - p0);
+        float len = length(n);
+        if (!(len > 0.f))
+        {
+            continue;
+        }
+        n /= len;
+        double d = -dot(n, p0);
+        for (int k = 0; k < 3; k++)
+        {
+            quadrics[welded[result[t * 3 + k]]].addPlane(n, d, 0.5 * len);
+        }
+    }
+
+    // the triangles of from that survive a collapse may not turn by more than about 75 degrees,
+    // a plain sign test lets triangles flip over several passes
+    auto keepsOrientation = [&](const uint32_t* triangle, uint32_t from, uint32_t to)
+    {
+        math::float3 p[3];
+        math::float3 q[3];
+        for (int k = 0; k < 3; k++)
+        {
+            p[k] = positions[triangle[k]];
+            q[k] = triangle[k] == from ? positions[to] : p[k];
+        }
+        math::float3 n0 = cross(p[1] - p[0], p[2] - p[0]);
+        math::float3 n1 = cross(q[1] - q[0], q[2] - q[0]);
+        return dot(n0, n1) > 0.25f * length(n0) * length(n1);
+    };
+
+    double maxErrorSq = (double)maxError * maxError;
+    std::vector<uint32_t> adjacencyOffsets;
+    std::vector<uint32_t> adjacency(result.size());
+    std::vector<uint32_t> fill;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<Collapse> collapses;
+    for (int pass = 0; pass < SIMPLIFY_MAX_PASSES && result.size() > targetIndexCount; pass++)
+    {
+        // triangles around each vertex
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        for (uint32_t v : result)
+        {
+            adjacencyOffsets[v + 1]++;
+        }
+        for (size_t i = 0; i < vertexCount; i++)
+        {
+            adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+        }
+        fill.assign(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < result.size(); i++)
+        {
+            adjacency[fill[result[i]]++] = (uint32_t)(i / 3);
+        }
+
+        // cheapest collapse of every free vertex onto one of its neighbours
+        collapses.clear();
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            if (locked[welded[v]])
+            {
+                continue;
+            }
+            Collapse best = { v, v, DBL_MAX };
+            for (uint32_t i = adjacencyOffsets[v]; i < adjacencyOffsets[v + 1]; i++)
+            {
+                const uint32_t* triangle = &result[adjacency[i] * 3];
+                for (int k = 0; k < 3; k++)
+                {
+                    double cost = quadrics[welded[v]].error(positions[triangle[k]]);
+                    if (triangle[k] != v && cost < best.cost)
+                    {
+                        best.to = triangle[k];
+                        best.cost = cost;
+                    }
+                }
+            }
+            if (best.to != v && best.cost <= maxErrorSq)
+            {
+                collapses.push_back(best);
+            }
+        }
+        if (collapses.empty())
+        {
+            break;
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+        {
+            return a.cost < b.cost;
+        });
+
+        // cheapest first, a collapse freezes the triangles around from for the rest of the pass
+        for (size_t i = 0; i < vertexCount; i++)
+        {
+            remap[i] = (uint32_t)i;
+        }
+        std::fill(touched.begin(), touched.end(), 0);
+        size_t removable = (result.size() - targetIndexCount) / 3;
+        size_t removed = 0;
+        for (const Collapse& c : collapses)
+        {
+            if (removed >= removable)
+            {
+                break;
+            }
+            if (touched[c.from] || remap[c.to] != c.to)
+            {
+                continue;
+            }
+            size_t collapsed = 0;
+            bool valid = true;
+            for (uint32_t i = adjacencyOffsets[c.from]; i < adjacencyOffsets[c.from + 1] && valid; i++)
+            {
+                const uint32_t* triangle = &result[adjacency[i] * 3];
+                if (triangle[0] == c.to || triangle[1] == c.to || triangle[2] == c.to)
+                {
+                    collapsed++;
+                }
+                else
+                {
+                    valid = keepsOrientation(triangle, c.from, c.to);
+                }
+            }
+            if (!valid)
+            {
+                continue;
+            }
+
+            remap[c.from] = c.to;
+            quadrics[welded[c.to]].add(quadrics[welded[c.from]]);
+            removed += collapsed;
+            for (uint32_t i = adjacencyOffsets[c.from]; i < adjacencyOffsets[c.from + 1]; i++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    touched[result[adjacency[i] * 3 + k]] = 1;
+                }
+            }
+        }
+        if (removed == 0)
+        {
+            break;
+        }
+        for (uint32_t& to : collapsedTo)
+        {
+            to = remap[to];
+        }
+
+        size_t kept = 0;
+        for (size_t t = 0; t < result.size() / 3; t++)
+        {
+            uint32_t a = remap[result[t * 3]];
+            uint32_t b = remap[result[t * 3 + 1]];
+            uint32_t c = remap[result[t * 3 + 2]];
+            if (a != b && b != c && a != c)
+            {
+                result[kept * 3] = a;
+                result[kept * 3 + 1] = b;
+                result[kept * 3 + 2] = c;
+                kept++;
+            }
+        }
+        result.resize(kept * 3);
+    }
+}
+
+float MeshSimplifier::simplify(const VertexArray& vertexArray, const uint32_t* indices, size_t indexCount,
+    size_t targetIndexCount, float maxError, std::vector<uint32_t>& result)
+{
+    PROFILE_ZONE("MeshSimplifier::simplify");
+    std::vector<math::float3> positions;
+    VertexUtils::getPositions(vertexArray, positions);
+    std::vector<uint32_t> collapsedTo;
+    collapseEdges(positions, indices, indexCount, targetIndexCount, maxError, result, collapsedTo);
+    return measureError(positions, indices, indexCount / 3 * 3, collapsedTo, result);
+}
+
+void MeshSimplifier::buildLods(const VertexArray& vertexArray, std::vector<uint32_t>& indices,
+    std::vector<MeshLod>& lods)
+{
+    PROFILE_ZONE("MeshSimplifier::buildLods");
+    lods.clear();
+    lods.push_back({ 0, (uint32_t)indices.size(), 0.f });
+
+    std::vector<math::float3> positions;
+    VertexUtils::getPositions(vertexArray, positions);
+    math::float3 boxMin(FLT_MAX);
+    math::float3 boxMax(-FLT_MAX);
+    for (uint32_t v : indices)
+    {
+        boxMin = min(boxMin, positions[v]);
+        boxMax = max(boxMax, positions[v]);
+    }
+    float maxError = indices.empty() ? 0.f : MESH_LOD_MAX_ERROR * length(boxMax - boxMin);
+
+    // each level simplifies the previous one and is measured against the full mesh, through the
+    // collapses of the whole chain
+    size_t fullCount = indices.size();
+    std::vector<uint32_t> level(indices.begin(), indices.end());
+    std::vector<uint32_t> simplified;
+    std::vector<uint32_t> levelRemap;
+    std::vector<uint32_t> chainRemap;
+    while (lods.size() < MESH_MAX_LODS && level.size() / 3 >= MESH_LOD_MIN_TRIANGLES)
+    {
+        collapseEdges(positions, level.data(), level.size(), level.size() / 6 * 3, maxError, simplified, levelRemap);
+        if ((float)simplified.size() > (float)level.size() * MESH_LOD_MAX_KEPT)
+        {
+            break;
+        }
+        if (chainRemap.empty())
+        {
+            chainRemap = levelRemap;
+        }
+        else
+        {
+            for (uint32_t& to : chainRemap)
+            {
+                to = levelRemap[to];
+            }
+        }
+        // selection walks the chain assuming errors never decrease
+        float error = std::max(lods.back().error,
+            measureError(positions, indices.data(), fullCount, chainRemap, simplified));
+        if (error > maxError)
+        {
+            break;
+        }
+        lods.push_back({ (uint32_t)indices.size(), (uint32_t)simplified.size(), error });
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        level.swap(simplified);
+    }
+}
+
+void MeshSimplifier::buildLods(ModelMesh& mesh)
+{
+    if (!mesh.lods.empty())
+    {
+        return;
+    }
+    std::vector<uint32_t> indices = mesh.getIndices();
+    std::vector<MeshLod> lods;
+    buildLods(mesh.vertexes, indices, lods);
+    if (lods.size() > 1)
+    {
+        mesh.setIndices(indices);
+        mesh.lods = std::move(lods);
+    }
+}
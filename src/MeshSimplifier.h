@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "render/Vertex.h"
+
+struct ModelMesh;
+
+// levels of a LOD chain including the full mesh
+constexpr uint32_t MESH_MAX_LODS = 4;
+
+// One level of detail, a range of the mesh index buffer sharing the vertexes of the full mesh.
+// error: largest distance from a vertex of the full mesh to the level surface, in mesh units, measured
+// against the level triangles near the vertex it was collapsed onto. Stored as is in mesh cache files.
+struct MeshLod
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    float error;
+};
+static_assert(sizeof(MeshLod) == 12, "MeshLod layout is part of the mesh cache format");
+
+// Quadric error metric simplification by edge collapses onto existing vertexes, so that every level
+// keeps indexing the vertex buffer of the full mesh. Each pass collapses the cheapest edges with
+// independent neighbourhoods, collapses flipping a triangle are rejected. Vertexes on open borders
+// and on attribute seams (positions shared by several vertexes) are never moved, which keeps
+// silhouettes and texture seams intact at the cost of weaker reduction around them.
+class MeshSimplifier
+{
+public:
+    // simplify the triangles of indices towards targetIndexCount, positions are the first attribute of
+    // vertexArray. collapses are ranked by quadric error, the area weighted RMS distance to the planes
+    // of the merged triangles, and skipped above maxError: the quadric only steers the collapses.
+    // returns the measured error of the result against indices, as in MeshLod::error
+    static float simplify(const VertexArray& vertexArray, const uint32_t* indices, size_t indexCount,
+        size_t targetIndexCount, float maxError, std::vector<uint32_t>& result);
+
+    // halve the triangle count level by level while it pays off and the measured error of the level
+    // stays in budget. indices holds the full mesh and receives the coarser levels after it, lods[0] is
+    // the full mesh
+    static void buildLods(const VertexArray& vertexArray, std::vector<uint32_t>& indices,
+        std::vector<MeshLod>& lods);
+
+    // build the LOD chain of mesh, its indices are replaced by owned ones with the chain appended
+    static void buildLods(ModelMesh& mesh);
+};
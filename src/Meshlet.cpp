@@ -0,0 +1,358 @@
+#include "Meshlet.h"
+#include "Model.h"
+#include "base/Profiler.h"
+#include "math/frustum.h"
+#include "render/VertexUtils.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// normals closer than this to the plane of the cone base make the cone useless
+static constexpr float MESHLET_MIN_CONE_DOT = 0.1f;
+
+static void computeBounds(const std::vector<math::float3>& positions, const uint32_t* indices, size_t indexCount,
+    Meshlet& meshlet)
+{
+    math::float3 boxMin(FLT_MAX);
+    math::float3 boxMax(-FLT_MAX);
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        const math::float3& p = positions[indices[i]];
+        boxMin = min(boxMin, p);
+        boxMax = max(boxMax, p);
+    }
+    meshlet.center = (boxMin + boxMax) * 0.5f;
+    float radius2 = 0.f;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        math::float3 d = positions[indices[i]] - meshlet.center;
+        radius2 = std::max(radius2, dot(d, d));
+    }
+    meshlet.radius = std::sqrt(radius2);
+
+    // cone around the area weighted average normal, degenerate triangles are ignored
+    size_t triangleCount = indexCount / 3;
+    std::vector<math::float3> normals;
+    std::vector<math::float3> corners;
+    normals.reserve(triangleCount);
+    corners.reserve(triangleCount);
+    math::float3 axis(0.f);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        const math::float3& p0 = positions[indices[t * 3]];
+        math::float3 n = cross(positions[indices[t * 3 + 1]] - p0, positions[indices[t * 3 + 2]] - p0);
+        float len = length(n);
+        if (len > 0.f)
+        {
+            axis += n;
+            normals.push_back(n / len);
+            corners.push_back(p0);
+        }
+    }
+
+    meshlet.coneAxis = math::float3(0.f, 0.f, 1.f);
+    meshlet.coneApex = meshlet.center;
+    meshlet.coneCutoff = 1.f;
+    float axisLen = length(axis);
+    if (normals.empty() || !(axisLen > 0.f))
+    {
+        return;
+    }
+    axis /= axisLen;
+
+    float minDot = 1.f;
+    for (auto& n : normals)
+    {
+        minDot = std::min(minDot, dot(axis, n));
+    }
+    if (minDot <= MESHLET_MIN_CONE_DOT)
+    {
+        return;
+    }
+
+    // apex behind every triangle plane along the axis, so the test holds for eyes close to the meshlet
+    float maxT = 0.f;
+    for (size_t i = 0; i < normals.size(); i++)
+    {
+        float t = dot(meshlet.center - corners[i], normals[i]) / dot(axis, normals[i]);
+        maxT = std::max(maxT, t);
+    }
+    meshlet.coneAxis = axis;
+    meshlet.coneApex = meshlet.center - axis * maxT;
+    meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+}
+
+void MeshletBuilder::build(const VertexArray& vertexArray, uint32_t* indices, size_t indexCount,
+    std::vector<Meshlet>& meshlets)
+{
+    PROFILE_ZONE("MeshletBuilder::build");
+    meshlets.clear();
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0 || vertexArray.vertexSize == 0 || vertexArray.vertexesDesc.empty())
+    {
+        return;
+    }
+
+    std::vector<math::float3> positions;
+    VertexUtils::getPositions(vertexArray, positions);
+    size_t vertexCount = positions.size();
+
+    std::vector<uint32_t> triangles(indices, indices + triangleCount * 3);
+    std::vector<math::float3> centroids(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        centroids[t] = (positions[triangles[t * 3]] + positions[triangles[t * 3 + 1]]
+            + positions[triangles[t * 3 + 2]]) / 3.f;
+    }
+
+    // triangles around each position, vertexes split by other attributes are welded so that
+    // meshes without shared vertexes still have neighbours
+    std::vector<uint32_t> welded;
+    VertexUtils::weldPositions(positions, welded);
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (uint32_t v : triangles)
+    {
+        adjacencyOffsets[welded[v] + 1]++;
+    }
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+    }
+    std::vector<uint32_t> adjacency(triangles.size());
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        adjacency[fill[welded[triangles[i]]]++] = (uint32_t)(i / 3);
+    }
+
+    // live: triangles left around each position, seeds and ties prefer triangles in corners of the
+    // remaining surface so that meshlets do not leave small islands behind
+    std::vector<uint32_t> live(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        live[i] = adjacencyOffsets[i + 1] - adjacencyOffsets[i];
+    }
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> vertexMeshlet(vertexCount, UINT32_MAX);       // meshlet the vertex was last added to
+    std::vector<uint32_t> candidateMeshlet(triangleCount, UINT32_MAX);  // meshlet the triangle was queued for
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> frontier;
+    std::vector<uint32_t> ordered;
+    ordered.reserve(triangles.size());
+
+    uint32_t meshletIdx = 0;
+    uint32_t meshletVertexes = 0;
+    uint32_t meshletTriangles = 0;
+    size_t meshletBegin = 0;
+    math::float3 centroidSum(0.f);
+    math::float3 boxMin(FLT_MAX);
+    math::float3 boxMax(-FLT_MAX);
+    size_t cursor = 0;
+
+    auto newVertexes = [&](size_t t)
+    {
+        uint32_t cnt = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            cnt += vertexMeshlet[triangles[t * 3 + k]] != meshletIdx ? 1 : 0;
+        }
+        return cnt;
+    };
+
+    auto liveNeighbours = [&](size_t t)
+    {
+        return live[welded[triangles[t * 3]]] + live[welded[triangles[t * 3 + 1]]] + live[welded[triangles[t * 3 + 2]]];
+    };
+
+    auto closeMeshlet = [&]()
+    {
+        Meshlet meshlet{};
+        meshlet.indexOffset = (uint32_t)meshletBegin;
+        meshlet.indexCount = (uint32_t)(ordered.size() - meshletBegin);
+        meshlet.vertexCount = meshletVertexes;
+        computeBounds(positions, ordered.data() + meshletBegin, meshlet.indexCount, meshlet);
+        meshlets.push_back(meshlet);
+
+        meshletIdx++;
+        meshletVertexes = 0;
+        meshletTriangles = 0;
+        meshletBegin = ordered.size();
+        centroidSum = math::float3(0.f);
+        boxMin = math::float3(FLT_MAX);
+        boxMax = math::float3(-FLT_MAX);
+        frontier.swap(candidates);
+        candidates.clear();
+    };
+
+    auto addTriangle = [&](size_t t)
+    {
+        emitted[t] = 1;
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t v = triangles[t * 3 + k];
+            uint32_t w = welded[v];
+            ordered.push_back(v);
+            live[w]--;
+            if (vertexMeshlet[v] == meshletIdx)
+            {
+                continue;
+            }
+            vertexMeshlet[v] = meshletIdx;
+            meshletVertexes++;
+            boxMin = min(boxMin, positions[v]);
+            boxMax = max(boxMax, positions[v]);
+            for (uint32_t i = adjacencyOffsets[w]; i < adjacencyOffsets[w + 1]; i++)
+            {
+                uint32_t n = adjacency[i];
+                if (!emitted[n] && candidateMeshlet[n] != meshletIdx)
+                {
+                    candidateMeshlet[n] = meshletIdx;
+                    candidates.push_back(n);
+                }
+            }
+        }
+        meshletTriangles++;
+        centroidSum += centroids[t];
+    };
+
+    // next seed: the triangle of the previous meshlet border with the fewest live neighbours
+    auto findSeed = [&]()
+    {
+        size_t seed = SIZE_MAX;
+        uint32_t seedLive = UINT32_MAX;
+        for (uint32_t t : frontier)
+        {
+            if (!emitted[t] && liveNeighbours(t) < seedLive)
+            {
+                seed = t;
+                seedLive = liveNeighbours(t);
+            }
+        }
+        if (seed == SIZE_MAX)
+        {
+            while (emitted[cursor])
+            {
+                cursor++;
+            }
+            seed = cursor;
+        }
+        return seed;
+    };
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        // best adjacent triangle: fewest new vertexes, then fewest live neighbours, then closest
+        size_t best = SIZE_MAX;
+        uint32_t bestNew = 4;
+        uint32_t bestLive = UINT32_MAX;
+        float bestDist = FLT_MAX;
+        math::float3 center = meshletTriangles > 0 ? centroidSum / (float)meshletTriangles : math::float3(0.f);
+        size_t kept = 0;
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            uint32_t t = candidates[i];
+            if (emitted[t])
+            {
+                continue;
+            }
+            candidates[kept++] = t;
+            uint32_t cnt = newVertexes(t);
+            if (meshletVertexes + cnt > MESHLET_MAX_VERTEXES || cnt > bestNew)
+            {
+                continue;
+            }
+            uint32_t liveCnt = liveNeighbours(t);
+            math::float3 d = centroids[t] - center;
+            float dist = dot(d, d);
+            if (cnt < bestNew || liveCnt < bestLive || (liveCnt == bestLive && dist < bestDist))
+            {
+                best = t;
+                bestNew = cnt;
+                bestLive = liveCnt;
+                bestDist = dist;
+            }
+        }
+        candidates.resize(kept);
+
+        if (best == SIZE_MAX)
+        {
+            // a disconnected triangle only joins a meshlet with room when it is within the meshlet size
+            if (meshletTriangles > 0)
+            {
+                best = findSeed();
+                float dist = length(centroids[best] - center);
+                if (meshletVertexes + newVertexes(best) > MESHLET_MAX_VERTEXES || dist > length(boxMax - boxMin))
+                {
+                    closeMeshlet();
+                    best = findSeed();
+                }
+            }
+            else
+            {
+                best = findSeed();
+            }
+        }
+
+        addTriangle(best);
+        if (meshletTriangles == MESHLET_MAX_TRIANGLES)
+        {
+            closeMeshlet();
+        }
+    }
+    if (meshletTriangles > 0)
+    {
+        closeMeshlet();
+    }
+    std::copy(ordered.begin(), ordered.end(), indices);
+}
+
+void MeshletBuilder::build(ModelMesh& mesh)
+{
+    // only the full detail level is clustered, the LOD chain after it is drawn whole
+    std::vector<uint32_t> indices = mesh.getIndices();
+    build(mesh.vertexes, indices.data(), mesh.getLodRange(0).count, mesh.meshletData);
+
+    mesh.setIndices(indices);
+    mesh.meshlets = mesh.meshletData.data();
+    mesh.meshletCount = mesh.meshletData.size();
+}
+
+void MeshletCuller::cull(const Meshlet* meshlets, size_t count, const math::mat4f& modelViewProjection,
+    const math::float3& eye, bool backFaces, std::vector<IndexRange>& ranges, MeshletCullStats& stats)
+{
+    math::Frustum frustum(modelViewProjection);
+    frustum.normalizePlanes();
+
+    stats.tested += count;
+    size_t firstRange = ranges.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        const Meshlet& m = meshlets[i];
+        if (!frustum.intersectsSphere(m.center, m.radius))
+        {
+            stats.frustumCulled++;
+            continue;
+        }
+        if (backFaces && m.coneCutoff < 1.f)
+        {
+            math::float3 dir = m.coneApex - eye;
+            float len = length(dir);
+            if (len > 0.f && dot(dir, m.coneAxis) >= m.coneCutoff * len)
+            {
+                stats.coneCulled++;
+                continue;
+            }
+        }
+
+        if (ranges.size() > firstRange && ranges.back().offset + ranges.back().count == m.indexOffset)
+        {
+            ranges.back().count += m.indexCount;
+        }
+        else
+        {
+            ranges.push_back({ m.indexOffset, m.indexCount });
+        }
+    }
+}
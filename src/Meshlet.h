@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "base/MathInc.h"
+#include "render/Vertex.h"
+
+struct ModelMesh;
+
+// limits of one meshlet, 124 triangles keep the 372 indices of a full meshlet below 384
+constexpr uint32_t MESHLET_MAX_VERTEXES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+// Cluster of adjacent triangles, a contiguous range of the mesh index buffer. Bounds are in mesh space:
+// the sphere holds the vertexes and the normal cone the triangle normals. Every triangle faces away from
+// an eye that sees the cone from behind, dot(normalize(coneApex - eye), coneAxis) >= coneCutoff.
+// coneCutoff is 1 when the normals spread too much for a cone. Stored as is in mesh cache files.
+struct Meshlet
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    math::float3 center;
+    float radius;
+    math::float3 coneApex;
+    math::float3 coneAxis;
+    float coneCutoff;
+    uint32_t vertexCount;
+};
+static_assert(sizeof(Meshlet) == 56, "Meshlet layout is part of the mesh cache format");
+
+// Greedy meshlet construction: a meshlet grows by the adjacent triangle adding the fewest new
+// vertexes, ties broken by the distance to the meshlet centroid to keep the bounds tight.
+// A meshlet is closed when full or when no adjacent triangle is left and the next unused one is far.
+class MeshletBuilder
+{
+public:
+    // split the triangles of indices[0, indexCount) and reorder them meshlet by meshlet in place,
+    // positions are the first attribute of vertexArray, its index buffer is not used
+    static void build(const VertexArray& vertexArray, uint32_t* indices, size_t indexCount,
+        std::vector<Meshlet>& meshlets);
+
+    // build the meshlets of the first level of detail of mesh and replace its indices by the
+    // reordered ones, owned by the mesh
+    static void build(ModelMesh& mesh);
+};
+
+struct MeshletCullStats
+{
+    size_t tested = 0;
+    size_t frustumCulled = 0;
+    size_t coneCulled = 0;
+};
+
+class MeshletCuller
+{
+public:
+    // append the index ranges of the meshlets that may be visible, consecutive meshlets are merged.
+    // modelViewProjection: projection * view * model, eye: camera position in mesh space.
+    // backFaces rejects meshlets facing away from eye, only for single sided materials and model
+    // matrices without non-uniform scale
+    static void cull(const Meshlet* meshlets, size_t count, const math::mat4f& modelViewProjection,
+        const math::float3& eye, bool backFaces, std::vector<IndexRange>& ranges, MeshletCullStats& stats);
+};
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "base/FileUtils.h"
+#include "base/MathInc.h"
+#include "math/aabb.h"
+#include "render/Vertex.h"
+#include "render/VertexUtils.h"
+#include "Meshlet.h"
+#include "MeshSimplifier.h"
+
+// vertex attributes of model meshes, VertexArray::vertexesDesc lists the present ones in this order
+enum ModelAttribute
+{
+    ModelAttribute_POSITION,
+    ModelAttribute_TEXCOORD,
+    ModelAttribute_NORMAL,
+    ModelAttribute_TANGENT,
+    ModelAttribute_COUNT,
+};
+
+// components of each attribute seen by the shader
+constexpr uint32_t MODEL_ATTRIBUTE_SIZES[ModelAttribute_COUNT] = { 3, 2, 3, 4 };
+
+enum AlphaMode
+{
+    AlphaMode_OPAQUE,
+    AlphaMode_MASK,
+    AlphaMode_BLEND,
+};
+
+// metallic roughness material, images are indices into Model::images, -1 if absent
+struct ModelMaterial
+{
+    math::float4 baseColorFactor = math::float4(1.f);
+    math::float3 emissiveFactor = math::float3(0.f);
+    float metallicFactor = 1.f;
+    float roughnessFactor = 1.f;
+    int alphaMode = AlphaMode_OPAQUE;
+    float alphaCutoff = 0.5f;
+    bool doubleSided = false;
+
+    int baseColorImage = -1;
+    int metallicRoughnessImage = -1;
+    int normalImage = -1;
+    int occlusionImage = -1;
+    int emissiveImage = -1;
+};
+
+struct ModelImage
+{
+    std::string name;
+    std::string path;   // image file, empty for images embedded in the model
+};
+
+// one triangle list with a single material, the unit of a draw call. vertexes points either
+// into Model::files (zero-copy) or into vertexData / indexData below
+struct ModelMesh
+{
+    VertexArray vertexes;
+    uint32_t attributeMask = 0;     // bit per ModelAttribute
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    int material = -1;
+    math::AABB bounds;
+
+    bool zeroCopyVertexes = false;
+    bool zeroCopyIndices = false;
+    std::vector<uint8_t> vertexData;
+    std::vector<int32_t> indexData;
+
+    // clusters of the index buffer for culling, none until built. point into meshletData or a cache file
+    const Meshlet* meshlets = nullptr;
+    size_t meshletCount = 0;
+    std::vector<Meshlet> meshletData;
+
+    // coarser levels stored after the full mesh in the index buffer, empty until built. meshlets
+    // cover the full mesh only
+    std::vector<MeshLod> lods;
+
+    ModelMesh() = default;
+    ModelMesh(const ModelMesh&) = delete;
+    ModelMesh& operator=(const ModelMesh&) = delete;
+    ModelMesh(ModelMesh&&) = default;
+    ModelMesh& operator=(ModelMesh&&) = default;
+
+    inline bool hasAttribute(ModelAttribute attribute) const
+    {
+        return (attributeMask >> attribute) & 1u;
+    }
+
+    // desc of a present attribute in vertexes.vertexesDesc, nullptr if absent
+    inline const VertexAttributeDesc* getAttributeDesc(ModelAttribute attribute) const
+    {
+        if (!hasAttribute(attribute))
+        {
+            return nullptr;
+        }
+        size_t idx = 0;
+        for (int k = 0; k < attribute; k++)
+        {
+            idx += hasAttribute((ModelAttribute)k) ? 1 : 0;
+        }
+        return &vertexes.vertexesDesc[idx];
+    }
+
+    inline size_t getLodCount() const
+    {
+        return lods.empty() ? 1 : lods.size();
+    }
+
+    // index range of a level of detail, level 0 is the full mesh
+    inline IndexRange getLodRange(size_t level) const
+    {
+        if (lods.empty())
+        {
+            return { 0, (uint32_t)indexCount };
+        }
+        return { lods[level].indexOffset, lods[level].indexCount };
+    }
+
+    inline float getLodError(size_t level) const
+    {
+        return lods.empty() ? 0.f : lods[level].error;
+    }
+
+    inline std::vector<uint32_t> getIndices() const
+    {
+        std::vector<uint32_t> indices(indexCount);
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            indices[i] = VertexUtils::getIndex(vertexes, i);
+        }
+        return indices;
+    }
+
+    // replace the indices by owned int32 ones
+    inline void setIndices(const std::vector<uint32_t>& indices)
+    {
+        indexData.assign(indices.begin(), indices.end());
+        indexCount = indexData.size();
+        vertexes.indexBuffer = indexData.data();
+        vertexes.indexBufferLength = indexData.size() * sizeof(int32_t);
+        vertexes.indexType = Index_UINT32;
+        zeroCopyIndices = false;
+    }
+};
+
+// parents are before their children
+struct ModelNode
+{
+    std::string name;
+    int parent = -1;
+    math::mat4f localMatrix;
+    std::vector<uint32_t> meshes;   // indices into Model::meshes
+};
+
+struct ModelLoadStats
+{
+    size_t meshCount = 0;
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+    size_t meshletCount = 0;
+    size_t lodCount = 0;        // coarser levels of detail over all meshes
+    size_t imageCount = 0;
+
+    // bytes referenced in place vs converted into owned arrays
+    size_t zeroCopyBytes = 0;
+    size_t convertedBytes = 0;
+
+    double parseMillis = 0;     // map files and parse json
+    double meshMillis = 0;      // build vertex arrays
+    double totalMillis = 0;
+};
+
+class Model
+{
+public:
+    std::string path;
+    std::vector<ModelMesh> meshes;
+    std::vector<ModelMaterial> materials;
+    std::vector<ModelImage> images;
+    std::vector<ModelNode> nodes;
+    math::AABB bounds;              // of the meshes in model space, node transforms applied
+
+    ModelLoadStats stats;
+
+private:
+    friend class GLTFLoader;
+    friend class MeshCache;
+
+    // storage the zero-copy vertex arrays point into, kept for the lifetime of the model
+    std::vector<std::shared_ptr<MappedFile>> files_;
+    std::vector<std::vector<uint8_t>> buffers_;
+};
@@ -0,0 +1,274 @@
+#include "OcclusionCuller.h"
+#include "base/ParallelUtils.h"
+#include "base/Profiler.h"
+#include "base/Timer.h"
+#include "math/simd.h"
+#include "math/transform.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <future>
+
+// clip w below this is treated as crossing the near plane
+static constexpr float OCCLUSION_MIN_W = 1e-5f;
+
+void OcclusionCuller::begin(const math::mat4f& viewProjection)
+{
+    viewProjection_ = viewProjection;
+    depth_.assign(OCCLUSION_WIDTH * OCCLUSION_HEIGHT, 1.f);
+    triangles_.clear();
+    stats_ = OcclusionStats();
+}
+
+void OcclusionCuller::addOccluder(const OccluderMesh& mesh, const math::mat4f& model)
+{
+    Timer timer;
+    clipPositions_.resize(mesh.positions.size());
+    math::transformPoints(viewProjection_ * model, mesh.positions.data(), clipPositions_.data(),
+        mesh.positions.size());
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        setupTriangle(clipPositions_[mesh.indices[i]], clipPositions_[mesh.indices[i + 1]],
+            clipPositions_[mesh.indices[i + 2]]);
+    }
+    stats_.rasterMillis += timer.elapseMillis();
+}
+
+void OcclusionCuller::setupTriangle(const math::float4& v0, const math::float4& v1, const math::float4& v2)
+{
+    // skipping an occluder triangle only makes the test less effective, never wrong
+    const math::float4* clip[3] = { &v0, &v1, &v2 };
+    float x[3], y[3];
+    float depth = -1.f;
+    for (int i = 0; i < 3; i++)
+    {
+        const math::float4& v = *clip[i];
+        if (!(v.w > OCCLUSION_MIN_W) || v.z < -v.w)
+        {
+            return;
+        }
+        float invW = 1.f / v.w;
+        x[i] = (v.x * invW * 0.5f + 0.5f) * (float)OCCLUSION_WIDTH;
+        y[i] = (v.y * invW * 0.5f + 0.5f) * (float)OCCLUSION_HEIGHT;
+        depth = std::max(depth, v.z * invW);
+    }
+
+    // counter clockwise on screen, either facing is rasterized
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (std::abs(area) < 1e-6f)
+    {
+        return;
+    }
+    if (area < 0.f)
+    {
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+    }
+
+    // pixels with the center px + 0.5, py + 0.5 in the bounding box
+    Triangle tri;
+    tri.minX = std::max(0, (int)std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5f));
+    tri.maxX = std::min(OCCLUSION_WIDTH - 1, (int)std::floor(std::max({ x[0], x[1], x[2] }) - 0.5f));
+    tri.minY = std::max(0, (int)std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5f));
+    tri.maxY = std::min(OCCLUSION_HEIGHT - 1, (int)std::floor(std::max({ y[0], y[1], y[2] }) - 0.5f));
+    if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+    {
+        return;
+    }
+
+    // a shared edge is set up from the same vertices in opposite order. c is computed with the
+    // vertices in a fixed order, so the edge function is the exact negation whether or not the
+    // products are contracted, and exactly one of the two orders is top-left: no center is dropped
+    // or written by both triangles
+    for (int i = 0; i < 3; i++)
+    {
+        int j = (i + 1) % 3;
+        float a = y[i] - y[j];
+        float b = x[j] - x[i];
+        bool swapped = x[i] > x[j] || (x[i] == x[j] && y[i] > y[j]);
+        int p = swapped ? j : i;
+        int q = swapped ? i : j;
+        float c = x[p] * y[q] - y[p] * x[q];
+        tri.a[i] = a;
+        tri.b[i] = b;
+        tri.c[i] = swapped ? -c : c;
+        tri.topLeft[i] = a > 0.f || (a == 0.f && b < 0.f);
+    }
+    tri.depth = depth;
+    triangles_.push_back(tri);
+}
+
+void OcclusionCuller::rasterize(ThreadPool* pool)
+{
+    PROFILE_ZONE("OcclusionCuller::rasterize");
+    Timer timer;
+
+    constexpr int bandCnt = OCCLUSION_HEIGHT / OCCLUSION_BAND_HEIGHT;
+    if (!pool || triangles_.empty())
+    {
+        rasterizeBand(0, OCCLUSION_HEIGHT);
+    }
+    else
+    {
+        // bands write disjoint rows, the caller takes the first one
+        std::vector<std::future<void>> futures;
+        for (int band = 1; band < bandCnt; band++)
+        {
+            futures.push_back(pool->pushTask([this, band]() {
+                rasterizeBand(band * OCCLUSION_BAND_HEIGHT, (band + 1) * OCCLUSION_BAND_HEIGHT);
+            }));
+        }
+        rasterizeBand(0, OCCLUSION_BAND_HEIGHT);
+        for (auto& f : futures)
+        {
+            f.wait();
+        }
+    }
+
+    stats_.occluderTriangles = triangles_.size();
+    stats_.rasterMillis += timer.elapseMillis();
+}
+
+void OcclusionCuller::rasterizeBand(int beginY, int endY)
+{
+    using math::simd::float8;
+    using math::simd::mask8;
+
+    for (const Triangle& tri : triangles_)
+    {
+        int y0 = std::max(tri.minY, beginY);
+        int y1 = std::min(tri.maxY, endY - 1);
+        if (y0 > y1)
+        {
+            continue;
+        }
+
+        auto edge = [&tri](int i, const float8& e) { return tri.topLeft[i] ? e >= 0.f : e > 0.f; };
+        float8 a0(tri.a[0]), a1(tri.a[1]), a2(tri.a[2]);
+        float8 depth(tri.depth);
+        int x0 = tri.minX & ~(int)(math::simd::WIDTH - 1);
+        for (int y = y0; y <= y1; y++)
+        {
+            float cy = (float)y + 0.5f;
+            float8 r0(tri.b[0] * cy + tri.c[0]);
+            float8 r1(tri.b[1] * cy + tri.c[1]);
+            float8 r2(tri.b[2] * cy + tri.c[2]);
+            float* row = &depth_[y * OCCLUSION_WIDTH];
+
+            // lanes outside [minX, maxX] fail an edge test, the spans never leave the row
+            for (int x = x0; x <= tri.maxX; x += (int)math::simd::WIDTH)
+            {
+                float8 px = float8::ramp((float)x + 0.5f, 1.f);
+                mask8 inside = edge(0, fma(a0, px, r0)) & edge(1, fma(a1, px, r1)) & edge(2, fma(a2, px, r2));
+                if (none(inside))
+                {
+                    continue;
+                }
+                float8 d = float8::load(row + x);
+                min(d, depth).store(row + x, inside);
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::isVisible(const math::AABB& box) const
+{
+    using math::simd::float8;
+    using math::simd::mask8;
+
+    // the 8 corners in the lanes, boxes crossing the near plane are visible
+    const math::mat4f& m = viewProjection_;
+    float8 cx(box.min.x, box.max.x, box.min.x, box.max.x, box.min.x, box.max.x, box.min.x, box.max.x);
+    float8 cy(box.min.y, box.min.y, box.max.y, box.max.y, box.min.y, box.min.y, box.max.y, box.max.y);
+    float8 cz(box.min.z, box.min.z, box.min.z, box.min.z, box.max.z, box.max.z, box.max.z, box.max.z);
+    float8 w = fma(m[0][3], cx, fma(m[1][3], cy, fma(m[2][3], cz, m[3][3])));
+    if (!all(w > OCCLUSION_MIN_W))
+    {
+        return true;
+    }
+    float8 invW = 1.f / w;
+    float8 x = fma(m[0][0], cx, fma(m[1][0], cy, fma(m[2][0], cz, m[3][0]))) * invW;
+    float8 y = fma(m[0][1], cx, fma(m[1][1], cy, fma(m[2][1], cz, m[3][1]))) * invW;
+    float8 z = fma(m[0][2], cx, fma(m[1][2], cy, fma(m[2][2], cz, m[3][2]))) * invW;
+
+    // screen rectangle and nearest depth of the corners
+    alignas(32) float lanes[3][math::simd::WIDTH];
+    x.store(lanes[0]);
+    y.store(lanes[1]);
+    z.store(lanes[2]);
+    float minX = lanes[0][0], maxX = lanes[0][0];
+    float minY = lanes[1][0], maxY = lanes[1][0];
+    float minZ = lanes[2][0];
+    for (size_t i = 1; i < math::simd::WIDTH; i++)
+    {
+        minX = std::min(minX, lanes[0][i]);
+        maxX = std::max(maxX, lanes[0][i]);
+        minY = std::min(minY, lanes[1][i]);
+        maxY = std::max(maxY, lanes[1][i]);
+        minZ = std::min(minZ, lanes[2][i]);
+    }
+    minX = (minX * 0.5f + 0.5f) * (float)OCCLUSION_WIDTH;
+    maxX = (maxX * 0.5f + 0.5f) * (float)OCCLUSION_WIDTH;
+    minY = (minY * 0.5f + 0.5f) * (float)OCCLUSION_HEIGHT;
+    maxY = (maxY * 0.5f + 0.5f) * (float)OCCLUSION_HEIGHT;
+
+    // occluders are sampled at pixel centers, so every point of the rectangle must have the centers
+    // around it tested: the pixels whose centers are within half a pixel of the rectangle
+    int x0 = std::max(0, (int)std::floor(minX - 0.5f));
+    int x1 = std::min(OCCLUSION_WIDTH - 1, (int)std::floor(maxX + 0.5f));
+    int y0 = std::max(0, (int)std::floor(minY - 0.5f));
+    int y1 = std::min(OCCLUSION_HEIGHT - 1, (int)std::floor(maxY + 0.5f));
+    if (x0 > x1 || y0 > y1)
+    {
+        return true;
+    }
+
+    float8 boxDepth(minZ);
+    float8 first((float)x0), last((float)x1);
+    int xBegin = x0 & ~(int)(math::simd::WIDTH - 1);
+    for (int y = y0; y <= y1; y++)
+    {
+        const float* row = &depth_[y * OCCLUSION_WIDTH];
+        for (int x = xBegin; x <= x1; x += (int)math::simd::WIDTH)
+        {
+            float8 px = float8::ramp((float)x, 1.f);
+            mask8 inRect = (px >= first) & (px <= last);
+            if (any(inRect & (float8::load(row + x) >= boxDepth)))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+size_t OcclusionCuller::cull(const math::AABBArray& boxes, std::vector<uint32_t>& indices, ThreadPool* pool)
+{
+    PROFILE_ZONE("OcclusionCuller::cull");
+    Timer timer;
+
+    visibleFlags_.resize(indices.size());
+    ParallelUtils::parallelRange(indices.size(), pool, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            visibleFlags_[i] = isVisible(boxes.get(indices[i])) ? 1 : 0;
+        }
+    });
+
+    size_t kept = 0;
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        if (visibleFlags_[i])
+        {
+            indices[kept++] = indices[i];
+        }
+    }
+    size_t occluded = indices.size() - kept;
+    indices.resize(kept);
+
+    stats_.objectsTested += visibleFlags_.size();
+    stats_.objectsOccluded += occluded;
+    stats_.testMillis += timer.elapseMillis();
+    return occluded;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "base/MathInc.h"
+#include "base/ThreadPool.h"
+#include "math/aabb.h"
+
+// coarse depth buffer, width is a multiple of the simd width
+constexpr int OCCLUSION_WIDTH = 256;
+constexpr int OCCLUSION_HEIGHT = 128;
+// rows rasterized by one task
+constexpr int OCCLUSION_BAND_HEIGHT = 16;
+
+// triangles of a closed, simplified mesh that hides what is behind it
+struct OccluderMesh
+{
+    std::vector<math::float3> positions;
+    std::vector<uint32_t> indices;
+};
+
+struct OcclusionStats
+{
+    size_t occluderTriangles = 0;   // triangles rasterized, after near plane and screen rejection
+    size_t objectsTested = 0;
+    size_t objectsOccluded = 0;
+
+    // latest frame
+    double rasterMillis = 0;
+    double testMillis = 0;
+};
+
+// Software occlusion culling against a low resolution depth buffer. Occluders are rasterized
+// watertight: a pixel is written when the triangle covers its center, ties on shared edges follow
+// the top-left rule, and the depth written is the farthest depth of the triangle. Boxes are tested
+// with the nearest depth of their corners over the pixel centers around their projection, so an
+// object is only culled when it is hidden everywhere, gaps below a pixel between occluders aside.
+// Rows are rasterized 8 pixels at a time, bands of rows and box tests are split across the pool.
+class OcclusionCuller
+{
+public:
+    // clear the depth buffer and drop the queued occluders
+    void begin(const math::mat4f& viewProjection);
+
+    // queue the triangles of mesh placed by model, triangles crossing the near plane are skipped
+    void addOccluder(const OccluderMesh& mesh, const math::mat4f& model);
+
+    // rasterize the queued occluders
+    void rasterize(ThreadPool* pool = nullptr);
+
+    // false when the box is hidden behind the occluders, call after rasterize()
+    bool isVisible(const math::AABB& box) const;
+
+    // remove the indices of occluded boxes, keeps the order. returns the removed count
+    size_t cull(const math::AABBArray& boxes, std::vector<uint32_t>& indices, ThreadPool* pool = nullptr);
+
+    // NDC depth, row 0 at the bottom of the screen
+    inline const std::vector<float>& getDepth() const
+    {
+        return depth_;
+    }
+
+    inline const OcclusionStats& getStats() const
+    {
+        return stats_;
+    }
+
+private:
+    // edge functions a * x + b * y + c inside when > 0, or == 0 on top-left edges, evaluated at
+    // pixel centers
+    struct Triangle
+    {
+        float a[3];
+        float b[3];
+        float c[3];
+        bool topLeft[3];
+        float depth;                // farthest depth of the vertices
+        int minX, maxX, minY, maxY; // pixel bounds, inclusive
+    };
+
+    void setupTriangle(const math::float4& v0, const math::float4& v1, const math::float4& v2);
+    void rasterizeBand(int beginY, int endY);
+
+private:
+    math::mat4f viewProjection_;
+    std::vector<float> depth_;
+    std::vector<Triangle> triangles_;
+    std::vector<math::float4> clipPositions_;
+    std::vector<uint8_t> visibleFlags_;
+
+    OcclusionStats stats_;
+};
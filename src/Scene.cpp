@@ -0,0 +1,354 @@
+#include "Scene.h"
+#include "base/Logger.h"
+#include "base/ParallelUtils.h"
+#include "base/Profiler.h"
+
+#include <algorithm>
+
+Scene::Scene(int threadCnt)
+{
+    if (threadCnt < 0)
+    {
+        threadCnt = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+    }
+    threadCnt_ = (size_t)threadCnt;
+}
+
+NodeId Scene::addNode(NodeId parent, const math::mat4f& localMatrix)
+{
+    int32_t parentIndex = -1;
+    uint16_t depth = 0;
+    if (parent != INVALID_NODE)
+    {
+        if (parent >= nodeIndex_.size())
+        {
+            LOGE("Scene::addNode failed: invalid parent %u", parent);
+            return INVALID_NODE;
+        }
+        parentIndex = (int32_t)nodeIndex_[parent];
+        depth = depths_[parentIndex] + 1;
+    }
+
+    // appending keeps parents before children, the depth levels only stay contiguous
+    // when the new node is not shallower than the last one
+    size_t index = nodeIds_.size();
+    if (levelOffsets_.empty())
+    {
+        levelOffsets_ = { 0, 1 };
+    }
+    else if (depth == depths_.back())
+    {
+        levelOffsets_.back()++;
+    }
+    else if (depth == depths_.back() + 1)
+    {
+        levelOffsets_.push_back(index + 1);
+    }
+    else
+    {
+        layoutDirty_ = true;
+    }
+
+    NodeId node = (NodeId)nodeIndex_.size();
+    localMatrices_.push_back(localMatrix);
+    worldMatrices_.push_back(localMatrix);
+    parents_.push_back(parentIndex);
+    depths_.push_back(depth);
+    dirty_.push_back(1);
+    nodeIds_.push_back(node);
+    nodeIndex_.push_back((uint32_t)index);
+    localBounds_.emplace_back();
+    worldBounds_.resize(nodeIds_.size());
+    anyDirty_ = true;
+    return node;
+}
+
+void Scene::clear()
+{
+    localMatrices_.clear();
+    worldMatrices_.clear();
+    parents_.clear();
+    depths_.clear();
+    dirty_.clear();
+    nodeIds_.clear();
+    nodeIndex_.clear();
+    localBounds_.clear();
+    worldBounds_.resize(0);
+    objectCount_ = 0;
+    bvh_.clear();
+    bvhDirty_ = false;
+    occluders_.clear();
+    levelOffsets_.clear();
+    layoutDirty_ = false;
+    anyDirty_ = false;
+}
+
+void Scene::setLocalMatrix(NodeId node, const math::mat4f& localMatrix)
+{
+    uint32_t index = nodeIndex_[node];
+    localMatrices_[index] = localMatrix;
+    dirty_[index] = 1;
+    anyDirty_ = true;
+}
+
+void Scene::setLocalBounds(NodeId node, const math::AABB& bounds)
+{
+    uint32_t index = nodeIndex_[node];
+    if (localBounds_[index].isEmpty() != bounds.isEmpty())
+    {
+        objectCount_ = bounds.isEmpty() ? objectCount_ - 1 : objectCount_ + 1;
+        bvhDirty_ = true;
+    }
+    localBounds_[index] = bounds;
+    if (bounds.isEmpty())
+    {
+        worldBounds_.set(index, bounds);
+    }
+    dirty_[index] = 1;
+    anyDirty_ = true;
+}
+
+size_t Scene::updateTransforms()
+{
+    if (!anyDirty_)
+    {
+        return 0;
+    }
+    PROFILE_ZONE("Scene::updateTransforms");
+
+    if (layoutDirty_)
+    {
+        sortByDepth();
+    }
+
+    // parents are in previous levels, so the nodes of one level can be updated in any order
+    size_t updated = 0;
+    for (size_t level = 0; level + 1 < levelOffsets_.size(); level++)
+    {
+        size_t begin = levelOffsets_[level];
+        size_t end = levelOffsets_[level + 1];
+        if (end - begin < SCENE_PARALLEL_MIN || threadCnt_ == 0)
+        {
+            updated += updateRange(begin, end);
+            continue;
+        }
+
+        ThreadPool* pool = getThreadPool();
+        size_t chunkCnt = pool->getThreadCnt() + 1;
+        size_t chunk = ((end - begin + chunkCnt - 1) / chunkCnt + 63) & ~(size_t)63;
+        std::vector<std::future<size_t>> futures;
+        for (size_t chunkBegin = begin + chunk; chunkBegin < end; chunkBegin += chunk)
+        {
+            size_t chunkEnd = std::min(end, chunkBegin + chunk);
+            futures.push_back(pool->pushTask([this, chunkBegin, chunkEnd]() {
+                return updateRange(chunkBegin, chunkEnd);
+            }));
+        }
+        updated += updateRange(begin, std::min(end, begin + chunk));
+        for (auto& f : futures)
+        {
+            updated += f.get();
+        }
+    }
+
+    if (bvhDirty_)
+    {
+        bvh_.build(worldBounds_, getThreadPool());
+        bvhDirty_ = false;
+    }
+    else
+    {
+        bvh_.refit(worldBounds_, dirty_.data());
+    }
+
+    std::fill(dirty_.begin(), dirty_.end(), 0);
+    anyDirty_ = false;
+    return updated;
+}
+
+size_t Scene::updateRange(size_t begin, size_t end)
+{
+    size_t updated = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        // a recomputed node stays marked dirty until the pass ends, so its children follow
+        int32_t parent = parents_[i];
+        if (parent < 0)
+        {
+            if (!dirty_[i])
+            {
+                continue;
+            }
+            worldMatrices_[i] = localMatrices_[i];
+        }
+        else if (dirty_[i] | dirty_[parent])
+        {
+            worldMatrices_[i] = worldMatrices_[parent] * localMatrices_[i];
+            dirty_[i] = 1;
+        }
+        else
+        {
+            continue;
+        }
+        if (!localBounds_[i].isEmpty())
+        {
+            worldBounds_.set(i, math::transformAABB(worldMatrices_[i], localBounds_[i]));
+        }
+        updated++;
+    }
+    return updated;
+}
+
+void Scene::cull(const math::Frustum& frustum, std::vector<uint32_t>& visible)
+{
+    PROFILE_ZONE("Scene::cull");
+    visible.clear();
+    if (objectCount_ == 0)
+    {
+        return;
+    }
+    if (objectCount_ >= SCENE_BVH_CULL_MIN)
+    {
+        bvh_.cull(frustum, worldBounds_, visible);
+        return;
+    }
+
+    // 8 boxes per mask byte, split across the pool for large scenes
+    cullMasks_.resize(worldBounds_.paddedSize() / 8);
+    ParallelUtils::cullAABBs(frustum, worldBounds_, cullMasks_.data(), getThreadPool());
+
+    for (size_t i = 0; i < cullMasks_.size(); i++)
+    {
+        uint32_t bits = cullMasks_[i];
+        for (uint32_t lane = 0; bits != 0; lane++, bits >>= 1)
+        {
+            if (bits & 1)
+            {
+                visible.push_back((uint32_t)(i * 8 + lane));
+            }
+        }
+    }
+}
+
+NodeId Scene::pick(const math::float3& origin, const math::float3& direction, float maxDistance, float* distance)
+{
+    int64_t index = bvh_.pick(origin, direction, worldBounds_, maxDistance, distance);
+    return index < 0 ? INVALID_NODE : nodeIds_[index];
+}
+
+void Scene::setOccluder(NodeId node, std::shared_ptr<const OccluderMesh> mesh)
+{
+    auto it = std::find_if(occluders_.begin(), occluders_.end(),
+        [node](const Occluder& occluder) { return occluder.node == node; });
+    if (it != occluders_.end())
+    {
+        if (mesh)
+        {
+            it->mesh = std::move(mesh);
+        }
+        else
+        {
+            occluders_.erase(it);
+        }
+    }
+    else if (mesh)
+    {
+        occluders_.push_back({ node, std::move(mesh) });
+    }
+}
+
+size_t Scene::occlusionCull(OcclusionCuller& culler, const math::mat4f& viewProjection, std::vector<uint32_t>& visible)
+{
+    if (occluders_.empty() || visible.empty())
+    {
+        return 0;
+    }
+    PROFILE_ZONE("Scene::occlusionCull");
+
+    culler.begin(viewProjection);
+    for (const Occluder& occluder : occluders_)
+    {
+        culler.addOccluder(*occluder.mesh, getWorldMatrix(occluder.node));
+    }
+    culler.rasterize(getThreadPool());
+    return culler.cull(worldBounds_, visible, getThreadPool());
+}
+
+ThreadPool* Scene::getThreadPool()
+{
+    if (threadCnt_ == 0)
+    {
+        return nullptr;
+    }
+    if (!threadPool_)
+    {
+        threadPool_ = std::make_shared<ThreadPool>(threadCnt_);
+    }
+    return threadPool_.get();
+}
+
+void Scene::sortByDepth()
+{
+    PROFILE_ZONE("Scene::sortByDepth");
+
+    // stable counting sort, parents are still before children inside each level
+    uint16_t maxDepth = *std::max_element(depths_.begin(), depths_.end());
+    levelOffsets_.assign(maxDepth + 2, 0);
+    for (uint16_t depth : depths_)
+    {
+        levelOffsets_[depth + 1]++;
+    }
+    for (size_t level = 1; level < levelOffsets_.size(); level++)
+    {
+        levelOffsets_[level] += levelOffsets_[level - 1];
+    }
+
+    size_t count = nodeIds_.size();
+    std::vector<uint32_t> newIndex(count);
+    std::vector<size_t> cursor(levelOffsets_.begin(), levelOffsets_.end() - 1);
+    for (size_t i = 0; i < count; i++)
+    {
+        newIndex[i] = (uint32_t)cursor[depths_[i]]++;
+    }
+
+    // padding of the bounds arrays is kept as is
+    auto permute = [&](auto& values)
+    {
+        auto sorted = values;
+        for (size_t i = 0; i < count; i++)
+        {
+            sorted[newIndex[i]] = values[i];
+        }
+        values.swap(sorted);
+    };
+    for (auto& parent : parents_)
+    {
+        if (parent >= 0)
+        {
+            parent = (int32_t)newIndex[parent];
+        }
+    }
+    permute(localMatrices_);
+    permute(worldMatrices_);
+    permute(parents_);
+    permute(depths_);
+    permute(dirty_);
+    permute(nodeIds_);
+    permute(localBounds_);
+    for (size_t i = 0; i < count; i++)
+    {
+        nodeIndex_[nodeIds_[i]] = (uint32_t)i;
+    }
+
+    permute(worldBounds_.centerX);
+    permute(worldBounds_.centerY);
+    permute(worldBounds_.centerZ);
+    permute(worldBounds_.extentX);
+    permute(worldBounds_.extentY);
+    permute(worldBounds_.extentZ);
+
+    // the tree references array indices
+    bvhDirty_ = true;
+
+    layoutDirty_ = false;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cfloat>
+
+#include "base/MathInc.h"
+#include "base/ThreadPool.h"
+#include "BVH.h"
+#include "OcclusionCuller.h"
+#include "math/aabb.h"
+#include "math/frustum.h"
+
+using NodeId = uint32_t;
+constexpr NodeId INVALID_NODE = UINT32_MAX;
+
+// levels with fewer nodes are updated on the calling thread
+constexpr size_t SCENE_PARALLEL_MIN = 4096;
+
+// scenes with fewer objects are culled by testing every box, the BVH is used from this count
+constexpr size_t SCENE_BVH_CULL_MIN = 16 * 1024;
+
+// Transform hierarchy stored as parallel arrays sorted parent-before-child, nodes of the same depth
+// are contiguous. World matrices are updated in one linear pass that skips clean subtrees, each depth
+// level is split across worker threads when large enough. Nodes with local bounds are the objects
+// tested by cull(), their world bounds are kept in SoA arrays updated with the world matrices and
+// indexed by a BVH, refitted after each update and rebuilt when objects or the array order change.
+// NodeId is stable, the array index of a node changes when nodes are added (see getNodeIndex).
+class Scene
+{
+public:
+    // threadCnt workers help the calling thread on large levels, -1 for one less than the hardware threads
+    explicit Scene(int threadCnt = -1);
+
+    // parent must be INVALID_NODE for a root or an existing node
+    NodeId addNode(NodeId parent, const math::mat4f& localMatrix);
+    void clear();
+
+    void setLocalMatrix(NodeId node, const math::mat4f& localMatrix);
+
+    // bounds in node space, an empty box (default) removes the node from culling
+    void setLocalBounds(NodeId node, const math::AABB& bounds);
+
+    inline const math::mat4f& getLocalMatrix(NodeId node) const
+    {
+        return localMatrices_[nodeIndex_[node]];
+    }
+
+    // valid after updateTransforms()
+    inline const math::mat4f& getWorldMatrix(NodeId node) const
+    {
+        return worldMatrices_[nodeIndex_[node]];
+    }
+
+    inline NodeId getParent(NodeId node) const
+    {
+        int32_t parent = parents_[nodeIndex_[node]];
+        return parent < 0 ? INVALID_NODE : nodeIds_[parent];
+    }
+
+    inline size_t getNodeCount() const
+    {
+        return nodeIds_.size();
+    }
+
+    // valid after updateTransforms(), empty for nodes without bounds
+    inline math::AABB getWorldBounds(NodeId node) const
+    {
+        return worldBounds_.get(nodeIndex_[node]);
+    }
+
+    // nodes with bounds
+    inline size_t getObjectCount() const
+    {
+        return objectCount_;
+    }
+
+    // recompute world matrices of dirty nodes and their descendants, returns the updated node count
+    size_t updateTransforms();
+
+    // array indices of the objects intersecting the frustum, in no particular order. call after updateTransforms()
+    void cull(const math::Frustum& frustum, std::vector<uint32_t>& visible);
+
+    // nearest object whose world bounds are hit by the ray, INVALID_NODE if none
+    NodeId pick(const math::float3& origin, const math::float3& direction, float maxDistance = FLT_MAX,
+        float* distance = nullptr);
+
+    inline const BVHStats& getBvhStats() const
+    {
+        return bvh_.getStats();
+    }
+
+    // mesh rasterized by occlusionCull() with the world matrix of node, nullptr removes it
+    void setOccluder(NodeId node, std::shared_ptr<const OccluderMesh> mesh);
+
+    inline size_t getOccluderCount() const
+    {
+        return occluders_.size();
+    }
+
+    // rasterize the occluders seen through viewProjection, then remove the objects they hide from
+    // visible. returns the removed count, call after cull()
+    size_t occlusionCull(OcclusionCuller& culler, const math::mat4f& viewProjection, std::vector<uint32_t>& visible);
+
+    // arrays in update order, valid until the next addNode() / updateTransforms()
+    inline size_t getNodeIndex(NodeId node) const { return nodeIndex_[node]; }
+    inline const std::vector<NodeId>& getNodeIds() const { return nodeIds_; }
+    inline const std::vector<math::mat4f>& getWorldMatrices() const { return worldMatrices_; }
+    inline const math::AABBArray& getWorldBounds() const { return worldBounds_; }
+
+private:
+    void sortByDepth();
+    size_t updateRange(size_t begin, size_t end);
+    ThreadPool* getThreadPool();
+
+private:
+    // indexed by array position
+    std::vector<math::mat4f> localMatrices_;
+    std::vector<math::mat4f> worldMatrices_;
+    std::vector<int32_t> parents_;    // -1 for roots
+    std::vector<uint16_t> depths_;
+    std::vector<uint8_t> dirty_;
+    std::vector<NodeId> nodeIds_;
+    std::vector<math::AABB> localBounds_;
+    math::AABBArray worldBounds_;
+    size_t objectCount_ = 0;
+
+    // indexed by NodeId
+    std::vector<uint32_t> nodeIndex_;
+
+    // levelOffsets_[d] is the first node of depth d, the last entry is the node count
+    std::vector<size_t> levelOffsets_;
+    bool layoutDirty_ = false;
+    bool anyDirty_ = false;
+
+    // one bit per object of the latest cull
+    std::vector<uint8_t> cullMasks_;
+
+    BVH bvh_;
+    bool bvhDirty_ = false;
+
+    struct Occluder
+    {
+        NodeId node;
+        std::shared_ptr<const OccluderMesh> mesh;
+    };
+    std::vector<Occluder> occluders_;
+
+    size_t threadCnt_ = 0;
+    std::shared_ptr<ThreadPool> threadPool_ = nullptr;
+};
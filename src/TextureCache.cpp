@@ -0,0 +1,219 @@
+#include "TextureCache.h"
+#include "base/FileUtils.h"
+#include "base/HashUtils.h"
+#include "base/ImageUtils.h"
+#include "base/Logger.h"
+#include "render/Texture.h"
+
+#include <cstdio>
+#include <thread>
+#include <sstream>
+#include <filesystem>
+
+TextureCache::TextureCache(const std::string& cacheDir)
+    : cacheDir_(cacheDir)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir_, ec);
+    if (ec)
+    {
+        LOGE("TextureCache: create cache dir failed: %s", cacheDir_.c_str());
+    }
+}
+
+bool TextureCache::load(const std::vector<std::string>& paths, ImageLevels& images, bool& cacheHit)
+{
+    images.clear();
+    cacheHit = false;
+
+    std::string cachePath = getCachePath(paths);
+    if (cachePath.empty())
+    {
+        return false;
+    }
+
+    if (FileUtils::exists(cachePath) && loadCache(cachePath, paths.size(), images))
+    {
+        cacheHit = true;
+        return true;
+    }
+
+    // cold path: decode, generate mipmaps and store
+    std::vector<std::vector<std::shared_ptr<Buffer<RGBA>>>> layers;
+    for (auto& path : paths)
+    {
+        auto image = ImageUtils::readImageRGBA(path);
+        if (!image)
+        {
+            return false;
+        }
+        layers.push_back(ImageUtils::generateMipmaps(image));
+    }
+
+    size_t levelCount = layers[0].size();
+    for (auto& layer : layers)
+    {
+        if (layer.size() != levelCount || layer[0]->getWidth() != layers[0][0]->getWidth())
+        {
+            LOGE("TextureCache: layer size not match: %s", paths[0].c_str());
+            return false;
+        }
+    }
+
+    images.resize(levelCount);
+    for (size_t level = 0; level < levelCount; level++)
+    {
+        for (auto& layer : layers)
+        {
+            images[level].push_back(layer[level]);
+        }
+    }
+
+    storeCache(cachePath, images);
+    return true;
+}
+
+std::string TextureCache::getCachePath(const std::vector<std::string>& paths)
+{
+    std::string key;
+    for (auto& path : paths)
+    {
+        std::string hash = HashUtils::getFileHashMD5(path);
+        if (hash.empty())
+        {
+            return "";
+        }
+        key += hash;
+    }
+    if (paths.size() > 1)
+    {
+        key = HashUtils::getHashMD5(key);
+    }
+    return cacheDir_ + "/" + key + ".stc";
+}
+
+bool TextureCache::loadCache(const std::string& cachePath, size_t layerCount, ImageLevels& images)
+{
+    auto file = FileUtils::mapFile(cachePath);
+    if (!file || file->size() < sizeof(TextureCacheHeader))
+    {
+        return false;
+    }
+
+    auto* header = reinterpret_cast<const TextureCacheHeader*>(file->data());
+    if (memcmp(header->magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC)) != 0
+        || header->version != TEXTURE_CACHE_VERSION
+        || header->format != TextureFormat_RGBA8
+        || header->layerCount != layerCount
+        || header->levelCount == 0)
+    {
+        LOGW("TextureCache: invalid cache file: %s", cachePath.c_str());
+        return false;
+    }
+
+    size_t entryCount = (size_t)header->layerCount * header->levelCount;
+    if (file->size() < sizeof(TextureCacheHeader) + entryCount * sizeof(TextureCacheEntry))
+    {
+        return false;
+    }
+    auto* entries = reinterpret_cast<const TextureCacheEntry*>(file->data() + sizeof(TextureCacheHeader));
+
+    // buffers keep the mapping alive through the aliasing shared_ptr
+    std::shared_ptr<MappedFile> owner = std::move(file);
+    images.resize(header->levelCount);
+    for (size_t level = 0; level < header->levelCount; level++)
+    {
+        for (size_t layer = 0; layer < header->layerCount; layer++)
+        {
+            auto& entry = entries[level * header->layerCount + layer];
+            size_t bytes = (size_t)entry.width * entry.height * sizeof(RGBA);
+            if (entry.offset + bytes > owner->size())
+            {
+                images.clear();
+                return false;
+            }
+
+            auto* pixels = (RGBA*)(owner->data() + entry.offset);
+            auto buffer = std::make_shared<Buffer<RGBA>>();
+            buffer->createExternal(entry.width, entry.height, std::shared_ptr<RGBA>(owner, pixels));
+            images[level].push_back(buffer);
+        }
+    }
+
+    return true;
+}
+
+bool TextureCache::storeCache(const std::string& cachePath, const ImageLevels& images)
+{
+    TextureCacheHeader header{};
+    memcpy(header.magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC));
+    header.version = TEXTURE_CACHE_VERSION;
+    header.format = TextureFormat_RGBA8;
+    header.width = (uint32_t)images[0][0]->getWidth();
+    header.height = (uint32_t)images[0][0]->getHeight();
+    header.layerCount = (uint32_t)images[0].size();
+    header.levelCount = (uint32_t)images.size();
+
+    std::vector<TextureCacheEntry> entries;
+    size_t offset = MemoryUtils::alignedSize(sizeof(TextureCacheHeader)
+        + header.layerCount * header.levelCount * sizeof(TextureCacheEntry));
+    for (auto& level : images)
+    {
+        for (auto& image : level)
+        {
+            TextureCacheEntry entry{};
+            entry.offset = offset;
+            entry.width = (uint32_t)image->getWidth();
+            entry.height = (uint32_t)image->getHeight();
+            entries.push_back(entry);
+            offset += MemoryUtils::alignedSize(image->getRawDataBytesSize());
+        }
+    }
+
+    // write to a temp file first, other loader threads may read the same key
+    std::stringstream tmpPath;
+    tmpPath << cachePath << "." << std::this_thread::get_id() << ".tmp";
+    {
+        std::ofstream file(tmpPath.str(), std::ios::out | std::ios::binary);
+        if (!file.is_open())
+        {
+            LOGE("TextureCache: write cache failed: %s", cachePath.c_str());
+            return false;
+        }
+
+        static const char padding[SOFTGL_ALIGNMENT] = {};
+        file.write((const char*)&header, sizeof(header));
+        file.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(TextureCacheEntry)));
+        size_t pos = sizeof(header) + entries.size() * sizeof(TextureCacheEntry);
+
+        size_t idx = 0;
+        for (auto& level : images)
+        {
+            for (auto& image : level)
+            {
+                file.write(padding, (std::streamsize)(entries[idx].offset - pos));
+                file.write((const char*)image->getRawDataPtr(), (std::streamsize)image->getRawDataBytesSize());
+                pos = entries[idx].offset + image->getRawDataBytesSize();
+                idx++;
+            }
+        }
+        if (!file.good())
+        {
+            file.close();
+            std::remove(tmpPath.str().c_str());
+            LOGE("TextureCache: write cache failed: %s", cachePath.c_str());
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    // rename does not replace existing files on windows
+    std::remove(cachePath.c_str());
+#endif
+    if (std::rename(tmpPath.str().c_str(), cachePath.c_str()) != 0)
+    {
+        std::remove(tmpPath.str().c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "base/Buffer.h"
+#include "base/MathInc.h"
+
+// cache file layout:
+//   TextureCacheHeader
+//   TextureCacheEntry[layerCount * levelCount], index: level * layerCount + layer
+//   pixel data, each image aligned to SOFTGL_ALIGNMENT
+constexpr char TEXTURE_CACHE_MAGIC[4] = { 'S', 'T', 'X', 'C' };
+constexpr uint32_t TEXTURE_CACHE_VERSION = 1;
+
+struct TextureCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t layerCount;
+    uint32_t levelCount;
+    uint32_t reserved;
+};
+
+struct TextureCacheEntry
+{
+    uint64_t offset;
+    uint32_t width;
+    uint32_t height;
+};
+
+class TextureCache
+{
+public:
+    // images[level][layer]
+    using ImageLevels = std::vector<std::vector<std::shared_ptr<Buffer<RGBA>>>>;
+
+    explicit TextureCache(const std::string& cacheDir);
+
+    // load images with full mip chain, from the cache file if present, otherwise decode and write the cache.
+    // cached images are read-only views into the file mapping.
+    bool load(const std::vector<std::string>& paths, ImageLevels& images, bool& cacheHit);
+
+private:
+    std::string getCachePath(const std::vector<std::string>& paths);
+    bool loadCache(const std::string& cachePath, size_t layerCount, ImageLevels& images);
+    bool storeCache(const std::string& cachePath, const ImageLevels& images);
+
+private:
+    std::string cacheDir_;
+};
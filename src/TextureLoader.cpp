@@ -0,0 +1,246 @@
+#include "TextureLoader.h"
+#include "base/ImageUtils.h"
+#include "base/Logger.h"
+#include "base/Profiler.h"
+
+#include <algorithm>
+
+#define TEXTURE_LOADER_MAX_THREADS 4
+
+TextureLoader::TextureLoader(std::shared_ptr<Renderer> renderer, size_t threadCnt)
+    : renderer_(std::move(renderer))
+{
+    if (threadCnt == 0)
+    {
+        threadCnt = std::max(1u, std::min((unsigned)TEXTURE_LOADER_MAX_THREADS, std::thread::hardware_concurrency()));
+    }
+    threadPool_ = std::make_shared<ThreadPool>(threadCnt);
+}
+
+TextureLoader::~TextureLoader()
+{
+    clear();
+    threadPool_ = nullptr;
+}
+
+void TextureLoader::setCacheDir(const std::string& cacheDir)
+{
+    cache_ = cacheDir.empty() ? nullptr : std::make_shared<TextureCache>(cacheDir);
+}
+
+std::shared_ptr<AsyncTexture> TextureLoader::loadTexture2D(const std::string& path, const SamplerDesc& sampler,
+    bool mipmaps)
+{
+    return load({ path }, TextureType_2D, sampler, mipmaps);
+}
+
+std::shared_ptr<AsyncTexture> TextureLoader::loadTextureCube(const std::vector<std::string>& paths,
+    const SamplerDesc& sampler, bool mipmaps)
+{
+    if (paths.size() != 6)
+    {
+        LOGE("TextureLoader::loadTextureCube failed: expect 6 faces, got %d", (int)paths.size());
+        auto handle = std::make_shared<AsyncTexture>();
+        handle->state_ = AsyncTexture::State_FAILED;
+        handle->placeholder_ = getPlaceholder(TextureType_CUBE);
+        return handle;
+    }
+    return load(paths, TextureType_CUBE, sampler, mipmaps);
+}
+
+std::shared_ptr<AsyncTexture> TextureLoader::load(const std::vector<std::string>& paths, TextureType type,
+    const SamplerDesc& sampler, bool mipmaps)
+{
+    auto handle = std::make_shared<AsyncTexture>();
+    handle->paths_ = paths;
+    handle->sampler_ = sampler;
+    handle->desc_.type = type;
+    handle->desc_.format = TextureFormat_RGBA8;
+    handle->desc_.usage = TextureUsage_Sampler | TextureUsage_UploadData;
+    handle->desc_.useMipmaps = mipmaps;
+    handle->desc_.tag = paths.front();
+    handle->placeholder_ = getPlaceholder(type);
+
+    if (pending_.empty())
+    {
+        batchTimer_.start();
+    }
+
+    PendingTask task;
+    task.handle = handle;
+    task.result = threadPool_->pushTask([paths, cache = cache_]() -> LoadResult {
+        LoadResult result;
+        Timer timer;
+        if (cache)
+        {
+            cache->load(paths, result.images, result.cacheHit);
+        }
+        else
+        {
+            std::vector<std::shared_ptr<Buffer<RGBA>>> layers;
+            for (auto& path : paths)
+            {
+                layers.push_back(ImageUtils::readImageRGBA(path));
+            }
+            result.images.push_back(std::move(layers));
+        }
+        result.loadMillis = timer.elapseMillis();
+        return result;
+    });
+    pending_.push_back(std::move(task));
+
+    return handle;
+}
+
+size_t TextureLoader::update(size_t budgetBytes)
+{
+    if (pending_.empty())
+    {
+        return 0;
+    }
+    PROFILE_ZONE("TextureLoader::update");
+
+    size_t uploadedBytes = 0;
+    for (auto it = pending_.begin(); it != pending_.end();)
+    {
+        if (uploadedBytes > 0 && uploadedBytes >= budgetBytes)
+        {
+            break;
+        }
+
+        if (it->result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++it;
+            continue;
+        }
+
+        uploadedBytes += upload(*it);
+        it = pending_.erase(it);
+    }
+
+    if (pending_.empty())
+    {
+        stats_.batchMillis = batchTimer_.elapseMillis();
+        LOGI("TextureLoader: batch loaded in %.2f ms, cold: %d (%.2f ms), warm: %d (%.2f ms)",
+             stats_.batchMillis, (int)stats_.coldCount, stats_.coldMillis, (int)stats_.warmCount, stats_.warmMillis);
+    }
+    return uploadedBytes;
+}
+
+void TextureLoader::flush()
+{
+    for (auto& task : pending_)
+    {
+        task.result.wait();
+        upload(task);
+    }
+    pending_.clear();
+    stats_.batchMillis = batchTimer_.elapseMillis();
+}
+
+void TextureLoader::clear()
+{
+    for (auto& task : pending_)
+    {
+        task.result.wait();
+    }
+    pending_.clear();
+}
+
+size_t TextureLoader::upload(PendingTask& task)
+{
+    PROFILE_ZONE("TextureLoader::upload");
+    auto& handle = *task.handle;
+    LoadResult result = task.result.get();
+    auto& images = result.images;
+
+    if (result.cacheHit)
+    {
+        stats_.warmCount++;
+        stats_.warmMillis += result.loadMillis;
+    }
+    else
+    {
+        stats_.coldCount++;
+        stats_.coldMillis += result.loadMillis;
+    }
+
+    bool valid = !images.empty() && !images[0].empty() && images[0][0];
+    for (size_t i = 0; valid && i < images[0].size(); i++)
+    {
+        auto& image = images[0][i];
+        valid = image && image->getWidth() == images[0][0]->getWidth()
+            && image->getHeight() == images[0][0]->getHeight();
+    }
+    if (!valid)
+    {
+        LOGE("TextureLoader: load texture failed: %s", handle.desc_.tag.c_str());
+        handle.state_ = AsyncTexture::State_FAILED;
+        return 0;
+    }
+
+    TextureDesc desc = handle.desc_;
+    desc.width = (int)images[0][0]->getWidth();
+    desc.height = (int)images[0][0]->getHeight();
+
+    auto texture = renderer_->createTexture(desc);
+    if (!texture)
+    {
+        handle.state_ = AsyncTexture::State_FAILED;
+        return 0;
+    }
+    texture->setSamplerDesc(handle.sampler_);
+
+    // use the cached mip chain when present, otherwise let the backend generate it
+    size_t levelCount = desc.useMipmaps ? images.size() : 1;
+    if (levelCount > 1)
+    {
+        for (size_t level = 0; level < levelCount; level++)
+        {
+            texture->setImageLevelData(images[level], (uint32_t)level);
+        }
+    }
+    else
+    {
+        texture->setImageData(images[0]);
+    }
+
+    handle.texture_ = std::move(texture);
+    handle.state_ = AsyncTexture::State_READY;
+
+    size_t bytes = 0;
+    for (size_t level = 0; level < levelCount; level++)
+    {
+        for (auto& image : images[level])
+        {
+            bytes += image->getRawDataBytesSize();
+        }
+    }
+    return bytes;
+}
+
+std::shared_ptr<Texture>& TextureLoader::getPlaceholder(TextureType type)
+{
+    auto& placeholder = type == TextureType_CUBE ? placeholderCube_ : placeholder2D_;
+    if (!placeholder)
+    {
+        TextureDesc desc{};
+        desc.width = 1;
+        desc.height = 1;
+        desc.type = type;
+        desc.format = TextureFormat_RGBA8;
+        desc.usage = TextureUsage_Sampler | TextureUsage_UploadData;
+        desc.useMipmaps = false;
+        desc.tag = "placeholder";
+        placeholder = renderer_->createTexture(desc);
+
+        SamplerDesc sampler{};
+        placeholder->setSamplerDesc(sampler);
+
+        auto pixel = Buffer<RGBA>::makeDefault(1, 1);
+        pixel->setAll(RGBA(128, 128, 128, 255));
+        std::vector<std::shared_ptr<Buffer<RGBA>>> faces(type == TextureType_CUBE ? 6 : 1, pixel);
+        placeholder->setImageData(faces);
+    }
+    return placeholder;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <future>
+#include <list>
+
+#include "base/Buffer.h"
+#include "base/ThreadPool.h"
+#include "base/Timer.h"
+#include "render/Renderer.h"
+#include "TextureCache.h"
+
+class TextureLoader;
+
+// handle of a texture being loaded, get() returns a placeholder until the real texture is uploaded
+class AsyncTexture
+{
+public:
+    enum State
+    {
+        State_LOADING,
+        State_READY,
+        State_FAILED,
+    };
+
+    inline const std::shared_ptr<Texture>& get() const
+    {
+        return state_ == State_READY ? texture_ : placeholder_;
+    }
+
+    inline bool isReady() const { return state_ == State_READY; }
+    inline bool isFailed() const { return state_ == State_FAILED; }
+    inline State getState() const { return state_; }
+    inline const std::vector<std::string>& getPaths() const { return paths_; }
+
+private:
+    friend class TextureLoader;
+
+    State state_ = State_LOADING;
+    std::vector<std::string> paths_;
+    TextureDesc desc_;
+    SamplerDesc sampler_;
+    std::shared_ptr<Texture> texture_ = nullptr;
+    std::shared_ptr<Texture> placeholder_ = nullptr;
+};
+
+struct TextureLoadStats
+{
+    // decoded from source images (cache miss)
+    size_t coldCount = 0;
+    double coldMillis = 0;
+
+    // loaded from cache files
+    size_t warmCount = 0;
+    double warmMillis = 0;
+
+    // wall time from first request to last upload of the latest batch
+    double batchMillis = 0;
+};
+
+class TextureLoader
+{
+public:
+    explicit TextureLoader(std::shared_ptr<Renderer> renderer, size_t threadCnt = 0);
+    ~TextureLoader();
+
+    // enable binary texture cache, empty dir to disable
+    void setCacheDir(const std::string& cacheDir);
+
+    // decode on worker threads, the returned handle is completed by update() on the render thread
+    std::shared_ptr<AsyncTexture> loadTexture2D(const std::string& path, const SamplerDesc& sampler, bool mipmaps);
+
+    // cube faces order: +x, -x, +y, -y, +z, -z
+    std::shared_ptr<AsyncTexture> loadTextureCube(const std::vector<std::string>& paths, const SamplerDesc& sampler,
+        bool mipmaps);
+
+    // upload decoded images to textures, stops once uploaded bytes exceed budgetBytes (at least one per call).
+    // returns the uploaded bytes
+    size_t update(size_t budgetBytes);
+
+    // block until all pending decodes are finished and uploaded
+    void flush();
+
+    inline size_t getPendingCount() const
+    {
+        return pending_.size();
+    }
+
+    inline const TextureLoadStats& getStats() const
+    {
+        return stats_;
+    }
+
+    void clear();
+
+private:
+    struct LoadResult
+    {
+        TextureCache::ImageLevels images;    // [level][layer]
+        bool cacheHit = false;
+        double loadMillis = 0;
+    };
+
+    struct PendingTask
+    {
+        std::shared_ptr<AsyncTexture> handle;
+        std::future<LoadResult> result;
+    };
+
+    std::shared_ptr<AsyncTexture> load(const std::vector<std::string>& paths, TextureType type,
+        const SamplerDesc& sampler, bool mipmaps);
+    size_t upload(PendingTask& task);
+    std::shared_ptr<Texture>& getPlaceholder(TextureType type);
+
+private:
+    std::shared_ptr<Renderer> renderer_;
+    std::shared_ptr<ThreadPool> threadPool_;
+    std::shared_ptr<TextureCache> cache_ = nullptr;
+    std::list<PendingTask> pending_;
+
+    TextureLoadStats stats_;
+    Timer batchTimer_;
+
+    std::shared_ptr<Texture> placeholder2D_ = nullptr;
+    std::shared_ptr<Texture> placeholderCube_ = nullptr;
+};
@@ -1,4 +1,16 @@
 #include "Viewer.h"
+#include "base/Profiler.h"
+
+#include <cmath>
+
+// width and height of the shadow map depth target
+static constexpr int SHADOW_MAP_SIZE = 1024;
+
+// scale of the x, y and z axes of m
+static inline math::float3 axisScales(const math::mat4f& m)
+{
+    return math::float3(length(m[0].xyz), length(m[1].xyz), length(m[2].xyz));
+}
 
 bool Viewer::create(int width, int height, int outTexId)
 {
@@ -16,13 +28,56 @@ bool Viewer::create(int width, int height, int outTexId)
             return false;
         }
     }
-    
+
+    if (!textureLoader_)
+    {
+        textureLoader_ = std::make_shared<TextureLoader>(renderer_);
+        textureLoader_->setCacheDir(config_.textureCache ? CACHE_DIR + "textures" : "");
+    }
 
     return true;
 }
 
 void Viewer::destroy()
 {
+    if (frameWriter_)
+    {
+        frameWriter_->close();
+        frameWriter_ = nullptr;
+    }
+
+    if (textureLoader_)
+    {
+        textureLoader_->clear();
+        textureLoader_ = nullptr;
+    }
+
+    meshVAOs_.assign(meshVAOs_.size(), nullptr);
+    meshPrograms_[0][0] = meshPrograms_[0][1] = nullptr;
+    meshPrograms_[1][0] = meshPrograms_[1][1] = nullptr;
+    meshStates_[0] = meshStates_[1] = nullptr;
+    drawResources_.clear();
+    instanceBuffers_.clear();
+}
+
+void Viewer::setModel(const std::shared_ptr<Model>& model, const std::vector<NodeId>& nodeIds)
+{
+    model_ = model;
+    modelNodes_.clear();
+    lodStateOffsets_.clear();
+    lodLevels_.clear();
+    meshVAOs_.clear();
+    if (!model_)
+    {
+        return;
+    }
+    for (size_t i = 0; i < nodeIds.size() && i < model_->nodes.size(); i++)
+    {
+        modelNodes_[nodeIds[i]] = (uint32_t)i;
+        lodStateOffsets_.push_back((uint32_t)lodLevels_.size());
+        lodLevels_.resize(lodLevels_.size() + model_->nodes[i].meshes.size(), 0);
+    }
+    meshVAOs_.resize(model_->meshes.size());
 }
 
 void Viewer::drawFrame(Scene* scene)
@@ -31,8 +86,16 @@ void Viewer::drawFrame(Scene* scene)
     {
         return;
     }
+    PROFILE_ZONE("Viewer::drawFrame");
 
     scene_ = scene;
+    renderer_->beginFrame();
+
+    // upload textures decoded by worker threads
+    renderer_->addTextureUpload(textureLoader_->update(config_.textureUploadBudget));
+
+    // frustum and occlusion culling of the main view
+    cullScene();
 
     // setup framebuffer
     setupMainBuffers();
@@ -42,28 +105,384 @@ void Viewer::drawFrame(Scene* scene)
     //setupScene();
 
     // draw shadow map
-    //drawShadowMap();
+    if (config_.shadowMap)
+    {
+        drawShadowMap();
+    }
 
     // main pass
+    {
+        PROFILE_ZONE("Viewer::mainPass");
+        ClearStates clearStates{};
+        clearStates.colorFlag = true;
+        clearStates.depthFlag = config_.depthTest;
+        clearStates.clearColor = config_.clearColor;
+        clearStates.clearDepth = config_.reverseZ ? 0.f : 1.f;
+
+        renderer_->beginRenderPass(m_fboMain, clearStates);
+        renderer_->setViewPort(0, 0, m_width, m_height);
+
+        // draw scene
+        renderer_->beginGroup("scene");
+        drawScene(false);
+        renderer_->endGroup();
+
+        // end main pass
+        renderer_->endRenderPass();
+    }
+
+    renderer_->endFrame();
+}
+
+std::shared_ptr<FrameWriter> Viewer::getFrameWriter()
+{
+    if (!frameWriter_)
+    {
+        auto writer = std::make_shared<FrameWriter>();
+        if (!writer->open(config_.captureOutput, (CaptureFormat)config_.captureFormat, config_.captureFps))
+        {
+            LOGE("Viewer: open capture output failed, capture disabled");
+            config_.captureFrames = false;
+            return nullptr;
+        }
+        frameWriter_ = std::move(writer);
+    }
+    return frameWriter_;
+}
+
+void Viewer::cullScene()
+{
+    visibleObjects_.clear();
+    if (!scene_ || !camera_)
+    {
+        return;
+    }
+    PROFILE_ZONE("Viewer::cullScene");
+
+    size_t objectCount = scene_->getObjectCount();
+    math::mat4f viewProjection = camera_->projectionMatrix() * camera_->viewMatrix();
+    scene_->cull(math::Frustum(viewProjection), visibleObjects_);
+
+    // occlusion only applies to the main view, the shadow view sees the scene from the light
+    if (config_.occlusionCulling && scene_->getOccluderCount() > 0)
+    {
+        size_t occluded = scene_->occlusionCull(occlusionCuller_, viewProjection, visibleObjects_);
+        const OcclusionStats& stats = occlusionCuller_.getStats();
+        renderer_->addOcclusionStats(occluded, stats.rasterMillis + stats.testMillis);
+    }
+    renderer_->addCullStats(objectCount, visibleObjects_.size());
+}
+
+void Viewer::drawShadowMap()
+{
+    if (!m_fboShadow)
+    {
+        return;
+    }
+    PROFILE_ZONE("Viewer::shadowPass");
+    cullShadowCasters();
+
     ClearStates clearStates{};
-    clearStates.colorFlag = true;
-    clearStates.depthFlag = config_.depthTest;
-    clearStates.clearColor = config_.clearColor;
+    clearStates.depthFlag = true;
     clearStates.clearDepth = config_.reverseZ ? 0.f : 1.f;
 
-    renderer_->beginRenderPass(m_fboMain, clearStates);
-    renderer_->setViewPort(0, 0, m_width, m_height);
+    renderer_->beginRenderPass(m_fboShadow, clearStates);
+    renderer_->setViewPort(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+    renderer_->beginGroup("shadow");
+    drawScene(true);
+    renderer_->endGroup();
+    renderer_->endRenderPass();
+}
 
-    // draw scene
-    drawScene(false);
+void Viewer::cullShadowCasters()
+{
+    shadowCasters_.clear();
+    if (!scene_ || !camera_)
+    {
+        return;
+    }
+    PROFILE_ZONE("Viewer::cullShadowCasters");
 
-    // end main pass
-    renderer_->endRenderPass();
+    setupShadowCamera();
+    scene_->cull(math::Frustum(cameraShadow_.projectionMatrix() * cameraShadow_.viewMatrix()), shadowCasters_);
+    renderer_->addShadowCullStats(shadowCasters_.size());
+}
+
+void Viewer::setupShadowCamera()
+{
+    // shadow map rendered from the point light towards the view target
+    math::float3 eye = config_.pointLightPosition;
+    math::float3 center = camera_->center();
+    math::float3 dir = center - eye;
+    if (dot(dir, dir) < 1e-8f)
+    {
+        dir = math::float3(0.f, -1.f, 0.f);
+        center = eye + dir;
+    }
+    math::float3 up(0.f, 1.f, 0.f);
+    if (std::abs(dot(normalize(dir), up)) > 0.999f)
+    {
+        up = math::float3(0.f, 0.f, 1.f);
+    }
+    cameraShadow_.setPerspective(90.f, 1.f, camera_->near(), camera_->far());
+    cameraShadow_.lookAt(eye, center, up);
 }
 
 void Viewer::drawScene(bool shadowPass)
 {
+    if (!model_ || !scene_ || !camera_)
+    {
+        return;
+    }
+    PROFILE_ZONE("Viewer::drawScene");
+
+    const Camera& camera = shadowPass ? cameraShadow_ : *camera_;
+    const std::vector<uint32_t>& objects = shadowPass ? shadowCasters_ : visibleObjects_;
+    math::mat4f viewProjection = camera.projectionMatrix() * camera.viewMatrix();
 
+    // head light
+    math::float3 lightDir = camera_->eye() - camera_->center();
+    lightDir = dot(lightDir, lightDir) > 0.f ? normalize(lightDir) : math::float3(0.f, 0.f, 1.f);
+
+    for (int i = 0; i < 2; i++)
+    {
+        bool cullFace = config_.cullFace && i == 0;
+        if (!meshStates_[i] || meshStates_[i]->renderStates.cullFace != cullFace
+            || meshStates_[i]->renderStates.depthTest != config_.depthTest)
+        {
+            RenderStates states;
+            states.depthTest = config_.depthTest;
+            states.cullFace = cullFace;
+            meshStates_[i] = renderer_->createPipelineStates(states);
+        }
+    }
+
+    MeshletCullStats meshletStats;
+    size_t trianglesSaved = 0;
+    size_t drawCount = 0;
+    instanceDraws_.clear();
+    const std::vector<NodeId>& nodeIds = scene_->getNodeIds();
+    const std::vector<math::mat4f>& worldMatrices = scene_->getWorldMatrices();
+    for (uint32_t idx : objects)
+    {
+        auto it = modelNodes_.find(nodeIds[idx]);
+        if (it == modelNodes_.end())
+        {
+            continue;
+        }
+        const ModelNode& node = model_->nodes[it->second];
+        const math::mat4f& world = worldMatrices[idx];
+        math::mat4f mvp = viewProjection * world;
+        math::float3 scales = axisScales(world);
+        bool uniformScale = std::max(scales.x, std::max(scales.y, scales.z))
+            <= 1.001f * std::min(scales.x, std::min(scales.y, scales.z));
+
+        for (size_t k = 0; k < node.meshes.size(); k++)
+        {
+            const ModelMesh& mesh = model_->meshes[node.meshes[k]];
+
+            // the shadow view does not move the level kept for the main view
+            uint8_t& lodState = lodLevels_[lodStateOffsets_[it->second] + k];
+            uint8_t shadowLodState = lodState;
+            size_t level = selectLod(mesh, world, camera, shadowPass ? shadowLodState : lodState);
+            IndexRange range = mesh.getLodRange(level);
+            trianglesSaved += (mesh.getLodRange(0).count - range.count) / 3;
+
+            // meshlets only cover the full detail level, whole levels are drawn instanced after the loop
+            const ModelMaterial* material = mesh.material >= 0 ? &model_->materials[mesh.material] : nullptr;
+            math::float4 baseColor = material ? material->baseColorFactor : math::float4(1.f);
+            bool meshletCulled = level == 0 && mesh.meshletCount > 0 && config_.meshlets;
+            if (!meshletCulled && config_.instancing)
+            {
+                instanceDraws_.push_back({ node.meshes[k], (uint32_t)level, { world, baseColor } });
+                continue;
+            }
+
+            auto program = getMeshProgram(mesh, false);
+            auto vao = getMeshVAO(node.meshes[k]);
+            if (!program || !vao)
+            {
+                continue;
+            }
+            bool doubleSided = material && material->doubleSided;
+            drawRanges_.clear();
+            if (meshletCulled)
+            {
+                math::float3 eye = (inverse(world) * math::float4(camera.eye(), 1.f)).xyz;
+                bool backFaces = config_.cullFace && !doubleSided && uniformScale;
+                MeshletCuller::cull(mesh.meshlets, mesh.meshletCount, mvp, eye, backFaces, drawRanges_, meshletStats);
+                if (drawRanges_.empty())
+                {
+                    continue;
+                }
+            }
+            else
+            {
+                drawRanges_.push_back(range);
+            }
+
+            auto& resources = getDrawResources(drawCount++);
+            MeshUniforms uniforms;
+            uniforms.mvp = mvp;
+            uniforms.model = world;
+            uniforms.baseColor = baseColor;
+            uniforms.lightDir = math::float4(lightDir, mesh.hasAttribute(ModelAttribute_NORMAL) ? 1.f : 0.f);
+            resources->blocks[0]->setData(&uniforms, sizeof(MeshUniforms));
+
+            renderer_->setVertexArrayObject(vao);
+            renderer_->setShaderProgram(program);
+            renderer_->setShaderResources(resources);
+            renderer_->setPipelineStates(meshStates_[doubleSided ? 1 : 0]);
+            renderer_->drawRanges(drawRanges_);
+        }
+    }
+
+    MeshUniforms uniforms;
+    uniforms.mvp = viewProjection;
+    uniforms.lightDir = math::float4(lightDir, 0.f);
+    drawInstances(uniforms, drawCount);
+
+    renderer_->addMeshletStats(meshletStats.tested, meshletStats.frustumCulled, meshletStats.coneCulled);
+    renderer_->addLodStats(trianglesSaved);
+}
+
+// draws gathered in instanceDraws_ sorted by mesh and level, one instanced draw per run of equal keys.
+// drawCount: draw resources already used this frame
+void Viewer::drawInstances(const MeshUniforms& uniforms, size_t drawCount)
+{
+    size_t instancedCount = 0;
+    std::sort(instanceDraws_.begin(), instanceDraws_.end(), [](const InstanceDraw& a, const InstanceDraw& b)
+    {
+        return a.mesh != b.mesh ? a.mesh < b.mesh : a.level < b.level;
+    });
+
+    for (size_t begin = 0; begin < instanceDraws_.size();)
+    {
+        const InstanceDraw& first = instanceDraws_[begin];
+        size_t end = begin + 1;
+        while (end < instanceDraws_.size() && instanceDraws_[end].mesh == first.mesh
+            && instanceDraws_[end].level == first.level)
+        {
+            end++;
+        }
+        const ModelMesh& mesh = model_->meshes[first.mesh];
+        auto program = getMeshProgram(mesh, true);
+        auto vao = getMeshVAO(first.mesh);
+        if (!program || !vao)
+        {
+            begin = end;
+            continue;
+        }
+
+        instanceData_.clear();
+        for (size_t i = begin; i < end; i++)
+        {
+            instanceData_.push_back(instanceDraws_[i].instance);
+        }
+        if (instancedCount == instanceBuffers_.size())
+        {
+            InstanceArray instanceArray;
+            instanceArray.instanceSize = sizeof(MeshInstance);
+            for (size_t c = 0; c < 4; c++)
+            {
+                instanceArray.instancesDesc.push_back({ 4, sizeof(MeshInstance), c * sizeof(math::float4) });
+            }
+            instanceArray.instancesDesc.push_back({ 4, sizeof(MeshInstance), offsetof(MeshInstance, baseColor) });
+            instanceBuffers_.push_back(renderer_->createInstanceBuffer(instanceArray));
+        }
+        auto& instances = instanceBuffers_[instancedCount++];
+        instances->updateInstanceData(instanceData_.data(), instanceData_.size() * sizeof(MeshInstance));
+
+        auto& resources = getDrawResources(drawCount++);
+        MeshUniforms meshUniforms = uniforms;
+        meshUniforms.lightDir.w = mesh.hasAttribute(ModelAttribute_NORMAL) ? 1.f : 0.f;
+        resources->blocks[0]->setData(&meshUniforms, sizeof(MeshUniforms));
+
+        const ModelMaterial* material = mesh.material >= 0 ? &model_->materials[mesh.material] : nullptr;
+        bool doubleSided = material && material->doubleSided;
+        renderer_->setVertexArrayObject(vao);
+        renderer_->setShaderProgram(program);
+        renderer_->setShaderResources(resources);
+        renderer_->setPipelineStates(meshStates_[doubleSided ? 1 : 0]);
+        renderer_->drawRangeInstanced(mesh.getLodRange(first.level), instances);
+        begin = end;
+    }
+}
+
+std::shared_ptr<ShaderProgram> Viewer::getMeshProgram(const ModelMesh& mesh, bool instanced)
+{
+    const VertexAttributeDesc* normal = mesh.getAttributeDesc(ModelAttribute_NORMAL);
+    bool octNormals = normal && normal->type == VertexAttr_OCT16;
+    auto& program = meshPrograms_[instanced ? 1 : 0][octNormals ? 1 : 0];
+    if (!program)
+    {
+        program = createMeshProgram(octNormals, instanced);
+    }
+    return program;
+}
+
+std::shared_ptr<ShaderResources>& Viewer::getDrawResources(size_t drawIdx)
+{
+    if (drawIdx == drawResources_.size())
+    {
+        auto resources = std::make_shared<ShaderResources>();
+        resources->blocks[0] = renderer_->createUniformBlock("MeshUniforms", sizeof(MeshUniforms));
+        drawResources_.push_back(std::move(resources));
+    }
+    return drawResources_[drawIdx];
+}
+
+std::shared_ptr<VertexArrayObject> Viewer::getMeshVAO(uint32_t meshIdx)
+{
+    auto& vao = meshVAOs_[meshIdx];
+    if (!vao)
+    {
+        // position and normal only, the descs keep their stride and offset into the interleaved vertexes.
+        // meshes without normals repeat the position so that instance attributes always start at 2
+        const ModelMesh& mesh = model_->meshes[meshIdx];
+        VertexArray vertexArray = mesh.vertexes;
+        vertexArray.vertexesDesc.clear();
+        vertexArray.vertexesDesc.push_back(*mesh.getAttributeDesc(ModelAttribute_POSITION));
+        vertexArray.vertexesDesc.push_back(*mesh.getAttributeDesc(mesh.hasAttribute(ModelAttribute_NORMAL)
+            ? ModelAttribute_NORMAL : ModelAttribute_POSITION));
+        vao = renderer_->createVertexArrayObject(vertexArray);
+    }
+    return vao;
+}
+
+// The coarsest level whose error, projected at the nearest point of the mesh bounds, stays below
+// config_.lodErrorPixels. level holds the level of the previous frame: finer levels are taken as soon
+// as the error exceeds the threshold, coarser ones only below threshold * (1 - lodHysteresis), so a
+// camera resting at the switch distance does not make the level flicker.
+size_t Viewer::selectLod(const ModelMesh& mesh, const math::mat4f& world, const Camera& camera, uint8_t& level) const
+{
+    size_t count = mesh.getLodCount();
+    if (count < 2 || !config_.meshLods || mesh.bounds.isEmpty())
+    {
+        level = 0;
+        return 0;
+    }
+
+    math::float3 scales = axisScales(world);
+    float scale = std::max(scales.x, std::max(scales.y, scales.z));
+    math::float3 center = (world * math::float4(mesh.bounds.center(), 1.f)).xyz;
+    float radius = length(mesh.bounds.extent()) * scale;
+    float distance = std::max(length(center - camera.eye()) - radius, camera.near());
+    float pixelsPerUnit = scale * (float)m_height
+        / (2.f * std::tan(camera.fovy() * 0.5f * math::f::DEG_TO_RAD) * distance);
+
+    size_t current = std::min((size_t)level, count - 1);
+    while (current > 0 && mesh.getLodError(current) * pixelsPerUnit > config_.lodErrorPixels)
+    {
+        current--;
+    }
+    float coarserPixels = config_.lodErrorPixels * (1.f - config_.lodHysteresis);
+    while (current + 1 < count && mesh.getLodError(current + 1) * pixelsPerUnit <= coarserPixels)
+    {
+        current++;
+    }
+    level = (uint8_t)current;
+    return current;
 }
 
 void Viewer::setupMainBuffers()
@@ -85,6 +504,35 @@ void Viewer::setupMainBuffers()
 
 void Viewer::setupShadowMapBuffers()
 {
+    if (!config_.shadowMap || m_fboShadow)
+    {
+        return;
+    }
+
+    // depth only, nothing is shaded into a color target
+    TextureDesc texDesc{};
+    texDesc.width = SHADOW_MAP_SIZE;
+    texDesc.height = SHADOW_MAP_SIZE;
+    texDesc.type = TextureType_2D;
+    texDesc.format = TextureFormat_FLOAT32;
+    texDesc.usage = TextureUsage_AttachmentDepth | TextureUsage_Sampler;
+    texDesc.useMipmaps = false;
+    m_texDepthShadow = renderer_->createTexture(texDesc);
+
+    SamplerDesc sampler{};
+    sampler.filterMin = Filter_NEAREST;
+    sampler.filterMag = Filter_NEAREST;
+    m_texDepthShadow->setSamplerDesc(sampler);
+    m_texDepthShadow->initImageData();
+
+    auto fbo = renderer_->createFrameBuffer(true);
+    fbo->setDepthAttachment(m_texDepthShadow);
+    if (!fbo->isValid())
+    {
+        LOGE("setupShadowMapBuffers failed");
+        return;
+    }
+    m_fboShadow = std::move(fbo);
 }
 
 void Viewer::setupMainColorBuffer(bool multiSample)
@@ -2,8 +2,32 @@
 
 #include "render/Renderer.h"
 #include "Config.h"
+#include "TextureLoader.h"
+#include "FrameWriter.h"
+#include "Camera.h"
+#include "Scene.h"
+#include "Model.h"
+#include "OcclusionCuller.h"
 
-class Scene;
+#include <unordered_map>
+
+// uniform block "MeshUniforms" of the model mesh programs, std140 compatible
+struct MeshUniforms
+{
+    math::mat4f mvp;
+    math::mat4f model;
+    math::float4 baseColor;
+    math::float4 lightDir;      // world space, towards the light. w: 1 if the mesh has normals
+};
+
+// per instance attributes of the instanced mesh programs, columns of the model matrix at attributes
+// 2 - 5 and the base color at 6. MeshUniforms::mvp then holds the view projection, model and
+// baseColor are unused
+struct MeshInstance
+{
+    math::mat4f model;
+    math::float4 baseColor;
+};
 
 class Viewer
 {
@@ -16,11 +40,50 @@ public:
     virtual void drawFrame(Scene* scene);
     virtual int swapBuffer() = 0;
 
+    inline std::shared_ptr<TextureLoader>& getTextureLoader()
+    {
+        return textureLoader_;
+    }
+
+    inline void setCamera(Camera* camera)
+    {
+        camera_ = camera;
+    }
+
+    // model drawn by drawScene, nodeIds: the scene node of each model node
+    void setModel(const std::shared_ptr<Model>& model, const std::vector<NodeId>& nodeIds);
+
+    // counters of the latest frame
+    inline const RenderStats& getRenderStats() const
+    {
+        static const RenderStats empty;
+        return renderer_ ? renderer_->getStats() : empty;
+    }
+
 protected:
     virtual std::shared_ptr<Renderer> createRenderer() = 0;
 
+    // program drawing model meshes with MeshUniforms, position at attribute 0 and the normal at 1.
+    // octNormals: the normal is VertexAttr_OCT16, instanced: see MeshInstance. nullptr if the renderer has none
+    virtual std::shared_ptr<ShaderProgram> createMeshProgram(bool octNormals, bool instanced)
+    {
+        return nullptr;
+    }
+
+    // frame writer opened on config_.captureOutput, nullptr if the output can not be opened
+    std::shared_ptr<FrameWriter> getFrameWriter();
+
 private:
+    void cullScene();
+    void drawShadowMap();
+    void cullShadowCasters();
+    void setupShadowCamera();
     void drawScene(bool shadowPass);
+    void drawInstances(const MeshUniforms& uniforms, size_t drawCount);
+    std::shared_ptr<ShaderProgram> getMeshProgram(const ModelMesh& mesh, bool instanced);
+    std::shared_ptr<ShaderResources>& getDrawResources(size_t drawIdx);
+    std::shared_ptr<VertexArrayObject> getMeshVAO(uint32_t meshIdx);
+    size_t selectLod(const ModelMesh& mesh, const math::mat4f& world, const Camera& camera, uint8_t& level) const;
 
     void setupMainBuffers();
     void setupShadowMapBuffers();
@@ -35,12 +98,49 @@ protected:
     int m_outTexId = 0;
 
     Scene* scene_ = nullptr;
+    Camera* camera_ = nullptr;
+    Camera cameraShadow_;
+
+    // array indices of the scene objects in the view / shadow frustum of this frame
+    std::vector<uint32_t> visibleObjects_;
+    std::vector<uint32_t> shadowCasters_;
+    OcclusionCuller occlusionCuller_;
 
     std::shared_ptr<Renderer> renderer_ = nullptr;
+    std::shared_ptr<TextureLoader> textureLoader_ = nullptr;
+
+    // model meshes, gpu resources are created on first draw
+    std::shared_ptr<Model> model_ = nullptr;
+    std::unordered_map<NodeId, uint32_t> modelNodes_;       // scene node to model node
+    std::vector<uint32_t> lodStateOffsets_;                 // by model node, into lodLevels_
+    std::vector<uint8_t> lodLevels_;                        // level drawn last frame, by mesh of each node
+    std::vector<std::shared_ptr<VertexArrayObject>> meshVAOs_;
+    std::shared_ptr<ShaderProgram> meshPrograms_[2][2];     // [instanced][float, octahedral normals]
+    std::shared_ptr<PipelineStates> meshStates_[2];         // single, double sided
+    std::vector<std::shared_ptr<ShaderResources>> drawResources_;   // one uniform block per draw of a frame
+    std::vector<IndexRange> drawRanges_;
+
+    // whole mesh levels gathered during drawScene, drawn instanced by mesh and level
+    struct InstanceDraw
+    {
+        uint32_t mesh;
+        uint32_t level;
+        MeshInstance instance;
+    };
+    std::vector<InstanceDraw> instanceDraws_;
+    std::vector<MeshInstance> instanceData_;
+    std::vector<std::shared_ptr<InstanceBuffer>> instanceBuffers_;  // one per instanced draw of a frame
+
+    // frame capture
+    std::shared_ptr<FrameWriter> frameWriter_ = nullptr;
 
     // main fbo
     std::shared_ptr<FrameBuffer> m_fboMain = nullptr;
     std::shared_ptr<Texture> m_texColorMain = nullptr;
     std::shared_ptr<Texture> m_texDepthMain = nullptr;
+
+    // shadow map fbo, depth only
+    std::shared_ptr<FrameBuffer> m_fboShadow = nullptr;
+    std::shared_ptr<Texture> m_texDepthShadow = nullptr;
 };
 
@@ -3,9 +3,18 @@
 
 #include <memory>
 #include <vector>
+#include <cfloat>
+#include <algorithm>
 
+#include "ViewerSoft.h"
 #include "ViewerOpenGL.h"
 #include "ViewerVulkan.h"
+#include "Scene.h"
+#include "GLTFLoader.h"
+#include "MeshCache.h"
+#include "base/Profiler.h"
+#include "base/Timer.h"
+#include "imgui/imgui.h"
 
 class ViewerManager
 {
@@ -18,9 +27,14 @@ public:
 
         // config
         config_ = std::make_shared<Config>();
+        setupCamera();
 
         m_viewers.resize(Renderer_Count);
 
+        // viewer software
+        auto viewer_soft = std::make_shared<ViewerSoft>(*config_);
+        m_viewers[Renderer_SOFT] = std::move(viewer_soft);
+
         // viewer opengl
         auto viewer_opengl = std::make_shared<ViewerOpenGL>(*config_);
         m_viewers[Renderer_OPENGL] = std::move(viewer_opengl);
@@ -29,6 +43,29 @@ public:
         auto viewer_vulkan = std::make_shared<ViewerVulkan>(*config_);
         m_viewers[Renderer_Vulkan] = std::move(viewer_vulkan);
 
+        for (auto& it : m_viewers)
+        {
+            it->setCamera(&camera_);
+        }
+
+        return true;
+    }
+
+    // software renderer only, no window or gl context required
+    bool createHeadless(int width, int height)
+    {
+        m_width = width;
+        m_height = height;
+        m_outTexId = 0;
+
+        config_ = std::make_shared<Config>();
+        config_->rendererType = Renderer_SOFT;
+        setupCamera();
+
+        m_viewers.resize(Renderer_Count);
+        m_viewers[Renderer_SOFT] = std::make_shared<ViewerSoft>(*config_);
+        m_viewers[Renderer_SOFT]->setCamera(&camera_);
+
         return true;
     }
 
@@ -36,28 +73,349 @@ public:
     {
         for (auto& it : m_viewers)
         {
-            it->destroy();
+            if (it)
+            {
+                it->destroy();
+            }
         }
     }
 
     int drawFrame()
     {
+        PROFILE_FRAME();
+        PROFILE_ZONE("ViewerManager::drawFrame");
         auto &viewer = m_viewers[config_->rendererType];
+        if (!viewer)
+        {
+            return 0;
+        }
         if (m_rendertype != config_->rendererType) {
             m_rendertype = (RendererType)config_->rendererType;
             viewer->create(m_width, m_height, m_outTexId);
+            m_statsHistory.clear();
         }
 
-        viewer->drawFrame(nullptr);
-        return viewer->swapBuffer();
+        Timer frameTimer;
+        scene_.updateTransforms();
+        viewer->drawFrame(&scene_);
+        int outTex = viewer->swapBuffer();
+
+        RenderStats stats = viewer->getRenderStats();
+        stats.frameMillis = frameTimer.elapseMillis();
+        m_statsHistory.push(stats);
+        config_->triangleCount_ = stats.trianglesIn;
+        return outTex;
     }
 
     inline void drawPanel()
     {
         if (m_showUI)
         {
+            drawStatsPanel();
         }
     }
+
+    // stats of the latest frames, e.g. for automated performance tests
+    inline const RenderStatsHistory& getStatsHistory() const
+    {
+        return m_statsHistory;
+    }
+
+    inline Config& getConfig()
+    {
+        return *config_;
+    }
+
+    inline Camera& getCamera()
+    {
+        return camera_;
+    }
+
+    inline Scene& getScene()
+    {
+        return scene_;
+    }
+
+    // load a glTF / glb model or a converted mesh cache file and add its nodes to the scene,
+    // nodes with meshes get their bounds
+    bool loadModel(const std::string& path)
+    {
+        std::shared_ptr<Model> model;
+        bool cacheHit = false;
+        if (path.size() > MESH_CACHE_EXT.size()
+            && path.compare(path.size() - MESH_CACHE_EXT.size(), MESH_CACHE_EXT.size(), MESH_CACHE_EXT) == 0)
+        {
+            model = MeshCache::read(path);
+        }
+        else if (config_->meshCache)
+        {
+            MeshCache cache(CACHE_DIR + "meshes", config_->meshQuantize);
+            model = cache.load(path, cacheHit);
+        }
+        else
+        {
+            GLTFLoader loader;
+            model = loader.load(path);
+        }
+        if (!model)
+        {
+            LOGE("load model failed: %s", path.c_str());
+            return false;
+        }
+        // the LOD chain is appended to the full mesh indices, meshlets are built on them after
+        if (config_->meshLods)
+        {
+            for (auto& mesh : model->meshes)
+            {
+                if (mesh.lods.empty())
+                {
+                    MeshSimplifier::buildLods(mesh);
+                    model->stats.lodCount += mesh.getLodCount() - 1;
+                }
+            }
+        }
+        if (config_->meshlets)
+        {
+            for (auto& mesh : model->meshes)
+            {
+                if (mesh.meshletCount == 0)
+                {
+                    MeshletBuilder::build(mesh);
+                    model->stats.meshletCount += mesh.meshletCount;
+                }
+            }
+        }
+
+        // the scene holds one model, nodes, bvh and occluders of the previous one are dropped
+        scene_.clear();
+        m_pickedNode = INVALID_NODE;
+
+        // model nodes are ordered parents first
+        std::vector<NodeId> nodeIds(model->nodes.size());
+        for (size_t i = 0; i < model->nodes.size(); i++)
+        {
+            const ModelNode& node = model->nodes[i];
+            nodeIds[i] = scene_.addNode(node.parent >= 0 ? nodeIds[node.parent] : INVALID_NODE, node.localMatrix);
+            math::AABB bounds;
+            for (uint32_t mesh : node.meshes)
+            {
+                bounds.merge(model->meshes[mesh].bounds);
+            }
+            scene_.setLocalBounds(nodeIds[i], bounds);
+        }
+        setupOccluders(*model, nodeIds);
+
+        for (auto& viewer : m_viewers)
+        {
+            if (viewer)
+            {
+                viewer->setModel(model, nodeIds);
+            }
+        }
+
+        LOGI("load model: %s, %.2f ms, cache hit: %d, occluders: %zu", path.c_str(), model->stats.totalMillis, cacheHit,
+             scene_.getOccluderCount());
+        config_->modelPath = path;
+        model_ = std::move(model);
+        return true;
+    }
+
+    inline const std::shared_ptr<Model>& getModel() const
+    {
+        return model_;
+    }
+
+    // select the nearest scene object under the window pixel (x, y)
+    NodeId pick(double x, double y)
+    {
+        // ray from the near to the far plane through the pixel, window y points down
+        float ndcX = 2.f * (float)x / (float)m_width - 1.f;
+        float ndcY = 1.f - 2.f * (float)y / (float)m_height;
+        math::mat4f invViewProj = inverse(camera_.projectionMatrix() * camera_.viewMatrix());
+        math::float4 nearPoint = invViewProj * math::float4(ndcX, ndcY, -1.f, 1.f);
+        math::float4 farPoint = invViewProj * math::float4(ndcX, ndcY, 1.f, 1.f);
+        math::float3 origin = nearPoint.xyz / nearPoint.w;
+        math::float3 direction = farPoint.xyz / farPoint.w - origin;
+        float distance = length(direction);
+        if (!(distance > 0.f))
+        {
+            m_pickedNode = INVALID_NODE;
+            return m_pickedNode;
+        }
+        m_pickedNode = scene_.pick(origin, direction / distance, distance, &m_pickedDistance);
+        return m_pickedNode;
+    }
+
+private:
+    void drawStatsPanel()
+    {
+        auto& history = m_statsHistory;
+        auto frameMillis = [](const RenderStats& s) { return s.frameMillis; };
+
+        ImGui::Begin("Stats");
+        ImGui::Text("frame %.2f ms, avg %.2f, p50 %.2f, p95 %.2f, p99 %.2f",
+                    history.last().frameMillis, history.average(frameMillis),
+                    history.percentile(frameMillis, 0.5), history.percentile(frameMillis, 0.95),
+                    history.percentile(frameMillis, 0.99));
+
+        m_plotValues.clear();
+        for (auto& frame : history.frames())
+        {
+            m_plotValues.push_back((float)frame.frameMillis);
+        }
+        ImGui::PlotLines("##frame", m_plotValues.data(), (int)m_plotValues.size(), 0, "frame ms", 0.f, FLT_MAX,
+                         ImVec2(0, 60));
+
+        if (ImGui::BeginTable("counters", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("");
+            ImGui::TableSetupColumn("last");
+            ImGui::TableSetupColumn("avg");
+            ImGui::TableHeadersRow();
+
+            auto row = [&](const char* name, uint64_t RenderStats::* field)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(name);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)(history.last().*field));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", history.average([&](const RenderStats& s) { return (double)(s.*field); }));
+            };
+            row("draw calls", &RenderStats::drawCalls);
+            row("instances drawn", &RenderStats::instancesDrawn);
+            row("triangles", &RenderStats::trianglesIn);
+            row("triangles culled", &RenderStats::trianglesCulled);
+            row("triangles clipped", &RenderStats::trianglesClipped);
+            row("vertices shaded", &RenderStats::verticesShaded);
+            row("fragments shaded", &RenderStats::fragmentsShaded);
+            row("fragments depth killed", &RenderStats::fragmentsDepthKilled);
+            row("state changes", &RenderStats::stateChanges);
+            row("texture bytes uploaded", &RenderStats::textureBytesUploaded);
+            row("objects tested", &RenderStats::objectsTested);
+            row("objects visible", &RenderStats::objectsVisible);
+            row("objects occluded", &RenderStats::objectsOccluded);
+            row("shadow casters", &RenderStats::shadowCasters);
+            row("meshlets tested", &RenderStats::meshletsTested);
+            row("meshlets frustum culled", &RenderStats::meshletsFrustumCulled);
+            row("meshlets cone culled", &RenderStats::meshletsConeCulled);
+            row("triangles saved by lod", &RenderStats::trianglesLodSaved);
+            ImGui::EndTable();
+        }
+
+        const BVHStats& bvh = scene_.getBvhStats();
+        ImGui::Text("bvh: %zu nodes, build %.2f ms, refit %zu nodes %.3f ms", bvh.nodeCount, bvh.buildMillis,
+                    bvh.refitNodes, bvh.refitMillis);
+        ImGui::Text("bvh: cull %.3f ms, pick %.3f ms", bvh.cullMillis, bvh.pickMillis);
+        ImGui::Text("occlusion: %.3f ms, avg %.3f", history.last().occlusionMillis,
+                    history.average([](const RenderStats& s) { return s.occlusionMillis; }));
+        if (history.last().meshletsTested > 0)
+        {
+            auto& last = history.last();
+            ImGui::Text("meshlets rejected: %.1f%% (frustum %.1f%%, cone %.1f%%)",
+                        100.0 * (double)(last.meshletsFrustumCulled + last.meshletsConeCulled) / (double)last.meshletsTested,
+                        100.0 * (double)last.meshletsFrustumCulled / (double)last.meshletsTested,
+                        100.0 * (double)last.meshletsConeCulled / (double)last.meshletsTested);
+        }
+        if (m_pickedNode != INVALID_NODE)
+        {
+            ImGui::Text("picked node %u at %.2f", m_pickedNode, m_pickedDistance);
+        }
+
+        auto& last = history.last();
+        for (uint32_t i = 0; i < std::min(last.renderPasses, (uint32_t)RENDER_STATS_MAX_PASSES); i++)
+        {
+            ImGui::Text("pass %u: %.2f ms", i, last.passMillis[i]);
+        }
+        if (last.gpuFrameLag > 0)
+        {
+            ImGui::Text("gpu, %u frames ago:", last.gpuFrameLag);
+            for (uint32_t i = 0; i < std::min(last.gpuPasses, (uint32_t)RENDER_STATS_MAX_PASSES); i++)
+            {
+                ImGui::Text("  pass %u: %.3f ms", i, last.gpuPassMillis[i]);
+            }
+            for (uint32_t i = 0; i < std::min(last.gpuGroups, (uint32_t)RENDER_STATS_MAX_GROUPS); i++)
+            {
+                ImGui::Text("  %s: %.3f ms", last.gpuGroupMillis[i].name, last.gpuGroupMillis[i].millis);
+            }
+        }
+        ImGui::End();
+    }
+
+    // opaque nodes large against the model bounds hide the objects behind them, rasterized at full
+    // detail: simplified levels may reach outside the surface and cull visible objects
+    void setupOccluders(const Model& model, const std::vector<NodeId>& nodeIds)
+    {
+        scene_.updateTransforms();
+        math::float3 modelSize = model.bounds.extent() * 2.f;
+        float minSize = config_->occluderMinSize * std::max(modelSize.x, std::max(modelSize.y, modelSize.z));
+
+        std::vector<math::float3> positions;
+        std::vector<uint32_t> remap;
+        for (size_t i = 0; i < model.nodes.size(); i++)
+        {
+            math::AABB bounds = scene_.getWorldBounds(nodeIds[i]);
+            if (bounds.isEmpty())
+            {
+                continue;
+            }
+            // walls, floors and blocks pass, thin poles hide too little for their raster cost
+            math::float3 size = bounds.extent() * 2.f;
+            float sizes[3] = { size.x, size.y, size.z };
+            std::sort(sizes, sizes + 3);
+            if (sizes[1] < minSize)
+            {
+                continue;
+            }
+
+            // blended and alpha tested meshes do not hide what is behind them
+            std::vector<uint32_t> meshes;
+            size_t triangleCount = 0;
+            for (uint32_t meshIdx : model.nodes[i].meshes)
+            {
+                const ModelMesh& mesh = model.meshes[meshIdx];
+                if (mesh.material < 0 || model.materials[mesh.material].alphaMode == AlphaMode_OPAQUE)
+                {
+                    meshes.push_back(meshIdx);
+                    triangleCount += mesh.getLodRange(0).count / 3;
+                }
+            }
+            if (meshes.empty() || triangleCount > config_->occluderMaxTriangles)
+            {
+                continue;
+            }
+
+            // only the vertices referenced by the full detail level are kept
+            auto occluder = std::make_shared<OccluderMesh>();
+            occluder->indices.reserve(triangleCount * 3);
+            for (uint32_t meshIdx : meshes)
+            {
+                const ModelMesh& mesh = model.meshes[meshIdx];
+                IndexRange range = mesh.getLodRange(0);
+                VertexUtils::getPositions(mesh.vertexes, positions);
+                remap.assign(positions.size(), UINT32_MAX);
+                for (uint32_t k = range.offset; k < range.offset + range.count; k++)
+                {
+                    uint32_t index = VertexUtils::getIndex(mesh.vertexes, k);
+                    if (remap[index] == UINT32_MAX)
+                    {
+                        remap[index] = (uint32_t)occluder->positions.size();
+                        occluder->positions.push_back(positions[index]);
+                    }
+                    occluder->indices.push_back(remap[index]);
+                }
+            }
+            scene_.setOccluder(nodeIds[i], std::move(occluder));
+        }
+    }
+
+    void setupCamera()
+    {
+        camera_.setPerspective(60.f, (float)m_width / (float)m_height, 0.01f, 100.f);
+        camera_.lookAt(math::float3(0.f, 0.f, 3.f), math::float3(0.f), math::float3(0.f, 1.f, 0.f));
+    }
+
 private:
     int m_width = 0;
     int m_height = 0;
@@ -67,4 +425,13 @@ private:
     std::vector<std::shared_ptr<Viewer>> m_viewers;
 
     std::shared_ptr<Config> config_;
-};
\ No newline at end of file
+    Camera camera_;
+    Scene scene_;
+    std::shared_ptr<Model> model_;
+
+    RenderStatsHistory m_statsHistory;
+    std::vector<float> m_plotValues;
+
+    NodeId m_pickedNode = INVALID_NODE;
+    float m_pickedDistance = 0.f;
+};
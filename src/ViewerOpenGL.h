@@ -4,6 +4,62 @@
 
 #include "render/opengl/OpenGLUtils.h"
 #include "render/opengl/RendererOpenGL.h"
+#include "render/opengl/FrameCaptureOpenGL.h"
+
+// model meshes lit per vertex by the head light of MeshUniforms, instanced: see MeshInstance
+constexpr char const* MESH_VS_GLSL = R"(
+layout(location = 0) in vec3 aPosition;
+#ifdef NORMAL_OCT16
+layout(location = 1) in vec2 aNormal;
+#else
+layout(location = 1) in vec3 aNormal;
+#endif
+#ifdef INSTANCED
+layout(location = 2) in mat4 aModel;
+layout(location = 6) in vec4 aBaseColor;
+#endif
+
+layout(std140) uniform MeshUniforms {
+  mat4 uMVP;
+  mat4 uModel;
+  vec4 uBaseColor;
+  vec4 uLightDir;
+};
+
+out vec3 vColor;
+
+void main() {
+#ifdef INSTANCED
+  mat4 model = aModel;
+  vec4 baseColor = aBaseColor;
+  gl_Position = uMVP * model * vec4(aPosition, 1.0);
+#else
+  mat4 model = uModel;
+  vec4 baseColor = uBaseColor;
+  gl_Position = uMVP * vec4(aPosition, 1.0);
+#endif
+  float lambert = 1.0;
+  if (uLightDir.w > 0.0) {
+#ifdef NORMAL_OCT16
+    vec3 n = octDecode(aNormal);
+#else
+    vec3 n = aNormal;
+#endif
+    n = normalize(mat3(model) * n);
+    lambert = 0.3 + 0.7 * max(dot(n, uLightDir.xyz), 0.0);
+  }
+  vColor = baseColor.rgb * lambert;
+}
+)";
+
+constexpr char const* MESH_FS_GLSL = R"(
+in vec3 vColor;
+out vec4 FragColor;
+
+void main() {
+  FragColor = vec4(vColor, 1.0);
+}
+)";
 
 class ViewerOpenGL : public Viewer
 {
@@ -14,7 +70,75 @@ public:
         GL_CHECK(glGenFramebuffers(1, &fbo_out_));
     }
 
+    void destroy() override
+    {
+        if (frameCapture_)
+        {
+            frameCapture_->poll(true);
+            frameCapture_ = nullptr;
+        }
+        Viewer::destroy();
+    }
+
     virtual int swapBuffer() override
+    {
+        int outTexId = resolveOutput();
+
+        // readback finished a few frames later, encoding runs on FrameWriter threads
+        if (config_.captureFrames)
+        {
+            if (!frameCapture_)
+            {
+                frameCapture_ = std::make_shared<FrameCaptureOpenGL>();
+            }
+            auto writer = getFrameWriter();
+            if (writer)
+            {
+                frameCapture_->capture(outTexId, m_width, m_height, [writer](std::shared_ptr<Buffer<RGBA>> frame) {
+                    writer->write(std::move(frame), true);
+                });
+            }
+        }
+        if (frameCapture_)
+        {
+            frameCapture_->poll();
+        }
+
+        return outTexId;
+    }
+
+    std::shared_ptr<Renderer> createRenderer() override
+    {
+        auto renderer = std::make_shared<RendererOpenGL>();
+        if (!renderer->create())
+        {
+            return nullptr;
+        }
+        return renderer;
+    }
+
+    std::shared_ptr<ShaderProgram> createMeshProgram(bool octNormals, bool instanced) override
+    {
+        auto program = renderer_->createShaderProgram();
+        auto* programGL = dynamic_cast<ShaderProgramOpenGL*>(program.get());
+        if (octNormals)
+        {
+            programGL->addDefine("NORMAL_OCT16");
+        }
+        if (instanced)
+        {
+            programGL->addDefine("INSTANCED");
+        }
+        if (!programGL->compileAndLink(std::string(OpenGL_GLSL_OCT_DECODE) + MESH_VS_GLSL, MESH_FS_GLSL))
+        {
+            LOGE("ViewerOpenGL: compile mesh program failed");
+            return nullptr;
+        }
+        return program;
+    }
+
+private:
+    int resolveOutput()
     {
         int width = m_texColorMain->width;
         int height = m_texColorMain->height;
@@ -44,17 +168,8 @@ public:
         return m_texColorMain->getId();
     }
 
-    std::shared_ptr<Renderer> createRenderer() override
-    {
-        auto renderer = std::make_shared<RendererOpenGL>();
-        if (!renderer->create())
-        {
-            return nullptr;
-        }
-        return renderer;
-    }
-
 private:
     GLuint fbo_in_ = 0;
     GLuint fbo_out_ = 0;
+    std::shared_ptr<FrameCaptureOpenGL> frameCapture_ = nullptr;
 };
\ No newline at end of file
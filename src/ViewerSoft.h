@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Viewer.h"
+
+#include "render/opengl/OpenGLUtils.h"
+#include "render/soft/RendererSoft.h"
+#include "render/soft/TextureSoft.h"
+
+// model meshes lit per vertex by the head light of MeshUniforms, instanced: see MeshInstance
+class MeshShaderSoft : public ShaderSoft
+{
+public:
+    explicit MeshShaderSoft(bool instanced) : instanced_(instanced) {}
+
+    size_t getVaryingsCount() const override
+    {
+        return 3;
+    }
+
+    int getUniformLocation(const std::string& name) override
+    {
+        return name == "MeshUniforms" ? 0 : -1;
+    }
+
+    void setUniformData(int location, const void* data, size_t size) override
+    {
+        memcpy(&uniforms_, data, std::min(size, sizeof(MeshUniforms)));
+    }
+
+    void vertexShader(const float* const* attributes, float* varyings, ShaderBuiltin& builtin) const override
+    {
+        const float* pos = attributes[0];
+        const float* n = attributes[1];
+        math::float4 position;
+        math::float3 normal;
+        math::float4 baseColor;
+        if (instanced_)
+        {
+            // model matrix columns, applied without building the matrix
+            math::float4 c0(attributes[2][0], attributes[2][1], attributes[2][2], attributes[2][3]);
+            math::float4 c1(attributes[3][0], attributes[3][1], attributes[3][2], attributes[3][3]);
+            math::float4 c2(attributes[4][0], attributes[4][1], attributes[4][2], attributes[4][3]);
+            math::float4 c3(attributes[5][0], attributes[5][1], attributes[5][2], attributes[5][3]);
+            position = uniforms_.mvp * (c0 * pos[0] + c1 * pos[1] + c2 * pos[2] + c3);
+            normal = (c0 * n[0] + c1 * n[1] + c2 * n[2]).xyz;
+            baseColor = math::float4(attributes[6][0], attributes[6][1], attributes[6][2], attributes[6][3]);
+        }
+        else
+        {
+            position = uniforms_.mvp * math::float4(pos[0], pos[1], pos[2], 1.f);
+            normal = (uniforms_.model * math::float4(n[0], n[1], n[2], 0.f)).xyz;
+            baseColor = uniforms_.baseColor;
+        }
+        builtin.position = position;
+        float lambert = 1.f;
+        if (uniforms_.lightDir.w > 0.f)
+        {
+            float len = length(normal);
+            float nDotL = len > 0.f ? dot(normal, uniforms_.lightDir.xyz) / len : 0.f;
+            lambert = 0.3f + 0.7f * std::max(nDotL, 0.f);
+        }
+        varyings[0] = baseColor.r * lambert;
+        varyings[1] = baseColor.g * lambert;
+        varyings[2] = baseColor.b * lambert;
+    }
+
+    void fragmentShader(const float* varyings, ShaderBuiltin& builtin) const override
+    {
+        builtin.fragColor = math::float4(varyings[0], varyings[1], varyings[2], 1.f);
+    }
+
+private:
+    bool instanced_;
+    MeshUniforms uniforms_;
+};
+
+class ViewerSoft : public Viewer
+{
+public:
+    ViewerSoft(Config& config) : Viewer(config)
+    {
+    }
+
+    virtual int swapBuffer() override
+    {
+        auto* texColor = dynamic_cast<TextureSoft*>(m_texColorMain.get());
+        auto* buffer = texColor ? texColor->getImageRGBA() : nullptr;
+        if (!buffer)
+        {
+            return m_outTexId;
+        }
+
+        // copy the frame, the color buffer is overwritten by the next frame while encoding
+        if (config_.captureFrames)
+        {
+            auto writer = getFrameWriter();
+            if (writer)
+            {
+                auto frame = Buffer<RGBA>::makeDefault(buffer->getWidth(), buffer->getHeight());
+                buffer->copyRawDataTo(frame->getRawDataPtr());
+                writer->write(std::move(frame), true);
+            }
+        }
+
+        // upload to the output texture when shown in a window, headless mode has no gl context
+        if (m_outTexId != 0)
+        {
+            GL_CHECK(glBindTexture(GL_TEXTURE_2D, m_outTexId));
+            GL_CHECK(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei)buffer->getWidth(), (GLsizei)buffer->getHeight(),
+                GL_RGBA, GL_UNSIGNED_BYTE, buffer->getRawDataPtr()));
+        }
+
+        return m_outTexId;
+    }
+
+    std::shared_ptr<Renderer> createRenderer() override
+    {
+        auto renderer = std::make_shared<RendererSoft>();
+        if (!renderer->create())
+        {
+            return nullptr;
+        }
+        return renderer;
+    }
+
+    // attributes reach soft shaders decoded, octahedral normals included
+    std::shared_ptr<ShaderProgram> createMeshProgram(bool octNormals, bool instanced) override
+    {
+        auto program = renderer_->createShaderProgram();
+        dynamic_cast<ShaderProgramSoft*>(program.get())->setShader(std::make_shared<MeshShaderSoft>(instanced));
+        return program;
+    }
+};
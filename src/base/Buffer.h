@@ -35,6 +35,17 @@ public:
         }
     }
 
+    // wrap memory owned by others (e.g. a file mapping), data must outlive the buffer through its owner
+    void createExternal(size_t w, size_t h, std::shared_ptr<T> data)
+    {
+        width_ = w;
+        height_ = h;
+
+        initLayout();
+        dataSize_ = innerWidth_ * innerHeight_;
+        data_ = std::move(data);
+    }
+
     virtual void destroy()
     {
         width_ = 0;
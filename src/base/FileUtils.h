@@ -3,8 +3,206 @@
 #pragma once
 
 #include <fstream>
+#include <memory>
+#include <vector>
+#include <string_view>
+#include <functional>
 #include "Logger.h"
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+enum MapAdvice {
+    MapAdvice_NORMAL,
+    MapAdvice_SEQUENTIAL,   // read once front to back, aggressive read-ahead
+    MapAdvice_RANDOM,       // sparse access, disable read-ahead
+    MapAdvice_WILLNEED,     // start paging in now
+};
+
+// read-only memory mapped file, unmapped on destruction
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file_, &fileSize) || fileSize.QuadPart <= 0) {
+            close();
+            return false;
+        }
+        size_ = (size_t)fileSize.QuadPart;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr) {
+            close();
+            return false;
+        }
+        data_ = (uint8_t*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        size_ = (size_t)st.st_size;
+        void* ptr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        data_ = ptr == MAP_FAILED ? nullptr : (uint8_t*)ptr;
+#endif
+        if (data_ == nullptr) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data_) {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_) {
+            CloseHandle(mapping_);
+            mapping_ = nullptr;
+        }
+        if (file_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(file_);
+            file_ = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (data_) {
+            munmap(data_, size_);
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    // access pattern hint for [offset, offset + length), length 0 means to the end of file
+    void advise(MapAdvice advice, size_t offset = 0, size_t length = 0) const {
+        if (!data_ || offset >= size_) {
+            return;
+        }
+        if (length == 0 || offset + length > size_) {
+            length = size_ - offset;
+        }
+#ifdef _WIN32
+        if (advice == MapAdvice_WILLNEED || advice == MapAdvice_SEQUENTIAL) {
+            WIN32_MEMORY_RANGE_ENTRY range{ data_ + offset, length };
+            PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+        }
+#else
+        // madvise requires page aligned address
+        static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+        size_t alignedOffset = offset - offset % pageSize;
+        int flag = MADV_NORMAL;
+        switch (advice) {
+            case MapAdvice_NORMAL:      flag = MADV_NORMAL;     break;
+            case MapAdvice_SEQUENTIAL:  flag = MADV_SEQUENTIAL; break;
+            case MapAdvice_RANDOM:      flag = MADV_RANDOM;     break;
+            case MapAdvice_WILLNEED:    flag = MADV_WILLNEED;   break;
+        }
+        madvise(data_ + alignedOffset, length + (offset - alignedOffset), flag);
+#endif
+    }
+
+    inline const uint8_t* data() const {
+        return data_;
+    }
+
+    inline size_t size() const {
+        return size_;
+    }
+
+    // zero-copy text view, valid while the mapping is alive
+    inline std::string_view view() const {
+        return { (const char*)data_, size_ };
+    }
+
+private:
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+};
+
+// sequential chunked reader with a reusable buffer, memory use is bounded by chunk size
+class FileStreamReader {
+public:
+    explicit FileStreamReader(size_t chunkSize = 4 * 1024 * 1024) : buffer_(chunkSize) {}
+
+    ~FileStreamReader() {
+        close();
+    }
+
+    bool open(const std::string& path) {
+        close();
+        file_ = fopen(path.c_str(), "rb");
+        if (!file_) {
+            return false;
+        }
+#if !defined(_WIN32) && !defined(__APPLE__)
+        posix_fadvise(fileno(file_), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        // use our own buffer only
+        setvbuf(file_, nullptr, _IONBF, 0);
+        return true;
+    }
+
+    void close() {
+        if (file_) {
+            fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    // read next chunk, data is valid until the next call. return false at end of file or error, see failed()
+    bool next(const uint8_t*& data, size_t& size) {
+        if (!file_) {
+            return false;
+        }
+        size = fread(buffer_.data(), 1, buffer_.size(), file_);
+        data = buffer_.data();
+        return size > 0;
+    }
+
+    // true if next() stopped on a read error rather than at end of file
+    bool failed() const {
+        return file_ && ferror(file_);
+    }
+
+private:
+    FILE* file_ = nullptr;
+    std::vector<uint8_t> buffer_;
+};
+
 class FileUtils {
 public:
     static bool exists(const std::string& path) {
@@ -34,13 +232,59 @@ public:
         return ret;
     }
 
+    static std::shared_ptr<MappedFile> mapFile(const std::string& path, MapAdvice advice = MapAdvice_NORMAL) {
+        auto ret = std::make_shared<MappedFile>();
+        if (!ret->open(path)) {
+            LOGE("failed to map file: %s", path.c_str());
+            return nullptr;
+        }
+        if (advice != MapAdvice_NORMAL) {
+            ret->advise(advice);
+        }
+        return ret;
+    }
+
+    // call func for each chunk of the file, stop early if func returns false.
+    // return false on open or read error, or if func stopped early
+    static bool readChunks(const std::string& path, size_t chunkSize,
+                           const std::function<bool(const uint8_t* data, size_t size)>& func) {
+        FileStreamReader reader(chunkSize);
+        if (!reader.open(path)) {
+            LOGE("failed to open file: %s", path.c_str());
+            return false;
+        }
+
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        while (reader.next(data, size)) {
+            if (!func(data, size)) {
+                return false;
+            }
+        }
+        if (reader.failed()) {
+            LOGE("failed to read file: %s", path.c_str());
+            return false;
+        }
+        return true;
+    }
+
     static std::string readText(const std::string& path) {
-        auto data = readBytes(path);
-        if (data.empty()) {
+        auto file = mapFile(path, MapAdvice_SEQUENTIAL);
+        if (!file) {
             return "";
         }
 
-        return { (char*)data.data(), data.size() };
+        return std::string(file->view());
+    }
+
+    // zero-copy text, the view is valid while holder is alive
+    static std::string_view readTextView(const std::string& path, std::shared_ptr<MappedFile>& holder) {
+        holder = mapFile(path, MapAdvice_SEQUENTIAL);
+        if (!holder) {
+            return {};
+        }
+
+        return holder->view();
     }
 
     static bool writeBytes(const std::string& path, const char* data, size_t length) {
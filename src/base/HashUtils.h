@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <algorithm>
+#include <md5.h>
+#include "FileUtils.h"
+
+class HashUtils {
+public:
+    static std::string getHashMD5(const void* data, size_t length) {
+        MD5_CTX ctx;
+        MD5_Init(&ctx);
+
+        // MD5_Update takes 32-bit length, feed large inputs in chunks
+        auto* ptr = (unsigned char*)data;
+        while (length > 0) {
+            auto chunk = (unsigned int)std::min(length, (size_t)0x40000000);
+            MD5_Update(&ctx, ptr, chunk);
+            ptr += chunk;
+            length -= chunk;
+        }
+
+        unsigned char digest[16];
+        MD5_Final(digest, &ctx);
+        return toHex(digest, sizeof(digest));
+    }
+
+    static std::string getHashMD5(const std::string& str) {
+        return getHashMD5(str.data(), str.length());
+    }
+
+    // md5 of file content, empty string if the file can not be read
+    static std::string getFileHashMD5(const std::string& path) {
+        auto file = FileUtils::mapFile(path);
+        if (!file) {
+            return "";
+        }
+        return getHashMD5(file->data(), file->size());
+    }
+
+private:
+    static std::string toHex(const unsigned char* data, size_t length) {
+        static const char* digits = "0123456789abcdef";
+        std::string ret(length * 2, '0');
+        for (size_t i = 0; i < length; i++) {
+            ret[i * 2] = digits[data[i] >> 4];
+            ret[i * 2 + 1] = digits[data[i] & 0x0F];
+        }
+        return ret;
+    }
+};
@@ -5,16 +5,12 @@
 #include <stb/stb_image.h>
 #include <stb/stb_image_write.h>
 
+#include <cfloat>
 #include "ImageUtils.h"
 #include "Logger.h"
 
-std::shared_ptr<Buffer<RGBA>> ImageUtils::readImageRGBA(const std::string& path) {
-    int iw = 0, ih = 0, n = 0;
-    unsigned char* data = stbi_load(path.c_str(), &iw, &ih, &n, STBI_default);
-    if (data == nullptr) {
-        LOGD("ImageUtils::readImage failed, path: %s", path.c_str());
-        return nullptr;
-    }
+// takes ownership of data returned by stbi_load*
+static std::shared_ptr<Buffer<RGBA>> convertToRGBA(unsigned char* data, int iw, int ih, int n) {
     auto buffer = Buffer<RGBA>::makeDefault(iw, ih);
 
     // convert to rgba
@@ -61,12 +57,91 @@ std::shared_ptr<Buffer<RGBA>> ImageUtils::readImageRGBA(const std::string& path)
     return buffer;
 }
 
+std::shared_ptr<Buffer<RGBA>> ImageUtils::readImageRGBA(const std::string& path) {
+    int iw = 0, ih = 0, n = 0;
+    unsigned char* data = stbi_load(path.c_str(), &iw, &ih, &n, STBI_default);
+    if (data == nullptr) {
+        LOGD("ImageUtils::readImage failed, path: %s", path.c_str());
+        return nullptr;
+    }
+    return convertToRGBA(data, iw, ih, n);
+}
+
+std::shared_ptr<Buffer<RGBA>> ImageUtils::readImageRGBA(const uint8_t* encoded, size_t size) {
+    int iw = 0, ih = 0, n = 0;
+    unsigned char* data = stbi_load_from_memory(encoded, (int)size, &iw, &ih, &n, STBI_default);
+    if (data == nullptr) {
+        LOGD("ImageUtils::readImage failed, %d bytes in memory", (int)size);
+        return nullptr;
+    }
+    return convertToRGBA(data, iw, ih, n);
+}
+
 void ImageUtils::writeImage(char const* filename, int w, int h, int comp, const void* data, int strideInBytes,
     bool flipY) {
-    stbi_flip_vertically_on_write(flipY);
+    // flip with a negative stride instead of the global stbi flag, so images can be written from multiple threads
+    if (strideInBytes == 0) {
+        strideInBytes = w * comp;
+    }
+    if (flipY) {
+        data = (const uint8_t*)data + (size_t)strideInBytes * (h - 1);
+        strideInBytes = -strideInBytes;
+    }
     stbi_write_png(filename, w, h, comp, data, strideInBytes);
 }
 
+std::vector<uint8_t> ImageUtils::encodePNG(int w, int h, int comp, const void* data, int strideInBytes, bool flipY) {
+    if (strideInBytes == 0) {
+        strideInBytes = w * comp;
+    }
+    if (flipY) {
+        data = (const uint8_t*)data + (size_t)strideInBytes * (h - 1);
+        strideInBytes = -strideInBytes;
+    }
+    std::vector<uint8_t> ret;
+    stbi_write_png_to_func([](void* context, void* bytes, int size) {
+        auto* out = (std::vector<uint8_t>*)context;
+        out->insert(out->end(), (uint8_t*)bytes, (uint8_t*)bytes + size);
+    }, &ret, w, h, comp, data, strideInBytes);
+    return ret;
+}
+
+std::vector<std::shared_ptr<Buffer<RGBA>>> ImageUtils::generateMipmaps(const std::shared_ptr<Buffer<RGBA>>& image) {
+    std::vector<std::shared_ptr<Buffer<RGBA>>> levels;
+    levels.push_back(image);
+
+    while (levels.back()->getWidth() > 1 || levels.back()->getHeight() > 1) {
+        auto& src = *levels.back();
+        size_t srcWidth = src.getWidth();
+        size_t srcHeight = src.getHeight();
+        size_t dstWidth = std::max((size_t)1, srcWidth / 2);
+        size_t dstHeight = std::max((size_t)1, srcHeight / 2);
+        auto dst = Buffer<RGBA>::makeDefault(dstWidth, dstHeight);
+
+        for (size_t y = 0; y < dstHeight; y++) {
+            size_t y0 = std::min(y * 2, srcHeight - 1);
+            size_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+            for (size_t x = 0; x < dstWidth; x++) {
+                size_t x0 = std::min(x * 2, srcWidth - 1);
+                size_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+
+                const RGBA& p00 = *src.get(x0, y0);
+                const RGBA& p01 = *src.get(x1, y0);
+                const RGBA& p10 = *src.get(x0, y1);
+                const RGBA& p11 = *src.get(x1, y1);
+
+                RGBA& to = *dst->get(x, y);
+                for (int c = 0; c < 4; c++) {
+                    to[c] = (uint8_t)(((uint32_t)p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+                }
+            }
+        }
+        levels.push_back(dst);
+    }
+
+    return levels;
+}
+
 void ImageUtils::convertFloatImage(RGBA* dst, float* src, uint32_t width, uint32_t height) {
     float* srcPixel = src;
 
@@ -2,14 +2,22 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "Buffer.h"
 #include "MathInc.h"
 
 class ImageUtils {
 public:
     static std::shared_ptr<Buffer<RGBA>> readImageRGBA(const std::string& path);
+    // decode a png / jpeg / ... file already in memory, e.g. embedded in a glb
+    static std::shared_ptr<Buffer<RGBA>> readImageRGBA(const uint8_t* encoded, size_t size);
     static void writeImage(char const* filename, int w, int h, int comp, const void* data, int strideInBytes,
         bool flipY);
+    // encode png into memory, e.g. for streaming to a pipe
+    static std::vector<uint8_t> encodePNG(int w, int h, int comp, const void* data, int strideInBytes, bool flipY);
+
+    // full mip chain down to 1x1 with 2x2 box filter, level 0 is the input buffer
+    static std::vector<std::shared_ptr<Buffer<RGBA>>> generateMipmaps(const std::shared_ptr<Buffer<RGBA>>& image);
 
     static void convertFloatImage(RGBA* dst, float* src, uint32_t width, uint32_t height);
 };
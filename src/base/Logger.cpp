@@ -1,54 +1,538 @@
-
 #include "Logger.h"
 
-void* Logger::logContext_ = nullptr;
-LogFunc Logger::logFunc_ = nullptr;
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <condition_variable>
 
 // default level: LOG_INFO
-LogLevel Logger::minLevel_ = LOG_INFO;
+std::atomic<int> Logger::minLevel_{ LOG_INFO };
 
-char Logger::buf_[MAX_LOG_LENGTH] = {};
-std::mutex Logger::mutex_;
+// single producer single consumer ring of variable sized records.
+// each record starts with an 8 bytes header (size, flags) and never wraps around the end,
+// a padding record fills the remaining space when the next record does not fit.
+class LogRing {
+public:
+    static constexpr uint32_t FLAG_PADDING = 1;
+    static constexpr size_t HEADER_SIZE = 8;
 
-void Logger::setLogFunc(void* ctx, LogFunc func) {
-    logContext_ = ctx;
-    logFunc_ = func;
-}
+    LogRing() : buffer_(LOG_RING_SIZE) {}
 
-void Logger::setLogLevel(LogLevel level) {
-    minLevel_ = level;
-}
+    // producer
+    uint8_t* reserve(size_t size) {
+        size_t total = (size + HEADER_SIZE + 7) & ~(size_t)7;
+        if (total > LOG_RING_SIZE / 2) {
+            dropped_++;
+            return nullptr;
+        }
+
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t offset = head & (LOG_RING_SIZE - 1);
+        size_t padding = offset + total > LOG_RING_SIZE ? LOG_RING_SIZE - offset : 0;
+        if (head + padding + total - tail > LOG_RING_SIZE) {
+            dropped_++;
+            return nullptr;
+        }
+
+        if (padding > 0) {
+            writeHeader(offset, (uint32_t)padding, FLAG_PADDING);
+            offset = 0;
+        }
+        writeHeader(offset, (uint32_t)total, 0);
+        pendingHead_ = head + padding + total;
+        return buffer_.data() + offset + HEADER_SIZE;
+    }
+
+    void commit() {
+        head_.store(pendingHead_, std::memory_order_release);
+    }
+
+    // consumer, calls func(record) for each committed record
+    template<typename F>
+    bool drain(F&& func) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        if (tail == head) {
+            return false;
+        }
+        while (tail != head) {
+            size_t offset = tail & (LOG_RING_SIZE - 1);
+            uint32_t header[2];
+            memcpy(header, buffer_.data() + offset, sizeof(header));
+            if (!(header[1] & FLAG_PADDING)) {
+                func(buffer_.data() + offset + HEADER_SIZE);
+            }
+            tail += header[0];
+            tail_.store(tail, std::memory_order_release);
+        }
+        return true;
+    }
+
+    inline bool empty() const {
+        return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+    }
+
+    inline size_t getDroppedCount() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+public:
+    // set when the owner thread exits, the ring is released after drained
+    std::atomic<bool> retired{ false };
+
+private:
+    void writeHeader(size_t offset, uint32_t size, uint32_t flags) {
+        uint32_t header[2] = { size, flags };
+        memcpy(buffer_.data() + offset, header, sizeof(header));
+    }
+
+private:
+    std::vector<uint8_t> buffer_;
+    alignas(64) std::atomic<size_t> head_{ 0 };
+    alignas(64) std::atomic<size_t> tail_{ 0 };
+    size_t pendingHead_ = 0;
+    std::atomic<size_t> dropped_{ 0 };
+};
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be power of 2");
+
+// formats records and owns the writer thread
+class LogBackend {
+public:
+    static LogBackend* get() {
+        static LogBackend backend;
+        return alive_ ? &backend : nullptr;
+    }
+
+    LogBackend() {
+        alive_ = true;
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    ~LogBackend() {
+        {
+            std::lock_guard<std::mutex> lock(waitMutex_);
+            running_ = false;
+        }
+        cond_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        alive_ = false;
+    }
+
+    std::shared_ptr<LogRing> registerRing() {
+        auto ring = std::make_shared<LogRing>();
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        rings_.push_back(ring);
+        return ring;
+    }
+
+    // called by producers after each record. only the first one since the writer last woke up
+    // takes the lock, the others see pending_ already set
+    void notify() {
+        if (pending_.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(waitMutex_);
+        }
+        cond_.notify_one();
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(drainMutex_);
+        drainAll();
+    }
+
+    void setLogFunc(void* ctx, LogFunc func) {
+        std::lock_guard<std::mutex> lock(drainMutex_);
+        logContext_ = ctx;
+        logFunc_ = func;
+    }
+
+    size_t getDroppedCount() {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        size_t ret = retiredDropped_;
+        for (auto& ring : rings_) {
+            ret += ring->getDroppedCount();
+        }
+        return ret;
+    }
+
+    // format a record written by Logger::log
+    static void formatRecord(const uint8_t* record, std::string& out);
+    static void output(void* context, LogFunc func, int level, const char* file, int line, const char* msg);
+
+private:
+    void run() {
+        bool running = true;
+        while (running) {
+            {
+                std::unique_lock<std::mutex> lock(waitMutex_);
+                cond_.wait(lock, [this]() { return !running_ || pending_.load(std::memory_order_relaxed); });
+                running = running_;
+            }
+            // cleared before draining, records committed during the drain signal again. the exchange
+            // reads the producer's release of pending_, so its record is visible to the drain
+            pending_.exchange(false, std::memory_order_acq_rel);
+            std::lock_guard<std::mutex> lock(drainMutex_);
+            drainAll();
+        }
+    }
+
+    // called with drainMutex_ held, the only consumer of all rings
+    void drainAll() {
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex_);
+            snapshot_ = rings_;
+        }
+
+        bool written = false;
+        for (auto& ring : snapshot_) {
+            written |= ring->drain([this](const uint8_t* record) {
+                auto* header = (const Logger::RecordHeader*)record;
+                formatRecord(record, line_);
+                output(logContext_, logFunc_, header->level, header->file, header->line, line_.c_str());
+            });
+        }
+        snapshot_.clear();
+
+        // release rings of exited threads, report dropped messages
+        size_t dropped = 0;
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex_);
+            for (auto it = rings_.begin(); it != rings_.end();) {
+                if ((*it)->retired && (*it)->empty()) {
+                    retiredDropped_ += (*it)->getDroppedCount();
+                    it = rings_.erase(it);
+                } else {
+                    dropped += (*it)->getDroppedCount();
+                    ++it;
+                }
+            }
+            dropped += retiredDropped_;
+        }
+        if (dropped > reportedDropped_) {
+            char msg[64];
+            snprintf(msg, sizeof(msg), "Logger: %d messages dropped", (int)(dropped - reportedDropped_));
+            output(logContext_, logFunc_, LOG_WARNING, __FILE__, __LINE__, msg);
+            reportedDropped_ = dropped;
+            written = true;
+        }
+
+        if (written) {
+            fflush(stdout);
+            fflush(stderr);
+        }
+    }
+
+private:
+    static std::atomic<bool> alive_;
+
+    std::thread thread_;
+    std::mutex waitMutex_;
+    std::condition_variable cond_;
+    bool running_ = true;
+    std::atomic<bool> pending_{ false };
+
+    std::mutex ringsMutex_;
+    std::vector<std::shared_ptr<LogRing>> rings_;
+    size_t retiredDropped_ = 0;
+
+    // consumer state
+    std::mutex drainMutex_;
+    std::vector<std::shared_ptr<LogRing>> snapshot_;
+    std::string line_;
+    size_t reportedDropped_ = 0;
+    void* logContext_ = nullptr;
+    LogFunc logFunc_ = nullptr;
+};
 
-void Logger::log(LogLevel level, const char* file, int line, const char* message, ...) {
-    std::lock_guard<std::mutex> lock_guard(mutex_);
-    if (level < minLevel_) {
+std::atomic<bool> LogBackend::alive_{ false };
+
+struct LogArg {
+    LogArgType type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+    };
+    const char* str;
+    uint32_t len;
+
+    int64_t asInt() const {
+        switch (type) {
+        case LogArg_INT:    return i;
+        case LogArg_DOUBLE: return (int64_t)d;
+        case LogArg_STRING: return 0;
+        default:            return (int64_t)u;
+        }
+    }
+
+    uint64_t asUInt() const {
+        return type == LogArg_DOUBLE ? (uint64_t)d : (uint64_t)asInt();
+    }
+
+    double asDouble() const {
+        switch (type) {
+        case LogArg_DOUBLE: return d;
+        case LogArg_UINT:   return (double)u;
+        default:            return (double)asInt();
+        }
+    }
+};
+
+template<typename T>
+static void appendFormat(std::string& out, const std::string& spec, T value) {
+    char buf[256];
+    int n = snprintf(buf, sizeof(buf), spec.c_str(), value);
+    if (n < 0) {
+        return;
+    }
+    if (n < (int)sizeof(buf)) {
+        out.append(buf, n);
         return;
     }
+    size_t pos = out.size();
+    out.resize(pos + n + 1);
+    snprintf(&out[pos], n + 1, spec.c_str(), value);
+    out.resize(pos + n);
+}
+
+void LogBackend::formatRecord(const uint8_t* record, std::string& out) {
+    auto* header = (const Logger::RecordHeader*)record;
+    const char* fmt = (const char*)record + sizeof(Logger::RecordHeader);
+    const char* fmtEnd = fmt + header->fmtLen;
+    const uint8_t* args = (const uint8_t*)fmtEnd;
+    int argsLeft = header->argCnt;
+
+    auto nextArg = [&](LogArg& arg) -> bool {
+        if (argsLeft <= 0) {
+            return false;
+        }
+        argsLeft--;
+        arg.type = (LogArgType)*args++;
+        if (arg.type == LogArg_STRING) {
+            memcpy(&arg.len, args, sizeof(uint32_t));
+            arg.str = (const char*)args + sizeof(uint32_t);
+            args += sizeof(uint32_t) + arg.len;
+        } else {
+            memcpy(&arg.u, args, sizeof(uint64_t));
+            args += sizeof(uint64_t);
+        }
+        return true;
+    };
 
-    va_list argPtr;
-    va_start(argPtr, message);
-    vsnprintf(buf_, MAX_LOG_LENGTH - 1, message, argPtr);
-    va_end(argPtr);
-    buf_[MAX_LOG_LENGTH - 1] = '\0';
+    out.clear();
+    std::string spec;
+    const char* p = fmt;
+    while (p < fmtEnd) {
+        if (*p != '%') {
+            out.push_back(*p++);
+            continue;
+        }
+        if (p + 1 < fmtEnd && p[1] == '%') {
+            out.push_back('%');
+            p += 2;
+            continue;
+        }
 
-    if (logFunc_ != nullptr) {
-        logFunc_(logContext_, level, buf_);
+        // rebuild the conversion spec, length modifiers are replaced by the stored 64-bit width
+        spec = "%";
+        p++;
+        while (p < fmtEnd && strchr("-+ #0", *p)) {
+            spec.push_back(*p++);
+        }
+        for (int part = 0; part < 2 && p < fmtEnd; part++) {
+            if (part == 1) {
+                if (*p != '.') {
+                    break;
+                }
+                spec.push_back(*p++);
+            }
+            if (p < fmtEnd && *p == '*') {
+                LogArg arg{};
+                spec += std::to_string(nextArg(arg) ? arg.asInt() : 0);
+                p++;
+            }
+            while (p < fmtEnd && *p >= '0' && *p <= '9') {
+                spec.push_back(*p++);
+            }
+        }
+        while (p < fmtEnd && strchr("hljztLq", *p)) {
+            p++;
+        }
+        if (p >= fmtEnd) {
+            out += spec;
+            break;
+        }
+
+        char conv = *p++;
+        LogArg arg{};
+        if (!nextArg(arg)) {
+            out += spec;
+            out.push_back(conv);
+            continue;
+        }
+
+        switch (conv) {
+        case 'd':
+        case 'i':
+            spec += "ll";
+            spec.push_back(conv);
+            appendFormat(out, spec, (long long)arg.asInt());
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            spec += "ll";
+            spec.push_back(conv);
+            appendFormat(out, spec, (unsigned long long)arg.asUInt());
+            break;
+        case 'c':
+            spec.push_back(conv);
+            appendFormat(out, spec, (int)arg.asInt());
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            spec.push_back(conv);
+            appendFormat(out, spec, arg.asDouble());
+            break;
+        case 's':
+            if (arg.type != LogArg_STRING) {
+                out += "(null)";
+            } else if (spec.size() == 1) {
+                out.append(arg.str, arg.len);
+            } else {
+                spec.push_back(conv);
+                appendFormat(out, spec, std::string(arg.str, arg.len).c_str());
+            }
+            break;
+        case 'p':
+            spec.push_back(conv);
+            appendFormat(out, spec, (void*)(uintptr_t)arg.u);
+            break;
+        default:
+            out += spec;
+            out.push_back(conv);
+            break;
+        }
+    }
+
+    if (out.size() > MAX_LOG_LENGTH - 1) {
+        out.resize(MAX_LOG_LENGTH - 1);
+    }
+}
+
+void LogBackend::output(void* context, LogFunc func, int level, const char* file, int line, const char* msg) {
+    if (func != nullptr) {
+        func(context, level, msg);
         return;
     }
 
     switch (level) {
 #ifdef LOG_SOURCE_LINE
-    case LOG_INFO:    fprintf(stdout, "[INFO] %s:%d: %s\n", file, line, buf_);    break;
-    case LOG_DEBUG:   fprintf(stdout, "[DEBUG] %s:%d: %s\n", file, line, buf_);   break;
-    case LOG_WARNING: fprintf(stdout, "[WARNING] %s:%d: %s\n", file, line, buf_); break;
-    case LOG_ERROR:   fprintf(stdout, "[ERROR] %s:%d: %s\n", file, line, buf_);   break;
+    case LOG_INFO:    fprintf(stdout, "[INFO] %s:%d: %s\n", file, line, msg);    break;
+    case LOG_DEBUG:   fprintf(stdout, "[DEBUG] %s:%d: %s\n", file, line, msg);   break;
+    case LOG_WARNING: fprintf(stdout, "[WARNING] %s:%d: %s\n", file, line, msg); break;
+    case LOG_ERROR:   fprintf(stderr, "[ERROR] %s:%d: %s\n", file, line, msg);   break;
 #else
-    case LOG_INFO:    fprintf(stdout, "[INFO] : %s\n", buf_);    break;
-    case LOG_DEBUG:   fprintf(stdout, "[DEBUG] : %s\n", buf_);   break;
-    case LOG_WARNING: fprintf(stdout, "[WARNING] : %s\n", buf_); break;
-    case LOG_ERROR:   fprintf(stderr, "[ERROR] : %s\n", buf_);   break;
+    case LOG_INFO:    fprintf(stdout, "[INFO] : %s\n", msg);    break;
+    case LOG_DEBUG:   fprintf(stdout, "[DEBUG] : %s\n", msg);   break;
+    case LOG_WARNING: fprintf(stdout, "[WARNING] : %s\n", msg); break;
+    case LOG_ERROR:   fprintf(stderr, "[ERROR] : %s\n", msg);   break;
 #endif
+    default: break;
+    }
+}
+
+// ring of the calling thread, marked retired on thread exit
+struct LogRingHolder {
+    ~LogRingHolder() {
+        if (ring) {
+            ring->retired = true;
+        }
+    }
+
+    std::shared_ptr<LogRing> ring;
+};
+
+static thread_local LogRingHolder tlsRing;
+
+// records logged after the backend is destroyed (static destructors) are written synchronously
+static thread_local std::vector<uint8_t> tlsSyncRecord;
+static thread_local bool tlsSync = false;
+static std::mutex syncMutex;
+static void* syncLogContext = nullptr;
+static LogFunc syncLogFunc = nullptr;
+
+void Logger::setLogFunc(void* ctx, LogFunc func) {
+    {
+        std::lock_guard<std::mutex> lock(syncMutex);
+        syncLogContext = ctx;
+        syncLogFunc = func;
+    }
+    if (auto* backend = LogBackend::get()) {
+        backend->setLogFunc(ctx, func);
+    }
+}
+
+void Logger::setLogLevel(LogLevel level) {
+    minLevel_ = level;
+}
+
+void Logger::flush() {
+    if (auto* backend = LogBackend::get()) {
+        backend->flush();
     }
     fflush(stdout);
     fflush(stderr);
 }
+
+size_t Logger::getDroppedCount() {
+    auto* backend = LogBackend::get();
+    return backend ? backend->getDroppedCount() : 0;
+}
+
+uint8_t* Logger::beginRecord(size_t size) {
+    auto* backend = LogBackend::get();
+    if (!backend) {
+        tlsSync = true;
+        tlsSyncRecord.resize(size);
+        return tlsSyncRecord.data();
+    }
+
+    if (!tlsRing.ring) {
+        tlsRing.ring = backend->registerRing();
+    }
+    return tlsRing.ring->reserve(size);
+}
+
+void Logger::endRecord(LogLevel level) {
+    if (tlsSync) {
+        tlsSync = false;
+        std::string line;
+        LogBackend::formatRecord(tlsSyncRecord.data(), line);
+        auto* header = (const RecordHeader*)tlsSyncRecord.data();
+        std::lock_guard<std::mutex> lock(syncMutex);
+        LogBackend::output(syncLogContext, syncLogFunc, level, header->file, header->line, line.c_str());
+        fflush(stdout);
+        fflush(stderr);
+        return;
+    }
+
+    tlsRing.ring->commit();
+    if (auto* backend = LogBackend::get()) {
+        backend->notify();
+    }
+}
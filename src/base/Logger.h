@@ -1,18 +1,76 @@
-
 #pragma once
 
 #include <cstdio>
 #include <cstring>
-#include <cstdarg>
-#include <mutex>
+#include <cstdint>
+#include <string>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+
+// calls below this level are removed at compile time, arguments are not evaluated.
+// 0: info, 1: debug, 2: warning, 3: error, 4: none
+#ifndef SOFTGL_LOG_MIN_LEVEL
+#define SOFTGL_LOG_MIN_LEVEL 0
+#endif
+
+// the level set by Logger::setLogLevel is checked before arguments are evaluated
+#define SOFTGL_LOG(level, ...)                                              \
+    do {                                                                    \
+        if (Logger::isEnabled(level)) {                                     \
+            Logger::log(level, __FILE__, __LINE__, __VA_ARGS__);            \
+        }                                                                   \
+    } while (0)
+
+// log the 1st, (n+1)th, (2n+1)th ... call of this call site
+#define SOFTGL_LOG_EVERY_N(level, n, ...)                                   \
+    do {                                                                    \
+        static std::atomic<uint32_t> logCounter_{ 0 };                      \
+        if (Logger::isEnabled(level)                                        \
+            && logCounter_.fetch_add(1, std::memory_order_relaxed) % (n) == 0) { \
+            Logger::log(level, __FILE__, __LINE__, __VA_ARGS__);            \
+        }                                                                   \
+    } while (0)
+
+#define SOFTGL_LOG_NONE(...) do {} while (0)
+
+#if SOFTGL_LOG_MIN_LEVEL <= 0
+#define LOGI(...)               SOFTGL_LOG(LOG_INFO, __VA_ARGS__)
+#define LOGI_EVERY_N(n, ...)    SOFTGL_LOG_EVERY_N(LOG_INFO, n, __VA_ARGS__)
+#else
+#define LOGI(...)               SOFTGL_LOG_NONE()
+#define LOGI_EVERY_N(n, ...)    SOFTGL_LOG_NONE()
+#endif
+
+#if SOFTGL_LOG_MIN_LEVEL <= 1
+#define LOGD(...)               SOFTGL_LOG(LOG_DEBUG, __VA_ARGS__)
+#define LOGD_EVERY_N(n, ...)    SOFTGL_LOG_EVERY_N(LOG_DEBUG, n, __VA_ARGS__)
+#else
+#define LOGD(...)               SOFTGL_LOG_NONE()
+#define LOGD_EVERY_N(n, ...)    SOFTGL_LOG_NONE()
+#endif
 
-#define LOGI(...) Logger::log(LOG_INFO,     __FILE__, __LINE__, __VA_ARGS__)
-#define LOGD(...) Logger::log(LOG_DEBUG,    __FILE__, __LINE__, __VA_ARGS__)
-#define LOGW(...) Logger::log(LOG_WARNING,  __FILE__, __LINE__, __VA_ARGS__)
-#define LOGE(...) Logger::log(LOG_ERROR,    __FILE__, __LINE__, __VA_ARGS__)
+#if SOFTGL_LOG_MIN_LEVEL <= 2
+#define LOGW(...)               SOFTGL_LOG(LOG_WARNING, __VA_ARGS__)
+#define LOGW_EVERY_N(n, ...)    SOFTGL_LOG_EVERY_N(LOG_WARNING, n, __VA_ARGS__)
+#else
+#define LOGW(...)               SOFTGL_LOG_NONE()
+#define LOGW_EVERY_N(n, ...)    SOFTGL_LOG_NONE()
+#endif
+
+#if SOFTGL_LOG_MIN_LEVEL <= 3
+#define LOGE(...)               SOFTGL_LOG(LOG_ERROR, __VA_ARGS__)
+#define LOGE_EVERY_N(n, ...)    SOFTGL_LOG_EVERY_N(LOG_ERROR, n, __VA_ARGS__)
+#else
+#define LOGE(...)               SOFTGL_LOG_NONE()
+#define LOGE_EVERY_N(n, ...)    SOFTGL_LOG_NONE()
+#endif
 
 static constexpr int MAX_LOG_LENGTH = 1024;
 
+// bytes of the ring buffer of each logging thread, messages are dropped when it is full
+static constexpr size_t LOG_RING_SIZE = 64 * 1024;
+
 typedef void (*LogFunc)(void* context, int level, const char* msg);
 
 enum LogLevel {
@@ -22,17 +80,129 @@ enum LogLevel {
     LOG_ERROR,
 };
 
+enum LogArgType : uint8_t {
+    LogArg_INT,
+    LogArg_UINT,
+    LogArg_DOUBLE,
+    LogArg_STRING,
+    LogArg_POINTER,
+};
+
+// asynchronous logger.
+// log() copies the format string and arguments into a ring buffer owned by the calling thread,
+// a background thread formats and writes the messages, so logging threads never share a lock.
+// the log function set by setLogFunc() is called on the background thread.
 class Logger {
 public:
     static void setLogFunc(void* ctx, LogFunc func);
     static void setLogLevel(LogLevel level);
-    static void log(LogLevel level, const char* file, int line, const char* message, ...);
+
+    static inline bool isEnabled(LogLevel level) {
+        return level >= minLevel_.load(std::memory_order_relaxed);
+    }
+
+    template<typename... Args>
+    static void log(LogLevel level, const char* file, int line, const char* message, const Args&... args) {
+        if (!isEnabled(level)) {
+            return;
+        }
+
+        size_t fmtLen = strnlen(message, MAX_LOG_LENGTH - 1);
+        size_t size = sizeof(RecordHeader) + fmtLen + (size_t(0) + ... + argSize(args));
+        uint8_t* ptr = beginRecord(size);
+        if (!ptr) {
+            return;
+        }
+
+        auto* header = (RecordHeader*)ptr;
+        header->file = file;
+        header->line = line;
+        header->level = (uint8_t)level;
+        header->argCnt = (uint8_t)sizeof...(Args);
+        header->fmtLen = (uint16_t)fmtLen;
+        ptr += sizeof(RecordHeader);
+        memcpy(ptr, message, fmtLen);
+        ptr += fmtLen;
+        (writeArg(ptr, args), ...);
+
+        endRecord(level);
+    }
+
+    // block until all messages logged before the call are written
+    static void flush();
+
+    // messages dropped because a ring buffer was full
+    static size_t getDroppedCount();
 
 private:
-    static void* logContext_;
-    static LogFunc logFunc_;
-    static LogLevel minLevel_;
+    struct RecordHeader {
+        const char* file;
+        int32_t line;
+        uint8_t level;
+        uint8_t argCnt;
+        uint16_t fmtLen;
+    };
+
+    static uint8_t* beginRecord(size_t size);
+    static void endRecord(LogLevel level);
+
+    template<typename T>
+    static constexpr bool isString() {
+        using D = std::decay_t<T>;
+        return std::is_same_v<D, char*> || std::is_same_v<D, const char*>;
+    }
 
-    static char buf_[MAX_LOG_LENGTH];
-    static std::mutex mutex_;
+    template<typename T>
+    static size_t argSize(const T& arg) {
+        if constexpr (std::is_same_v<T, std::string>) {
+            return 1 + sizeof(uint32_t) + std::min(arg.size(), (size_t)MAX_LOG_LENGTH);
+        } else if constexpr (isString<T>()) {
+            const char* str = arg;
+            return 1 + sizeof(uint32_t) + (str ? strnlen(str, MAX_LOG_LENGTH) : 0);
+        } else {
+            return 1 + sizeof(uint64_t);
+        }
+    }
+
+    template<typename T>
+    static void writeArg(uint8_t*& ptr, const T& arg) {
+        using D = std::decay_t<T>;
+        if constexpr (std::is_same_v<T, std::string>) {
+            writeString(ptr, arg.data(), std::min(arg.size(), (size_t)MAX_LOG_LENGTH));
+        } else if constexpr (isString<T>()) {
+            const char* str = arg;
+            writeString(ptr, str, str ? strnlen(str, MAX_LOG_LENGTH) : 0);
+        } else if constexpr (std::is_floating_point_v<D>) {
+            writeValue(ptr, LogArg_DOUBLE, (double)arg);
+        } else if constexpr (std::is_enum_v<D> || std::is_signed_v<D>) {
+            writeValue(ptr, LogArg_INT, (int64_t)arg);
+        } else if constexpr (std::is_integral_v<D>) {
+            writeValue(ptr, LogArg_UINT, (uint64_t)arg);
+        } else {
+            writeValue(ptr, LogArg_POINTER, (uint64_t)(uintptr_t)(const void*)arg);
+        }
+    }
+
+    template<typename V>
+    static void writeValue(uint8_t*& ptr, LogArgType type, V value) {
+        *ptr++ = type;
+        memcpy(ptr, &value, sizeof(uint64_t));
+        ptr += sizeof(uint64_t);
+    }
+
+    static void writeString(uint8_t*& ptr, const char* str, size_t len) {
+        auto len32 = (uint32_t)len;
+        *ptr++ = LogArg_STRING;
+        memcpy(ptr, &len32, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+        if (len > 0) {
+            memcpy(ptr, str, len);
+            ptr += len;
+        }
+    }
+
+    friend class LogBackend;
+
+private:
+    static std::atomic<int> minLevel_;
 };
@@ -2,5 +2,10 @@
 
 #include "math/mathfwd.h"
 #include "math/scalar.h"
+#include "math/vec2.h"
+#include "math/vec3.h"
+#include "math/vec4.h"
+#include "math/mat3.h"
+#include "math/mat4.h"
 
-using RGBA = math::ubyte4;
\ No newline at end of file
+using RGBA = math::ubyte4;
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <future>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "math/frustum.h"
+#include "math/transform.h"
+
+// inputs of at least PARALLEL_RANGE_MIN elements are split across the pool
+constexpr size_t PARALLEL_RANGE_MIN = 1 << 15;
+
+// The batch kernels of math/transform.h and math/frustum.h split across a ThreadPool. The caller
+// thread takes a share too, so these must not be called from a task of the same pool. A null pool
+// runs the plain single threaded versions.
+class ParallelUtils {
+public:
+    // run func(begin, end) over [0, n), chunks are multiples of 8 elements
+    template<typename F>
+    static void parallelRange(size_t n, ThreadPool* pool, F&& func) {
+        size_t threadCnt = pool ? pool->getThreadCnt() + 1 : 1;
+        if (n < PARALLEL_RANGE_MIN || threadCnt == 1) {
+            func((size_t) 0, n);
+            return;
+        }
+        size_t chunk = ((n + threadCnt - 1) / threadCnt + 7) & ~(size_t) 7;
+        std::vector<std::future<void>> futures;
+        futures.reserve(threadCnt);
+        size_t begin = chunk;
+        for (; begin < n; begin += chunk) {
+            size_t end = std::min(n, begin + chunk);
+            futures.push_back(pool->pushTask([&func, begin, end]() { func(begin, end); }));
+        }
+        func((size_t) 0, std::min(n, chunk));
+        for (auto& f : futures) {
+            f.wait();
+        }
+    }
+
+    static void transformPoints(const math::mat4f& m, const math::float3* in, math::float4* out, size_t n,
+                                ThreadPool* pool) {
+        parallelRange(n, pool, [&](size_t begin, size_t end) {
+            math::details::batch::transformPoints(m, in, out, begin, end);
+        });
+    }
+
+    static void transformPoints(const math::mat4f& m, const math::float3* in, math::float3* out, size_t n,
+                                ThreadPool* pool) {
+        parallelRange(n, pool, [&](size_t begin, size_t end) {
+            math::details::batch::transformPoints(m, in, out, begin, end);
+        });
+    }
+
+    static void transformNormals(const math::mat4f& m, const math::float3* in, math::float3* out, size_t n,
+                                 ThreadPool* pool) {
+        parallelRange(n, pool, [&](size_t begin, size_t end) {
+            math::details::batch::transformNormals(m, in, out, begin, end);
+        });
+    }
+
+    static void transformAABBs(const math::mat4f& m, const math::AABB* in, math::AABB* out, size_t n,
+                               ThreadPool* pool) {
+        parallelRange(n, pool, [&](size_t begin, size_t end) {
+            math::details::batch::transformAABBs(m, in, out, begin, end);
+        });
+    }
+
+    static void cullAABBs(const math::Frustum& frustum, const math::AABBArray& boxes, uint8_t* visibleMasks,
+                          ThreadPool* pool) {
+        parallelRange(boxes.paddedSize(), pool, [&](size_t begin, size_t end) {
+            math::details::batch::cullAABBs(frustum, boxes, visibleMasks, begin, end);
+        });
+    }
+};
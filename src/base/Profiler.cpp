@@ -0,0 +1,167 @@
+#include "Profiler.h"
+#include "Logger.h"
+#include "FileUtils.h"
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <json11.hpp>
+
+std::atomic<bool> Profiler::enabled_{ false };
+std::atomic<uint32_t> Profiler::frameIndex_{ 0 };
+const std::chrono::steady_clock::time_point Profiler::epoch_ = std::chrono::steady_clock::now();
+
+// zones of one thread, the lock is only contended while exporting
+struct ProfileRing {
+    std::mutex mutex;
+    std::vector<ProfileEvent> events;
+    size_t head = 0;
+    uint32_t threadId = 0;
+    std::string threadName;
+};
+
+struct ProfileFrame {
+    uint32_t index;
+    int64_t time;
+};
+
+class ProfileRegistry {
+public:
+    static ProfileRegistry& instance() {
+        static ProfileRegistry registry;
+        return registry;
+    }
+
+    std::shared_ptr<ProfileRing> createRing() {
+        auto ring = std::make_shared<ProfileRing>();
+        ring->events.resize(PROFILE_RING_SIZE);
+        std::lock_guard<std::mutex> lock(mutex_);
+        ring->threadId = nextThreadId_++;
+        rings_.push_back(ring);
+        return ring;
+    }
+
+    void addFrame(uint32_t index, int64_t time) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        frames_.push_back({index, time});
+        if (frames_.size() > PROFILE_RING_SIZE) {
+            frames_.pop_front();
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        frames_.clear();
+        for (auto& ring : rings_) {
+            std::lock_guard<std::mutex> ringLock(ring->mutex);
+            ring->head = 0;
+        }
+        // rings of exited threads are only referenced here
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                    [](const std::shared_ptr<ProfileRing>& ring) { return ring.use_count() == 1; }),
+                     rings_.end());
+    }
+
+    json11::Json::array exportEvents() {
+        json11::Json::array events;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& frame : frames_) {
+            events.push_back(json11::Json::object{
+                {"name", "Frame"},
+                {"ph", "i"},
+                {"s", "g"},
+                {"pid", 0},
+                {"tid", 0},
+                {"ts", (double)frame.time / 1000.0},
+                {"args", json11::Json::object{{"frame", (int)frame.index}}},
+            });
+        }
+
+        for (auto& ring : rings_) {
+            std::lock_guard<std::mutex> ringLock(ring->mutex);
+            int tid = (int)ring->threadId;
+            std::string threadName = ring->threadName.empty() ? "Thread " + std::to_string(tid) : ring->threadName;
+            events.push_back(json11::Json::object{
+                {"name", "thread_name"},
+                {"ph", "M"},
+                {"pid", 0},
+                {"tid", tid},
+                {"args", json11::Json::object{{"name", threadName}}},
+            });
+
+            size_t count = std::min(ring->head, PROFILE_RING_SIZE);
+            for (size_t i = ring->head - count; i < ring->head; i++) {
+                auto& event = ring->events[i % PROFILE_RING_SIZE];
+                events.push_back(json11::Json::object{
+                    {"name", event.name},
+                    {"ph", "X"},
+                    {"pid", 0},
+                    {"tid", tid},
+                    {"ts", (double)event.start / 1000.0},
+                    {"dur", (double)(event.end - event.start) / 1000.0},
+                    {"args", json11::Json::object{{"frame", (int)event.frame}, {"depth", (int)event.depth}}},
+                });
+            }
+        }
+        return events;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<ProfileRing>> rings_;
+    std::deque<ProfileFrame> frames_;
+    uint32_t nextThreadId_ = 1;
+};
+
+static ProfileRing& threadRing() {
+    thread_local std::shared_ptr<ProfileRing> ring = ProfileRegistry::instance().createRing();
+    return *ring;
+}
+
+void Profiler::setEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const char* name) {
+    auto& ring = threadRing();
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    ring.threadName = name;
+}
+
+void Profiler::frameMark() {
+    uint32_t index = frameIndex_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (isEnabled()) {
+        ProfileRegistry::instance().addFrame(index, now());
+    }
+}
+
+void Profiler::clear() {
+    ProfileRegistry::instance().clear();
+}
+
+uint32_t& Profiler::threadDepth() {
+    thread_local uint32_t depth = 0;
+    return depth;
+}
+
+void Profiler::pushEvent(const ProfileEvent& event) {
+    auto& ring = threadRing();
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    ring.events[ring.head % PROFILE_RING_SIZE] = event;
+    ring.head++;
+}
+
+bool Profiler::exportChromeTrace(const std::string& path) {
+    json11::Json trace = json11::Json::object{
+        {"traceEvents", ProfileRegistry::instance().exportEvents()},
+        {"displayTimeUnit", "ms"},
+    };
+    if (!FileUtils::writeText(path, trace.dump())) {
+        LOGE("Profiler::exportChromeTrace failed: can not write %s", path.c_str());
+        return false;
+    }
+    LOGI("Profiler: trace saved to %s", path.c_str());
+    return true;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+#include <chrono>
+
+// zones recorded by each thread, the oldest zones are overwritten when the ring is full
+static constexpr size_t PROFILE_RING_SIZE = 64 * 1024;
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// PROFILE_ZONE("name") records the time from this line to the end of the enclosing scope,
+// name must be a string literal (or any string with static storage), only the pointer is stored.
+// SOFTGL_PROFILER off removes all markers at compile time.
+#ifdef SOFTGL_PROFILER
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_FRAME() Profiler::frameMark()
+#else
+#define PROFILE_ZONE(name) do {} while (0)
+#define PROFILE_FRAME() do {} while (0)
+#endif
+
+struct ProfileEvent {
+    const char* name;
+    int64_t start;  // ns since the profiler epoch
+    int64_t end;
+    uint32_t frame;
+    uint32_t depth;
+};
+
+// hierarchical cpu profiler.
+// zones are pushed to a ring buffer owned by the calling thread, nesting is given by the depth
+// of each zone on its thread. exportChromeTrace() writes all rings to a Chrome trace json file
+// which can be opened in chrome://tracing or https://ui.perfetto.dev
+class Profiler {
+public:
+    static inline bool isEnabled() {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    static void setEnabled(bool enabled);
+
+    // name shown for the calling thread in the trace
+    static void setThreadName(const char* name);
+
+    // mark the beginning of a new frame
+    static void frameMark();
+
+    static inline uint32_t getFrameIndex() {
+        return frameIndex_.load(std::memory_order_relaxed);
+    }
+
+    // ns since the profiler epoch
+    static inline int64_t now() {
+        auto duration = std::chrono::steady_clock::now() - epoch_;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    }
+
+    // drop all recorded zones
+    static void clear();
+
+    static bool exportChromeTrace(const std::string& path);
+
+    static void pushEvent(const ProfileEvent& event);
+
+    static uint32_t& threadDepth();
+
+private:
+    static std::atomic<bool> enabled_;
+    static std::atomic<uint32_t> frameIndex_;
+    static const std::chrono::steady_clock::time_point epoch_;
+};
+
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) {
+        if (Profiler::isEnabled()) {
+            name_ = name;
+            depth_ = Profiler::threadDepth()++;
+            start_ = Profiler::now();
+        }
+    }
+
+    ~ProfileZone() {
+        if (name_) {
+            int64_t end = Profiler::now();
+            Profiler::threadDepth()--;
+            Profiler::pushEvent({name_, start_, end, Profiler::getFrameIndex(), depth_});
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name_ = nullptr;
+    int64_t start_ = 0;
+    uint32_t depth_ = 0;
+};
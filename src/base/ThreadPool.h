@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <functional>
+#include <condition_variable>
+
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCnt = std::thread::hardware_concurrency()) {
+        if (threadCnt == 0) {
+            threadCnt = 1;
+        }
+        threads_.reserve(threadCnt);
+        for (size_t i = 0; i < threadCnt; i++) {
+            threads_.emplace_back([this, i]() { worker(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        taskCond_.notify_all();
+        for (auto& th : threads_) {
+            if (th.joinable()) {
+                th.join();
+            }
+        }
+    }
+
+    inline size_t getThreadCnt() const {
+        return threads_.size();
+    }
+
+    // push task and get a future of its result, task runs on any worker thread
+    template<typename F>
+    auto pushTask(F&& func) -> std::future<decltype(func())> {
+        using R = decltype(func());
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(func));
+        std::future<R> ret = task->get_future();
+        enqueue([task](size_t) { (*task)(); });
+        return ret;
+    }
+
+    // push task receiving the index of the worker thread, useful for per-thread scratch data
+    void pushTaskIndexed(const std::function<void(size_t threadId)>& func) {
+        enqueue(func);
+    }
+
+    // block until task queue is empty and all workers are idle
+    void waitTasksFinish() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idleCond_.wait(lock, [this]() { return tasks_.empty() && busyCnt_ == 0; });
+    }
+
+private:
+    void enqueue(std::function<void(size_t)> func) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push(std::move(func));
+        }
+        taskCond_.notify_one();
+    }
+
+    void worker(size_t threadId) {
+        while (true) {
+            std::function<void(size_t)> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                taskCond_.wait(lock, [this]() { return !running_ || !tasks_.empty(); });
+                if (!running_ && tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop();
+                busyCnt_++;
+            }
+
+            task(threadId);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                busyCnt_--;
+                if (tasks_.empty() && busyCnt_ == 0) {
+                    idleCond_.notify_all();
+                }
+            }
+        }
+    }
+
+private:
+    std::vector<std::thread> threads_;
+    std::queue<std::function<void(size_t)>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable taskCond_;
+    std::condition_variable idleCond_;
+    size_t busyCnt_ = 0;
+    bool running_ = true;
+};
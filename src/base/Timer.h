@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include "Logger.h"
+
+class Timer {
+public:
+    Timer() {
+        start();
+    }
+
+    inline void start() {
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    // elapsed time since start() in milliseconds
+    inline double elapseMillis() const {
+        auto now = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(now - start_).count();
+    }
+
+private:
+    std::chrono::time_point<std::chrono::steady_clock> start_;
+};
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* tag) : tag_(tag) {}
+
+    ~ScopedTimer() {
+        LOGD("TIMER %s: cost: %.2f ms", tag_.c_str(), timer_.elapseMillis());
+    }
+
+private:
+    Timer timer_;
+    std::string tag_;
+};
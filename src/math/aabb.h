@@ -0,0 +1,119 @@
+#ifndef TNT_MATH_AABB_H
+#define TNT_MATH_AABB_H
+
+#include <math/compiler.h>
+#include <math/vec3.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace math {
+
+/**
+ * Axis aligned bounding box, default constructed empty (min > max) so that
+ * merging points or boxes into it starts from nothing.
+ */
+struct AABB {
+    float3 min = float3(std::numeric_limits<float>::max());
+    float3 max = float3(std::numeric_limits<float>::lowest());
+
+    AABB() = default;
+    constexpr AABB(const float3& min, const float3& max) noexcept : min(min), max(max) {}
+
+    inline constexpr bool isEmpty() const noexcept {
+        return min.x > max.x || min.y > max.y || min.z > max.z;
+    }
+
+    inline constexpr float3 center() const noexcept {
+        return (min + max) * 0.5f;
+    }
+
+    // half size
+    inline constexpr float3 extent() const noexcept {
+        return (max - min) * 0.5f;
+    }
+
+    inline void merge(const float3& p) noexcept {
+        merge(p, p);
+    }
+
+    inline void merge(const AABB& box) noexcept {
+        merge(box.min, box.max);
+    }
+
+    inline void merge(const float3& lo, const float3& hi) noexcept {
+        // the min / max members hide the vector functions of the same name
+        min = float3(std::min(min.x, lo.x), std::min(min.y, lo.y), std::min(min.z, lo.z));
+        max = float3(std::max(max.x, hi.x), std::max(max.y, hi.y), std::max(max.z, hi.z));
+    }
+
+    inline constexpr bool contains(const float3& p) const noexcept {
+        return p.x >= min.x && p.y >= min.y && p.z >= min.z &&
+               p.x <= max.x && p.y <= max.y && p.z <= max.z;
+    }
+
+    inline constexpr bool intersects(const AABB& box) const noexcept {
+        return min.x <= box.max.x && min.y <= box.max.y && min.z <= box.max.z &&
+               max.x >= box.min.x && max.y >= box.min.y && max.z >= box.min.z;
+    }
+};
+
+/**
+ * Boxes of many objects as center and half extent arrays (SoA), to test 8 of them at a time.
+ * The arrays are padded to a multiple of 8, empty and padding boxes have a NaN center so
+ * that every comparison against them fails.
+ */
+struct AABBArray {
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    size_t count = 0;
+
+    inline size_t size() const noexcept {
+        return count;
+    }
+
+    // multiple of 8
+    inline size_t paddedSize() const noexcept {
+        return centerX.size();
+    }
+
+    void resize(size_t n) {
+        size_t padded = (n + 7) & ~(size_t) 7;
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        centerX.resize(padded, nan);
+        centerY.resize(padded, nan);
+        centerZ.resize(padded, nan);
+        extentX.resize(padded, 0.f);
+        extentY.resize(padded, 0.f);
+        extentZ.resize(padded, 0.f);
+        for (size_t i = n; i < padded; i++) {
+            set(i, AABB());
+        }
+        count = n;
+    }
+
+    inline void set(size_t i, const AABB& box) noexcept {
+        float3 c = box.isEmpty() ? float3(std::numeric_limits<float>::quiet_NaN()) : box.center();
+        float3 e = box.isEmpty() ? float3(0.f) : box.extent();
+        centerX[i] = c.x;
+        centerY[i] = c.y;
+        centerZ[i] = c.z;
+        extentX[i] = e.x;
+        extentY[i] = e.y;
+        extentZ[i] = e.z;
+    }
+
+    inline AABB get(size_t i) const noexcept {
+        if (centerX[i] != centerX[i]) {
+            return AABB();
+        }
+        float3 c(centerX[i], centerY[i], centerZ[i]);
+        float3 e(extentX[i], extentY[i], extentZ[i]);
+        return AABB(c - e, c + e);
+    }
+};
+
+}  // namespace math
+
+#endif  // TNT_MATH_AABB_H
@@ -112,6 +112,16 @@
 
 #endif // _MSC_VER
 
+// float4 / mat4f specializations written with SSE intrinsics, see sse.h
+#if defined(SOFTGL_SIMD_OPT) && (defined(__SSE4_1__) || defined(__AVX__))
+#   define MATH_SSE 1
+#endif
+
+// 8-wide batch types of simd.h on AVX2, plain arrays otherwise
+#if defined(SOFTGL_SIMD_OPT) && defined(__AVX2__)
+#   define MATH_AVX2 1
+#endif
+
 namespace math {
 
 // MSVC 2019 16.4 doesn't seem to like it when we specialize std::is_arithmetic for
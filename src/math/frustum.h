@@ -0,0 +1,161 @@
+#ifndef TNT_MATH_FRUSTUM_H
+#define TNT_MATH_FRUSTUM_H
+
+#include <math/aabb.h>
+#include <math/compiler.h>
+#include <math/mat4.h>
+#include <math/simd.h>
+#include <math/vec3.h>
+#include <math/vec4.h>
+
+#include <cmath>
+#include <stdint.h>
+
+namespace math {
+
+/**
+ * The 6 planes of a view frustum, extracted from the clip volume -w <= x, y, z <= w of an
+ * OpenGL style projection * view matrix. A plane (a, b, c, d) keeps the points p with
+ * dot(p, (a, b, c)) + d >= 0, the planes are not normalized since the tests only use signs.
+ *
+ * Box tests compare the distance of the center against the extent projected on the plane
+ * normal, a box is culled when it is entirely behind one plane. Boxes crossing two planes
+ * outside of a corner are kept, which is conservative.
+ */
+struct Frustum {
+    // NEAR / FAR are macros on windows
+    enum {
+        PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT
+    };
+
+    float4 planes[PLANE_COUNT];
+
+    Frustum() = default;
+
+    explicit Frustum(const mat4f& viewProjection) {
+        const mat4f& m = viewProjection;
+        float4 r0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        float4 r1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        float4 r2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        float4 r3(m[0][3], m[1][3], m[2][3], m[3][3]);
+        planes[PLANE_LEFT] = r3 + r0;
+        planes[PLANE_RIGHT] = r3 - r0;
+        planes[PLANE_BOTTOM] = r3 + r1;
+        planes[PLANE_TOP] = r3 - r1;
+        planes[PLANE_NEAR] = r3 + r2;
+        planes[PLANE_FAR] = r3 - r2;
+    }
+
+    inline bool intersects(const float3& center, const float3& extent) const {
+        for (const float4& p : planes) {
+            float d = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+            float r = std::abs(p.x) * extent.x + std::abs(p.y) * extent.y + std::abs(p.z) * extent.z;
+            if (!(d + r >= 0.f)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    inline bool intersects(const AABB& box) const {
+        return !box.isEmpty() && intersects(box.center(), box.extent());
+    }
+
+    // scale the planes to unit normals, required by the sphere test
+    inline void normalizePlanes() {
+        for (float4& p : planes) {
+            float len = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+            if (len > 0.f) {
+                p /= len;
+            }
+        }
+    }
+
+    // planes must be normalized
+    inline bool intersectsSphere(const float3& center, float radius) const {
+        for (const float4& p : planes) {
+            float d = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+            if (!(d + radius >= 0.f)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    enum Containment {
+        OUTSIDE, INTERSECTING, INSIDE
+    };
+
+    // INSIDE when the box is in front of every plane, for hierarchical culling
+    inline Containment classify(const float3& center, const float3& extent) const {
+        Containment ret = INSIDE;
+        for (const float4& p : planes) {
+            float d = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+            float r = std::abs(p.x) * extent.x + std::abs(p.y) * extent.y + std::abs(p.z) * extent.z;
+            if (!(d + r >= 0.f)) {
+                return OUTSIDE;
+            }
+            if (d - r < 0.f) {
+                ret = INTERSECTING;
+            }
+        }
+        return ret;
+    }
+};
+
+namespace details {
+namespace batch {
+
+// begin and end are multiples of 8, one mask byte per 8 boxes
+inline void cullAABBs(const Frustum& frustum, const AABBArray& boxes, uint8_t* visibleMasks,
+        size_t begin, size_t end) {
+    using simd::float8;
+    using simd::mask8;
+
+    // planes and their absolute normals splat across the lanes
+    constexpr size_t N = Frustum::PLANE_COUNT;
+    float8 px[N], py[N], pz[N], pw[N];
+    float8 ax[N], ay[N], az[N];
+    for (size_t k = 0; k < N; k++) {
+        const float4& p = frustum.planes[k];
+        px[k] = float8(p.x);
+        py[k] = float8(p.y);
+        pz[k] = float8(p.z);
+        pw[k] = float8(p.w);
+        ax[k] = float8(std::abs(p.x));
+        ay[k] = float8(std::abs(p.y));
+        az[k] = float8(std::abs(p.z));
+    }
+
+    const float8 zero(0.f);
+    for (size_t i = begin; i < end; i += simd::WIDTH) {
+        float8 cx = float8::load(&boxes.centerX[i]);
+        float8 cy = float8::load(&boxes.centerY[i]);
+        float8 cz = float8::load(&boxes.centerZ[i]);
+        float8 ex = float8::load(&boxes.extentX[i]);
+        float8 ey = float8::load(&boxes.extentY[i]);
+        float8 ez = float8::load(&boxes.extentZ[i]);
+
+        // false for NaN centers, so empty boxes are never visible
+        mask8 visible(true);
+        for (size_t k = 0; k < N; k++) {
+            float8 d = fma(px[k], cx, fma(py[k], cy, fma(pz[k], cz, pw[k])));
+            float8 r = fma(ax[k], ex, fma(ay[k], ey, az[k] * ez));
+            visible = visible & (d + r >= zero);
+        }
+        visibleMasks[i / simd::WIDTH] = (uint8_t) visible.bits();
+    }
+}
+
+}  // namespace batch
+}  // namespace details
+
+// bit i % 8 of visibleMasks[i / 8] is set when box i intersects the frustum,
+// visibleMasks holds boxes.paddedSize() / 8 bytes
+inline void cullAABBs(const Frustum& frustum, const AABBArray& boxes, uint8_t* visibleMasks) {
+    details::batch::cullAABBs(frustum, boxes, visibleMasks, 0, boxes.paddedSize());
+}
+
+}  // namespace math
+
+#endif  // TNT_MATH_FRUSTUM_H
@@ -22,6 +22,7 @@
 #include <math/mat3.h>
 #include <math/quat.h>
 #include <math/scalar.h>
+#include <math/sse.h>
 #include <math/vec3.h>
 #include <math/vec4.h>
 
@@ -545,6 +546,39 @@ constexpr typename TMat44<T>::col_type MATH_PURE operator*(const TMat44<T>& lhs,
     return lhs * TVec4<U>{ rhs, 1 };
 }
 
+#ifdef MATH_SSE
+// ----------------------------------------------------------------------------------------
+// float specializations, picked by every mat4f call site instead of the generic helpers.
+// transpose() is left generic, the compiler already turns it into shuffles
+// ----------------------------------------------------------------------------------------
+
+// mat4f * float4, preferred over the TMatProductOperators template
+inline TVec4<float> MATH_PURE operator*(const TMat44<float>& lhs, const TVec4<float>& rhs) noexcept {
+    TVec4<float> result;
+    _mm_storeu_ps(&result[0], sse::mulMat4Vec4(&lhs[0][0], _mm_loadu_ps(&rhs[0])));
+    return result;
+}
+
+namespace matrix {
+
+template<>
+inline TMat44<float> MATH_PURE multiply<TMat44<float>, TMat44<float>, TMat44<float>, int>(
+        TMat44<float> lhs, TMat44<float> rhs) {
+    TMat44<float> res(TMat44<float>::NO_INIT);
+    sse::mulMat4Mat4(&lhs[0][0], &rhs[0][0], &res[0][0]);
+    return res;
+}
+
+template<>
+inline TMat44<float> MATH_PURE inverse<TMat44<float>, int>(const TMat44<float>& matrix) {
+    TMat44<float> inverted(TMat44<float>::NO_INIT);
+    sse::inverse4(&matrix[0][0], &inverted[0][0]);
+    return inverted;
+}
+
+} // namespace matrix
+#endif // MATH_SSE
+
 } // namespace details
 
 // ----------------------------------------------------------------------------------------
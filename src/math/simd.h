@@ -0,0 +1,862 @@
+#ifndef TNT_MATH_SIMD_H
+#define TNT_MATH_SIMD_H
+
+#include <math/compiler.h>
+#include <math/mat4.h>
+#include <math/sse.h>
+#include <math/vec3.h>
+#include <math/vec4.h>
+
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef MATH_AVX2
+#include <immintrin.h>
+#endif
+
+namespace math {
+namespace simd {
+
+/*
+ * 8-wide batch types for data parallel shading and rasterization: one float8 holds the same
+ * attribute of 8 fragments or vertices, float3x8 / float4x8 hold vectors in SoA layout
+ * (x of the 8 lanes, then y, ...). Operators follow TVec*, comparisons return a mask8 that
+ * selects lanes with select().
+ *
+ * With MATH_AVX2 the types wrap __m256 / __m256i, otherwise they are arrays of 8 lanes and
+ * every operation is a loop the compiler may still vectorize.
+ */
+
+constexpr size_t WIDTH = 8;
+
+class float8;
+class int8;
+
+class mask8 {
+public:
+    mask8() = default;
+
+    explicit mask8(bool b) {
+#ifdef MATH_AVX2
+        v = _mm256_castsi256_ps(_mm256_set1_epi32(b ? -1 : 0));
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            v[i] = b ? -1 : 0;
+        }
+#endif
+    }
+
+    // bit i set when lane i is true
+    inline uint32_t bits() const {
+#ifdef MATH_AVX2
+        return (uint32_t)_mm256_movemask_ps(v);
+#else
+        uint32_t r = 0;
+        for (size_t i = 0; i < WIDTH; i++) {
+            r |= (v[i] ? 1u : 0u) << i;
+        }
+        return r;
+#endif
+    }
+
+    inline bool operator[](size_t i) const {
+        return (bits() >> i) & 1u;
+    }
+
+    friend inline mask8 operator&(const mask8& a, const mask8& b) {
+        mask8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_and_ps(a.v, b.v);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = a.v[i] & b.v[i];
+        }
+#endif
+        return r;
+    }
+
+    friend inline mask8 operator|(const mask8& a, const mask8& b) {
+        mask8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_or_ps(a.v, b.v);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = a.v[i] | b.v[i];
+        }
+#endif
+        return r;
+    }
+
+    friend inline mask8 operator^(const mask8& a, const mask8& b) {
+        mask8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_xor_ps(a.v, b.v);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = a.v[i] ^ b.v[i];
+        }
+#endif
+        return r;
+    }
+
+    friend inline mask8 operator~(const mask8& a) {
+        return a ^ mask8(true);
+    }
+
+    friend inline mask8 andNot(const mask8& a, const mask8& b) {
+        return a & ~b;
+    }
+
+    friend inline bool any(const mask8& m) {
+        return m.bits() != 0;
+    }
+
+    friend inline bool all(const mask8& m) {
+        return m.bits() == 0xFFu;
+    }
+
+    friend inline bool none(const mask8& m) {
+        return m.bits() == 0;
+    }
+
+    // the raw lanes, all ones or all zeros, for code that needs intrinsics directly
+#ifdef MATH_AVX2
+    __m256 v;
+#else
+    int32_t v[WIDTH];
+#endif
+};
+
+class float8 {
+public:
+    float8() = default;
+
+    // broadcast, implicit so that scalars mix with batches like they do with TVec*
+    float8(float s) {
+#ifdef MATH_AVX2
+        v = _mm256_set1_ps(s);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            v[i] = s;
+        }
+#endif
+    }
+
+    float8(float a0, float a1, float a2, float a3, float a4, float a5, float a6, float a7) {
+#ifdef MATH_AVX2
+        v = _mm256_setr_ps(a0, a1, a2, a3, a4, a5, a6, a7);
+#else
+        v[0] = a0; v[1] = a1; v[2] = a2; v[3] = a3;
+        v[4] = a4; v[5] = a5; v[6] = a6; v[7] = a7;
+#endif
+    }
+
+    // (start, start + step, ... start + 7 * step), e.g. the x of 8 pixels of a span
+    static inline float8 ramp(float start, float step) {
+        return float8(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f) * step + start;
+    }
+
+    static inline float8 load(const float* p) {
+        float8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_loadu_ps(p);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = p[i];
+        }
+#endif
+        return r;
+    }
+
+    inline void store(float* p) const {
+#ifdef MATH_AVX2
+        _mm256_storeu_ps(p, v);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            p[i] = v[i];
+        }
+#endif
+    }
+
+    // only lanes set in m are written
+    inline void store(float* p, const mask8& m) const {
+#ifdef MATH_AVX2
+        _mm256_maskstore_ps(p, _mm256_castps_si256(m.v), v);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            if (m.v[i]) {
+                p[i] = v[i];
+            }
+        }
+#endif
+    }
+
+    inline float operator[](size_t i) const {
+#ifdef MATH_AVX2
+        alignas(32) float lanes[WIDTH];
+        _mm256_store_ps(lanes, v);
+        return lanes[i];
+#else
+        return v[i];
+#endif
+    }
+
+    // lane-wise float to int, truncated toward zero
+    inline int8 toInt() const;
+
+    // lane-wise float to int, rounded to nearest
+    inline int8 roundToInt() const;
+
+#ifdef MATH_AVX2
+#define MATH_SIMD_FLOAT8_OP(OP, INTRINSIC)                                      \
+    friend inline float8 operator OP(const float8& a, const float8& b) {       \
+        float8 r;                                                               \
+        r.v = INTRINSIC(a.v, b.v);                                              \
+        return r;                                                               \
+    }
+#define MATH_SIMD_FLOAT8_CMP(OP, PREDICATE)                                     \
+    friend inline mask8 operator OP(const float8& a, const float8& b) {        \
+        mask8 r;                                                                \
+        r.v = _mm256_cmp_ps(a.v, b.v, PREDICATE);                               \
+        return r;                                                               \
+    }
+    MATH_SIMD_FLOAT8_OP(+, _mm256_add_ps)
+    MATH_SIMD_FLOAT8_OP(-, _mm256_sub_ps)
+    MATH_SIMD_FLOAT8_OP(*, _mm256_mul_ps)
+    MATH_SIMD_FLOAT8_OP(/, _mm256_div_ps)
+    MATH_SIMD_FLOAT8_CMP(<, _CMP_LT_OQ)
+    MATH_SIMD_FLOAT8_CMP(<=, _CMP_LE_OQ)
+    MATH_SIMD_FLOAT8_CMP(>, _CMP_GT_OQ)
+    MATH_SIMD_FLOAT8_CMP(>=, _CMP_GE_OQ)
+    MATH_SIMD_FLOAT8_CMP(==, _CMP_EQ_OQ)
+    MATH_SIMD_FLOAT8_CMP(!=, _CMP_NEQ_UQ)
+#else
+#define MATH_SIMD_FLOAT8_OP(OP, INTRINSIC)                                      \
+    friend inline float8 operator OP(const float8& a, const float8& b) {       \
+        float8 r;                                                               \
+        for (size_t i = 0; i < WIDTH; i++) {                                    \
+            r.v[i] = a.v[i] OP b.v[i];                                          \
+        }                                                                       \
+        return r;                                                               \
+    }
+#define MATH_SIMD_FLOAT8_CMP(OP, PREDICATE)                                     \
+    friend inline mask8 operator OP(const float8& a, const float8& b) {        \
+        mask8 r;                                                                \
+        for (size_t i = 0; i < WIDTH; i++) {                                    \
+            r.v[i] = a.v[i] OP b.v[i] ? -1 : 0;                                 \
+        }                                                                       \
+        return r;                                                               \
+    }
+    MATH_SIMD_FLOAT8_OP(+, _)
+    MATH_SIMD_FLOAT8_OP(-, _)
+    MATH_SIMD_FLOAT8_OP(*, _)
+    MATH_SIMD_FLOAT8_OP(/, _)
+    MATH_SIMD_FLOAT8_CMP(<, _)
+    MATH_SIMD_FLOAT8_CMP(<=, _)
+    MATH_SIMD_FLOAT8_CMP(>, _)
+    MATH_SIMD_FLOAT8_CMP(>=, _)
+    MATH_SIMD_FLOAT8_CMP(==, _)
+    MATH_SIMD_FLOAT8_CMP(!=, _)
+#endif
+#undef MATH_SIMD_FLOAT8_OP
+#undef MATH_SIMD_FLOAT8_CMP
+
+    friend inline float8 operator-(const float8& a) {
+        return float8(-0.f) ^ a;
+    }
+
+    inline float8& operator+=(const float8& b) { return *this = *this + b; }
+    inline float8& operator-=(const float8& b) { return *this = *this - b; }
+    inline float8& operator*=(const float8& b) { return *this = *this * b; }
+    inline float8& operator/=(const float8& b) { return *this = *this / b; }
+
+    // a * b + c, fused when the target has fma
+    friend inline float8 fma(const float8& a, const float8& b, const float8& c) {
+#ifdef MATH_AVX2
+        float8 r;
+#ifdef __FMA__
+        r.v = _mm256_fmadd_ps(a.v, b.v, c.v);
+#else
+        r.v = _mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v);
+#endif
+        return r;
+#else
+        return a * b + c;
+#endif
+    }
+
+    friend inline float8 min(const float8& a, const float8& b) {
+#ifdef MATH_AVX2
+        float8 r;
+        r.v = _mm256_min_ps(a.v, b.v);
+        return r;
+#else
+        return select(b < a, b, a);
+#endif
+    }
+
+    friend inline float8 max(const float8& a, const float8& b) {
+#ifdef MATH_AVX2
+        float8 r;
+        r.v = _mm256_max_ps(a.v, b.v);
+        return r;
+#else
+        return select(b > a, b, a);
+#endif
+    }
+
+    friend inline float8 abs(const float8& a) {
+        return andNot(float8(-0.f), a);
+    }
+
+    friend inline float8 sqrt(const float8& a) {
+        float8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_sqrt_ps(a.v);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = std::sqrt(a.v[i]);
+        }
+#endif
+        return r;
+    }
+
+    friend inline float8 floor(const float8& a) {
+        float8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_floor_ps(a.v);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = std::floor(a.v[i]);
+        }
+#endif
+        return r;
+    }
+
+    friend inline float8 ceil(const float8& a) {
+        float8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_ceil_ps(a.v);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = std::ceil(a.v[i]);
+        }
+#endif
+        return r;
+    }
+
+    // lanes of a where m is set, lanes of b elsewhere
+    friend inline float8 select(const mask8& m, const float8& a, const float8& b) {
+        float8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_blendv_ps(b.v, a.v, m.v);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = m.v[i] ? a.v[i] : b.v[i];
+        }
+#endif
+        return r;
+    }
+
+    friend inline float hsum(const float8& a) {
+#ifdef MATH_AVX2
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+        return _mm_cvtss_f32(s);
+#else
+        float r = 0;
+        for (size_t i = 0; i < WIDTH; i++) {
+            r += a.v[i];
+        }
+        return r;
+#endif
+    }
+
+    // bitwise, for sign manipulation
+    friend inline float8 operator^(const float8& a, const float8& b) {
+        float8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_xor_ps(a.v, b.v);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = bitCast(bitCast(a.v[i]) ^ bitCast(b.v[i]));
+        }
+#endif
+        return r;
+    }
+
+    // ~a & b
+    friend inline float8 andNot(const float8& a, const float8& b) {
+        float8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_andnot_ps(a.v, b.v);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = bitCast(~bitCast(a.v[i]) & bitCast(b.v[i]));
+        }
+#endif
+        return r;
+    }
+
+#ifndef MATH_AVX2
+private:
+    static inline uint32_t bitCast(float f) {
+        uint32_t u;
+        memcpy(&u, &f, sizeof(u));
+        return u;
+    }
+
+    static inline float bitCast(uint32_t u) {
+        float f;
+        memcpy(&f, &u, sizeof(f));
+        return f;
+    }
+
+public:
+#endif
+
+    // the raw lanes, for code that needs intrinsics directly
+#ifdef MATH_AVX2
+    __m256 v;
+#else
+    float v[WIDTH];
+#endif
+};
+
+class int8 {
+public:
+    int8() = default;
+
+    int8(int32_t s) {
+#ifdef MATH_AVX2
+        v = _mm256_set1_epi32(s);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            v[i] = s;
+        }
+#endif
+    }
+
+    int8(int32_t a0, int32_t a1, int32_t a2, int32_t a3, int32_t a4, int32_t a5, int32_t a6, int32_t a7) {
+#ifdef MATH_AVX2
+        v = _mm256_setr_epi32(a0, a1, a2, a3, a4, a5, a6, a7);
+#else
+        v[0] = a0; v[1] = a1; v[2] = a2; v[3] = a3;
+        v[4] = a4; v[5] = a5; v[6] = a6; v[7] = a7;
+#endif
+    }
+
+    static inline int8 load(const int32_t* p) {
+        int8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_loadu_si256((const __m256i*)p);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = p[i];
+        }
+#endif
+        return r;
+    }
+
+    inline void store(int32_t* p) const {
+#ifdef MATH_AVX2
+        _mm256_storeu_si256((__m256i*)p, v);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            p[i] = v[i];
+        }
+#endif
+    }
+
+    inline int32_t operator[](size_t i) const {
+#ifdef MATH_AVX2
+        alignas(32) int32_t lanes[WIDTH];
+        _mm256_store_si256((__m256i*)lanes, v);
+        return lanes[i];
+#else
+        return v[i];
+#endif
+    }
+
+    inline float8 toFloat() const {
+        float8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_cvtepi32_ps(v);
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = (float)v[i];
+        }
+#endif
+        return r;
+    }
+
+#ifdef MATH_AVX2
+#define MATH_SIMD_INT8_OP(OP, INTRINSIC)                                        \
+    friend inline int8 operator OP(const int8& a, const int8& b) {             \
+        int8 r;                                                                 \
+        r.v = INTRINSIC(a.v, b.v);                                              \
+        return r;                                                               \
+    }
+    MATH_SIMD_INT8_OP(+, _mm256_add_epi32)
+    MATH_SIMD_INT8_OP(-, _mm256_sub_epi32)
+    MATH_SIMD_INT8_OP(*, _mm256_mullo_epi32)
+    MATH_SIMD_INT8_OP(&, _mm256_and_si256)
+    MATH_SIMD_INT8_OP(|, _mm256_or_si256)
+    MATH_SIMD_INT8_OP(^, _mm256_xor_si256)
+#else
+#define MATH_SIMD_INT8_OP(OP, INTRINSIC)                                        \
+    friend inline int8 operator OP(const int8& a, const int8& b) {             \
+        int8 r;                                                                 \
+        for (size_t i = 0; i < WIDTH; i++) {                                    \
+            r.v[i] = (int32_t)((uint32_t)a.v[i] OP (uint32_t)b.v[i]);           \
+        }                                                                       \
+        return r;                                                               \
+    }
+    MATH_SIMD_INT8_OP(+, _)
+    MATH_SIMD_INT8_OP(-, _)
+    MATH_SIMD_INT8_OP(*, _)
+    MATH_SIMD_INT8_OP(&, _)
+    MATH_SIMD_INT8_OP(|, _)
+    MATH_SIMD_INT8_OP(^, _)
+#endif
+#undef MATH_SIMD_INT8_OP
+
+    inline int8& operator+=(const int8& b) { return *this = *this + b; }
+    inline int8& operator-=(const int8& b) { return *this = *this - b; }
+    inline int8& operator*=(const int8& b) { return *this = *this * b; }
+
+    friend inline int8 operator<<(const int8& a, int n) {
+        int8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_sll_epi32(a.v, _mm_cvtsi32_si128(n));
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = (int32_t)((uint32_t)a.v[i] << n);
+        }
+#endif
+        return r;
+    }
+
+    // arithmetic shift
+    friend inline int8 operator>>(const int8& a, int n) {
+        int8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_sra_epi32(a.v, _mm_cvtsi32_si128(n));
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = a.v[i] >> n;
+        }
+#endif
+        return r;
+    }
+
+    friend inline mask8 operator==(const int8& a, const int8& b) {
+        mask8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_castsi256_ps(_mm256_cmpeq_epi32(a.v, b.v));
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = a.v[i] == b.v[i] ? -1 : 0;
+        }
+#endif
+        return r;
+    }
+
+    friend inline mask8 operator>(const int8& a, const int8& b) {
+        mask8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_castsi256_ps(_mm256_cmpgt_epi32(a.v, b.v));
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = a.v[i] > b.v[i] ? -1 : 0;
+        }
+#endif
+        return r;
+    }
+
+    friend inline mask8 operator!=(const int8& a, const int8& b) { return ~(a == b); }
+    friend inline mask8 operator<(const int8& a, const int8& b) { return b > a; }
+    friend inline mask8 operator>=(const int8& a, const int8& b) { return ~(b > a); }
+    friend inline mask8 operator<=(const int8& a, const int8& b) { return ~(a > b); }
+
+    friend inline int8 min(const int8& a, const int8& b) {
+#ifdef MATH_AVX2
+        int8 r;
+        r.v = _mm256_min_epi32(a.v, b.v);
+        return r;
+#else
+        return select(b < a, b, a);
+#endif
+    }
+
+    friend inline int8 max(const int8& a, const int8& b) {
+#ifdef MATH_AVX2
+        int8 r;
+        r.v = _mm256_max_epi32(a.v, b.v);
+        return r;
+#else
+        return select(b > a, b, a);
+#endif
+    }
+
+    friend inline int8 select(const mask8& m, const int8& a, const int8& b) {
+        int8 r;
+#ifdef MATH_AVX2
+        r.v = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b.v), _mm256_castsi256_ps(a.v), m.v));
+#else
+        for (size_t i = 0; i < WIDTH; i++) {
+            r.v[i] = m.v[i] ? a.v[i] : b.v[i];
+        }
+#endif
+        return r;
+    }
+
+    // the raw lanes, for code that needs intrinsics directly
+#ifdef MATH_AVX2
+    __m256i v;
+#else
+    int32_t v[WIDTH];
+#endif
+};
+
+inline int8 float8::toInt() const {
+    int8 r;
+#ifdef MATH_AVX2
+    r.v = _mm256_cvttps_epi32(v);
+#else
+    for (size_t i = 0; i < WIDTH; i++) {
+        r.v[i] = (int32_t)v[i];
+    }
+#endif
+    return r;
+}
+
+inline int8 float8::roundToInt() const {
+#ifdef MATH_AVX2
+    int8 r;
+    r.v = _mm256_cvtps_epi32(v);
+    return r;
+#else
+    int8 r;
+    for (size_t i = 0; i < WIDTH; i++) {
+        r.v[i] = (int32_t)std::nearbyint(v[i]);
+    }
+    return r;
+#endif
+}
+
+// ----------------------------------------------------------------------------------------
+// SoA vectors, written once on top of float8
+// ----------------------------------------------------------------------------------------
+
+class float3x8 {
+public:
+    float8 x, y, z;
+
+    float3x8() = default;
+    float3x8(const float8& x, const float8& y, const float8& z) : x(x), y(y), z(z) {}
+
+    // broadcast
+    float3x8(const float3& v) : x(v.x), y(v.y), z(v.z) {}
+
+    // 8 consecutive float3 (AoS) to SoA
+    static inline float3x8 load(const float3* p) {
+        alignas(32) float lanes[3][WIDTH];
+        for (size_t i = 0; i < WIDTH; i++) {
+            lanes[0][i] = p[i].x;
+            lanes[1][i] = p[i].y;
+            lanes[2][i] = p[i].z;
+        }
+        return {float8::load(lanes[0]), float8::load(lanes[1]), float8::load(lanes[2])};
+    }
+
+    inline void store(float3* p) const {
+        alignas(32) float lanes[3][WIDTH];
+        x.store(lanes[0]);
+        y.store(lanes[1]);
+        z.store(lanes[2]);
+        for (size_t i = 0; i < WIDTH; i++) {
+            p[i] = {lanes[0][i], lanes[1][i], lanes[2][i]};
+        }
+    }
+
+    inline float3 lane(size_t i) const {
+        return {x[i], y[i], z[i]};
+    }
+
+    friend inline float3x8 operator+(const float3x8& a, const float3x8& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+    friend inline float3x8 operator-(const float3x8& a, const float3x8& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    friend inline float3x8 operator*(const float3x8& a, const float3x8& b) { return {a.x * b.x, a.y * b.y, a.z * b.z}; }
+    friend inline float3x8 operator/(const float3x8& a, const float3x8& b) { return {a.x / b.x, a.y / b.y, a.z / b.z}; }
+    friend inline float3x8 operator*(const float3x8& a, const float8& s) { return {a.x * s, a.y * s, a.z * s}; }
+    friend inline float3x8 operator*(const float8& s, const float3x8& a) { return a * s; }
+    friend inline float3x8 operator/(const float3x8& a, const float8& s) { return {a.x / s, a.y / s, a.z / s}; }
+    friend inline float3x8 operator-(const float3x8& a) { return {-a.x, -a.y, -a.z}; }
+
+    inline float3x8& operator+=(const float3x8& b) { return *this = *this + b; }
+    inline float3x8& operator-=(const float3x8& b) { return *this = *this - b; }
+    inline float3x8& operator*=(const float8& s) { return *this = *this * s; }
+
+    friend inline float8 dot(const float3x8& a, const float3x8& b) {
+        return fma(a.z, b.z, fma(a.y, b.y, a.x * b.x));
+    }
+
+    friend inline float3x8 cross(const float3x8& u, const float3x8& v) {
+        return {u.y * v.z - u.z * v.y,
+                u.z * v.x - u.x * v.z,
+                u.x * v.y - u.y * v.x};
+    }
+
+    friend inline float8 length(const float3x8& a) {
+        return sqrt(dot(a, a));
+    }
+
+    friend inline float3x8 normalize(const float3x8& a) {
+        return a * (float8(1.f) / length(a));
+    }
+
+    friend inline float3x8 min(const float3x8& a, const float3x8& b) { return {min(a.x, b.x), min(a.y, b.y), min(a.z, b.z)}; }
+    friend inline float3x8 max(const float3x8& a, const float3x8& b) { return {max(a.x, b.x), max(a.y, b.y), max(a.z, b.z)}; }
+
+    friend inline float3x8 clamp(const float3x8& v, const float8& lo, const float8& hi) {
+        return {min(hi, max(lo, v.x)), min(hi, max(lo, v.y)), min(hi, max(lo, v.z))};
+    }
+
+    friend inline float3x8 mix(const float3x8& u, const float3x8& v, const float8& a) {
+        return u * (float8(1.f) - a) + v * a;
+    }
+
+    friend inline float3x8 select(const mask8& m, const float3x8& a, const float3x8& b) {
+        return {select(m, a.x, b.x), select(m, a.y, b.y), select(m, a.z, b.z)};
+    }
+};
+
+class float4x8 {
+public:
+    float8 x, y, z, w;
+
+    float4x8() = default;
+    float4x8(const float8& x, const float8& y, const float8& z, const float8& w) : x(x), y(y), z(z), w(w) {}
+    float4x8(const float3x8& v, const float8& w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+    // broadcast
+    float4x8(const float4& v) : x(v.x), y(v.y), z(v.z), w(v.w) {}
+
+    // 8 consecutive float4 (AoS) to SoA
+    static inline float4x8 load(const float4* p) {
+        alignas(32) float lanes[4][WIDTH];
+        for (size_t i = 0; i < WIDTH; i++) {
+            for (size_t k = 0; k < 4; k++) {
+                lanes[k][i] = p[i][k];
+            }
+        }
+        return {float8::load(lanes[0]), float8::load(lanes[1]), float8::load(lanes[2]), float8::load(lanes[3])};
+    }
+
+    inline void store(float4* p) const {
+        alignas(32) float lanes[4][WIDTH];
+        x.store(lanes[0]);
+        y.store(lanes[1]);
+        z.store(lanes[2]);
+        w.store(lanes[3]);
+        for (size_t i = 0; i < WIDTH; i++) {
+            p[i] = {lanes[0][i], lanes[1][i], lanes[2][i], lanes[3][i]};
+        }
+    }
+
+    inline float4 lane(size_t i) const {
+        return {x[i], y[i], z[i], w[i]};
+    }
+
+    inline float3x8 xyz() const {
+        return {x, y, z};
+    }
+
+    friend inline float4x8 operator+(const float4x8& a, const float4x8& b) { return {a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w}; }
+    friend inline float4x8 operator-(const float4x8& a, const float4x8& b) { return {a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w}; }
+    friend inline float4x8 operator*(const float4x8& a, const float4x8& b) { return {a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w}; }
+    friend inline float4x8 operator/(const float4x8& a, const float4x8& b) { return {a.x / b.x, a.y / b.y, a.z / b.z, a.w / b.w}; }
+    friend inline float4x8 operator*(const float4x8& a, const float8& s) { return {a.x * s, a.y * s, a.z * s, a.w * s}; }
+    friend inline float4x8 operator*(const float8& s, const float4x8& a) { return a * s; }
+    friend inline float4x8 operator/(const float4x8& a, const float8& s) { return {a.x / s, a.y / s, a.z / s, a.w / s}; }
+    friend inline float4x8 operator-(const float4x8& a) { return {-a.x, -a.y, -a.z, -a.w}; }
+
+    inline float4x8& operator+=(const float4x8& b) { return *this = *this + b; }
+    inline float4x8& operator-=(const float4x8& b) { return *this = *this - b; }
+    inline float4x8& operator*=(const float8& s) { return *this = *this * s; }
+
+    friend inline float8 dot(const float4x8& a, const float4x8& b) {
+        return fma(a.w, b.w, fma(a.z, b.z, fma(a.y, b.y, a.x * b.x)));
+    }
+
+    friend inline float8 length(const float4x8& a) {
+        return sqrt(dot(a, a));
+    }
+
+    friend inline float4x8 normalize(const float4x8& a) {
+        return a * (float8(1.f) / length(a));
+    }
+
+    friend inline float4x8 min(const float4x8& a, const float4x8& b) {
+        return {min(a.x, b.x), min(a.y, b.y), min(a.z, b.z), min(a.w, b.w)};
+    }
+
+    friend inline float4x8 max(const float4x8& a, const float4x8& b) {
+        return {max(a.x, b.x), max(a.y, b.y), max(a.z, b.z), max(a.w, b.w)};
+    }
+
+    friend inline float4x8 clamp(const float4x8& v, const float8& lo, const float8& hi) {
+        return {min(hi, max(lo, v.x)), min(hi, max(lo, v.y)), min(hi, max(lo, v.z)), min(hi, max(lo, v.w))};
+    }
+
+    friend inline float4x8 mix(const float4x8& u, const float4x8& v, const float8& a) {
+        return u * (float8(1.f) - a) + v * a;
+    }
+
+    friend inline float4x8 select(const mask8& m, const float4x8& a, const float4x8& b) {
+        return {select(m, a.x, b.x), select(m, a.y, b.y), select(m, a.z, b.z), select(m, a.w, b.w)};
+    }
+};
+
+inline float8 clamp(const float8& v, const float8& lo, const float8& hi) {
+    return min(hi, max(lo, v));
+}
+
+inline float8 saturate(const float8& v) {
+    return clamp(v, float8(0.f), float8(1.f));
+}
+
+inline float8 mix(const float8& x, const float8& y, const float8& a) {
+    return x * (float8(1.f) - a) + y * a;
+}
+
+// m * v of 8 vectors, same column order as mat4f * float4
+inline float4x8 transform(const mat4f& m, const float4x8& v) {
+    auto row = [&](size_t k) {
+        return fma(float8(m[3][k]), v.w, fma(float8(m[2][k]), v.z, fma(float8(m[1][k]), v.y, float8(m[0][k]) * v.x)));
+    };
+    return {row(0), row(1), row(2), row(3)};
+}
+
+// m * {v, 1}
+inline float4x8 transform(const mat4f& m, const float3x8& v) {
+    auto row = [&](size_t k) {
+        return fma(float8(m[2][k]), v.z, fma(float8(m[1][k]), v.y, fma(float8(m[0][k]), v.x, float8(m[3][k]))));
+    };
+    return {row(0), row(1), row(2), row(3)};
+}
+
+// upper 3x3 of m * v, for directions and normals (use the inverse transpose for non-uniform scales)
+inline float3x8 transformVector(const mat4f& m, const float3x8& v) {
+    return {fma(float8(m[2][0]), v.z, fma(float8(m[1][0]), v.y, float8(m[0][0]) * v.x)),
+            fma(float8(m[2][1]), v.z, fma(float8(m[1][1]), v.y, float8(m[0][1]) * v.x)),
+            fma(float8(m[2][2]), v.z, fma(float8(m[1][2]), v.y, float8(m[0][2]) * v.x))};
+}
+
+}  // namespace simd
+}  // namespace math
+
+#endif  // TNT_MATH_SIMD_H
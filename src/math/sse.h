@@ -0,0 +1,157 @@
+#ifndef TNT_MATH_SSE_H
+#define TNT_MATH_SSE_H
+
+#include <math/compiler.h>
+
+#ifdef MATH_SSE
+
+#include <immintrin.h>
+
+namespace math {
+namespace details {
+namespace sse {
+
+/*
+ * Kernels behind the float specializations of vec4.h and mat4.h.
+ * Matrices are 16 floats, column-major like TMat44, loads and stores are unaligned.
+ * Results match the generic code within a few ULPs (fma contraction and summation
+ * order differ), inverse4() uses a different algorithm and has its own rounding.
+ */
+
+// a * b + c
+inline __m128 madd(__m128 a, __m128 b, __m128 c) {
+#ifdef __FMA__
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+template<int I>
+inline __m128 splat(__m128 v) {
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(I, I, I, I));
+}
+
+inline float dot4(__m128 a, __m128 b) {
+    __m128 p = _mm_mul_ps(a, b);
+    __m128 s = _mm_add_ps(p, _mm_movehl_ps(p, p));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(s);
+}
+
+// m * v, the columns weighted by the components of v
+inline __m128 mulMat4Vec4(const float* m, __m128 v) {
+    __m128 r = _mm_mul_ps(_mm_loadu_ps(m), splat<0>(v));
+    r = madd(_mm_loadu_ps(m + 4), splat<1>(v), r);
+    r = madd(_mm_loadu_ps(m + 8), splat<2>(v), r);
+    r = madd(_mm_loadu_ps(m + 12), splat<3>(v), r);
+    return r;
+}
+
+// out = a * b, out may alias a or b
+inline void mulMat4Mat4(const float* a, const float* b, float* out) {
+    __m128 a0 = _mm_loadu_ps(a);
+    __m128 a1 = _mm_loadu_ps(a + 4);
+    __m128 a2 = _mm_loadu_ps(a + 8);
+    __m128 a3 = _mm_loadu_ps(a + 12);
+    __m128 r[4];
+    for (int c = 0; c < 4; c++) {
+        __m128 v = _mm_loadu_ps(b + c * 4);
+        __m128 col = _mm_mul_ps(a0, splat<0>(v));
+        col = madd(a1, splat<1>(v), col);
+        col = madd(a2, splat<2>(v), col);
+        col = madd(a3, splat<3>(v), col);
+        r[c] = col;
+    }
+    for (int c = 0; c < 4; c++) {
+        _mm_storeu_ps(out + c * 4, r[c]);
+    }
+}
+
+// 2x2 matrices packed in one register as (m00, m01, m10, m11), the inverse below works
+// on the transpose of the 4x4 matrix, which is fine since inverse(transpose(M)) == transpose(inverse(M))
+
+// a * b
+inline __m128 mat2Mul(__m128 a, __m128 b) {
+    return _mm_add_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+                      _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)),
+                                 _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+// adjugate(a) * b
+inline __m128 mat2AdjMul(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+                      _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)),
+                                 _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+
+// a * adjugate(b)
+inline __m128 mat2MulAdj(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+                      _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)),
+                                 _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+// block-wise inverse from the four 2x2 sub matrices and their adjugates.
+// unlike the generic Gauss-Jordan inverse there is no pivoting, the result is
+// undefined for singular matrices as well.
+inline void inverse4(const float* m, float* out) {
+    __m128 r0 = _mm_loadu_ps(m);
+    __m128 r1 = _mm_loadu_ps(m + 4);
+    __m128 r2 = _mm_loadu_ps(m + 8);
+    __m128 r3 = _mm_loadu_ps(m + 12);
+
+    // | A B |
+    // | C D |
+    __m128 A = _mm_movelh_ps(r0, r1);
+    __m128 B = _mm_movehl_ps(r1, r0);
+    __m128 C = _mm_movelh_ps(r2, r3);
+    __m128 D = _mm_movehl_ps(r3, r2);
+
+    // (|A|, |B|, |C|, |D|)
+    __m128 detSub = _mm_sub_ps(
+            _mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 0, 2, 0)),
+                       _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 1, 3, 1))),
+            _mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 1, 3, 1)),
+                       _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 0, 2, 0))));
+    __m128 detA = splat<0>(detSub);
+    __m128 detB = splat<1>(detSub);
+    __m128 detC = splat<2>(detSub);
+    __m128 detD = splat<3>(detSub);
+
+    __m128 D_C = mat2AdjMul(D, C);
+    __m128 A_B = mat2AdjMul(A, B);
+
+    // adjugates of the blocks of the inverse
+    __m128 X_ = _mm_sub_ps(_mm_mul_ps(detD, A), mat2Mul(B, D_C));
+    __m128 W_ = _mm_sub_ps(_mm_mul_ps(detA, D), mat2Mul(C, A_B));
+    __m128 Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), mat2MulAdj(D, A_B));
+    __m128 Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), mat2MulAdj(A, D_C));
+
+    // |M| = |A| |D| + |B| |C| - trace(A#B * D#C)
+    __m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+    __m128 tr = _mm_mul_ps(A_B, _mm_shuffle_ps(D_C, D_C, _MM_SHUFFLE(3, 1, 2, 0)));
+    tr = _mm_hadd_ps(tr, tr);
+    tr = _mm_hadd_ps(tr, tr);
+    detM = _mm_sub_ps(detM, tr);
+
+    __m128 rcpDetM = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), detM);
+    X_ = _mm_mul_ps(X_, rcpDetM);
+    Y_ = _mm_mul_ps(Y_, rcpDetM);
+    Z_ = _mm_mul_ps(Z_, rcpDetM);
+    W_ = _mm_mul_ps(W_, rcpDetM);
+
+    // the adjugate shuffle merged with the store
+    _mm_storeu_ps(out, _mm_shuffle_ps(X_, Y_, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(out + 4, _mm_shuffle_ps(X_, Y_, _MM_SHUFFLE(0, 2, 0, 2)));
+    _mm_storeu_ps(out + 8, _mm_shuffle_ps(Z_, W_, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(out + 12, _mm_shuffle_ps(Z_, W_, _MM_SHUFFLE(0, 2, 0, 2)));
+}
+
+}  // namespace sse
+}  // namespace details
+}  // namespace math
+
+#endif  // MATH_SSE
+
+#endif  // TNT_MATH_SSE_H
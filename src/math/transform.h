@@ -0,0 +1,207 @@
+#ifndef TNT_MATH_TRANSFORM_H
+#define TNT_MATH_TRANSFORM_H
+
+#include <math/aabb.h>
+#include <math/compiler.h>
+#include <math/mat4.h>
+#include <math/sse.h>
+#include <math/vec3.h>
+#include <math/vec4.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace math {
+
+/*
+ * Batch transforms of arrays through one mat4f, for scene traversal and CPU vertex processing.
+ * With MATH_SSE each element is a few FMAs with the matrix columns kept in registers, so the
+ * loops are limited by memory bandwidth. The range kernels in details::batch are split across
+ * a ThreadPool by base/ParallelUtils.h.
+ * in and out must not overlap, unless they are the same array of the same type.
+ */
+
+namespace details {
+namespace batch {
+
+#ifdef MATH_SSE
+// (x, y, z, 0) without reading past the float3
+inline __m128 loadFloat3(const float* p) {
+    return _mm_movelh_ps(_mm_castpd_ps(_mm_load_sd((const double*) p)), _mm_load_ss(p + 2));
+}
+
+inline void storeFloat3(float* p, __m128 v) {
+    _mm_storel_pi((__m64*) p, v);
+    _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+}
+
+struct Columns {
+    __m128 c0, c1, c2, c3;
+
+    explicit Columns(const mat4f& m)
+            : c0(_mm_loadu_ps(&m[0][0])), c1(_mm_loadu_ps(&m[1][0])),
+              c2(_mm_loadu_ps(&m[2][0])), c3(_mm_loadu_ps(&m[3][0])) {}
+
+    // m * {p, 1}
+    inline __m128 point(const float* p) const {
+        __m128 r = sse::madd(c0, _mm_set1_ps(p[0]), c3);
+        r = sse::madd(c1, _mm_set1_ps(p[1]), r);
+        return sse::madd(c2, _mm_set1_ps(p[2]), r);
+    }
+
+    // m * {v, 0}
+    inline __m128 vector(const float* v) const {
+        __m128 r = _mm_mul_ps(c0, _mm_set1_ps(v[0]));
+        r = sse::madd(c1, _mm_set1_ps(v[1]), r);
+        return sse::madd(c2, _mm_set1_ps(v[2]), r);
+    }
+};
+#endif
+
+inline void transformPoints(const mat4f& m, const float3* in, float4* out, size_t begin, size_t end) {
+#ifdef MATH_SSE
+    Columns cols(m);
+    size_t i = begin;
+#if defined(MATH_AVX2) && defined(__FMA__)
+    // two points per iteration, the columns repeated in both halves
+    const __m256 c0 = _mm256_broadcast_ps(&cols.c0);
+    const __m256 c1 = _mm256_broadcast_ps(&cols.c1);
+    const __m256 c2 = _mm256_broadcast_ps(&cols.c2);
+    const __m256 c3 = _mm256_broadcast_ps(&cols.c3);
+    const __m256i ix = _mm256_setr_epi32(0, 0, 0, 0, 3, 3, 3, 3);
+    const __m256i iy = _mm256_setr_epi32(1, 1, 1, 1, 4, 4, 4, 4);
+    const __m256i iz = _mm256_setr_epi32(2, 2, 2, 2, 5, 5, 5, 5);
+    // 8 floats are loaded for 6, stop before the last pair to stay in bounds
+    for (; i + 3 <= end; i += 2) {
+        __m256 p = _mm256_loadu_ps(&in[i][0]);
+        __m256 r = _mm256_fmadd_ps(c0, _mm256_permutevar8x32_ps(p, ix), c3);
+        r = _mm256_fmadd_ps(c1, _mm256_permutevar8x32_ps(p, iy), r);
+        r = _mm256_fmadd_ps(c2, _mm256_permutevar8x32_ps(p, iz), r);
+        _mm256_storeu_ps(&out[i][0], r);
+    }
+#endif
+    for (; i < end; i++) {
+        _mm_storeu_ps(&out[i][0], cols.point(&in[i][0]));
+    }
+#else
+    for (size_t i = begin; i < end; i++) {
+        out[i] = m * float4(in[i], 1.f);
+    }
+#endif
+}
+
+inline void transformPoints(const mat4f& m, const float3* in, float3* out, size_t begin, size_t end) {
+#ifdef MATH_SSE
+    Columns cols(m);
+    for (size_t i = begin; i < end; i++) {
+        storeFloat3(&out[i][0], cols.point(&in[i][0]));
+    }
+#else
+    for (size_t i = begin; i < end; i++) {
+        out[i] = (m * float4(in[i], 1.f)).xyz;
+    }
+#endif
+}
+
+inline void transformNormals(const mat4f& m, const float3* in, float3* out, size_t begin, size_t end) {
+#ifdef MATH_SSE
+    Columns cols(m);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    for (size_t i = begin; i < end; i++) {
+        // w holds the last matrix row, it must not count in the length
+        __m128 n = _mm_and_ps(cols.vector(&in[i][0]), xyzMask);
+        __m128 len = _mm_sqrt_ps(_mm_set1_ps(sse::dot4(n, n)));
+        // zero length normals stay zero instead of 0 / 0
+        storeFloat3(&out[i][0], _mm_and_ps(_mm_div_ps(n, len), _mm_cmpgt_ps(len, zero)));
+    }
+#else
+    for (size_t i = begin; i < end; i++) {
+        float3 n = (m * float4(in[i], 0.f)).xyz;
+        float len = length(n);
+        out[i] = len > 0.f ? n / len : float3(0.f);
+    }
+#endif
+}
+
+// the box of the 8 transformed corners, from the transformed center and the extent
+// projected on the absolute matrix (Arvo)
+inline void transformAABBs(const mat4f& m, const AABB* in, AABB* out, size_t begin, size_t end) {
+#ifdef MATH_SSE
+    Columns cols(m);
+    const __m128 signMask = _mm_set1_ps(-0.f);
+    const __m128 a0 = _mm_andnot_ps(signMask, cols.c0);
+    const __m128 a1 = _mm_andnot_ps(signMask, cols.c1);
+    const __m128 a2 = _mm_andnot_ps(signMask, cols.c2);
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (size_t i = begin; i < end; i++) {
+        if (in[i].isEmpty()) {
+            out[i] = AABB();
+            continue;
+        }
+        __m128 lo = loadFloat3(&in[i].min[0]);
+        __m128 hi = loadFloat3(&in[i].max[0]);
+        __m128 c = _mm_mul_ps(_mm_add_ps(lo, hi), half);
+        __m128 e = _mm_mul_ps(_mm_sub_ps(hi, lo), half);
+
+        __m128 center = sse::madd(cols.c0, sse::splat<0>(c), cols.c3);
+        center = sse::madd(cols.c1, sse::splat<1>(c), center);
+        center = sse::madd(cols.c2, sse::splat<2>(c), center);
+        __m128 extent = _mm_mul_ps(a0, sse::splat<0>(e));
+        extent = sse::madd(a1, sse::splat<1>(e), extent);
+        extent = sse::madd(a2, sse::splat<2>(e), extent);
+
+        storeFloat3(&out[i].min[0], _mm_sub_ps(center, extent));
+        storeFloat3(&out[i].max[0], _mm_add_ps(center, extent));
+    }
+#else
+    for (size_t i = begin; i < end; i++) {
+        if (in[i].isEmpty()) {
+            out[i] = AABB();
+            continue;
+        }
+        float3 c = in[i].center();
+        float3 e = in[i].extent();
+        float3 center = (m * float4(c, 1.f)).xyz;
+        float3 extent;
+        for (size_t k = 0; k < 3; k++) {
+            extent[k] = std::abs(m[0][k]) * e.x + std::abs(m[1][k]) * e.y + std::abs(m[2][k]) * e.z;
+        }
+        out[i] = AABB(center - extent, center + extent);
+    }
+#endif
+}
+
+}  // namespace batch
+}  // namespace details
+
+// out[i] = m * {in[i], 1}
+inline void transformPoints(const mat4f& m, const float3* in, float4* out, size_t n) {
+    details::batch::transformPoints(m, in, out, 0, n);
+}
+
+// out[i] = (m * {in[i], 1}).xyz, for affine transforms
+inline void transformPoints(const mat4f& m, const float3* in, float3* out, size_t n) {
+    details::batch::transformPoints(m, in, out, 0, n);
+}
+
+// out[i] = normalize(upper3x3(m) * in[i]), m is usually transpose(inverse(model)),
+// zero for normals transformed to zero length
+inline void transformNormals(const mat4f& m, const float3* in, float3* out, size_t n) {
+    details::batch::transformNormals(m, in, out, 0, n);
+}
+
+// out[i] = the bounds of the corners of in[i] transformed by m, for affine transforms
+inline void transformAABBs(const mat4f& m, const AABB* in, AABB* out, size_t n) {
+    details::batch::transformAABBs(m, in, out, 0, n);
+}
+
+inline AABB transformAABB(const mat4f& m, const AABB& box) {
+    AABB ret;
+    details::batch::transformAABBs(m, &box, &ret, 0, 1);
+    return ret;
+}
+
+}  // namespace math
+
+#endif  // TNT_MATH_TRANSFORM_H
@@ -18,6 +18,7 @@
 #define TNT_MATH_VEC4_H
 
 #include <math/half.h>
+#include <math/sse.h>
 #include <math/vec3.h>
 
 #include <stdint.h>
@@ -106,6 +107,13 @@ public:
     constexpr TVec4(const TVec4<A>& v) noexcept : v{ T(v[0]), T(v[1]), T(v[2]), T(v[3]) } {}
 };
 
+#ifdef MATH_SSE
+// preferred over the generic TVecFunctions::dot, norm(), length() and normalize() of float4 use it too
+inline float MATH_PURE dot(const TVec4<float>& lv, const TVec4<float>& rv) {
+    return sse::dot4(_mm_loadu_ps(&lv[0]), _mm_loadu_ps(&rv[0]));
+}
+#endif
+
 }  // namespace details
 
 // ----------------------------------------------------------------------------------------
@@ -1,7 +1,7 @@
 
 #pragma once
 
-#include "Base/MathInc.h"
+#include "base/MathInc.h"
 
 enum DepthFunction {
   DepthFunc_NEVER,
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+#define RENDER_STATS_MAX_PASSES 8
+#define RENDER_STATS_MAX_GROUPS 16
+
+struct RenderStatsGroup
+{
+    const char* name = nullptr;
+    double millis = 0;
+};
+
+// counters of one frame, reset by the viewer at the beginning of each frame
+struct RenderStats
+{
+    uint64_t drawCalls = 0;
+    uint64_t instancesDrawn = 0;        // instances of instanced draw calls, each counts as one draw call
+    uint64_t trianglesIn = 0;           // primitives submitted by draw calls
+    uint64_t trianglesCulled = 0;       // back facing, degenerate or outside the viewport
+    uint64_t trianglesClipped = 0;      // crossing the near plane
+    uint64_t verticesShaded = 0;
+    uint64_t fragmentsShaded = 0;       // fragment shader invocations, not available on OpenGL
+    uint64_t fragmentsDepthKilled = 0;  // rejected by early depth test, not available on OpenGL
+    uint64_t stateChanges = 0;          // vao, program, resources or pipeline states bound
+    uint64_t textureBytesUploaded = 0;
+    uint64_t objectsTested = 0;         // scene objects frustum culled, main view
+    uint64_t objectsVisible = 0;
+    uint64_t objectsOccluded = 0;       // frustum visible objects hidden by occluders, main view
+    uint64_t shadowCasters = 0;         // scene objects in the shadow frustum
+    uint64_t meshletsTested = 0;        // clusters of drawn meshes tested before submission
+    uint64_t meshletsFrustumCulled = 0;
+    uint64_t meshletsConeCulled = 0;    // normal cone facing away from the camera
+    uint64_t trianglesLodSaved = 0;     // full detail triangles of drawn meshes minus the drawn level
+
+    // cpu time of occluder rasterization and box tests
+    double occlusionMillis = 0;
+
+    // cpu time from beginRenderPass to endRenderPass of each pass
+    uint32_t renderPasses = 0;
+    double passMillis[RENDER_STATS_MAX_PASSES] = {};
+
+    // gpu time of passes and draw groups, measured gpuFrameLag frames before this one (0: not available)
+    uint32_t gpuFrameLag = 0;
+    uint32_t gpuPasses = 0;
+    double gpuPassMillis[RENDER_STATS_MAX_PASSES] = {};
+    uint32_t gpuGroups = 0;
+    RenderStatsGroup gpuGroupMillis[RENDER_STATS_MAX_GROUPS] = {};
+
+    // cpu time of the whole frame, set by ViewerManager
+    double frameMillis = 0;
+
+    inline void reset()
+    {
+        *this = RenderStats();
+    }
+
+    inline double totalPassMillis() const
+    {
+        double sum = 0;
+        for (uint32_t i = 0; i < std::min(renderPasses, (uint32_t)RENDER_STATS_MAX_PASSES); i++)
+        {
+            sum += passMillis[i];
+        }
+        return sum;
+    }
+
+    inline double totalGpuPassMillis() const
+    {
+        double sum = 0;
+        for (uint32_t i = 0; i < std::min(gpuPasses, (uint32_t)RENDER_STATS_MAX_PASSES); i++)
+        {
+            sum += gpuPassMillis[i];
+        }
+        return sum;
+    }
+};
+
+// stats of the latest frames, for rolling averages and percentiles
+class RenderStatsHistory
+{
+public:
+    explicit RenderStatsHistory(size_t capacity = 240)
+        : capacity_(std::max((size_t)1, capacity)) {}
+
+    inline void push(const RenderStats& stats)
+    {
+        frames_.push_back(stats);
+        if (frames_.size() > capacity_)
+        {
+            frames_.pop_front();
+        }
+    }
+
+    inline void clear()
+    {
+        frames_.clear();
+    }
+
+    inline size_t size() const
+    {
+        return frames_.size();
+    }
+
+    inline const std::deque<RenderStats>& frames() const
+    {
+        return frames_;
+    }
+
+    inline const RenderStats& last() const
+    {
+        static const RenderStats empty;
+        return frames_.empty() ? empty : frames_.back();
+    }
+
+    // e.g. average([](const RenderStats& s) { return (double) s.trianglesIn; })
+    template<typename F>
+    double average(F&& value) const
+    {
+        if (frames_.empty())
+        {
+            return 0;
+        }
+        double sum = 0;
+        for (auto& frame : frames_)
+        {
+            sum += (double)value(frame);
+        }
+        return sum / (double)frames_.size();
+    }
+
+    // p in [0, 1], nearest rank
+    template<typename F>
+    double percentile(F&& value, double p) const
+    {
+        if (frames_.empty())
+        {
+            return 0;
+        }
+        std::vector<double> values;
+        values.reserve(frames_.size());
+        for (auto& frame : frames_)
+        {
+            values.push_back((double)value(frame));
+        }
+        auto rank = (size_t)(std::clamp(p, 0.0, 1.0) * (double)(values.size() - 1) + 0.5);
+        std::nth_element(values.begin(), values.begin() + (ptrdiff_t)rank, values.end());
+        return values[rank];
+    }
+
+private:
+    size_t capacity_;
+    std::deque<RenderStats> frames_;
+};
@@ -6,6 +6,8 @@
 #include "PipelineStates.h"
 #include "Uniform.h"
 #include "Vertex.h"
+#include "RenderStats.h"
+#include "base/Timer.h"
 
 enum RendererType
 {
@@ -23,6 +25,10 @@ public:
     virtual bool create() { return true; };
     virtual void destroy() {};
 
+    // called by the viewer at the beginning of each frame, resets stats
+    virtual void beginFrame() { resetStats(); }
+    virtual void endFrame() {}
+
     // framebuffer
     virtual std::shared_ptr<FrameBuffer> createFrameBuffer(bool offscreen) = 0;
 
@@ -31,6 +37,7 @@ public:
 
     // vertex
     virtual std::shared_ptr<VertexArrayObject> createVertexArrayObject(const VertexArray& vertexArray) = 0;
+    virtual std::shared_ptr<InstanceBuffer> createInstanceBuffer(const InstanceArray& instanceArray) = 0;
 
     // shader program
     virtual std::shared_ptr<ShaderProgram> createShaderProgram() = 0;
@@ -50,6 +57,80 @@ public:
     virtual void setShaderResources(std::shared_ptr<ShaderResources>& uniforms) = 0;
     virtual void setPipelineStates(std::shared_ptr<PipelineStates>& states) = 0;
     virtual void draw() = 0;
+    // draw parts of the index buffer of the bound vertex array object as one call, e.g. visible meshlets
+    virtual void drawRanges(const std::vector<IndexRange>& ranges) = 0;
+    // draw the index buffer of the bound vertex array object once per instance of instances as one call
+    virtual void drawInstanced(std::shared_ptr<InstanceBuffer>& instances) = 0;
+    // same for one part of the index buffer, e.g. a level of detail
+    virtual void drawRangeInstanced(const IndexRange& range, std::shared_ptr<InstanceBuffer>& instances) = 0;
     virtual void endRenderPass() = 0;
     virtual void waitIdle() = 0;
+
+    // named range of draws timed on the gpu if supported, name must have static storage
+    virtual void beginGroup(const char* name) {}
+    virtual void endGroup() {}
+
+    // stats
+    inline const RenderStats& getStats() const
+    {
+        return stats_;
+    }
+
+    inline void resetStats()
+    {
+        stats_.reset();
+    }
+
+    inline void addTextureUpload(size_t bytes)
+    {
+        stats_.textureBytesUploaded += bytes;
+    }
+
+    inline void addCullStats(size_t tested, size_t visible)
+    {
+        stats_.objectsTested += tested;
+        stats_.objectsVisible += visible;
+    }
+
+    inline void addShadowCullStats(size_t casters)
+    {
+        stats_.shadowCasters += casters;
+    }
+
+    inline void addOcclusionStats(size_t occluded, double millis)
+    {
+        stats_.objectsOccluded += occluded;
+        stats_.occlusionMillis += millis;
+    }
+
+    inline void addMeshletStats(size_t tested, size_t frustumCulled, size_t coneCulled)
+    {
+        stats_.meshletsTested += tested;
+        stats_.meshletsFrustumCulled += frustumCulled;
+        stats_.meshletsConeCulled += coneCulled;
+    }
+
+    inline void addLodStats(size_t trianglesSaved)
+    {
+        stats_.trianglesLodSaved += trianglesSaved;
+    }
+
+protected:
+    inline void beginPassStats()
+    {
+        passTimer_.start();
+    }
+
+    inline void endPassStats()
+    {
+        if (stats_.renderPasses < RENDER_STATS_MAX_PASSES)
+        {
+            stats_.passMillis[stats_.renderPasses] = passTimer_.elapseMillis();
+        }
+        stats_.renderPasses++;
+    }
+
+protected:
+    RenderStats stats_;
+    Timer passTimer_;
 };
\ No newline at end of file
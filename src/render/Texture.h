@@ -107,6 +107,8 @@ class Texture : public TextureDesc
     virtual void initImageData() {};
     virtual void setImageData(const std::vector<std::shared_ptr<Buffer<RGBA>>>& buffers) {};
     virtual void setImageData(const std::vector<std::shared_ptr<Buffer<float>>>& buffers) {};
+    // upload one pre-built mip level (one buffer per layer), mipmaps are not generated by the backend
+    virtual void setImageLevelData(const std::vector<std::shared_ptr<Buffer<RGBA>>>& buffers, uint32_t level) {};
     virtual void dumpImage(const char* path, uint32_t layer, uint32_t level) = 0;
 };
 
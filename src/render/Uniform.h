@@ -6,7 +6,7 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
-#include "Base/UUID.h"
+#include "base/UUID.h"
 #include "Texture.h"
 
 class ShaderProgram;
@@ -8,6 +8,7 @@
 
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 class VertexArrayObject {
  public:
@@ -15,11 +16,44 @@ class VertexArrayObject {
   virtual void updateVertexData(void *data, size_t length) = 0;
 };
 
-// only support float type attributes
+// per instance attributes of Renderer::drawInstanced, the instance count follows the data length
+class InstanceBuffer {
+ public:
+  virtual int getId() const = 0;
+  virtual void updateInstanceData(void *data, size_t length) = 0;
+  virtual size_t getInstanceCnt() const = 0;
+};
+
+// component type of attributes in the vertex buffer, shaders always see floats.
+// integer types are normalized to [0, 1] (unorm) or [-1, 1] (snorm), VertexAttr_OCT16 is a unit
+// vector stored as 2 snorm16 octahedral coordinates and decoded to size 3
+enum VertexAttributeType {
+  VertexAttr_FLOAT,
+  VertexAttr_HALF,
+  VertexAttr_SNORM16,
+  VertexAttr_UNORM16,
+  VertexAttr_SNORM8,
+  VertexAttr_UNORM8,
+  VertexAttr_OCT16,
+};
+
+enum IndexType {
+  Index_UINT32,
+  Index_UINT16,
+};
+
+// part of the index buffer in indices, see Renderer::drawRanges
+struct IndexRange {
+  uint32_t offset;
+  uint32_t count;
+};
+
+// size: components seen by the shader (1 - 4), stride and offset in bytes
 struct VertexAttributeDesc {
   size_t size;
   size_t stride;
   size_t offset;
+  VertexAttributeType type = VertexAttr_FLOAT;
 };
 
 struct VertexArray {
@@ -29,7 +63,17 @@ struct VertexArray {
   uint8_t *vertexesBuffer = nullptr;
   size_t vertexesBufferLength = 0;
 
-  int32_t *indexBuffer = nullptr;
+  void *indexBuffer = nullptr;    // int32_t or uint16_t elements, see indexType
   size_t indexBufferLength = 0;
+  IndexType indexType = Index_UINT32;
 };
 
+// instance attributes follow the attributes of the bound vertex array object:
+// instancesDesc[k] is shader attribute vertexesDesc.size() + k, stride and offset within instancesBuffer
+struct InstanceArray {
+  size_t instanceSize = 0;
+  std::vector<VertexAttributeDesc> instancesDesc;
+
+  uint8_t *instancesBuffer = nullptr;   // may be null and filled later by updateInstanceData()
+  size_t instancesBufferLength = 0;
+};
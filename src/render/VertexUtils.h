@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include "base/MathInc.h"
+#include "math/half.h"
+#include "render/Vertex.h"
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+class VertexUtils {
+ public:
+  // bytes of one attribute in the vertex buffer
+  static inline size_t attributeBytes(VertexAttributeType type, size_t size) {
+    switch (type) {
+      case VertexAttr_FLOAT:    return size * sizeof(float);
+      case VertexAttr_HALF:
+      case VertexAttr_SNORM16:
+      case VertexAttr_UNORM16:  return size * sizeof(uint16_t);
+      case VertexAttr_SNORM8:
+      case VertexAttr_UNORM8:   return size;
+      case VertexAttr_OCT16:    return 2 * sizeof(int16_t);
+    }
+    return 0;
+  }
+
+  static inline size_t attributeBytes(const VertexAttributeDesc &desc) {
+    return attributeBytes(desc.type, desc.size);
+  }
+
+  // components stored in the vertex buffer, differs from size for VertexAttr_OCT16
+  static inline size_t storedComponents(const VertexAttributeDesc &desc) {
+    return desc.type == VertexAttr_OCT16 ? 2 : desc.size;
+  }
+
+  static inline size_t indexBytes(IndexType type) {
+    return type == Index_UINT16 ? sizeof(uint16_t) : sizeof(int32_t);
+  }
+
+  static inline size_t getIndexCnt(const VertexArray &vertexArr) {
+    return vertexArr.indexBufferLength / indexBytes(vertexArr.indexType);
+  }
+
+  static inline uint32_t getIndex(const VertexArray &vertexArr, size_t i) {
+    if (vertexArr.indexType == Index_UINT16) {
+      return ((const uint16_t *) vertexArr.indexBuffer)[i];
+    }
+    return (uint32_t) ((const int32_t *) vertexArr.indexBuffer)[i];
+  }
+
+  // decoded first attribute of every vertex in the vertex buffer
+  static inline void getPositions(const VertexArray &vertexArr, std::vector<math::float3> &positions) {
+    positions.clear();
+    if (vertexArr.vertexSize == 0 || vertexArr.vertexesDesc.empty()) {
+      return;
+    }
+    auto &desc = vertexArr.vertexesDesc[0];
+    positions.resize(vertexArr.vertexesBufferLength / vertexArr.vertexSize);
+    for (size_t i = 0; i < positions.size(); i++) {
+      float value[4] = {};
+      decodeAttribute(desc, vertexArr.vertexesBuffer + i * desc.stride + desc.offset, value);
+      positions[i] = math::float3(value[0], value[1], value[2]);
+    }
+  }
+
+  // welded[i]: the first vertex with the bitwise same position as vertex i
+  static inline void weldPositions(const std::vector<math::float3> &positions, std::vector<uint32_t> &welded) {
+    size_t tableSize = 1;
+    while (tableSize < positions.size() * 2) {
+      tableSize *= 2;
+    }
+    std::vector<uint32_t> table(tableSize, UINT32_MAX);  // open addressing on the position bits
+    welded.resize(positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+      uint32_t bits[3];
+      memcpy(bits, &positions[i], sizeof(bits));
+      size_t slot = (bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u) & (tableSize - 1);
+      while (table[slot] != UINT32_MAX && memcmp(&positions[table[slot]], &positions[i], sizeof(bits)) != 0) {
+        slot = (slot + 1) & (tableSize - 1);
+      }
+      if (table[slot] == UINT32_MAX) {
+        table[slot] = (uint32_t) i;
+      }
+      welded[i] = table[slot];
+    }
+  }
+
+  // unit vector to the octahedron folded onto [-1, 1]^2
+  static inline void octEncode(const float *n, int16_t *out) {
+    float l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+    float x = l1 > 0.f ? n[0] / l1 : 0.f;
+    float y = l1 > 0.f ? n[1] / l1 : 0.f;
+    if (n[2] < 0.f) {
+      float fx = (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f);
+      float fy = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+      x = fx;
+      y = fy;
+    }
+    out[0] = encodeSnorm16(x);
+    out[1] = encodeSnorm16(y);
+  }
+
+  static inline void octDecode(const int16_t *in, float *n) {
+    float x = decodeSnorm16(in[0]);
+    float y = decodeSnorm16(in[1]);
+    float z = 1.f - std::abs(x) - std::abs(y);
+    float t = std::max(-z, 0.f);
+    x += x >= 0.f ? -t : t;
+    y += y >= 0.f ? -t : t;
+    float invLen = 1.f / std::sqrt(x * x + y * y + z * z);
+    n[0] = x * invLen;
+    n[1] = y * invLen;
+    n[2] = z * invLen;
+  }
+
+  // decode one attribute into desc.size floats, src may be unaligned
+  static inline void decodeAttribute(const VertexAttributeDesc &desc, const uint8_t *src, float *dst) {
+    switch (desc.type) {
+      case VertexAttr_FLOAT:
+        memcpy(dst, src, desc.size * sizeof(float));
+        break;
+      case VertexAttr_HALF:
+        for (size_t i = 0; i < desc.size; i++) {
+          dst[i] = halfToFloat(load<uint16_t>(src + i * 2));
+        }
+        break;
+      case VertexAttr_SNORM16:
+        for (size_t i = 0; i < desc.size; i++) {
+          dst[i] = decodeSnorm16(load<int16_t>(src + i * 2));
+        }
+        break;
+      case VertexAttr_UNORM16:
+        for (size_t i = 0; i < desc.size; i++) {
+          dst[i] = (float) load<uint16_t>(src + i * 2) / 65535.f;
+        }
+        break;
+      case VertexAttr_SNORM8:
+        for (size_t i = 0; i < desc.size; i++) {
+          dst[i] = std::max((float) (int8_t) src[i] / 127.f, -1.f);
+        }
+        break;
+      case VertexAttr_UNORM8:
+        for (size_t i = 0; i < desc.size; i++) {
+          dst[i] = (float) src[i] / 255.f;
+        }
+        break;
+      case VertexAttr_OCT16: {
+        int16_t oct[2] = {load<int16_t>(src), load<int16_t>(src + 2)};
+        octDecode(oct, dst);
+        break;
+      }
+    }
+  }
+
+  // encode size floats (3 for VertexAttr_OCT16), values are clamped to the range of the type
+  static inline void encodeAttribute(VertexAttributeType type, const float *src, size_t size, uint8_t *dst) {
+    switch (type) {
+      case VertexAttr_FLOAT:
+        memcpy(dst, src, size * sizeof(float));
+        break;
+      case VertexAttr_HALF:
+        for (size_t i = 0; i < size; i++) {
+          store<uint16_t>(dst + i * 2, floatToHalf(src[i]));
+        }
+        break;
+      case VertexAttr_SNORM16:
+        for (size_t i = 0; i < size; i++) {
+          store<int16_t>(dst + i * 2, encodeSnorm16(src[i]));
+        }
+        break;
+      case VertexAttr_UNORM16:
+        for (size_t i = 0; i < size; i++) {
+          store<uint16_t>(dst + i * 2, (uint16_t) std::lround(std::clamp(src[i], 0.f, 1.f) * 65535.f));
+        }
+        break;
+      case VertexAttr_SNORM8:
+        for (size_t i = 0; i < size; i++) {
+          dst[i] = (uint8_t) (int8_t) std::lround(std::clamp(src[i], -1.f, 1.f) * 127.f);
+        }
+        break;
+      case VertexAttr_UNORM8:
+        for (size_t i = 0; i < size; i++) {
+          dst[i] = (uint8_t) std::lround(std::clamp(src[i], 0.f, 1.f) * 255.f);
+        }
+        break;
+      case VertexAttr_OCT16: {
+        int16_t oct[2];
+        octEncode(src, oct);
+        store<int16_t>(dst, oct[0]);
+        store<int16_t>(dst + 2, oct[1]);
+        break;
+      }
+    }
+  }
+
+ private:
+  template<typename T>
+  static inline T load(const uint8_t *p) {
+    T v;
+    memcpy(&v, p, sizeof(T));
+    return v;
+  }
+
+  template<typename T>
+  static inline void store(uint8_t *p, T v) {
+    memcpy(p, &v, sizeof(T));
+  }
+
+  static inline float halfToFloat(uint16_t bits) {
+#ifdef __F16C__
+    return _cvtsh_ss(bits);
+#else
+    return (float) math::makeHalf(bits);
+#endif
+  }
+
+  static inline uint16_t floatToHalf(float v) {
+#ifdef __F16C__
+    return _cvtss_sh(v, _MM_FROUND_TO_NEAREST_INT);
+#else
+    return getBits(math::half(v));
+#endif
+  }
+
+  static inline float decodeSnorm16(int16_t v) {
+    return std::max((float) v / 32767.f, -1.f);
+  }
+
+  static inline int16_t encodeSnorm16(float v) {
+    return (int16_t) std::lround(std::clamp(v, -1.f, 1.f) * 32767.f);
+  }
+};
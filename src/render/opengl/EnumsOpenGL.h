@@ -6,7 +6,8 @@
 
 #pragma once
 
-#include "Render/PipelineStates.h"
+#include "render/PipelineStates.h"
+#include "render/Vertex.h"
 
 namespace OpenGL {
 
@@ -121,6 +122,25 @@ static inline GLint cvtDrawMode(PrimitiveType type) {
   return 0;
 }
 
+static inline GLenum cvtVertexAttributeType(VertexAttributeType type) {
+  switch (type) {
+    case VertexAttr_FLOAT:      return GL_FLOAT;
+    case VertexAttr_HALF:       return GL_HALF_FLOAT;
+    case VertexAttr_SNORM16:    return GL_SHORT;
+    case VertexAttr_UNORM16:    return GL_UNSIGNED_SHORT;
+    case VertexAttr_SNORM8:     return GL_BYTE;
+    case VertexAttr_UNORM8:     return GL_UNSIGNED_BYTE;
+    case VertexAttr_OCT16:      return GL_SHORT;
+    default:
+      break;
+  }
+  return GL_FLOAT;
+}
+
+static inline GLenum cvtIndexType(IndexType type) {
+  return type == Index_UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
 static inline math::float4 cvtBorderColor(BorderColor color) {
   switch (color) {
     case Border_BLACK:          return math::float4(0.f);
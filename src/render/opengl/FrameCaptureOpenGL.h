@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <glad/glad.h>
+#include "base/Buffer.h"
+#include "base/MathInc.h"
+#include "render/opengl/OpenGLUtils.h"
+
+// non-blocking readback of RGBA8 textures through a ring of pixel buffer objects.
+// capture() queues glReadPixels into a PBO with a fence, poll() maps the PBOs whose
+// fence has signaled (usually a few frames later) and hands the pixels to the callback.
+class FrameCaptureOpenGL {
+ public:
+  using Callback = std::function<void(std::shared_ptr<Buffer<RGBA>> frame)>;
+
+  explicit FrameCaptureOpenGL(size_t ringSize = 3) : slots_(ringSize) {
+    GL_CHECK(glGenFramebuffers(1, &fbo_));
+    for (auto &slot : slots_) {
+      GL_CHECK(glGenBuffers(1, &slot.pbo));
+    }
+  }
+
+  ~FrameCaptureOpenGL() {
+    for (auto &slot : slots_) {
+      if (slot.fence) {
+        glDeleteSync(slot.fence);
+      }
+      GL_CHECK(glDeleteBuffers(1, &slot.pbo));
+    }
+    GL_CHECK(glDeleteFramebuffers(1, &fbo_));
+  }
+
+  // queue readback of level 0 of a 2D RGBA8 texture. if all slots are in flight the oldest one is waited
+  void capture(GLuint texId, int width, int height, Callback callback) {
+    Slot &slot = slots_[head_];
+    if (slot.fence) {
+      resolve(slot, true);
+    }
+
+    size_t bytes = (size_t) width * height * sizeof(RGBA);
+    GL_CHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo));
+    if (slot.bytes != bytes) {
+      GL_CHECK(glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr) bytes, nullptr, GL_STREAM_READ));
+      slot.bytes = bytes;
+    }
+
+    GL_CHECK(glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_));
+    GL_CHECK(glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texId, 0));
+    GL_CHECK(glPixelStorei(GL_PACK_ALIGNMENT, 4));
+    GL_CHECK(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+    GL_CHECK(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+    GL_CHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.width = width;
+    slot.height = height;
+    slot.callback = std::move(callback);
+
+    head_ = (head_ + 1) % slots_.size();
+  }
+
+  // resolve finished readbacks in capture order, wait = true blocks until all are done
+  void poll(bool wait = false) {
+    for (size_t i = 0; i < slots_.size(); i++) {
+      Slot &slot = slots_[(head_ + i) % slots_.size()];
+      if (slot.fence && !resolve(slot, wait)) {
+        break;
+      }
+    }
+  }
+
+ private:
+  struct Slot {
+    GLuint pbo = 0;
+    GLsync fence = nullptr;
+    size_t bytes = 0;
+    int width = 0;
+    int height = 0;
+    Callback callback;
+  };
+
+  bool resolve(Slot &slot, bool wait) {
+    GLenum ret = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? GL_TIMEOUT_IGNORED : 0);
+    if (ret != GL_ALREADY_SIGNALED && ret != GL_CONDITION_SATISFIED) {
+      return false;
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    auto frame = Buffer<RGBA>::makeDefault(slot.width, slot.height);
+    GL_CHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo));
+    void *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr) slot.bytes, GL_MAP_READ_BIT);
+    if (pixels) {
+      memcpy(frame->getRawDataPtr(), pixels, slot.bytes);
+      GL_CHECK(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+    }
+    GL_CHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+    if (pixels && slot.callback) {
+      slot.callback(std::move(frame));
+    }
+    slot.callback = nullptr;
+    return true;
+  }
+
+ private:
+  GLuint fbo_ = 0;
+  std::vector<Slot> slots_;
+  size_t head_ = 0;
+};
@@ -7,9 +7,9 @@
 #pragma once
 
 #include <glad/glad.h>
-#include "Render/Framebuffer.h"
-#include "Render/OpenGL/TextureOpenGL.h"
-#include "Render/OpenGL/OpenGLUtils.h"
+#include "render/Framebuffer.h"
+#include "render/opengl/TextureOpenGL.h"
+#include "render/opengl/OpenGLUtils.h"
 
 class FrameBufferOpenGL : public FrameBuffer {
  public:
@@ -31,6 +31,11 @@ class FrameBufferOpenGL : public FrameBuffer {
     }
 
     GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, fbo_));
+    if (!colorAttachment_.tex) {
+      // depth only, a GL 3.3 fbo without a color attachment is incomplete unless draw and read buffers are off
+      GL_CHECK(glDrawBuffer(GL_NONE));
+      GL_CHECK(glReadBuffer(GL_NONE));
+    }
     GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
     if (status != GL_FRAMEBUFFER_COMPLETE) {
       LOGE("glCheckFramebufferStatus: %x", status);
@@ -8,6 +8,17 @@
 constexpr char const *OpenGL_GLSL_VERSION = "#version 330 core";
 constexpr char const *OpenGL_GLSL_DEFINE = "OpenGL";
 
+// VertexAttr_OCT16 attributes reach vertex shaders as vec2, e.g. "vec3 normal = octDecode(aNormal);"
+constexpr char const *OpenGL_GLSL_OCT_DECODE = R"(
+vec3 octDecode(vec2 e) {
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+)";
+
 class ShaderGLSL {
  public:
   explicit ShaderGLSL(GLenum type) : type_(type) {
@@ -8,7 +8,7 @@
 class OpenGLUtils {
  public:
   static void checkGLError_(const char *stmt, const char *file, int line) {
-    const char *str;
+    [[maybe_unused]] const char *str;
     GLenum err = glGetError();
     switch (err) {
       case GL_NO_ERROR:
@@ -36,6 +36,7 @@ class OpenGLUtils {
 
     if (err != GL_NO_ERROR) {
       LOGE("GL_CHECK: %s, %s:%d, %s", str, file, line, stmt);
+      Logger::flush();
       abort();
     }
   }
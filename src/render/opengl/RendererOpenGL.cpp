@@ -11,9 +11,50 @@
 #include "ShaderProgramOpenGL.h"
 #include "VertexOpenGL.h"
 #include "EnumsOpenGL.h"
+#include "base/Profiler.h"
 
 #define GL_STATE_SET(var, gl_state) if (var) GL_CHECK(glEnable(gl_state)); else GL_CHECK(glDisable(gl_state));
 
+void RendererOpenGL::destroy() {
+  timerQuery_ = nullptr;
+}
+
+void RendererOpenGL::beginFrame() {
+  resetStats();
+  if (!timerQuery_) {
+    timerQuery_ = std::make_shared<TimerQueryOpenGL>();
+  }
+
+  // the latest frame whose timer queries are available
+  uint32_t frameLag = 0;
+  while (timerQuery_->poll(timerResults_, frameLag)) {
+    stats_.gpuFrameLag = frameLag;
+  }
+  if (stats_.gpuFrameLag > 0) {
+    for (auto &range : timerResults_) {
+      if (range.pass) {
+        if (stats_.gpuPasses < RENDER_STATS_MAX_PASSES) {
+          stats_.gpuPassMillis[stats_.gpuPasses] = range.millis;
+        }
+        stats_.gpuPasses++;
+      } else {
+        if (stats_.gpuGroups < RENDER_STATS_MAX_GROUPS) {
+          stats_.gpuGroupMillis[stats_.gpuGroups] = {range.name, range.millis};
+        }
+        stats_.gpuGroups++;
+      }
+    }
+  }
+
+  timerQuery_->beginFrame();
+}
+
+void RendererOpenGL::endFrame() {
+  if (timerQuery_) {
+    timerQuery_->endFrame();
+  }
+}
+
 // framebuffer
 std::shared_ptr<FrameBuffer> RendererOpenGL::createFrameBuffer(bool offscreen) {
   return std::make_shared<FrameBufferOpenGL>(offscreen);
@@ -33,6 +74,10 @@ std::shared_ptr<VertexArrayObject> RendererOpenGL::createVertexArrayObject(const
   return std::make_shared<VertexArrayObjectOpenGL>(vertexArray);
 }
 
+std::shared_ptr<InstanceBuffer> RendererOpenGL::createInstanceBuffer(const InstanceArray &instanceArray) {
+  return std::make_shared<InstanceBufferOpenGL>(instanceArray);
+}
+
 // shader program
 std::shared_ptr<ShaderProgram> RendererOpenGL::createShaderProgram() {
   return std::make_shared<ShaderProgramOpenGL>();
@@ -54,6 +99,11 @@ std::shared_ptr<UniformSampler> RendererOpenGL::createUniformSampler(const std::
 
 // pipeline
 void RendererOpenGL::beginRenderPass(std::shared_ptr<FrameBuffer> &frameBuffer, const ClearStates &states) {
+  PROFILE_ZONE("RendererOpenGL::beginRenderPass");
+  beginPassStats();
+  if (timerQuery_) {
+    timerQuery_->begin("pass", true);
+  }
   auto *fbo = dynamic_cast<FrameBufferOpenGL *>(frameBuffer.get());
   fbo->bind();
 
@@ -78,6 +128,7 @@ void RendererOpenGL::setVertexArrayObject(std::shared_ptr<VertexArrayObject> &va
   }
   vao_ = dynamic_cast<VertexArrayObjectOpenGL *>(vao.get());
   vao_->bind();
+  stats_.stateChanges++;
 }
 
 void RendererOpenGL::setShaderProgram(std::shared_ptr<ShaderProgram> &program) {
@@ -86,6 +137,7 @@ void RendererOpenGL::setShaderProgram(std::shared_ptr<ShaderProgram> &program) {
   }
   shaderProgram_ = dynamic_cast<ShaderProgramOpenGL *>(program.get());
   shaderProgram_->use();
+  stats_.stateChanges++;
 }
 
 void RendererOpenGL::setShaderResources(std::shared_ptr<ShaderResources> &resources) {
@@ -94,6 +146,7 @@ void RendererOpenGL::setShaderResources(std::shared_ptr<ShaderResources> &resour
   }
   if (shaderProgram_) {
     shaderProgram_->bindResources(*resources);
+    stats_.stateChanges++;
   }
 }
 
@@ -102,6 +155,7 @@ void RendererOpenGL::setPipelineStates(std::shared_ptr<PipelineStates> &states)
     return;
   }
   pipelineStates_ = states.get();
+  stats_.stateChanges++;
 
   auto &renderStates = states->renderStates;
   // blend
@@ -126,8 +180,70 @@ void RendererOpenGL::setPipelineStates(std::shared_ptr<PipelineStates> &states)
 }
 
 void RendererOpenGL::draw() {
+  PROFILE_ZONE("RendererOpenGL::draw");
+  GLenum mode = OpenGL::cvtDrawMode(pipelineStates_->renderStates.primitiveType);
+  GL_CHECK(glDrawElements(mode, (GLsizei) vao_->getIndicesCnt(), vao_->getIndexType(), nullptr));
+
+  stats_.drawCalls++;
+  stats_.verticesShaded += vao_->getVertexCnt();
+  if (pipelineStates_->renderStates.primitiveType == Primitive_TRIANGLE) {
+    stats_.trianglesIn += vao_->getIndicesCnt() / 3;
+  }
+}
+
+void RendererOpenGL::drawRanges(const std::vector<IndexRange> &ranges) {
+  PROFILE_ZONE("RendererOpenGL::drawRanges");
+  size_t indexBytes = vao_->getIndexType() == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+  size_t indicesCnt = 0;
+  rangeCounts_.clear();
+  rangeOffsets_.clear();
+  for (auto &range : ranges) {
+    if (range.count > 0) {
+      rangeCounts_.push_back((GLsizei) range.count);
+      rangeOffsets_.push_back((const void *) (range.offset * indexBytes));
+      indicesCnt += range.count;
+    }
+  }
+  if (rangeCounts_.empty()) {
+    return;
+  }
+
+  GLenum mode = OpenGL::cvtDrawMode(pipelineStates_->renderStates.primitiveType);
+  GL_CHECK(glMultiDrawElements(mode, rangeCounts_.data(), vao_->getIndexType(), rangeOffsets_.data(),
+                               (GLsizei) rangeCounts_.size()));
+
+  stats_.drawCalls++;
+  stats_.verticesShaded += vao_->getVertexCnt();
+  if (pipelineStates_->renderStates.primitiveType == Primitive_TRIANGLE) {
+    stats_.trianglesIn += indicesCnt / 3;
+  }
+}
+
+void RendererOpenGL::drawInstanced(std::shared_ptr<InstanceBuffer> &instances) {
+  drawRangeInstanced({0, (uint32_t) vao_->getIndicesCnt()}, instances);
+}
+
+void RendererOpenGL::drawRangeInstanced(const IndexRange &range, std::shared_ptr<InstanceBuffer> &instances) {
+  auto *instanceBuffer = dynamic_cast<InstanceBufferOpenGL *>(instances.get());
+  if (!instanceBuffer || instanceBuffer->getInstanceCnt() == 0 || range.count == 0) {
+    return;
+  }
+  PROFILE_ZONE("RendererOpenGL::drawInstanced");
+  size_t indexBytes = vao_->getIndexType() == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+  auto instanceCnt = instanceBuffer->getInstanceCnt();
+
+  instanceBuffer->bind(vao_->getAttributeCnt());
   GLenum mode = OpenGL::cvtDrawMode(pipelineStates_->renderStates.primitiveType);
-  GL_CHECK(glDrawElements(mode, (GLsizei) vao_->getIndicesCnt(), GL_UNSIGNED_INT, nullptr));
+  GL_CHECK(glDrawElementsInstanced(mode, (GLsizei) range.count, vao_->getIndexType(),
+                                   (const void *) (range.offset * indexBytes), (GLsizei) instanceCnt));
+  instanceBuffer->unbind(vao_->getAttributeCnt());
+
+  stats_.drawCalls++;
+  stats_.instancesDrawn += instanceCnt;
+  stats_.verticesShaded += vao_->getVertexCnt() * instanceCnt;
+  if (pipelineStates_->renderStates.primitiveType == Primitive_TRIANGLE) {
+    stats_.trianglesIn += range.count / 3 * instanceCnt;
+  }
 }
 
 void RendererOpenGL::endRenderPass() {
@@ -137,8 +253,26 @@ void RendererOpenGL::endRenderPass() {
   GL_CHECK(glDepthMask(true));
   GL_CHECK(glDisable(GL_CULL_FACE));
   GL_CHECK(glPolygonMode(GL_FRONT_AND_BACK, GL_FILL));
+
+  if (timerQuery_) {
+    timerQuery_->end();
+  }
+  endPassStats();
 }
 
 void RendererOpenGL::waitIdle() {
+  PROFILE_ZONE("RendererOpenGL::waitIdle");
   GL_CHECK(glFinish());
 }
+
+void RendererOpenGL::beginGroup(const char *name) {
+  if (timerQuery_) {
+    timerQuery_->begin(name, false);
+  }
+}
+
+void RendererOpenGL::endGroup() {
+  if (timerQuery_) {
+    timerQuery_->end();
+  }
+}
@@ -1,14 +1,19 @@
 
 #pragma once
 
-#include "Render/Renderer.h"
-#include "Render/OpenGL/VertexOpenGL.h"
-#include "Render/OpenGL/ShaderProgramOpenGL.h"
+#include "render/Renderer.h"
+#include "render/opengl/VertexOpenGL.h"
+#include "render/opengl/ShaderProgramOpenGL.h"
+#include "render/opengl/TimerQueryOpenGL.h"
 
 class RendererOpenGL : public Renderer
 {
 public:
     RendererType type() override { return Renderer_OPENGL; }
+    void destroy() override;
+
+    void beginFrame() override;
+    void endFrame() override;
 
     // framebuffer
     std::shared_ptr<FrameBuffer> createFrameBuffer(bool offscreen) override;
@@ -18,6 +23,7 @@ public:
 
     // vertex
     std::shared_ptr<VertexArrayObject> createVertexArrayObject(const VertexArray& vertexArray) override;
+    std::shared_ptr<InstanceBuffer> createInstanceBuffer(const InstanceArray& instanceArray) override;
 
     // shader program
     std::shared_ptr<ShaderProgram> createShaderProgram() override;
@@ -37,12 +43,25 @@ public:
     void setShaderResources(std::shared_ptr<ShaderResources>& resources) override;
     void setPipelineStates(std::shared_ptr<PipelineStates>& states) override;
     void draw() override;
+    void drawRanges(const std::vector<IndexRange>& ranges) override;
+    void drawInstanced(std::shared_ptr<InstanceBuffer>& instances) override;
+    void drawRangeInstanced(const IndexRange& range, std::shared_ptr<InstanceBuffer>& instances) override;
     void endRenderPass() override;
     void waitIdle() override;
 
+    void beginGroup(const char* name) override;
+    void endGroup() override;
+
 private:
     VertexArrayObjectOpenGL* vao_ = nullptr;
     ShaderProgramOpenGL* shaderProgram_ = nullptr;
     PipelineStates* pipelineStates_ = nullptr;
+
+    // glMultiDrawElements arguments of drawRanges()
+    std::vector<GLsizei> rangeCounts_;
+    std::vector<const void*> rangeOffsets_;
+
+    std::shared_ptr<TimerQueryOpenGL> timerQuery_;
+    std::vector<TimerQueryOpenGL::Range> timerResults_;
 };
 
@@ -7,8 +7,8 @@
 #pragma once
 
 #include <unordered_map>
-#include "Base/FileUtils.h"
-#include "Render/ShaderProgram.h"
+#include "base/FileUtils.h"
+#include "render/ShaderProgram.h"
 #include "GLSLUtils.h"
 
 class ShaderProgramOpenGL : public ShaderProgram {
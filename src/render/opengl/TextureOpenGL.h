@@ -8,9 +8,9 @@
 
 #include <glad/glad.h>
 #include "base/ImageUtils.h"
-#include "Render/Texture.h"
-#include "Render/OpenGL/EnumsOpenGL.h"
-#include "Render/OpenGL/OpenGLUtils.h"
+#include "render/Texture.h"
+#include "render/opengl/EnumsOpenGL.h"
+#include "render/opengl/OpenGLUtils.h"
 
 struct TextureOpenGLDesc {
   GLint internalformat;
@@ -60,7 +60,8 @@ class TextureOpenGL : public Texture {
     auto levelWidth = (int32_t) getLevelWidth(level);
     auto levelHeight = (int32_t) getLevelHeight(level);
 
-    auto *pixels = new uint8_t[levelWidth * levelHeight * 4];
+    std::vector<uint8_t> buffer((size_t) levelWidth * levelHeight * 4);
+    auto *pixels = buffer.data();
     GL_CHECK(glReadPixels(0, 0, levelWidth, levelHeight, glDesc_.format, glDesc_.type, pixels));
 
     GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
@@ -71,7 +72,6 @@ class TextureOpenGL : public Texture {
       ImageUtils::convertFloatImage(reinterpret_cast<RGBA *>(pixels), reinterpret_cast<float *>(pixels), levelWidth, levelHeight);
     }
     ImageUtils::writeImage(path, levelWidth, levelHeight, 4, pixels, levelWidth * 4, true);
-    delete[] pixels;
   }
 
  protected:
@@ -145,6 +145,23 @@ class Texture2DOpenGL : public TextureOpenGL {
     }
   }
 
+  void setImageLevelData(const std::vector<std::shared_ptr<Buffer<RGBA>>> &buffers, uint32_t level) override {
+    if (multiSample || format != TextureFormat_RGBA8) {
+      LOGE("setImageLevelData error: format not support");
+      return;
+    }
+
+    if (getLevelWidth(level) != buffers[0]->getWidth() || getLevelHeight(level) != buffers[0]->getHeight()) {
+      LOGE("setImageLevelData error: size not match");
+      return;
+    }
+
+    GL_CHECK(glBindTexture(target_, texId_));
+    GL_CHECK(glTexImage2D(target_, (GLint) level, glDesc_.internalformat, (GLsizei) buffers[0]->getWidth(),
+                          (GLsizei) buffers[0]->getHeight(), 0, glDesc_.format, glDesc_.type,
+                          buffers[0]->getRawDataPtr()));
+  }
+
   void initImageData() override {
     GL_CHECK(glBindTexture(target_, texId_));
     if (multiSample) {
@@ -230,6 +247,25 @@ class TextureCubeOpenGL : public TextureOpenGL {
     }
   }
 
+  void setImageLevelData(const std::vector<std::shared_ptr<Buffer<RGBA>>> &buffers, uint32_t level) override {
+    if (multiSample || format != TextureFormat_RGBA8) {
+      LOGE("setImageLevelData error: format not support");
+      return;
+    }
+
+    if (getLevelWidth(level) != buffers[0]->getWidth() || getLevelHeight(level) != buffers[0]->getHeight()) {
+      LOGE("setImageLevelData error: size not match");
+      return;
+    }
+
+    GL_CHECK(glBindTexture(GL_TEXTURE_CUBE_MAP, texId_));
+    for (int i = 0; i < 6; i++) {
+      GL_CHECK(glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, (GLint) level, glDesc_.internalformat,
+                            (GLsizei) buffers[i]->getWidth(), (GLsizei) buffers[i]->getHeight(), 0,
+                            glDesc_.format, glDesc_.type, buffers[i]->getRawDataPtr()));
+    }
+  }
+
   void initImageData() override {
     GL_CHECK(glBindTexture(GL_TEXTURE_CUBE_MAP, texId_));
     for (int i = 0; i < 6; i++) {
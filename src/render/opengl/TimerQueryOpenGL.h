@@ -0,0 +1,139 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <glad/glad.h>
+#include "render/opengl/OpenGLUtils.h"
+
+// gpu timing of nested ranges (render passes and draw groups) with a ring of query pools.
+// GL_TIME_ELAPSED queries can not be nested, so each range is a pair of GL_TIMESTAMP queries.
+// results are read back when available, usually a few frames later, the render thread never waits.
+class TimerQueryOpenGL {
+ public:
+  struct Range {
+    const char *name = nullptr;
+    bool pass = false;
+    double millis = 0;
+  };
+
+  explicit TimerQueryOpenGL(size_t ringSize = 4) : frames_(ringSize) {}
+
+  ~TimerQueryOpenGL() {
+    for (auto &frame : frames_) {
+      if (!frame.queries.empty()) {
+        GL_CHECK(glDeleteQueries((GLsizei) frame.queries.size(), frame.queries.data()));
+      }
+    }
+  }
+
+  // start recording a new frame. when the results of all frames in flight are still pending
+  // the frame is not timed, rather than waiting for the gpu
+  void beginFrame() {
+    frameIdx_++;
+    Frame &frame = frames_[head_];
+    recording_ = !frame.pending;
+    if (!recording_) {
+      return;
+    }
+    frame.ranges.clear();
+    frame.queryUsed = 0;
+    frame.frameIdx = frameIdx_;
+    stack_.clear();
+  }
+
+  // close the ranges of the frame and queue it for readback
+  void endFrame() {
+    if (!recording_) {
+      return;
+    }
+    while (!stack_.empty()) {
+      end();
+    }
+    Frame &frame = frames_[head_];
+    frame.pending = frame.queryUsed > 0;
+    head_ = (head_ + 1) % frames_.size();
+    recording_ = false;
+  }
+
+  // name must have static storage
+  void begin(const char *name, bool pass) {
+    if (!recording_) {
+      return;
+    }
+    Frame &frame = frames_[head_];
+    stack_.push_back(frame.ranges.size());
+    frame.ranges.push_back({name, pass, timestamp(frame), 0});
+  }
+
+  void end() {
+    if (!recording_ || stack_.empty()) {
+      return;
+    }
+    Frame &frame = frames_[head_];
+    frame.ranges[stack_.back()].endQuery = timestamp(frame);
+    stack_.pop_back();
+  }
+
+  // read back the oldest frame whose queries are all available, returns false if there is none.
+  // frameLag is the distance from that frame to the next beginFrame(), at least 1
+  bool poll(std::vector<Range> &results, uint32_t &frameLag) {
+    size_t tail = head_;
+    for (size_t i = 0; i < frames_.size(); i++) {
+      Frame &frame = frames_[(tail + i) % frames_.size()];
+      if (!frame.pending) {
+        continue;
+      }
+      GLint available = 0;
+      GL_CHECK(glGetQueryObjectiv(frame.queries[frame.queryUsed - 1], GL_QUERY_RESULT_AVAILABLE, &available));
+      if (!available) {
+        return false;
+      }
+
+      results.clear();
+      for (auto &range : frame.ranges) {
+        GLuint64 t0 = 0, t1 = 0;
+        GL_CHECK(glGetQueryObjectui64v(frame.queries[range.beginQuery], GL_QUERY_RESULT, &t0));
+        GL_CHECK(glGetQueryObjectui64v(frame.queries[range.endQuery], GL_QUERY_RESULT, &t1));
+        results.push_back({range.name, range.pass, t1 > t0 ? (double) (t1 - t0) / 1000000.0 : 0.0});
+      }
+      frameLag = (uint32_t) (frameIdx_ + 1 - frame.frameIdx);
+      frame.pending = false;
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  struct RecordedRange {
+    const char *name;
+    bool pass;
+    size_t beginQuery;
+    size_t endQuery;
+  };
+
+  struct Frame {
+    std::vector<GLuint> queries;
+    size_t queryUsed = 0;
+    std::vector<RecordedRange> ranges;
+    uint64_t frameIdx = 0;
+    bool pending = false;
+  };
+
+  size_t timestamp(Frame &frame) {
+    if (frame.queryUsed == frame.queries.size()) {
+      size_t cnt = std::max((size_t) 16, frame.queries.size());
+      frame.queries.resize(frame.queries.size() + cnt);
+      GL_CHECK(glGenQueries((GLsizei) cnt, frame.queries.data() + frame.queryUsed));
+    }
+    size_t idx = frame.queryUsed++;
+    GL_CHECK(glQueryCounter(frame.queries[idx], GL_TIMESTAMP));
+    return idx;
+  }
+
+ private:
+  std::vector<Frame> frames_;
+  size_t head_ = 0;
+  uint64_t frameIdx_ = 0;
+  bool recording_ = false;
+  std::vector<size_t> stack_;
+};
@@ -1,10 +1,10 @@
 #pragma once
 
 #include <glad/glad.h>
-#include "Base/Logger.h"
-#include "Render/Uniform.h"
-#include "Render/OpenGL/ShaderProgramOpenGL.h"
-#include "Render/OpenGL/OpenGLUtils.h"
+#include "base/Logger.h"
+#include "render/Uniform.h"
+#include "render/opengl/ShaderProgramOpenGL.h"
+#include "render/opengl/OpenGLUtils.h"
 
 #define BIND_TEX_OPENGL(n) case n: GL_CHECK(glActiveTexture(GL_TEXTURE##n)); break;
 
@@ -76,7 +76,7 @@ class UniformSamplerOpenGL : public UniformSampler {
       BIND_TEX_OPENGL(6)
       BIND_TEX_OPENGL(7)
       default: {
-        LOGE("UniformSampler::bindProgram error: texture unit not support");
+        LOGE_EVERY_N(100, "UniformSampler::bindProgram error: texture unit not support");
         break;
       }
     }
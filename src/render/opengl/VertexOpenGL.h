@@ -7,8 +7,10 @@
 #pragma once
 
 #include <glad/glad.h>
-#include "Render/Vertex.h"
-#include "Render/OpenGL/OpenGLUtils.h"
+#include "render/Vertex.h"
+#include "render/VertexUtils.h"
+#include "render/opengl/OpenGLUtils.h"
+#include "render/opengl/EnumsOpenGL.h"
 
 class VertexArrayObjectOpenGL : public VertexArrayObject {
  public:
@@ -16,7 +18,10 @@ class VertexArrayObjectOpenGL : public VertexArrayObject {
     if (!vertexArr.vertexesBuffer || !vertexArr.indexBuffer) {
       return;
     }
-    indicesCnt_ = vertexArr.indexBufferLength / sizeof(int32_t);
+    indicesCnt_ = VertexUtils::getIndexCnt(vertexArr);
+    indexType_ = OpenGL::cvtIndexType(vertexArr.indexType);
+    vertexCnt_ = vertexArr.vertexSize > 0 ? vertexArr.vertexesBufferLength / vertexArr.vertexSize : 0;
+    attributeCnt_ = vertexArr.vertexesDesc.size();
 
     // vao
     GL_CHECK(glGenVertexArrays(1, &vao_));
@@ -32,7 +37,11 @@ class VertexArrayObjectOpenGL : public VertexArrayObject {
 
     for (int i = 0; i < vertexArr.vertexesDesc.size(); i++) {
       auto &desc = vertexArr.vertexesDesc[i];
-      GL_CHECK(glVertexAttribPointer(i, desc.size, GL_FLOAT, GL_FALSE, desc.stride, (void *) desc.offset));
+      // integer types are normalized, octahedral vectors reach the shader as the 2 encoded components
+      GLboolean normalized = desc.type == VertexAttr_FLOAT || desc.type == VertexAttr_HALF ? GL_FALSE : GL_TRUE;
+      GL_CHECK(glVertexAttribPointer(i, (GLint) VertexUtils::storedComponents(desc),
+                                     OpenGL::cvtVertexAttributeType(desc.type), normalized,
+                                     desc.stride, (void *) desc.offset));
       GL_CHECK(glEnableVertexAttribArray(i));
     }
 
@@ -76,10 +85,88 @@ class VertexArrayObjectOpenGL : public VertexArrayObject {
     return indicesCnt_;
   }
 
+  inline size_t getVertexCnt() const {
+    return vertexCnt_;
+  }
+
+  inline GLenum getIndexType() const {
+    return indexType_;
+  }
+
+  // first attribute location free for instance attributes
+  inline size_t getAttributeCnt() const {
+    return attributeCnt_;
+  }
+
  private:
   GLuint vao_ = 0;
   GLuint vbo_ = 0;
   GLuint ebo_ = 0;
   size_t indicesCnt_ = 0;
+  size_t vertexCnt_ = 0;
+  size_t attributeCnt_ = 0;
+  GLenum indexType_ = GL_UNSIGNED_INT;
+};
+
+class InstanceBufferOpenGL : public InstanceBuffer {
+ public:
+  explicit InstanceBufferOpenGL(const InstanceArray &instanceArr)
+      : instanceSize_(instanceArr.instanceSize), attributes_(instanceArr.instancesDesc) {
+    GL_CHECK(glGenBuffers(1, &vbo_));
+    if (instanceArr.instancesBuffer) {
+      updateInstanceData(instanceArr.instancesBuffer, instanceArr.instancesBufferLength);
+    }
+  }
+
+  ~InstanceBufferOpenGL() {
+    if (vbo_) {
+      GL_CHECK(glDeleteBuffers(1, &vbo_));
+    }
+  }
+
+  // the previous storage is orphaned, draws still reading it are not stalled
+  void updateInstanceData(void *data, size_t length) override {
+    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, vbo_));
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, length, data, GL_STREAM_DRAW));
+    instanceCnt_ = instanceSize_ ? length / instanceSize_ : 0;
+  }
+
+  int getId() const override {
+    return (int) vbo_;
+  }
+
+  size_t getInstanceCnt() const override {
+    return instanceCnt_;
+  }
+
+  // attributes from firstLocation on advance once per instance, the vertex array object must be bound
+  inline void bind(size_t firstLocation) const {
+    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, vbo_));
+    for (size_t i = 0; i < attributes_.size(); i++) {
+      auto &desc = attributes_[i];
+      auto location = (GLuint) (firstLocation + i);
+      GLboolean normalized = desc.type == VertexAttr_FLOAT || desc.type == VertexAttr_HALF ? GL_FALSE : GL_TRUE;
+      GL_CHECK(glVertexAttribPointer(location, (GLint) VertexUtils::storedComponents(desc),
+                                     OpenGL::cvtVertexAttributeType(desc.type), normalized,
+                                     desc.stride, (void *) desc.offset));
+      GL_CHECK(glVertexAttribDivisor(location, 1));
+      GL_CHECK(glEnableVertexAttribArray(location));
+    }
+  }
+
+  // restore the vertex array object state for draws without instances
+  inline void unbind(size_t firstLocation) const {
+    for (size_t i = 0; i < attributes_.size(); i++) {
+      auto location = (GLuint) (firstLocation + i);
+      GL_CHECK(glDisableVertexAttribArray(location));
+      GL_CHECK(glVertexAttribDivisor(location, 0));
+    }
+  }
+
+ private:
+  GLuint vbo_ = 0;
+  size_t instanceSize_ = 0;
+  size_t instanceCnt_ = 0;
+  std::vector<VertexAttributeDesc> attributes_;
 };
 
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "base/UUID.h"
+#include "render/Framebuffer.h"
+#include "render/soft/TextureSoft.h"
+
+class FrameBufferSoft : public FrameBuffer {
+ public:
+  explicit FrameBufferSoft(bool offscreen) : FrameBuffer(offscreen) {}
+
+  int getId() const override {
+    return uuid_.get();
+  }
+
+  bool isValid() override {
+    return getColorBuffer() != nullptr || getDepthBuffer() != nullptr;
+  }
+
+  Buffer<RGBA> *getColorBuffer() const {
+    if (!colorReady_) {
+      return nullptr;
+    }
+    auto *tex = dynamic_cast<TextureSoft *>(colorAttachment_.tex.get());
+    return tex ? tex->getImageRGBA(colorAttachment_.layer, colorAttachment_.level) : nullptr;
+  }
+
+  Buffer<float> *getDepthBuffer() const {
+    if (!depthReady_) {
+      return nullptr;
+    }
+    auto *tex = dynamic_cast<TextureSoft *>(depthAttachment_.tex.get());
+    return tex ? tex->getImageFloat(depthAttachment_.layer, depthAttachment_.level) : nullptr;
+  }
+
+ private:
+  UUID<FrameBufferSoft> uuid_;
+};
@@ -0,0 +1,900 @@
+#include "RendererSoft.h"
+#include "FramebufferSoft.h"
+#include "TextureSoft.h"
+#include "UniformSoft.h"
+#include "ShaderProgramSoft.h"
+#include "VertexSoft.h"
+#include "base/Profiler.h"
+
+#include <atomic>
+#include <algorithm>
+
+// window positions are snapped to 1/256 pixel for exact edge functions,
+// coordinates far outside the viewport are clamped to keep 64-bit products in range
+#define SOFT_SUBPIXEL_BITS 8
+#define SOFT_SUBPIXEL_ONE (1 << SOFT_SUBPIXEL_BITS)
+#define SOFT_GUARD_BAND (float) (1 << 20)
+
+#define SOFT_VERTEX_GRAIN 1024
+// shaded vertexes of one batch of an instanced draw, bounds the vertex output storage
+#define SOFT_INSTANCE_BATCH_VERTEXES (64 * 1024)
+#define SOFT_TRIANGLE_GRAIN 512
+
+RendererSoft::RendererSoft(size_t threadCnt) {
+  if (threadCnt == 0) {
+    threadCnt = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threadPool_ = std::make_shared<ThreadPool>(threadCnt);
+  threadVaryings_.resize(threadCnt);
+  threadCounters_.resize(threadCnt);
+}
+
+// framebuffer
+std::shared_ptr<FrameBuffer> RendererSoft::createFrameBuffer(bool offscreen) {
+  return std::make_shared<FrameBufferSoft>(offscreen);
+}
+
+// texture
+std::shared_ptr<Texture> RendererSoft::createTexture(const TextureDesc &desc) {
+  return std::make_shared<TextureSoft>(desc);
+}
+
+// vertex
+std::shared_ptr<VertexArrayObject> RendererSoft::createVertexArrayObject(const VertexArray &vertexArray) {
+  return std::make_shared<VertexArrayObjectSoft>(vertexArray);
+}
+
+std::shared_ptr<InstanceBuffer> RendererSoft::createInstanceBuffer(const InstanceArray &instanceArray) {
+  return std::make_shared<InstanceBufferSoft>(instanceArray);
+}
+
+// shader program
+std::shared_ptr<ShaderProgram> RendererSoft::createShaderProgram() {
+  return std::make_shared<ShaderProgramSoft>();
+}
+
+// pipeline states
+std::shared_ptr<PipelineStates> RendererSoft::createPipelineStates(const RenderStates &renderStates) {
+  return std::make_shared<PipelineStates>(renderStates);
+}
+
+// uniform
+std::shared_ptr<UniformBlock> RendererSoft::createUniformBlock(const std::string &name, int size) {
+  return std::make_shared<UniformBlockSoft>(name, size);
+}
+
+std::shared_ptr<UniformSampler> RendererSoft::createUniformSampler(const std::string &name, const TextureDesc &desc) {
+  return std::make_shared<UniformSamplerSoft>(name, desc.type, desc.format);
+}
+
+// pipeline
+void RendererSoft::beginRenderPass(std::shared_ptr<FrameBuffer> &frameBuffer, const ClearStates &states) {
+  PROFILE_ZONE("RendererSoft::beginRenderPass");
+  beginPassStats();
+  fbo_ = dynamic_cast<FrameBufferSoft *>(frameBuffer.get());
+  colorBuffer_ = fbo_ ? fbo_->getColorBuffer() : nullptr;
+  depthBuffer_ = fbo_ ? fbo_->getDepthBuffer() : nullptr;
+
+  fbWidth_ = 0;
+  fbHeight_ = 0;
+  if (colorBuffer_) {
+    fbWidth_ = (int) colorBuffer_->getWidth();
+    fbHeight_ = (int) colorBuffer_->getHeight();
+  } else if (depthBuffer_) {
+    fbWidth_ = (int) depthBuffer_->getWidth();
+    fbHeight_ = (int) depthBuffer_->getHeight();
+  }
+  setViewPort(0, 0, fbWidth_, fbHeight_);
+
+  if (states.colorFlag && colorBuffer_) {
+    math::float4 color = clamp(states.clearColor, 0.f, 1.f) * 255.f + 0.5f;
+    colorBuffer_->setAll(RGBA(color));
+  }
+  if (states.depthFlag && depthBuffer_) {
+    depthBuffer_->setAll(states.clearDepth);
+  }
+}
+
+void RendererSoft::setViewPort(int x, int y, int width, int height) {
+  viewportX_ = x;
+  viewportY_ = y;
+  viewportWidth_ = width;
+  viewportHeight_ = height;
+}
+
+void RendererSoft::setVertexArrayObject(std::shared_ptr<VertexArrayObject> &vao) {
+  if (!vao) {
+    return;
+  }
+  vao_ = dynamic_cast<VertexArrayObjectSoft *>(vao.get());
+  stats_.stateChanges++;
+}
+
+void RendererSoft::setShaderProgram(std::shared_ptr<ShaderProgram> &program) {
+  if (!program) {
+    return;
+  }
+  shaderProgram_ = dynamic_cast<ShaderProgramSoft *>(program.get());
+  shader_ = shaderProgram_ ? shaderProgram_->getShader() : nullptr;
+  stats_.stateChanges++;
+}
+
+void RendererSoft::setShaderResources(std::shared_ptr<ShaderResources> &resources) {
+  if (!resources) {
+    return;
+  }
+  if (shaderProgram_) {
+    shaderProgram_->bindResources(*resources);
+    stats_.stateChanges++;
+  }
+}
+
+void RendererSoft::setPipelineStates(std::shared_ptr<PipelineStates> &states) {
+  if (!states) {
+    return;
+  }
+  pipelineStates_ = states.get();
+  stats_.stateChanges++;
+}
+
+void RendererSoft::draw() {
+  if (!vao_ || !shader_ || !pipelineStates_ || fbWidth_ <= 0 || fbHeight_ <= 0) {
+    return;
+  }
+  PROFILE_ZONE("RendererSoft::draw");
+  drawIndices(vao_->getIndices(), false);
+}
+
+void RendererSoft::drawRanges(const std::vector<IndexRange> &ranges) {
+  if (!vao_ || !shader_ || !pipelineStates_ || fbWidth_ <= 0 || fbHeight_ <= 0) {
+    return;
+  }
+  PROFILE_ZONE("RendererSoft::drawRanges");
+
+  // ranges are gathered into one index list, setup and binning then run as for a single draw
+  auto &indices = vao_->getIndices();
+  rangeIndices_.clear();
+  for (auto &range : ranges) {
+    size_t begin = std::min((size_t) range.offset, indices.size());
+    size_t end = std::min(begin + range.count, indices.size());
+    rangeIndices_.insert(rangeIndices_.end(), indices.begin() + (ptrdiff_t) begin, indices.begin() + (ptrdiff_t) end);
+  }
+  if (rangeIndices_.empty()) {
+    return;
+  }
+  drawIndices(rangeIndices_, true);
+}
+
+void RendererSoft::drawInstanced(std::shared_ptr<InstanceBuffer> &instances) {
+  if (!vao_ || !shader_ || !pipelineStates_ || fbWidth_ <= 0 || fbHeight_ <= 0) {
+    return;
+  }
+  auto *instanceBuffer = dynamic_cast<InstanceBufferSoft *>(instances.get());
+  if (!instanceBuffer) {
+    return;
+  }
+  drawIndicesInstanced(vao_->getIndices(), *instanceBuffer);
+}
+
+void RendererSoft::drawRangeInstanced(const IndexRange &range, std::shared_ptr<InstanceBuffer> &instances) {
+  if (!vao_ || !shader_ || !pipelineStates_ || fbWidth_ <= 0 || fbHeight_ <= 0) {
+    return;
+  }
+  auto *instanceBuffer = dynamic_cast<InstanceBufferSoft *>(instances.get());
+  if (!instanceBuffer) {
+    return;
+  }
+  auto &indices = vao_->getIndices();
+  size_t begin = std::min((size_t) range.offset, indices.size());
+  size_t end = std::min(begin + range.count, indices.size());
+  rangeIndices_.assign(indices.begin() + (ptrdiff_t) begin, indices.begin() + (ptrdiff_t) end);
+  drawIndicesInstanced(rangeIndices_, *instanceBuffer);
+}
+
+void RendererSoft::drawIndices(const std::vector<int32_t> &indices, bool referencedOnly) {
+  stats_.drawCalls++;
+  stats_.verticesShaded += processVertexes(referencedOnly ? &indices : nullptr);
+  processPrimitives(indices);
+}
+
+void RendererSoft::drawIndicesInstanced(const std::vector<int32_t> &indices, const InstanceBufferSoft &instances) {
+  size_t instanceCnt = instances.getInstanceCnt();
+  if (indices.empty() || instanceCnt == 0) {
+    return;
+  }
+  PROFILE_ZONE("RendererSoft::drawInstanced");
+
+  // referenced vertexes are compacted, vertex j of the b-th instance of a batch is shaded at b * refCnt + j
+  vertexRemap_.assign(vao_->getVertexCnt(), -1);
+  instanceVertexes_.clear();
+  instanceIndices_.resize(indices.size());
+  for (size_t i = 0; i < indices.size(); i++) {
+    int32_t &slot = vertexRemap_[indices[i]];
+    if (slot < 0) {
+      slot = (int32_t) instanceVertexes_.size();
+      instanceVertexes_.push_back(indices[i]);
+    }
+    instanceIndices_[i] = slot;
+  }
+  size_t refCnt = instanceVertexes_.size();
+
+  // vertex attributes are fetched and decoded once for all instances, instance attributes follow them
+  size_t attrCnt = std::min(vao_->getAttributes().size(), (size_t) SOFT_MAX_VERTEX_ATTRIBUTES);
+  size_t instanceAttrCnt = std::min(instances.getAttributes().size(), SOFT_MAX_VERTEX_ATTRIBUTES - attrCnt);
+  vertexAttributes_.resize(refCnt * attrCnt * 4);
+  for (size_t j = 0; j < refCnt; j++) {
+    for (size_t k = 0; k < attrCnt; k++) {
+      float *dst = &vertexAttributes_[(j * attrCnt + k) * 4];
+      const float *src = vao_->getAttribute(instanceVertexes_[j], k, dst);
+      if (src != dst) {
+        memcpy(dst, src, vao_->getAttributes()[k].size * sizeof(float));
+      }
+    }
+  }
+
+  stats_.drawCalls++;
+  stats_.instancesDrawn += instanceCnt;
+  varyingsCnt_ = shader_->getVaryingsCount();
+
+  // instances are shaded and set up in batches, one raster pass per batch instead of per instance
+  size_t batchSize = std::max((size_t) 1, (size_t) SOFT_INSTANCE_BATCH_VERTEXES / refCnt);
+  for (size_t first = 0; first < instanceCnt; first += batchSize) {
+    size_t batchCnt = std::min(batchSize, instanceCnt - first);
+    size_t shadeCnt = batchCnt * refCnt;
+
+    instanceAttributes_.resize(batchCnt * instanceAttrCnt * 4);
+    for (size_t b = 0; b < batchCnt; b++) {
+      for (size_t k = 0; k < instanceAttrCnt; k++) {
+        instances.getAttribute(first + b, k, &instanceAttributes_[(b * instanceAttrCnt + k) * 4]);
+      }
+    }
+
+    clipPositions_.resize(shadeCnt);
+    varyings_.resize(shadeCnt * varyingsCnt_);
+    pointSizes_.resize(shadeCnt);
+    parallelFor(shadeCnt, SOFT_VERTEX_GRAIN, [&](size_t begin, size_t end, size_t threadId) {
+      PROFILE_ZONE("RendererSoft::vertexShader");
+      const float *attributes[SOFT_MAX_VERTEX_ATTRIBUTES] = {};
+      for (size_t i = begin; i < end; i++) {
+        size_t b = i / refCnt;
+        size_t j = i % refCnt;
+        for (size_t k = 0; k < attrCnt; k++) {
+          attributes[k] = &vertexAttributes_[(j * attrCnt + k) * 4];
+        }
+        for (size_t k = 0; k < instanceAttrCnt; k++) {
+          attributes[attrCnt + k] = &instanceAttributes_[(b * instanceAttrCnt + k) * 4];
+        }
+        ShaderBuiltin builtin;
+        shader_->vertexShader(attributes, varyings_.data() + i * varyingsCnt_, builtin);
+        clipPositions_[i] = builtin.position;
+        pointSizes_[i] = builtin.pointSize;
+      }
+    });
+    stats_.verticesShaded += shadeCnt;
+
+    batchIndices_.resize(batchCnt * indices.size());
+    for (size_t b = 0; b < batchCnt; b++) {
+      auto base = (int32_t) (b * refCnt);
+      int32_t *dst = batchIndices_.data() + b * indices.size();
+      for (size_t i = 0; i < indices.size(); i++) {
+        dst[i] = instanceIndices_[i] + base;
+      }
+    }
+    processPrimitives(batchIndices_);
+  }
+}
+
+void RendererSoft::processPrimitives(const std::vector<int32_t> &indices) {
+  for (auto &counters : threadCounters_) {
+    counters = {};
+  }
+
+  auto &renderStates = pipelineStates_->renderStates;
+  if (renderStates.primitiveType == Primitive_TRIANGLE) {
+    stats_.trianglesIn += indices.size() / 3;
+  }
+
+  switch (renderStates.primitiveType) {
+    case Primitive_TRIANGLE:
+      switch (renderStates.polygonMode) {
+        case PolygonMode_FILL:  processTriangles(indices);      break;
+        case PolygonMode_LINE:  processLines(indices, true);    break;
+        case PolygonMode_POINT: processPoints(indices);         break;
+      }
+      break;
+    case Primitive_LINE:
+      processLines(indices, false);
+      break;
+    case Primitive_POINT:
+      processPoints(indices);
+      break;
+  }
+
+  for (auto &counters : threadCounters_) {
+    stats_.fragmentsShaded += counters.fragmentsShaded;
+    stats_.fragmentsDepthKilled += counters.fragmentsDepthKilled;
+  }
+}
+
+void RendererSoft::endRenderPass() {
+  endPassStats();
+  fbo_ = nullptr;
+  colorBuffer_ = nullptr;
+  depthBuffer_ = nullptr;
+}
+
+void RendererSoft::waitIdle() {
+  // draw() returns after all raster work finished
+}
+
+size_t RendererSoft::processVertexes(const std::vector<int32_t> *indices) {
+  PROFILE_ZONE("RendererSoft::processVertexes");
+  size_t vertexCnt = vao_->getVertexCnt();
+  size_t attrCnt = std::min(vao_->getAttributes().size(), (size_t) SOFT_MAX_VERTEX_ATTRIBUTES);
+
+  varyingsCnt_ = shader_->getVaryingsCount();
+  clipPositions_.resize(vertexCnt);
+  varyings_.resize(vertexCnt * varyingsCnt_);
+  pointSizes_.resize(vertexCnt);
+
+  // vertexes of culled ranges are skipped, their outputs are never read
+  size_t shadeCnt = vertexCnt;
+  const uint8_t *referenced = nullptr;
+  if (indices) {
+    vertexReferenced_.assign(vertexCnt, 0);
+    shadeCnt = 0;
+    for (int32_t idx : *indices) {
+      shadeCnt += vertexReferenced_[idx] ? 0 : 1;
+      vertexReferenced_[idx] = 1;
+    }
+    referenced = vertexReferenced_.data();
+  }
+
+  parallelFor(vertexCnt, SOFT_VERTEX_GRAIN, [&](size_t begin, size_t end, size_t threadId) {
+    PROFILE_ZONE("RendererSoft::vertexShader");
+    const float *attributes[SOFT_MAX_VERTEX_ATTRIBUTES] = {};
+    float decoded[SOFT_MAX_VERTEX_ATTRIBUTES][4];
+    for (size_t i = begin; i < end; i++) {
+      if (referenced && !referenced[i]) {
+        continue;
+      }
+      for (size_t k = 0; k < attrCnt; k++) {
+        attributes[k] = vao_->getAttribute(i, k, decoded[k]);
+      }
+      ShaderBuiltin builtin;
+      shader_->vertexShader(attributes, varyings_.data() + i * varyingsCnt_, builtin);
+      clipPositions_[i] = builtin.position;
+      pointSizes_[i] = builtin.pointSize;
+    }
+  });
+  return shadeCnt;
+}
+
+void RendererSoft::processTriangles(const std::vector<int32_t> &indices) {
+  size_t triangleCnt = indices.size() / 3;
+  if (triangleCnt == 0) {
+    return;
+  }
+
+  tilesX_ = (fbWidth_ + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+  tilesY_ = (fbHeight_ + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+  size_t tileCnt = (size_t) tilesX_ * tilesY_;
+
+  // setup & binning, chunks keep submission order so blending stays in draw order
+  chunkCnt_ = std::min((triangleCnt + SOFT_TRIANGLE_GRAIN - 1) / SOFT_TRIANGLE_GRAIN,
+                       threadPool_->getThreadCnt() * 4);
+  if (chunks_.size() < chunkCnt_) {
+    chunks_.resize(chunkCnt_);
+  }
+  for (size_t c = 0; c < chunkCnt_; c++) {
+    auto &chunk = chunks_[c];
+    chunk.triangles.clear();
+    chunk.bins.resize(tileCnt);
+    for (auto &bin : chunk.bins) {
+      bin.clear();
+    }
+    chunk.arena.reset();
+    chunk.culledCnt = 0;
+    chunk.clippedCnt = 0;
+  }
+
+  PROFILE_ZONE("RendererSoft::processTriangles");
+  parallelFor(chunkCnt_, 1, [&](size_t begin, size_t end, size_t threadId) {
+    PROFILE_ZONE("RendererSoft::setup");
+    for (size_t c = begin; c < end; c++) {
+      size_t triBegin = triangleCnt * c / chunkCnt_;
+      size_t triEnd = triangleCnt * (c + 1) / chunkCnt_;
+      for (size_t t = triBegin; t < triEnd; t++) {
+        ClipVertex v[3];
+        for (int k = 0; k < 3; k++) {
+          int32_t idx = indices[t * 3 + k];
+          v[k].clip = clipPositions_[idx];
+          v[k].varyings = varyings_.data() + idx * varyingsCnt_;
+        }
+        clipTriangle(v[0], v[1], v[2], chunks_[c]);
+      }
+    }
+  });
+
+  for (size_t c = 0; c < chunkCnt_; c++) {
+    stats_.trianglesCulled += chunks_[c].culledCnt;
+    stats_.trianglesClipped += chunks_[c].clippedCnt;
+  }
+
+  // rasterization
+  parallelFor(tileCnt, 1, [&](size_t begin, size_t end, size_t threadId) {
+    for (size_t tile = begin; tile < end; tile++) {
+      rasterTile(tile, threadId);
+    }
+  });
+}
+
+void RendererSoft::clipTriangle(const ClipVertex &v0, const ClipVertex &v1, const ClipVertex &v2, SetupChunk &chunk) {
+  // only the near plane (z >= -w) is clipped, the other planes are handled by the guard band and scissor
+  const ClipVertex *in[3] = {&v0, &v1, &v2};
+  float dist[3];
+  int insideCnt = 0;
+  for (int i = 0; i < 3; i++) {
+    dist[i] = in[i]->clip.z + in[i]->clip.w;
+    insideCnt += dist[i] >= 0.f ? 1 : 0;
+  }
+
+  if (insideCnt == 3) {
+    setupTriangle(in, chunk);
+    return;
+  }
+  if (insideCnt == 0) {
+    chunk.culledCnt++;
+    return;
+  }
+  chunk.clippedCnt++;
+
+  ClipVertex polygon[4];
+  int polygonCnt = 0;
+  for (int i = 0; i < 3; i++) {
+    int j = (i + 1) % 3;
+    if (dist[i] >= 0.f) {
+      polygon[polygonCnt++] = *in[i];
+    }
+    if ((dist[i] >= 0.f) != (dist[j] >= 0.f)) {
+      float t = dist[i] / (dist[i] - dist[j]);
+      ClipVertex &v = polygon[polygonCnt++];
+      v.clip = mix(in[i]->clip, in[j]->clip, t);
+      float *varyings = chunk.arena.alloc(varyingsCnt_);
+      for (size_t k = 0; k < varyingsCnt_; k++) {
+        varyings[k] = math::mix(in[i]->varyings[k], in[j]->varyings[k], t);
+      }
+      v.varyings = varyings;
+    }
+  }
+
+  for (int i = 1; i + 1 < polygonCnt; i++) {
+    const ClipVertex *tri[3] = {&polygon[0], &polygon[i], &polygon[i + 1]};
+    setupTriangle(tri, chunk);
+  }
+}
+
+math::float4 RendererSoft::toScreen(const math::float4 &clip) const {
+  float invW = 1.f / clip.w;
+  float x = (clip.x * invW * 0.5f + 0.5f) * (float) viewportWidth_ + (float) viewportX_;
+  float y = (clip.y * invW * 0.5f + 0.5f) * (float) viewportHeight_ + (float) viewportY_;
+  float z = clip.z * invW * 0.5f + 0.5f;
+  return {math::clamp(x, -SOFT_GUARD_BAND, SOFT_GUARD_BAND), math::clamp(y, -SOFT_GUARD_BAND, SOFT_GUARD_BAND), z, invW};
+}
+
+void RendererSoft::setupTriangle(const ClipVertex *v[3], SetupChunk &chunk) {
+  if (v[0]->clip.w <= 0.f || v[1]->clip.w <= 0.f || v[2]->clip.w <= 0.f) {
+    chunk.culledCnt++;
+    return;
+  }
+
+  TriangleSetup tri;
+  for (int i = 0; i < 3; i++) {
+    tri.screen[i] = toScreen(v[i]->clip);
+    tri.varyings[i] = v[i]->varyings;
+    tri.fx[i] = (int64_t) std::lround(tri.screen[i].x * SOFT_SUBPIXEL_ONE);
+    tri.fy[i] = (int64_t) std::lround(tri.screen[i].y * SOFT_SUBPIXEL_ONE);
+  }
+
+  // counter-clockwise in window space (y up) is front facing
+  tri.area = (tri.fx[1] - tri.fx[0]) * (tri.fy[2] - tri.fy[0]) - (tri.fy[1] - tri.fy[0]) * (tri.fx[2] - tri.fx[0]);
+  if (tri.area == 0) {
+    chunk.culledCnt++;
+    return;
+  }
+  tri.frontFacing = tri.area > 0;
+  if (pipelineStates_->renderStates.cullFace && !tri.frontFacing) {
+    chunk.culledCnt++;
+    return;
+  }
+  if (tri.area < 0) {
+    std::swap(tri.screen[1], tri.screen[2]);
+    std::swap(tri.varyings[1], tri.varyings[2]);
+    std::swap(tri.fx[1], tri.fx[2]);
+    std::swap(tri.fy[1], tri.fy[2]);
+    tri.area = -tri.area;
+  }
+
+  // bounds clamped to viewport and framebuffer
+  int clipMinX = std::max(viewportX_, 0);
+  int clipMinY = std::max(viewportY_, 0);
+  int clipMaxX = std::min(viewportX_ + viewportWidth_, fbWidth_) - 1;
+  int clipMaxY = std::min(viewportY_ + viewportHeight_, fbHeight_) - 1;
+
+  int64_t minFx = std::min({tri.fx[0], tri.fx[1], tri.fx[2]});
+  int64_t minFy = std::min({tri.fy[0], tri.fy[1], tri.fy[2]});
+  int64_t maxFx = std::max({tri.fx[0], tri.fx[1], tri.fx[2]});
+  int64_t maxFy = std::max({tri.fy[0], tri.fy[1], tri.fy[2]});
+  tri.minX = std::max((int) (minFx >> SOFT_SUBPIXEL_BITS), clipMinX);
+  tri.minY = std::max((int) (minFy >> SOFT_SUBPIXEL_BITS), clipMinY);
+  tri.maxX = std::min((int) (maxFx >> SOFT_SUBPIXEL_BITS), clipMaxX);
+  tri.maxY = std::min((int) (maxFy >> SOFT_SUBPIXEL_BITS), clipMaxY);
+  if (tri.minX > tri.maxX || tri.minY > tri.maxY) {
+    chunk.culledCnt++;
+    return;
+  }
+
+  // binning
+  auto triIdx = (uint32_t) chunk.triangles.size();
+  chunk.triangles.push_back(tri);
+  for (int ty = tri.minY / SOFT_TILE_SIZE; ty <= tri.maxY / SOFT_TILE_SIZE; ty++) {
+    for (int tx = tri.minX / SOFT_TILE_SIZE; tx <= tri.maxX / SOFT_TILE_SIZE; tx++) {
+      chunk.bins[ty * tilesX_ + tx].push_back(triIdx);
+    }
+  }
+}
+
+void RendererSoft::rasterTile(size_t tileIdx, size_t threadId) {
+  PROFILE_ZONE("RendererSoft::rasterTile");
+  int x0 = (int) (tileIdx % tilesX_) * SOFT_TILE_SIZE;
+  int y0 = (int) (tileIdx / tilesX_) * SOFT_TILE_SIZE;
+  int x1 = std::min(x0 + SOFT_TILE_SIZE, fbWidth_) - 1;
+  int y1 = std::min(y0 + SOFT_TILE_SIZE, fbHeight_) - 1;
+
+  auto &varyings = threadVaryings_[threadId];
+  varyings.resize(varyingsCnt_);
+
+  // counted locally, the per thread counters share cache lines and are only touched once per tile
+  RasterCounters counters;
+  for (size_t c = 0; c < chunkCnt_; c++) {
+    auto &chunk = chunks_[c];
+    for (uint32_t triIdx : chunk.bins[tileIdx]) {
+      rasterTriangle(chunk.triangles[triIdx], x0, y0, x1, y1, varyings.data(), counters);
+    }
+  }
+  threadCounters_[threadId].fragmentsShaded += counters.fragmentsShaded;
+  threadCounters_[threadId].fragmentsDepthKilled += counters.fragmentsDepthKilled;
+}
+
+void RendererSoft::rasterTriangle(const TriangleSetup &tri, int x0, int y0, int x1, int y1, float *varyings,
+                                  RasterCounters &counters) {
+  int minX = std::max(tri.minX, x0);
+  int minY = std::max(tri.minY, y0);
+  int maxX = std::min(tri.maxX, x1);
+  int maxY = std::min(tri.maxY, y1);
+  if (minX > maxX || minY > maxY) {
+    return;
+  }
+
+  // edge i is opposite to vertex i, its value at a pixel is the barycentric weight of vertex i scaled by area
+  int64_t stepX[3], stepY[3], rowStart[3], bias[3];
+  int64_t px = (int64_t) minX * SOFT_SUBPIXEL_ONE + SOFT_SUBPIXEL_ONE / 2;
+  int64_t py = (int64_t) minY * SOFT_SUBPIXEL_ONE + SOFT_SUBPIXEL_ONE / 2;
+  for (int i = 0; i < 3; i++) {
+    int a = (i + 1) % 3;
+    int b = (i + 2) % 3;
+    int64_t dx = tri.fx[b] - tri.fx[a];
+    int64_t dy = tri.fy[b] - tri.fy[a];
+    stepX[i] = -dy * SOFT_SUBPIXEL_ONE;
+    stepY[i] = dx * SOFT_SUBPIXEL_ONE;
+    rowStart[i] = dx * (py - tri.fy[a]) - dy * (px - tri.fx[a]);
+
+    // top-left rule: pixels exactly on an edge belong to the triangle only for top and left edges
+    bool topLeft = dy < 0 || (dy == 0 && dx < 0);
+    bias[i] = topLeft ? 0 : -1;
+  }
+
+  float invArea = 1.f / (float) tri.area;
+  bool testDepth = pipelineStates_->renderStates.depthTest && depthBuffer_;
+
+  for (int y = minY; y <= maxY; y++) {
+    int64_t e0 = rowStart[0];
+    int64_t e1 = rowStart[1];
+    int64_t e2 = rowStart[2];
+    for (int x = minX; x <= maxX; x++, e0 += stepX[0], e1 += stepX[1], e2 += stepX[2]) {
+      if (((e0 + bias[0]) | (e1 + bias[1]) | (e2 + bias[2])) < 0) {
+        continue;
+      }
+
+      float w0 = (float) e0 * invArea;
+      float w1 = (float) e1 * invArea;
+      float w2 = 1.f - w0 - w1;
+      float z = w0 * tri.screen[0].z + w1 * tri.screen[1].z + w2 * tri.screen[2].z;
+      if (z > 1.f) {
+        continue;
+      }
+
+      // early depth test, shaders can not write depth
+      if (testDepth && !depthTest(z, *depthBuffer_->get(x, y))) {
+        counters.fragmentsDepthKilled++;
+        continue;
+      }
+
+      // perspective correct interpolation
+      float p0 = w0 * tri.screen[0].w;
+      float p1 = w1 * tri.screen[1].w;
+      float p2 = w2 * tri.screen[2].w;
+      float invW = p0 + p1 + p2;
+      float norm = 1.f / invW;
+      p0 *= norm;
+      p1 *= norm;
+      p2 *= norm;
+      for (size_t k = 0; k < varyingsCnt_; k++) {
+        varyings[k] = p0 * tri.varyings[0][k] + p1 * tri.varyings[1][k] + p2 * tri.varyings[2][k];
+      }
+
+      shadeFragment(x, y, z, invW, varyings, tri.frontFacing);
+      counters.fragmentsShaded++;
+    }
+    rowStart[0] += stepY[0];
+    rowStart[1] += stepY[1];
+    rowStart[2] += stepY[2];
+  }
+}
+
+void RendererSoft::processLines(const std::vector<int32_t> &indices, bool fromTriangles) {
+  // lines are rare (debug drawing, wireframe), rasterized on the calling thread
+  PROFILE_ZONE("RendererSoft::processLines");
+  auto &varyings = threadVaryings_[0];
+  auto &counters = threadCounters_[0];
+  varyings.resize(varyingsCnt_);
+
+  auto vertex = [&](int32_t idx) -> ClipVertex {
+    return {clipPositions_[idx], varyings_.data() + idx * varyingsCnt_};
+  };
+
+  if (fromTriangles) {
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+      ClipVertex v[3] = {vertex(indices[i]), vertex(indices[i + 1]), vertex(indices[i + 2])};
+      if (pipelineStates_->renderStates.cullFace) {
+        auto s0 = toScreen(v[0].clip), s1 = toScreen(v[1].clip), s2 = toScreen(v[2].clip);
+        float area = (s1.x - s0.x) * (s2.y - s0.y) - (s1.y - s0.y) * (s2.x - s0.x);
+        if (area <= 0.f && v[0].clip.w > 0.f && v[1].clip.w > 0.f && v[2].clip.w > 0.f) {
+          continue;
+        }
+      }
+      rasterLine(v[0], v[1], varyings.data(), counters);
+      rasterLine(v[1], v[2], varyings.data(), counters);
+      rasterLine(v[2], v[0], varyings.data(), counters);
+    }
+  } else {
+    for (size_t i = 0; i + 1 < indices.size(); i += 2) {
+      rasterLine(vertex(indices[i]), vertex(indices[i + 1]), varyings.data(), counters);
+    }
+  }
+}
+
+void RendererSoft::rasterLine(const ClipVertex &v0, const ClipVertex &v1, float *varyings, RasterCounters &counters) {
+  float d0 = v0.clip.z + v0.clip.w;
+  float d1 = v1.clip.z + v1.clip.w;
+  if (d0 < 0.f && d1 < 0.f) {
+    return;
+  }
+
+  // clip against near plane by parameter range
+  float t0 = 0.f;
+  float t1 = 1.f;
+  if (d0 < 0.f) {
+    t0 = d0 / (d0 - d1);
+  } else if (d1 < 0.f) {
+    t1 = d0 / (d0 - d1);
+  }
+  math::float4 c0 = mix(v0.clip, v1.clip, t0);
+  math::float4 c1 = mix(v0.clip, v1.clip, t1);
+  if (c0.w <= 0.f || c1.w <= 0.f) {
+    return;
+  }
+  math::float4 s0 = toScreen(c0);
+  math::float4 s1 = toScreen(c1);
+
+  int clipMinX = std::max(viewportX_, 0);
+  int clipMinY = std::max(viewportY_, 0);
+  int clipMaxX = std::min(viewportX_ + viewportWidth_, fbWidth_) - 1;
+  int clipMaxY = std::min(viewportY_ + viewportHeight_, fbHeight_) - 1;
+  bool testDepth = pipelineStates_->renderStates.depthTest && depthBuffer_;
+
+  // dda in window space with perspective correct parameter
+  float dx = s1.x - s0.x;
+  float dy = s1.y - s0.y;
+  int steps = std::max(1, (int) std::ceil(std::max(std::abs(dx), std::abs(dy))));
+  steps = std::min(steps, 4 * std::max(fbWidth_, fbHeight_));
+  for (int s = 0; s <= steps; s++) {
+    float a = (float) s / (float) steps;
+    int x = (int) std::floor(s0.x + dx * a);
+    int y = (int) std::floor(s0.y + dy * a);
+    if (x < clipMinX || x > clipMaxX || y < clipMinY || y > clipMaxY) {
+      continue;
+    }
+    float z = math::mix(s0.z, s1.z, a);
+    if (z > 1.f) {
+      continue;
+    }
+    if (testDepth && !depthTest(z, *depthBuffer_->get(x, y))) {
+      counters.fragmentsDepthKilled++;
+      continue;
+    }
+
+    float invW = math::mix(s0.w, s1.w, a);
+    float t = math::mix(t0, t1, a * s1.w / invW);
+    for (size_t k = 0; k < varyingsCnt_; k++) {
+      varyings[k] = math::mix(v0.varyings[k], v1.varyings[k], t);
+    }
+    shadeFragment(x, y, z, invW, varyings, true);
+    counters.fragmentsShaded++;
+  }
+}
+
+void RendererSoft::processPoints(const std::vector<int32_t> &indices) {
+  PROFILE_ZONE("RendererSoft::processPoints");
+  int clipMinX = std::max(viewportX_, 0);
+  int clipMinY = std::max(viewportY_, 0);
+  int clipMaxX = std::min(viewportX_ + viewportWidth_, fbWidth_) - 1;
+  int clipMaxY = std::min(viewportY_ + viewportHeight_, fbHeight_) - 1;
+  bool testDepth = pipelineStates_->renderStates.depthTest && depthBuffer_;
+  auto &counters = threadCounters_[0];
+
+  for (int32_t idx : indices) {
+    auto &clip = clipPositions_[idx];
+    if (clip.z + clip.w < 0.f || clip.w <= 0.f) {
+      continue;
+    }
+    math::float4 s = toScreen(clip);
+    if (s.z > 1.f) {
+      continue;
+    }
+    const float *varyings = varyings_.data() + idx * varyingsCnt_;
+    float half = std::max(pointSizes_[idx], 1.f) * 0.5f;
+    int minX = std::max((int) std::floor(s.x - half + 0.5f), clipMinX);
+    int minY = std::max((int) std::floor(s.y - half + 0.5f), clipMinY);
+    int maxX = std::min((int) std::floor(s.x + half - 0.5f), clipMaxX);
+    int maxY = std::min((int) std::floor(s.y + half - 0.5f), clipMaxY);
+    for (int y = minY; y <= maxY; y++) {
+      for (int x = minX; x <= maxX; x++) {
+        if (testDepth && !depthTest(s.z, *depthBuffer_->get(x, y))) {
+          counters.fragmentsDepthKilled++;
+          continue;
+        }
+        shadeFragment(x, y, s.z, s.w, varyings, true);
+        counters.fragmentsShaded++;
+      }
+    }
+  }
+}
+
+void RendererSoft::shadeFragment(int x, int y, float z, float invW, const float *varyings, bool frontFacing) {
+  auto &renderStates = pipelineStates_->renderStates;
+
+  ShaderBuiltin builtin;
+  builtin.fragCoord = {(float) x + 0.5f, (float) y + 0.5f, z, invW};
+  builtin.frontFacing = frontFacing;
+  shader_->fragmentShader(varyings, builtin);
+  if (builtin.discard) {
+    return;
+  }
+
+  if (renderStates.depthTest && renderStates.depthMask && depthBuffer_) {
+    *depthBuffer_->get(x, y) = z;
+  }
+
+  if (colorBuffer_) {
+    RGBA *dst = colorBuffer_->get(x, y);
+    math::float4 color = clamp(builtin.fragColor, 0.f, 1.f);
+    if (renderStates.blend) {
+      color = blend(color, math::float4(*dst) * (1.f / 255.f));
+    }
+    *dst = RGBA(color * 255.f + 0.5f);
+  }
+}
+
+bool RendererSoft::depthTest(float z, float depth) const {
+  switch (pipelineStates_->renderStates.depthFunc) {
+    case DepthFunc_NEVER:     return false;
+    case DepthFunc_LESS:      return z < depth;
+    case DepthFunc_EQUAL:     return z == depth;
+    case DepthFunc_LEQUAL:    return z <= depth;
+    case DepthFunc_GREATER:   return z > depth;
+    case DepthFunc_NOTEQUAL:  return z != depth;
+    case DepthFunc_GEQUAL:    return z >= depth;
+    case DepthFunc_ALWAYS:    return true;
+  }
+  return z < depth;
+}
+
+static math::float4 blendFactor(BlendFactor factor, const math::float4 &src, const math::float4 &dst) {
+  switch (factor) {
+    case BlendFactor_ZERO:                return math::float4(0.f);
+    case BlendFactor_ONE:                 return math::float4(1.f);
+    case BlendFactor_SRC_COLOR:           return src;
+    case BlendFactor_SRC_ALPHA:           return math::float4(src.a);
+    case BlendFactor_DST_COLOR:           return dst;
+    case BlendFactor_DST_ALPHA:           return math::float4(dst.a);
+    case BlendFactor_ONE_MINUS_SRC_COLOR: return 1.f - src;
+    case BlendFactor_ONE_MINUS_SRC_ALPHA: return math::float4(1.f - src.a);
+    case BlendFactor_ONE_MINUS_DST_COLOR: return 1.f - dst;
+    case BlendFactor_ONE_MINUS_DST_ALPHA: return math::float4(1.f - dst.a);
+  }
+  return math::float4(1.f);
+}
+
+static math::float4 blendFunction(BlendFunction func, const math::float4 &src, const math::float4 &dst,
+                                  const math::float4 &srcFactor, const math::float4 &dstFactor) {
+  switch (func) {
+    case BlendFunc_ADD:               return src * srcFactor + dst * dstFactor;
+    case BlendFunc_SUBTRACT:          return src * srcFactor - dst * dstFactor;
+    case BlendFunc_REVERSE_SUBTRACT:  return dst * dstFactor - src * srcFactor;
+    case BlendFunc_MIN:               return min(src, dst);
+    case BlendFunc_MAX:               return max(src, dst);
+  }
+  return src;
+}
+
+math::float4 RendererSoft::blend(const math::float4 &src, const math::float4 &dst) const {
+  auto &params = pipelineStates_->renderStates.blendParams;
+  math::float4 rgb = blendFunction(params.blendFuncRgb, src, dst,
+                                   blendFactor(params.blendSrcRgb, src, dst),
+                                   blendFactor(params.blendDstRgb, src, dst));
+  math::float4 alpha = blendFunction(params.blendFuncAlpha, src, dst,
+                                     blendFactor(params.blendSrcAlpha, src, dst),
+                                     blendFactor(params.blendDstAlpha, src, dst));
+  return clamp(math::float4(rgb.r, rgb.g, rgb.b, alpha.a), 0.f, 1.f);
+}
+
+void RendererSoft::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t, size_t)> &func) {
+  if (count == 0) {
+    return;
+  }
+  size_t threadCnt = threadPool_->getThreadCnt();
+  if (count <= grain || threadCnt <= 1) {
+    func(0, count, 0);
+    return;
+  }
+
+  // workers grab slices from a shared counter, balancing uneven tiles
+  std::atomic<size_t> next{0};
+  size_t taskCnt = std::min(threadCnt, (count + grain - 1) / grain);
+  for (size_t i = 0; i < taskCnt; i++) {
+    threadPool_->pushTaskIndexed([&](size_t threadId) {
+      PROFILE_ZONE("RendererSoft::worker");
+      size_t begin;
+      while ((begin = next.fetch_add(grain)) < count) {
+        func(begin, std::min(begin + grain, count), threadId);
+      }
+    });
+  }
+  threadPool_->waitTasksFinish();
+}
+
+float *RendererSoft::VaryingsArena::alloc(size_t cnt) {
+  if (cnt == 0) {
+    return nullptr;
+  }
+  // blocks kept from earlier draws are skipped while too small, oversized requests get their own block
+  while (blockIdx < blocks.size() && blockUsed + cnt > capacities[blockIdx]) {
+    blockIdx++;
+    blockUsed = 0;
+  }
+  if (blockIdx >= blocks.size()) {
+    size_t capacity = std::max(BLOCK_SIZE, cnt);
+    blocks.emplace_back(new float[capacity]);
+    capacities.push_back(capacity);
+    blockUsed = 0;
+  }
+  float *ret = blocks[blockIdx].get() + blockUsed;
+  blockUsed += cnt;
+  return ret;
+}
+
+void RendererSoft::VaryingsArena::reset() {
+  blockIdx = 0;
+  blockUsed = 0;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include "base/ThreadPool.h"
+#include "render/Renderer.h"
+#include "render/soft/FramebufferSoft.h"
+#include "render/soft/ShaderProgramSoft.h"
+#include "render/soft/VertexSoft.h"
+
+// screen is split into tiles of SOFT_TILE_SIZE^2 pixels, triangles are binned to the tiles
+// they overlap and each tile is rasterized by one thread, so pixel writes need no locking.
+#define SOFT_TILE_SIZE 64
+
+class RendererSoft : public Renderer
+{
+public:
+    // threadCnt 0: one thread per hardware core
+    explicit RendererSoft(size_t threadCnt = 0);
+
+    RendererType type() override { return Renderer_SOFT; }
+
+    // framebuffer
+    std::shared_ptr<FrameBuffer> createFrameBuffer(bool offscreen) override;
+
+    // texture
+    std::shared_ptr<Texture> createTexture(const TextureDesc& desc) override;
+
+    // vertex
+    std::shared_ptr<VertexArrayObject> createVertexArrayObject(const VertexArray& vertexArray) override;
+    std::shared_ptr<InstanceBuffer> createInstanceBuffer(const InstanceArray& instanceArray) override;
+
+    // shader program
+    std::shared_ptr<ShaderProgram> createShaderProgram() override;
+
+    // pipeline states
+    std::shared_ptr<PipelineStates> createPipelineStates(const RenderStates& renderStates) override;
+
+    // uniform
+    std::shared_ptr<UniformBlock> createUniformBlock(const std::string& name, int size) override;
+    std::shared_ptr<UniformSampler> createUniformSampler(const std::string& name, const TextureDesc& desc) override;
+
+    // pipeline
+    void beginRenderPass(std::shared_ptr<FrameBuffer>& frameBuffer, const ClearStates& states) override;
+    void setViewPort(int x, int y, int width, int height) override;
+    void setVertexArrayObject(std::shared_ptr<VertexArrayObject>& vao) override;
+    void setShaderProgram(std::shared_ptr<ShaderProgram>& program) override;
+    void setShaderResources(std::shared_ptr<ShaderResources>& resources) override;
+    void setPipelineStates(std::shared_ptr<PipelineStates>& states) override;
+    void draw() override;
+    void drawRanges(const std::vector<IndexRange>& ranges) override;
+    void drawInstanced(std::shared_ptr<InstanceBuffer>& instances) override;
+    void drawRangeInstanced(const IndexRange& range, std::shared_ptr<InstanceBuffer>& instances) override;
+    void endRenderPass() override;
+    void waitIdle() override;
+
+private:
+    struct ClipVertex
+    {
+        math::float4 clip;
+        const float* varyings;
+    };
+
+    struct TriangleSetup
+    {
+        math::float4 screen[3];     // window x, y, z and 1/w
+        const float* varyings[3];
+        int64_t fx[3];              // window position in 24.8 fixed point
+        int64_t fy[3];
+        int64_t area;
+        int minX, minY, maxX, maxY; // pixel bounds, inclusive
+        bool frontFacing;
+    };
+
+    // storage of varyings created by clipping, pointers stay valid until reset()
+    struct VaryingsArena
+    {
+        static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+        float* alloc(size_t cnt);
+        void reset();
+
+        std::vector<std::unique_ptr<float[]>> blocks;
+        std::vector<size_t> capacities;     // floats of each block
+        size_t blockIdx = 0;
+        size_t blockUsed = 0;
+    };
+
+    // triangles set up by one worker, bins keep triangle indices per tile in submission order
+    struct SetupChunk
+    {
+        std::vector<TriangleSetup> triangles;
+        std::vector<std::vector<uint32_t>> bins;
+        VaryingsArena arena;
+        uint64_t culledCnt = 0;
+        uint64_t clippedCnt = 0;
+    };
+
+    // fragment counters of one worker thread
+    struct RasterCounters
+    {
+        uint64_t fragmentsShaded = 0;
+        uint64_t fragmentsDepthKilled = 0;
+    };
+
+    void drawIndices(const std::vector<int32_t>& indices, bool referencedOnly);
+    void drawIndicesInstanced(const std::vector<int32_t>& indices, const InstanceBufferSoft& instances);
+    void processPrimitives(const std::vector<int32_t>& indices);
+
+    // shade all vertexes or only those referenced by indices, returns the shaded count
+    size_t processVertexes(const std::vector<int32_t>* indices);
+    void processTriangles(const std::vector<int32_t>& indices);
+    void processLines(const std::vector<int32_t>& indices, bool fromTriangles);
+    void processPoints(const std::vector<int32_t>& indices);
+
+    void clipTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, SetupChunk& chunk);
+    void setupTriangle(const ClipVertex* v[3], SetupChunk& chunk);
+    void rasterTile(size_t tileIdx, size_t threadId);
+    void rasterTriangle(const TriangleSetup& tri, int x0, int y0, int x1, int y1, float* varyings,
+                        RasterCounters& counters);
+    void rasterLine(const ClipVertex& v0, const ClipVertex& v1, float* varyings, RasterCounters& counters);
+
+    math::float4 toScreen(const math::float4& clip) const;
+    void shadeFragment(int x, int y, float z, float invW, const float* varyings, bool frontFacing);
+    bool depthTest(float z, float depth) const;
+    math::float4 blend(const math::float4& src, const math::float4& dst) const;
+
+    // run func(begin, end, threadId) over [0, count) on the thread pool in slices of grain
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t, size_t)>& func);
+
+private:
+    std::shared_ptr<ThreadPool> threadPool_;
+
+    FrameBufferSoft* fbo_ = nullptr;
+    Buffer<RGBA>* colorBuffer_ = nullptr;
+    Buffer<float>* depthBuffer_ = nullptr;
+    int fbWidth_ = 0;
+    int fbHeight_ = 0;
+
+    int viewportX_ = 0;
+    int viewportY_ = 0;
+    int viewportWidth_ = 0;
+    int viewportHeight_ = 0;
+
+    VertexArrayObjectSoft* vao_ = nullptr;
+    ShaderProgramSoft* shaderProgram_ = nullptr;
+    ShaderSoft* shader_ = nullptr;
+    PipelineStates* pipelineStates_ = nullptr;
+
+    // indices of drawRanges() and the vertexes they reference
+    std::vector<int32_t> rangeIndices_;
+    std::vector<uint8_t> vertexReferenced_;
+
+    // instanced draws: referenced vertexes with their decoded attributes, indices into them and the
+    // index list of one batch of instances
+    std::vector<int32_t> instanceVertexes_;
+    std::vector<int32_t> vertexRemap_;
+    std::vector<int32_t> instanceIndices_;
+    std::vector<int32_t> batchIndices_;
+    std::vector<float> vertexAttributes_;
+    std::vector<float> instanceAttributes_;
+
+    // per draw vertex shader output
+    size_t varyingsCnt_ = 0;
+    std::vector<math::float4> clipPositions_;
+    std::vector<float> varyings_;
+    std::vector<float> pointSizes_;
+
+    // per draw triangle setup and binning
+    int tilesX_ = 0;
+    int tilesY_ = 0;
+    std::vector<SetupChunk> chunks_;
+    size_t chunkCnt_ = 0;
+
+    // per thread interpolated varyings and counters
+    std::vector<std::vector<float>> threadVaryings_;
+    std::vector<RasterCounters> threadCounters_;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <set>
+#include <memory>
+#include "base/UUID.h"
+#include "render/ShaderProgram.h"
+#include "render/soft/TextureSoft.h"
+
+#define SOFT_MAX_VERTEX_ATTRIBUTES 8
+
+struct ShaderBuiltin {
+  // vertex shader output
+  math::float4 position = math::float4(0.f);
+  float pointSize = 1.f;
+
+  // fragment shader input
+  math::float4 fragCoord = math::float4(0.f);
+  bool frontFacing = true;
+
+  // fragment shader output
+  math::float4 fragColor = math::float4(0.f);
+  bool discard = false;
+};
+
+// shader of the software renderer, implemented in C++.
+// vertexShader() and fragmentShader() are called concurrently from the raster threads,
+// so they must not modify the shader, uniforms and samplers are set before draw.
+class ShaderSoft {
+ public:
+  virtual ~ShaderSoft() = default;
+
+  // float count of varyings written by vertexShader(), interpolated for fragmentShader()
+  virtual size_t getVaryingsCount() const = 0;
+
+  virtual int getUniformLocation(const std::string &name) = 0;
+  virtual void setUniformData(int location, const void *data, size_t size) = 0;
+  virtual void setSampler(int location, TextureSoft *tex) {}
+
+  virtual void vertexShader(const float *const *attributes, float *varyings, ShaderBuiltin &builtin) const = 0;
+  virtual void fragmentShader(const float *varyings, ShaderBuiltin &builtin) const = 0;
+
+ public:
+  std::set<std::string> defines;
+};
+
+class ShaderProgramSoft : public ShaderProgram {
+ public:
+  int getId() const override {
+    return uuid_.get();
+  }
+
+  void addDefine(const std::string &def) override {
+    defines_.insert(def);
+    if (shader_) {
+      shader_->defines.insert(def);
+    }
+  }
+
+  void setShader(const std::shared_ptr<ShaderSoft> &shader) {
+    shader_ = shader;
+    if (shader_) {
+      shader_->defines.insert(defines_.begin(), defines_.end());
+    }
+    uniformLocations_.clear();
+  }
+
+  inline ShaderSoft *getShader() const {
+    return shader_.get();
+  }
+
+ private:
+  UUID<ShaderProgramSoft> uuid_;
+  std::set<std::string> defines_;
+  std::shared_ptr<ShaderSoft> shader_;
+};
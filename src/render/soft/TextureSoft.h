@@ -0,0 +1,215 @@
+#pragma once
+
+#include <vector>
+#include "base/UUID.h"
+#include "base/ImageUtils.h"
+#include "render/Texture.h"
+
+class TextureSoft : public Texture {
+ public:
+  explicit TextureSoft(const TextureDesc &desc) {
+    width = desc.width;
+    height = desc.height;
+    type = desc.type;
+    format = desc.format;
+    usage = desc.usage;
+    useMipmaps = desc.useMipmaps;
+    multiSample = false;   // not supported, rendered as single sample
+    tag = desc.tag;
+
+    layerCount_ = type == TextureType_CUBE ? 6 : 1;
+    rgba_.resize(layerCount_);
+    float_.resize(layerCount_);
+  }
+
+  int getId() const override {
+    return uuid_.get();
+  }
+
+  void setSamplerDesc(SamplerDesc &sampler) override {
+    sampler_ = sampler;
+  }
+
+  void initImageData() override {
+    for (uint32_t layer = 0; layer < layerCount_; layer++) {
+      if (format == TextureFormat_RGBA8) {
+        rgba_[layer] = {Buffer<RGBA>::makeDefault(width, height)};
+        rgba_[layer][0]->clear();
+      } else {
+        float_[layer] = {Buffer<float>::makeDefault(width, height)};
+        float_[layer][0]->clear();
+      }
+    }
+  }
+
+  void setImageData(const std::vector<std::shared_ptr<Buffer<RGBA>>> &buffers) override {
+    if (format != TextureFormat_RGBA8) {
+      LOGE("setImageData error: format not match");
+      return;
+    }
+    for (uint32_t layer = 0; layer < layerCount_ && layer < buffers.size(); layer++) {
+      if (width != buffers[layer]->getWidth() || height != buffers[layer]->getHeight()) {
+        LOGE("setImageData error: size not match");
+        return;
+      }
+      rgba_[layer] = useMipmaps ? ImageUtils::generateMipmaps(buffers[layer])
+                                : std::vector<std::shared_ptr<Buffer<RGBA>>>{buffers[layer]};
+    }
+  }
+
+  void setImageData(const std::vector<std::shared_ptr<Buffer<float>>> &buffers) override {
+    if (format != TextureFormat_FLOAT32) {
+      LOGE("setImageData error: format not match");
+      return;
+    }
+    for (uint32_t layer = 0; layer < layerCount_ && layer < buffers.size(); layer++) {
+      float_[layer] = {buffers[layer]};
+    }
+  }
+
+  void setImageLevelData(const std::vector<std::shared_ptr<Buffer<RGBA>>> &buffers, uint32_t level) override {
+    if (format != TextureFormat_RGBA8) {
+      LOGE("setImageLevelData error: format not match");
+      return;
+    }
+    for (uint32_t layer = 0; layer < layerCount_ && layer < buffers.size(); layer++) {
+      if (getLevelWidth(level) != buffers[layer]->getWidth() || getLevelHeight(level) != buffers[layer]->getHeight()) {
+        LOGE("setImageLevelData error: size not match");
+        return;
+      }
+      auto &levels = rgba_[layer];
+      if (levels.size() <= level) {
+        levels.resize(level + 1);
+      }
+      levels[level] = buffers[layer];
+    }
+  }
+
+  void dumpImage(const char *path, uint32_t layer, uint32_t level) override {
+    auto levelWidth = (int32_t) getLevelWidth(level);
+    auto levelHeight = (int32_t) getLevelHeight(level);
+
+    if (format == TextureFormat_FLOAT32) {
+      auto *buffer = getImageFloat(layer, level);
+      if (!buffer) {
+        return;
+      }
+      std::vector<RGBA> pixels((size_t) levelWidth * levelHeight);
+      ImageUtils::convertFloatImage(pixels.data(), buffer->getRawDataPtr(), levelWidth, levelHeight);
+      ImageUtils::writeImage(path, levelWidth, levelHeight, 4, pixels.data(), levelWidth * 4, true);
+    } else {
+      auto *buffer = getImageRGBA(layer, level);
+      if (!buffer) {
+        return;
+      }
+      ImageUtils::writeImage(path, levelWidth, levelHeight, 4, buffer->getRawDataPtr(), levelWidth * 4, true);
+    }
+  }
+
+  inline Buffer<RGBA> *getImageRGBA(uint32_t layer = 0, uint32_t level = 0) const {
+    if (layer >= rgba_.size() || level >= rgba_[layer].size()) {
+      return nullptr;
+    }
+    return rgba_[layer][level].get();
+  }
+
+  inline Buffer<float> *getImageFloat(uint32_t layer = 0, uint32_t level = 0) const {
+    if (layer >= float_.size() || level >= float_[layer].size()) {
+      return nullptr;
+    }
+    return float_[layer][level].get();
+  }
+
+  inline uint32_t getLevelCount() const {
+    return rgba_[0].empty() ? (float_[0].empty() ? 0 : 1) : (uint32_t) rgba_[0].size();
+  }
+
+  inline const SamplerDesc &getSamplerDesc() const {
+    return sampler_;
+  }
+
+  // bilinear (or nearest) sample of a 2D RGBA8 texture with normalized [0, 1] output, uv origin at bottom-left
+  math::float4 sample2D(const math::float2 &uv, float lod = 0.f, uint32_t layer = 0) const {
+    bool mip = sampler_.filterMin >= Filter_NEAREST_MIPMAP_NEAREST && rgba_[layer].size() > 1;
+    auto level = mip ? (uint32_t) math::clamp((int) (lod + 0.5f), 0, (int) rgba_[layer].size() - 1) : 0;
+    auto *buffer = getImageRGBA(layer, level);
+    if (!buffer) {
+      return {0.f, 0.f, 0.f, 1.f};
+    }
+
+    bool linear = lod > 0.f && mip ? (sampler_.filterMin == Filter_LINEAR_MIPMAP_LINEAR
+                                          || sampler_.filterMin == Filter_LINEAR_MIPMAP_NEAREST
+                                          || sampler_.filterMin == Filter_LINEAR)
+                                   : sampler_.filterMag == Filter_LINEAR;
+    auto w = (int) buffer->getWidth();
+    auto h = (int) buffer->getHeight();
+    float fx = uv.x * (float) w - 0.5f;
+    float fy = uv.y * (float) h - 0.5f;
+
+    if (!linear) {
+      return texel(*buffer, (int) std::floor(fx + 0.5f), (int) std::floor(fy + 0.5f));
+    }
+
+    int x0 = (int) std::floor(fx);
+    int y0 = (int) std::floor(fy);
+    float tx = fx - (float) x0;
+    float ty = fy - (float) y0;
+    math::float4 c00 = texel(*buffer, x0, y0);
+    math::float4 c10 = texel(*buffer, x0 + 1, y0);
+    math::float4 c01 = texel(*buffer, x0, y0 + 1);
+    math::float4 c11 = texel(*buffer, x0 + 1, y0 + 1);
+    return mix(mix(c00, c10, tx), mix(c01, c11, tx), ty);
+  }
+
+  // nearest sample of a depth texture
+  float sampleDepth(const math::float2 &uv) const {
+    auto *buffer = getImageFloat(0, 0);
+    if (!buffer) {
+      return 1.f;
+    }
+    auto x = math::clamp((int) (uv.x * (float) buffer->getWidth()), 0, (int) buffer->getWidth() - 1);
+    auto y = math::clamp((int) (uv.y * (float) buffer->getHeight()), 0, (int) buffer->getHeight() - 1);
+    return *buffer->get(x, y);
+  }
+
+ private:
+  static int wrap(int i, int size, WrapMode mode) {
+    switch (mode) {
+      case Wrap_REPEAT:
+        i %= size;
+        return i < 0 ? i + size : i;
+      case Wrap_MIRRORED_REPEAT: {
+        int period = size * 2;
+        i %= period;
+        i = i < 0 ? i + period : i;
+        return i < size ? i : period - 1 - i;
+      }
+      case Wrap_CLAMP_TO_EDGE:
+      default:
+        return math::clamp(i, 0, size - 1);
+    }
+  }
+
+  math::float4 texel(const Buffer<RGBA> &buffer, int x, int y) const {
+    auto w = (int) buffer.getWidth();
+    auto h = (int) buffer.getHeight();
+    if (sampler_.wrapS == Wrap_CLAMP_TO_BORDER || sampler_.wrapT == Wrap_CLAMP_TO_BORDER) {
+      if (x < 0 || x >= w || y < 0 || y >= h) {
+        return sampler_.borderColor == Border_WHITE ? math::float4(1.f) : math::float4(0.f, 0.f, 0.f, 1.f);
+      }
+    }
+    x = wrap(x, w, sampler_.wrapS);
+    y = wrap(y, h, sampler_.wrapT);
+    const RGBA &c = buffer.getRawDataPtr()[x + y * w];
+    return math::float4(c) * (1.f / 255.f);
+  }
+
+ private:
+  UUID<TextureSoft> uuid_;
+  SamplerDesc sampler_;
+  uint32_t layerCount_ = 1;
+
+  // [layer][level]
+  std::vector<std::vector<std::shared_ptr<Buffer<RGBA>>>> rgba_;
+  std::vector<std::vector<std::shared_ptr<Buffer<float>>>> float_;
+};
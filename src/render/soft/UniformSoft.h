@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include "base/Logger.h"
+#include "render/Uniform.h"
+#include "render/soft/ShaderProgramSoft.h"
+#include "render/soft/TextureSoft.h"
+
+class UniformBlockSoft : public UniformBlock {
+ public:
+  UniformBlockSoft(const std::string &name, int size) : UniformBlock(name, size), data_(size) {}
+
+  int getLocation(ShaderProgram &program) override {
+    auto *shader = dynamic_cast<ShaderProgramSoft *>(&program)->getShader();
+    return shader ? shader->getUniformLocation(name) : -1;
+  }
+
+  void bindProgram(ShaderProgram &program, int location) override {
+    if (location < 0) {
+      return;
+    }
+    auto *shader = dynamic_cast<ShaderProgramSoft *>(&program)->getShader();
+    if (shader) {
+      shader->setUniformData(location, data_.data(), data_.size());
+    }
+  }
+
+  void setSubData(void *data, int len, int offset) override {
+    if (offset < 0 || offset + len > (int) data_.size()) {
+      LOGE("UniformBlockSoft::setSubData error: out of range");
+      return;
+    }
+    memcpy(data_.data() + offset, data, len);
+  }
+
+  void setData(void *data, int len) override {
+    data_.resize(len);
+    memcpy(data_.data(), data, len);
+  }
+
+ private:
+  std::vector<uint8_t> data_;
+};
+
+class UniformSamplerSoft : public UniformSampler {
+ public:
+  UniformSamplerSoft(const std::string &name, TextureType type, TextureFormat format)
+      : UniformSampler(name, type, format) {}
+
+  int getLocation(ShaderProgram &program) override {
+    auto *shader = dynamic_cast<ShaderProgramSoft *>(&program)->getShader();
+    return shader ? shader->getUniformLocation(name) : -1;
+  }
+
+  void bindProgram(ShaderProgram &program, int location) override {
+    if (location < 0) {
+      return;
+    }
+    auto *shader = dynamic_cast<ShaderProgramSoft *>(&program)->getShader();
+    if (shader) {
+      shader->setSampler(location, tex_.get());
+    }
+  }
+
+  void setTexture(const std::shared_ptr<Texture> &tex) override {
+    tex_ = std::dynamic_pointer_cast<TextureSoft>(tex);
+    if (!tex_) {
+      LOGE("UniformSamplerSoft::setTexture error: texture type not support");
+    }
+  }
+
+ private:
+  std::shared_ptr<TextureSoft> tex_;
+};
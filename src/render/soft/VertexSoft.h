@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include "base/UUID.h"
+#include "render/Vertex.h"
+#include "render/VertexUtils.h"
+
+class VertexArrayObjectSoft : public VertexArrayObject {
+ public:
+  explicit VertexArrayObjectSoft(const VertexArray &vertexArr) {
+    if (!vertexArr.vertexesBuffer || !vertexArr.indexBuffer || vertexArr.vertexSize == 0) {
+      return;
+    }
+    vertexSize_ = vertexArr.vertexSize;
+    attributes_ = vertexArr.vertexesDesc;
+
+    updateVertexData(vertexArr.vertexesBuffer, vertexArr.vertexesBufferLength);
+
+    // 16 bit indices are widened, the attributes stay quantized and are decoded on fetch
+    size_t indexCnt = VertexUtils::getIndexCnt(vertexArr);
+    if (vertexArr.indexType == Index_UINT16) {
+      auto *indices = (const uint16_t *) vertexArr.indexBuffer;
+      indices_.assign(indices, indices + indexCnt);
+    } else {
+      auto *indices = (const int32_t *) vertexArr.indexBuffer;
+      indices_.assign(indices, indices + indexCnt);
+    }
+  }
+
+  void updateVertexData(void *data, size_t length) override {
+    vertexes_.resize(length);
+    memcpy(vertexes_.data(), data, length);
+    vertexCnt_ = vertexSize_ ? length / vertexSize_ : 0;
+  }
+
+  int getId() const override {
+    return uuid_.get();
+  }
+
+  inline size_t getVertexCnt() const {
+    return vertexCnt_;
+  }
+
+  inline const std::vector<VertexAttributeDesc> &getAttributes() const {
+    return attributes_;
+  }
+
+  // float attributes point into the vertex data, others are decoded into scratch (desc.size floats)
+  inline const float *getAttribute(size_t vertexIdx, size_t attrIdx, float *scratch) const {
+    auto &desc = attributes_[attrIdx];
+    const uint8_t *src = vertexes_.data() + vertexIdx * desc.stride + desc.offset;
+    if (desc.type == VertexAttr_FLOAT) {
+      return (const float *) src;
+    }
+    VertexUtils::decodeAttribute(desc, src, scratch);
+    return scratch;
+  }
+
+  inline const std::vector<int32_t> &getIndices() const {
+    return indices_;
+  }
+
+ private:
+  UUID<VertexArrayObjectSoft> uuid_;
+  size_t vertexSize_ = 0;
+  size_t vertexCnt_ = 0;
+  std::vector<VertexAttributeDesc> attributes_;
+  std::vector<uint8_t> vertexes_;
+  std::vector<int32_t> indices_;
+};
+
+class InstanceBufferSoft : public InstanceBuffer {
+ public:
+  explicit InstanceBufferSoft(const InstanceArray &instanceArr)
+      : instanceSize_(instanceArr.instanceSize), attributes_(instanceArr.instancesDesc) {
+    if (instanceArr.instancesBuffer) {
+      updateInstanceData(instanceArr.instancesBuffer, instanceArr.instancesBufferLength);
+    }
+  }
+
+  void updateInstanceData(void *data, size_t length) override {
+    instances_.resize(length);
+    memcpy(instances_.data(), data, length);
+    instanceCnt_ = instanceSize_ ? length / instanceSize_ : 0;
+  }
+
+  int getId() const override {
+    return uuid_.get();
+  }
+
+  size_t getInstanceCnt() const override {
+    return instanceCnt_;
+  }
+
+  inline const std::vector<VertexAttributeDesc> &getAttributes() const {
+    return attributes_;
+  }
+
+  // decode one attribute of one instance into desc.size floats
+  inline void getAttribute(size_t instanceIdx, size_t attrIdx, float *dst) const {
+    auto &desc = attributes_[attrIdx];
+    VertexUtils::decodeAttribute(desc, instances_.data() + instanceIdx * desc.stride + desc.offset, dst);
+  }
+
+ private:
+  UUID<InstanceBufferSoft> uuid_;
+  size_t instanceSize_ = 0;
+  size_t instanceCnt_ = 0;
+  std::vector<VertexAttributeDesc> attributes_;
+  std::vector<uint8_t> instances_;
+};
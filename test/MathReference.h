@@ -0,0 +1,33 @@
+#pragma once
+
+#include "base/MathInc.h"
+
+// scalar reference kernels shared by the math tests and the "scalar" variants of bench_math
+
+// the generic code of TMatHelpers / TVecHelpers, the reference of the float specializations
+// the math library uses when SOFTGL_SIMD_OPT is defined
+inline math::float4 mulMat4Vec4Scalar(const math::mat4f& m, const math::float4& v) {
+    math::float4 r{};
+    for (int c = 0; c < 4; c++) {
+        for (int k = 0; k < 4; k++) {
+            r[k] += m[c][k] * v[c];
+        }
+    }
+    return r;
+}
+
+inline math::mat4f mulMat4Mat4Scalar(const math::mat4f& a, const math::mat4f& b) {
+    math::mat4f r(math::mat4f::NO_INIT);
+    for (int c = 0; c < 4; c++) {
+        r[c] = mulMat4Vec4Scalar(a, b[c]);
+    }
+    return r;
+}
+
+inline float dot4Scalar(const math::float4& a, const math::float4& b) {
+    float r = 0;
+    for (int k = 0; k < 4; k++) {
+        r += a[k] * b[k];
+    }
+    return r;
+}
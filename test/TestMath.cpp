@@ -0,0 +1,463 @@
+// correctness of the math library, scene transforms and culling against scalar references
+// usage: SoftRenderAdv_test_math, registered with ctest. returns the number of failed tests
+// inputs are deterministic, the same cases are timed by SoftRenderAdv_bench_math
+
+#include <cstdio>
+#include <cmath>
+#include <cfloat>
+#include <vector>
+#include <algorithm>
+
+#include "base/MathInc.h"
+#include "math/simd.h"
+#include "math/transform.h"
+#include "math/frustum.h"
+#include "Scene.h"
+#include "BVH.h"
+#include "OcclusionCuller.h"
+#include "MathReference.h"
+
+static constexpr size_t BATCH = 1024;
+
+static uint32_t seed_ = 1;
+
+static float randomFloat(float lo, float hi) {
+    seed_ = seed_ * 1664525u + 1013904223u;
+    return lo + (hi - lo) * (float)(seed_ >> 8) / (float)(1u << 24);
+}
+
+static math::mat4f randomMatrix() {
+    math::mat4f m;
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            m[c][r] = randomFloat(-1.f, 1.f) + (c == r ? 4.f : 0.f);
+        }
+    }
+    return m;
+}
+
+// error in units of FLT_EPSILON relative to scale
+static inline double ulpError(float value, float reference, float scale) {
+    return std::abs((double)value - (double)reference) / ((double)std::max(scale, FLT_MIN) * FLT_EPSILON);
+}
+
+// the math library against the scalar reference kernels,
+// products within 4 ulps of the sum of absolute terms (fma and summation order differ),
+// inverse within 16 ulps of the largest element (block-wise inverse vs Gauss-Jordan)
+static bool testKernels(const std::vector<math::mat4f>& matrices, const std::vector<math::float4>& vectors) {
+    double errMulVec = 0, errMulMat = 0, errDot = 0, errInverse = 0;
+    for (size_t i = 0; i < matrices.size(); i++) {
+        const math::mat4f& a = matrices[i];
+        const math::mat4f& b = matrices[(i + 1) % matrices.size()];
+        const math::float4& v = vectors[i];
+
+        math::float4 mv = a * v;
+        math::float4 mvRef = mulMat4Vec4Scalar(a, v);
+        math::mat4f mm = a * b;
+        math::mat4f mmRef = mulMat4Mat4Scalar(a, b);
+        math::mat4f inv = inverse(a);
+        math::mat4f invRef = math::details::matrix::gaussJordanInverse(a);
+
+        float invScale = 0;
+        for (int c = 0; c < 4; c++) {
+            for (int k = 0; k < 4; k++) {
+                invScale = std::max(invScale, std::abs(invRef[c][k]));
+            }
+        }
+        for (int k = 0; k < 4; k++) {
+            float mvScale = 0;
+            for (int c = 0; c < 4; c++) {
+                mvScale += std::abs(a[c][k] * v[c]);
+            }
+            errMulVec = std::max(errMulVec, ulpError(mv[k], mvRef[k], mvScale));
+            for (int c = 0; c < 4; c++) {
+                float mmScale = 0;
+                for (int j = 0; j < 4; j++) {
+                    mmScale += std::abs(a[j][k] * b[c][j]);
+                }
+                errMulMat = std::max(errMulMat, ulpError(mm[c][k], mmRef[c][k], mmScale));
+                errInverse = std::max(errInverse, ulpError(inv[c][k], invRef[c][k], invScale));
+            }
+        }
+
+        float dotScale = 0;
+        for (int k = 0; k < 4; k++) {
+            dotScale += std::abs(v[k] * mv[k]);
+        }
+        errDot = std::max(errDot, ulpError(dot(v, mv), dot4Scalar(v, mv), dotScale));
+    }
+
+    // 8-wide batches, one matrix per batch
+    double errBatchTransform = 0, errBatchNormalize = 0;
+    for (size_t i = 0; i + math::simd::WIDTH <= vectors.size(); i += math::simd::WIDTH) {
+        const math::mat4f& a = matrices[i];
+        math::simd::float4x8 t = math::simd::transform(a, math::simd::float4x8::load(&vectors[i]));
+        math::simd::float3x8 n = normalize(math::simd::float4x8::load(&vectors[i]).xyz());
+        for (size_t lane = 0; lane < math::simd::WIDTH; lane++) {
+            const math::float4& v = vectors[i + lane];
+            math::float4 ref = mulMat4Vec4Scalar(a, v);
+            math::float4 batch = t.lane(lane);
+            math::float3 nRef = normalize(v.xyz);
+            math::float3 nBatch = n.lane(lane);
+            for (int k = 0; k < 4; k++) {
+                float scale = 0;
+                for (int c = 0; c < 4; c++) {
+                    scale += std::abs(a[c][k] * v[c]);
+                }
+                errBatchTransform = std::max(errBatchTransform, ulpError(batch[k], ref[k], scale));
+            }
+            for (int k = 0; k < 3; k++) {
+                errBatchNormalize = std::max(errBatchNormalize, ulpError(nBatch[k], nRef[k], 1.f));
+            }
+        }
+    }
+
+    // array transforms, points as xyz of the vectors and boxes spanned by two of them
+    const size_t n = vectors.size();
+    const math::mat4f& m = matrices[0];
+    std::vector<math::float3> points(n);
+    std::vector<math::AABB> boxes(n);
+    for (size_t i = 0; i < n; i++) {
+        points[i] = vectors[i].xyz;
+        boxes[i] = math::AABB(min(vectors[i].xyz, vectors[(i + 1) % n].xyz), max(vectors[i].xyz, vectors[(i + 1) % n].xyz));
+    }
+    std::vector<math::float4> outPoints(n);
+    std::vector<math::AABB> outBoxes(n);
+    std::vector<math::float3> outNormals(n);
+    math::transformPoints(m, points.data(), outPoints.data(), n);
+    math::transformAABBs(m, boxes.data(), outBoxes.data(), n);
+    // the first point doubles as a zero length normal, which must come out zero rather than NaN
+    points[0] = math::float3(0.f);
+    math::transformNormals(m, points.data(), outNormals.data(), n);
+
+    double errPoints = 0, errAABBs = 0, errNormals = 0;
+    if (outNormals[0].x != 0.f || outNormals[0].y != 0.f || outNormals[0].z != 0.f) {
+        errNormals = INFINITY;
+    }
+    for (size_t i = 1; i < n; i++) {
+        math::float3 ref = normalize(mulMat4Vec4Scalar(m, math::float4(points[i], 0.f)).xyz);
+        for (int k = 0; k < 3; k++) {
+            errNormals = std::max(errNormals, ulpError(outNormals[i][k], ref[k], 1.f));
+        }
+    }
+    points[0] = vectors[0].xyz;
+    for (size_t i = 0; i < n; i++) {
+        math::float4 ref = mulMat4Vec4Scalar(m, math::float4(points[i], 1.f));
+        math::AABB boxRef;
+        for (int corner = 0; corner < 8; corner++) {
+            math::float3 p((corner & 1) ? boxes[i].max.x : boxes[i].min.x, (corner & 2) ? boxes[i].max.y : boxes[i].min.y,
+                           (corner & 4) ? boxes[i].max.z : boxes[i].min.z);
+            boxRef.merge(mulMat4Vec4Scalar(m, math::float4(p, 1.f)).xyz);
+        }
+        for (int k = 0; k < 4; k++) {
+            float scale = std::abs(m[3][k]);
+            float boxScale = std::abs(m[3][k]);
+            for (int c = 0; c < 3; c++) {
+                scale += std::abs(m[c][k] * points[i][c]);
+                boxScale += std::abs(m[c][k]) * std::max(std::abs(boxes[i].min[c]), std::abs(boxes[i].max[c]));
+            }
+            errPoints = std::max(errPoints, ulpError(outPoints[i][k], ref[k], scale));
+            if (k < 3) {
+                errAABBs = std::max(errAABBs, ulpError(outBoxes[i].min[k], boxRef.min[k], boxScale));
+                errAABBs = std::max(errAABBs, ulpError(outBoxes[i].max[k], boxRef.max[k], boxScale));
+            }
+        }
+    }
+
+    struct Check {
+        const char* name;
+        double error;
+        double tolerance;
+    };
+    const Check checks[] = {
+        {"mat4_mul_vec4", errMulVec, 4.0},
+        {"mat4_mul_mat4", errMulMat, 4.0},
+        {"mat4_inverse", errInverse, 16.0},
+        {"vec4_dot", errDot, 4.0},
+        {"simd_transform", errBatchTransform, 4.0},
+        {"simd_normalize", errBatchNormalize, 4.0},
+        {"transform_points", errPoints, 4.0},
+        {"transform_aabbs", errAABBs, 8.0},
+        {"transform_normals", errNormals, 8.0},
+    };
+    bool pass = true;
+    for (auto& check : checks) {
+        if (check.error > check.tolerance) {
+            fprintf(stderr, "%s: %.2f ulps against the scalar reference, tolerance %.0f\n", check.name, check.error,
+                    check.tolerance);
+            pass = false;
+        }
+    }
+    return pass;
+}
+
+// 64 roots with 64 children of 64 boxes each, world matrices of every 97th node against the scalar product
+static bool testSceneUpdate(const std::vector<math::mat4f>& matrices) {
+    Scene scene;
+    std::vector<NodeId> roots;
+    for (size_t i = 0; i < 64; i++) {
+        roots.push_back(scene.addNode(INVALID_NODE, matrices[i]));
+    }
+    for (size_t i = 0; i < 64 * 64; i++) {
+        scene.addNode(roots[i % 64], matrices[i % BATCH]);
+    }
+    for (size_t i = 0; i < 64 * 64 * 64; i++) {
+        NodeId node = scene.addNode(roots.size() + i % (64 * 64), matrices[(i * 7) % BATCH]);
+        scene.setLocalBounds(node, math::AABB(math::float3(-0.5f), math::float3(0.5f)));
+    }
+    scene.updateTransforms();
+    for (NodeId node = 0; node < scene.getNodeCount(); node += 97) {
+        NodeId parent = scene.getParent(node);
+        math::mat4f a = parent != INVALID_NODE ? scene.getWorldMatrix(parent) : math::mat4f();
+        const math::mat4f& b = scene.getLocalMatrix(node);
+        math::mat4f ref = mulMat4Mat4Scalar(a, b);
+        for (int c = 0; c < 4; c++) {
+            for (int k = 0; k < 4; k++) {
+                float scale = 0;
+                for (int j = 0; j < 4; j++) {
+                    scale += std::abs(a[j][k] * b[c][j]);
+                }
+                if (ulpError(scene.getWorldMatrix(node)[c][k], ref[c][k], scale) > 4) {
+                    fprintf(stderr, "scene_update: node %u mismatch\n", node);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// unit boxes scattered in a 200^3 volume seen from the center, about 1/6 visible
+struct CullCase {
+    math::Frustum frustum;
+    std::vector<math::AABB> boxes;
+    math::AABBArray boxArray;
+
+    CullCase()
+        : frustum(math::mat4f::perspective(60.f, 1.f, 0.1f, 100.f)
+                  * inverse(math::mat4f::lookAt(math::float3(0.f), math::float3(0.f, 0.f, -1.f),
+                                                math::float3(0.f, 1.f, 0.f)))) {
+        const size_t boxCnt = 1 << 16;
+        boxes.resize(boxCnt);
+        boxArray.resize(boxCnt);
+        for (size_t i = 0; i < boxCnt; i++) {
+            math::float3 c(randomFloat(-100.f, 100.f), randomFloat(-100.f, 100.f), randomFloat(-100.f, 100.f));
+            boxes[i] = math::AABB(c - 0.5f, c + 0.5f);
+            boxArray.set(i, boxes[i]);
+        }
+    }
+};
+
+static bool testFrustumCull(const CullCase& cull) {
+    size_t boxCnt = cull.boxes.size();
+    std::vector<uint8_t> masks(cull.boxArray.paddedSize() / 8);
+    math::cullAABBs(cull.frustum, cull.boxArray, masks.data());
+    size_t mismatches = 0;
+    for (size_t i = 0; i < boxCnt; i++) {
+        bool visible = (masks[i / 8] >> (i % 8)) & 1;
+        mismatches += visible != cull.frustum.intersects(cull.boxes[i]) ? 1 : 0;
+    }
+    // fma contraction may flip boxes touching a plane
+    if (mismatches > boxCnt / 10000) {
+        fprintf(stderr, "frustum_cull: %zu of %zu boxes mismatch\n", mismatches, boxCnt);
+        return false;
+    }
+    return true;
+}
+
+// the same boxes in a BVH, checked against the flat cull
+static bool testBvhCull(const CullCase& cull) {
+    BVH bvh;
+    bvh.build(cull.boxArray);
+    std::vector<uint32_t> bvhVisible;
+    bvh.cull(cull.frustum, cull.boxArray, bvhVisible);
+    std::sort(bvhVisible.begin(), bvhVisible.end());
+    std::vector<uint32_t> flatVisible;
+    for (uint32_t i = 0; i < cull.boxes.size(); i++) {
+        if (cull.frustum.intersects(cull.boxes[i])) {
+            flatVisible.push_back(i);
+        }
+    }
+    if (bvhVisible != flatVisible) {
+        fprintf(stderr, "bvh_cull: %zu visible, flat %zu\n", bvhVisible.size(), flatVisible.size());
+        return false;
+    }
+    return true;
+}
+
+// rays from the center, checked against testing every box
+static bool testBvhPick(const CullCase& cull) {
+    BVH bvh;
+    bvh.build(cull.boxArray);
+    for (size_t r = 0; r < 64; r++) {
+        math::float3 dir = normalize(math::float3(randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f), -1.f));
+        float distance = 0.f;
+        int64_t hit = bvh.pick(math::float3(0.f), dir, cull.boxArray, FLT_MAX, &distance);
+        float nearest = FLT_MAX;
+        for (auto& box : cull.boxes) {
+            math::float3 t1 = box.min / dir;
+            math::float3 t2 = box.max / dir;
+            float enter = std::max(std::max(std::min(t1.x, t2.x), std::min(t1.y, t2.y)),
+                                   std::max(std::min(t1.z, t2.z), 0.f));
+            float exit = std::min(std::min(std::max(t1.x, t2.x), std::max(t1.y, t2.y)), std::max(t1.z, t2.z));
+            if (enter <= exit) {
+                nearest = std::min(nearest, enter);
+            }
+        }
+        if ((hit < 0) != (nearest == FLT_MAX) || (hit >= 0 && std::abs(distance - nearest) > 1e-3f)) {
+            fprintf(stderr, "bvh_pick: ray %zu mismatch\n", r);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 4x4 wall panels with gaps at z = -20 in front of scattered boxes, every occluded box must be hidden
+static bool testOcclusionCull() {
+    const size_t boxCnt = 1 << 16;
+    math::mat4f view = inverse(math::mat4f::lookAt(math::float3(0.f), math::float3(0.f, 0.f, -1.f),
+                                                   math::float3(0.f, 1.f, 0.f)));
+    math::mat4f viewProjection = math::mat4f::perspective(60.f, 1.f, 0.1f, 100.f) * view;
+
+    OccluderMesh cube;
+    for (int i = 0; i < 8; i++) {
+        cube.positions.emplace_back((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f);
+    }
+    cube.indices = { 0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+                     2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5 };
+    std::vector<math::AABB> walls;
+    OcclusionCuller culler;
+    culler.begin(viewProjection);
+    for (int i = 0; i < 16; i++) {
+        math::float3 center(-15.f + 10.f * (float)(i % 4), -15.f + 10.f * (float)(i / 4), -20.f);
+        math::float3 size(8.f, 8.f, 1.f);
+        walls.emplace_back(center - size * 0.5f, center + size * 0.5f);
+        culler.addOccluder(cube, math::mat4f::translation(center) * math::mat4f::scaling(size));
+    }
+    culler.rasterize();
+
+    math::Frustum frustum(viewProjection);
+    math::AABBArray boxArray;
+    boxArray.resize(boxCnt);
+    std::vector<uint32_t> inFrustum;
+    for (uint32_t i = 0; i < boxCnt; i++) {
+        math::float3 c(randomFloat(-50.f, 50.f), randomFloat(-50.f, 50.f), randomFloat(-99.f, -1.f));
+        boxArray.set(i, math::AABB(c - 0.5f, c + 0.5f));
+        if (frustum.intersects(boxArray.get(i))) {
+            inFrustum.push_back(i);
+        }
+    }
+
+    // the corners and the center of an occluded box must be off screen or behind a wall seen from the eye
+    auto hiddenByWalls = [&](const math::float3& p) {
+        for (auto& wall : walls) {
+            math::float3 t1 = wall.min / p;
+            math::float3 t2 = wall.max / p;
+            float enter = std::max(std::max(std::min(t1.x, t2.x), std::min(t1.y, t2.y)), std::min(t1.z, t2.z));
+            float exit = std::min(std::min(std::max(t1.x, t2.x), std::max(t1.y, t2.y)), std::max(t1.z, t2.z));
+            if (enter <= exit && enter > 0.f && enter < 1.f) {
+                return true;
+            }
+        }
+        return false;
+    };
+    std::vector<uint32_t> visible = inFrustum;
+    size_t occluded = culler.cull(boxArray, visible);
+    std::vector<uint8_t> kept(boxCnt, 0);
+    for (uint32_t i : visible) {
+        kept[i] = 1;
+    }
+    for (uint32_t i : inFrustum) {
+        if (kept[i]) {
+            continue;
+        }
+        math::AABB box = boxArray.get(i);
+        for (int k = 0; k < 9; k++) {
+            math::float3 p = k == 8 ? box.center() : math::float3((k & 1) ? box.max.x : box.min.x,
+                                                                 (k & 2) ? box.max.y : box.min.y,
+                                                                 (k & 4) ? box.max.z : box.min.z);
+            math::float4 q = viewProjection * math::float4(p, 1.f);
+            bool onScreen = std::abs(q.x) <= q.w && std::abs(q.y) <= q.w;
+            if (onScreen && !hiddenByWalls(p)) {
+                fprintf(stderr, "occlusion_cull: box %u culled but visible\n", i);
+                return false;
+            }
+        }
+    }
+    if (occluded == 0) {
+        fprintf(stderr, "occlusion_cull: no box occluded\n");
+        return false;
+    }
+    return true;
+}
+
+// two triangle wall at z = -10, the shared diagonal must not leave a crack: every box behind it,
+// a coarse pixel inside its silhouette, is occluded
+static bool testOcclusionWall() {
+    math::mat4f view = inverse(math::mat4f::lookAt(math::float3(0.f), math::float3(0.f, 0.f, -1.f),
+                                                   math::float3(0.f, 1.f, 0.f)));
+    math::mat4f viewProjection = math::mat4f::perspective(60.f, 1.f, 0.1f, 100.f) * view;
+
+    OccluderMesh wall;
+    wall.positions = {{-5.f, -5.f, -10.f}, {5.f, -5.f, -10.f}, {5.f, 5.f, -10.f}, {-5.f, 5.f, -10.f}};
+    wall.indices = {0, 1, 2, 0, 2, 3};
+    OcclusionCuller culler;
+    culler.begin(viewProjection);
+    culler.addOccluder(wall, math::mat4f(1.f));
+    culler.rasterize();
+
+    // wall corners project to +-0.866 in ndc, a coarse pixel is 2 / OCCLUSION_HEIGHT high
+    float limit = 0.866f - 2.f * 2.f / (float)OCCLUSION_HEIGHT;
+    size_t tested = 0;
+    while (tested < 4096) {
+        math::float3 c(randomFloat(-8.f, 8.f), randomFloat(-8.f, 8.f), randomFloat(-40.f, -11.f));
+        math::float3 half(randomFloat(0.05f, 1.f));
+        math::AABB box(c - half, c + half);
+        bool inside = box.max.z < -10.f;
+        for (int k = 0; k < 8 && inside; k++) {
+            math::float3 p((k & 1) ? box.max.x : box.min.x, (k & 2) ? box.max.y : box.min.y,
+                           (k & 4) ? box.max.z : box.min.z);
+            math::float4 q = viewProjection * math::float4(p, 1.f);
+            inside = std::abs(q.x) <= limit * q.w && std::abs(q.y) <= limit * q.w;
+        }
+        if (!inside) {
+            continue;
+        }
+        tested++;
+        if (culler.isVisible(box)) {
+            fprintf(stderr, "occlusion_wall: box at %f %f %f not occluded\n", c.x, c.y, c.z);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    std::vector<math::mat4f> matrices(BATCH);
+    std::vector<math::float4> vectors(BATCH);
+    for (size_t i = 0; i < BATCH; i++) {
+        matrices[i] = randomMatrix();
+        vectors[i] = {randomFloat(-10.f, 10.f), randomFloat(-10.f, 10.f), randomFloat(-10.f, 10.f), 1.f};
+    }
+    CullCase cull;
+
+    struct Test {
+        const char* name;
+        bool pass;
+    };
+    const Test tests[] = {
+        {"kernels", testKernels(matrices, vectors)},
+        {"scene_update", testSceneUpdate(matrices)},
+        {"frustum_cull", testFrustumCull(cull)},
+        {"bvh_cull", testBvhCull(cull)},
+        {"bvh_pick", testBvhPick(cull)},
+        {"occlusion_cull", testOcclusionCull()},
+        {"occlusion_wall", testOcclusionWall()},
+    };
+    int failed = 0;
+    for (auto& test : tests) {
+        printf("%-16s %s\n", test.name, test.pass ? "ok" : "FAILED");
+        failed += test.pass ? 0 : 1;
+    }
+    return failed;
+}
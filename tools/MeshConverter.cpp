@@ -0,0 +1,87 @@
+// convert glTF / glb models into the binary mesh cache format, see MeshCache.h
+// usage: SoftRenderAdv_mesh_converter [--quantize] <input .gltf / .glb> [output, default input with .smc extension]
+// --quantize stores half texcoords, octahedral normals and snorm16 tangents
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "GLTFLoader.h"
+#include "MeshCache.h"
+#include "base/Timer.h"
+
+int main(int argc, char** argv) {
+    bool quantize = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--quantize") {
+            quantize = true;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty() || paths.size() > 2) {
+        fprintf(stderr, "usage: %s [--quantize] <input .gltf / .glb> [output%s]\n", argv[0], MESH_CACHE_EXT.c_str());
+        return 1;
+    }
+    std::string input = paths[0];
+    std::string output;
+    if (paths.size() > 1) {
+        output = paths[1];
+    } else {
+        size_t dot = input.find_last_of('.');
+        output = (dot == std::string::npos ? input : input.substr(0, dot)) + MESH_CACHE_EXT;
+    }
+
+    Timer timer;
+    GLTFLoader loader;
+    auto model = loader.load(input);
+    if (!model) {
+        fprintf(stderr, "load failed: %s\n", input.c_str());
+        return 1;
+    }
+    double loadMillis = timer.elapseMillis();
+
+    timer.start();
+    if (!MeshCache::write(*model, output, quantize)) {
+        fprintf(stderr, "write failed: %s\n", output.c_str());
+        return 1;
+    }
+    double writeMillis = timer.elapseMillis();
+
+    // read back to validate and to report the warm load time
+    timer.start();
+    auto cached = MeshCache::read(output);
+    if (!cached) {
+        fprintf(stderr, "read back failed: %s\n", output.c_str());
+        return 1;
+    }
+    double readMillis = timer.elapseMillis();
+
+    printf("%s -> %s\n", input.c_str(), output.c_str());
+    printf("meshes %zu, vertices %zu -> %zu, triangles %zu, meshlets %zu, lods %zu, images %zu\n",
+           model->stats.meshCount, model->stats.vertexCount, cached->stats.vertexCount, model->stats.triangleCount,
+           cached->stats.meshletCount, cached->stats.lodCount, model->stats.imageCount);
+    for (size_t i = 0; i < cached->meshes.size(); i++) {
+        const ModelMesh& mesh = cached->meshes[i];
+        if (mesh.getLodCount() < 2) {
+            continue;
+        }
+        printf("mesh %zu lods:", i);
+        for (size_t level = 0; level < mesh.getLodCount(); level++) {
+            printf(" %u (%.2g)", mesh.getLodRange(level).count / 3, mesh.getLodError(level));
+        }
+        printf("\n");
+    }
+    size_t sourceBytes = 0;
+    size_t cachedBytes = 0;
+    for (size_t i = 0; i < model->meshes.size(); i++) {
+        sourceBytes += model->meshes[i].vertexes.vertexesBufferLength + model->meshes[i].vertexes.indexBufferLength;
+        cachedBytes += cached->meshes[i].vertexes.vertexesBufferLength + cached->meshes[i].vertexes.indexBufferLength;
+    }
+    printf("vertex and index data %.2f MB -> %.2f MB\n", (double)sourceBytes / (1024.0 * 1024.0),
+           (double)cachedBytes / (1024.0 * 1024.0));
+    printf("source load %.2f ms, write %.2f ms, cache load %.2f ms\n", loadMillis, writeMillis, readMillis);
+    return 0;
+}